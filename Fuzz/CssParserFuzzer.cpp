@@ -0,0 +1,21 @@
+#include "FuzzBudget.hpp"
+
+#include "YepSVGCore/CssColor.hpp"
+#include "YepSVGCore/CssParser.hpp"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    static const csvg::fuzz::BudgetLimits limits = csvg::fuzz::LimitsFromEnvironment();
+    const std::string input = csvg::fuzz::InputToString(data, size);
+
+    csvg::fuzz::ScopedBudget budget("css_parser", size, limits);
+    const csvg::CssParser parser;
+    size_t source_order = 0;
+    std::vector<csvg::CssRule> rules;
+    parser.ParseRules(input, source_order, rules);
+    (void)parser.ParseSelector(input);
+    for (const auto& [name, value] : parser.ParseDeclarations(input)) {
+        (void)csvg::ParseCssColor(value);
+    }
+    (void)csvg::ParseCssColor(input);
+    return 0;
+}
@@ -0,0 +1,13 @@
+#include "FuzzBudget.hpp"
+
+#include "YepSVGCore/DataUrl.hpp"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    static const csvg::fuzz::BudgetLimits limits = csvg::fuzz::LimitsFromEnvironment();
+    const std::string input = csvg::fuzz::InputToString(data, size);
+
+    csvg::fuzz::ScopedBudget budget("data_url", size, limits);
+    (void)csvg::DataUrlDecoder::DecodeBase64(input);
+    (void)csvg::DataUrlDecoder::Decode(input);
+    return 0;
+}
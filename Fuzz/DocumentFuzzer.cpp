@@ -0,0 +1,128 @@
+#include "FuzzBudget.hpp"
+
+#include <cmath>
+
+#include "YepSVGCore/CssParser.hpp"
+#include "YepSVGCore/DataUrl.hpp"
+#include "YepSVGCore/Document.hpp"
+#include "YepSVGCore/ElementBounds.hpp"
+#include "YepSVGCore/DocumentIndex.hpp"
+#include "YepSVGCore/FilterGraph.hpp"
+#include "YepSVGCore/GeometryEngine.hpp"
+#include "YepSVGCore/HitTest.hpp"
+#include "YepSVGCore/LayoutEngine.hpp"
+#include "YepSVGCore/NodeTransforms.hpp"
+#include "YepSVGCore/PathData.hpp"
+#include "YepSVGCore/PathFlattener.hpp"
+#include "YepSVGCore/ResourceResolver.hpp"
+#include "YepSVGCore/Stylesheet.hpp"
+#include "YepSVGCore/SvgDom.hpp"
+#include "YepSVGCore/XmlParser.hpp"
+
+// Drives every portable stage of Engine::Render and the attribute parsers the
+// paint pass would reach; typed attributes are parsed by XmlParser itself.
+// Painting needs CoreGraphics and is left to the XCTest suites.
+namespace {
+
+class NullPathSink final : public csvg::PathDataSink {
+public:
+    void MoveTo(double, double) override {}
+    void LineTo(double, double) override {}
+    void CubicTo(double, double, double, double, double, double) override {}
+    void QuadTo(double, double, double, double) override {}
+    void ClosePath() override {}
+};
+
+void ParseAttributes(const csvg::XmlNode& node,
+                     const csvg::CssParser& css_parser,
+                     const csvg::Stylesheet& stylesheet,
+                     std::vector<csvg::CssSelectorRef>& candidates) {
+    candidates.clear();
+    stylesheet.CollectCandidates(node, candidates);
+    for (const auto& [name, value] : node.attributes) {
+        if (name == "d") {
+            NullPathSink sink;
+            (void)csvg::PathDataParser().Parse(value, sink);
+        } else if (name == "style") {
+            (void)css_parser.ParseDeclarations(value);
+        } else if (name == "href" || name == "xlink:href") {
+            (void)csvg::DataUrlDecoder::Decode(value);
+        }
+    }
+    for (const auto& child : node.children) {
+        ParseAttributes(child, css_parser, stylesheet, candidates);
+    }
+}
+
+// Flattens every outline at the tolerance its device scale calls for, as
+// textPath layout does.
+void FlattenOutlines(const csvg::XmlNode& node,
+                     const csvg::GeometryEngine& geometry_engine,
+                     const csvg::NodeTransformCache& transforms,
+                     csvg::FlattenedPathCache& paths) {
+    if (const csvg::AffineMatrix* matrix = transforms.UserToDevice(node)) {
+        const double scale = std::sqrt(std::fabs(matrix->a * matrix->d - matrix->b * matrix->c));
+        const csvg::FlattenedPath* path = paths.Get(node, geometry_engine, csvg::FlatteningTolerance(scale));
+        csvg::Point point;
+        csvg::Point tangent;
+        (void)path->PointAndTangentAt(path->length() * 0.5, point, tangent);
+    }
+    for (const auto& child : node.children) {
+        FlattenOutlines(child, geometry_engine, transforms, paths);
+    }
+}
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    static const csvg::fuzz::BudgetLimits limits = csvg::fuzz::LimitsFromEnvironment();
+    const std::string input = csvg::fuzz::InputToString(data, size);
+
+    csvg::fuzz::ScopedBudget budget("document", size, limits);
+    csvg::RenderError error;
+    auto xml_root = csvg::XmlParser().Parse(input, error);
+    if (!xml_root.has_value()) {
+        return 0;
+    }
+    auto document = csvg::SvgDom().Build(*xml_root, error);
+    if (!document.has_value()) {
+        return 0;
+    }
+
+    const csvg::DocumentIndex index = csvg::DocumentIndexer().Build(*document);
+    const auto stylesheet = csvg::Stylesheet::Compile(index.css_blocks, csvg::StylesheetOrigin::kAuthor);
+    std::vector<csvg::CssSelectorRef> candidates;
+    ParseAttributes(document->root, csvg::CssParser(), *stylesheet, candidates);
+
+    csvg::RenderOptions options;
+    options.enable_external_resources = true;
+    (void)csvg::ResourceResolver().ValidatePolicy(index.external_urls, options, false, error);
+    (void)csvg::ResourceResolver().CollectRemoteRequests(index.external_urls);
+    (void)csvg::FilterGraph().ValidateFilterSupport(index, csvg::CompatFlags{}, error);
+    if (const auto layout = csvg::LayoutEngine().Compute(*document, options, error)) {
+        const csvg::NodeTransformCache transforms(document->root, *layout);
+        csvg::FlattenedPathCache paths;
+        FlattenOutlines(document->root,
+                        csvg::GeometryEngine(layout->view_box_width, layout->view_box_height),
+                        transforms,
+                        paths);
+    }
+
+    // Hit testing and bounds queries run on a retained document, as the bridge does.
+    if (const auto retained = csvg::Document::Parse(input, true, error)) {
+        if (const auto hit_index = csvg::HitTestIndex::Build(*retained, options, error)) {
+            csvg::HitTestQuery query;
+            query.tolerance = 2.0;
+            query.collect_all = true;
+            for (int i = 0; i < 16; ++i) {
+                (void)hit_index->HitTest(i * 16.0, i * 9.0, query);
+            }
+        }
+        if (const auto bounds_index = csvg::ElementBoundsIndex::Build(*retained, options, error)) {
+            for (const auto& entry : retained->index().nodes_by_id) {
+                (void)bounds_index->Find(entry.first);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,40 @@
+#include "FuzzBudget.hpp"
+
+#include "YepSVGCore/FontLibrary.hpp"
+
+#include <algorithm>
+
+namespace {
+
+class NullSink final : public csvg::PathDataSink {
+public:
+    void MoveTo(double, double) override {}
+    void LineTo(double, double) override {}
+    void CubicTo(double, double, double, double, double, double) override {}
+    void QuadTo(double, double, double, double) override {}
+    void ClosePath() override {}
+};
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    static const csvg::fuzz::BudgetLimits limits = csvg::fuzz::LimitsFromEnvironment();
+
+    csvg::fuzz::ScopedBudget budget("font_face", size, limits);
+    csvg::FontLibrary library;
+    csvg::RenderError error;
+    if (library.AddFontData(std::vector<uint8_t>(data, data + size), error) == 0) {
+        return 0;
+    }
+    const auto face = library.Match("sans-serif", 700, true);
+    NullSink sink;
+    const auto shaped = library.Shape("AVAV Hg\xC3\xA9\xF0\x9F\x98\x80", *face, 16.0, 0.5, 2.0);
+    library.EmitText(shaped, 16.0, 0.0, 16.0, sink);
+    const uint16_t glyphs = std::min<uint16_t>(face->glyph_count(), 256);
+    for (uint16_t glyph = 0; glyph < glyphs; ++glyph) {
+        csvg::GlyphOutline outline;
+        (void)face->BuildOutline(glyph, outline);
+        (void)face->AdvanceWidth(glyph);
+    }
+    return 0;
+}
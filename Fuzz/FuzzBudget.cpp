@@ -0,0 +1,141 @@
+#include "FuzzBudget.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace csvg::fuzz {
+namespace {
+
+std::atomic<uint64_t> g_allocated_bytes{0};
+std::atomic<uint64_t> g_allocation_count{0};
+
+void* CountedAllocate(size_t size) {
+    g_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    void* pointer = std::malloc(size == 0 ? 1 : size);
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+double EnvironmentDouble(const char* name, double fallback) {
+    const char* value = std::getenv(name);
+    if (value == nullptr || *value == '\0') {
+        return fallback;
+    }
+    char* end = nullptr;
+    const double parsed = std::strtod(value, &end);
+    if (end == value || parsed <= 0.0) {
+        return fallback;
+    }
+    return parsed;
+}
+
+} // namespace
+
+BudgetLimits LimitsFromEnvironment(const BudgetLimits& defaults) {
+    BudgetLimits limits = defaults;
+    limits.time_ms = EnvironmentDouble("YEPSVG_FUZZ_TIME_BUDGET_MS", defaults.time_ms);
+    const double megabytes = EnvironmentDouble("YEPSVG_FUZZ_ALLOC_BUDGET_MB",
+                                               static_cast<double>(defaults.allocated_bytes) / (1024.0 * 1024.0));
+    limits.allocated_bytes = static_cast<uint64_t>(megabytes * 1024.0 * 1024.0);
+    limits.allocation_count = static_cast<uint64_t>(
+        EnvironmentDouble("YEPSVG_FUZZ_ALLOC_COUNT_BUDGET", static_cast<double>(defaults.allocation_count)));
+    return limits;
+}
+
+uint64_t AllocatedBytes() {
+    return g_allocated_bytes.load(std::memory_order_relaxed);
+}
+
+uint64_t AllocationCount() {
+    return g_allocation_count.load(std::memory_order_relaxed);
+}
+
+void ResetAllocationCounters() {
+    g_allocated_bytes.store(0, std::memory_order_relaxed);
+    g_allocation_count.store(0, std::memory_order_relaxed);
+}
+
+ScopedBudget::ScopedBudget(const char* target, size_t input_size, const BudgetLimits& limits)
+    : target_(target), input_size_(input_size), limits_(limits), start_(std::chrono::steady_clock::now()) {
+    ResetAllocationCounters();
+}
+
+ScopedBudget::~ScopedBudget() {
+    const double elapsed_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+    const uint64_t bytes = AllocatedBytes();
+    const uint64_t count = AllocationCount();
+
+    const char* exceeded = nullptr;
+    if (elapsed_ms > limits_.time_ms) {
+        exceeded = "time";
+    } else if (bytes > limits_.allocated_bytes) {
+        exceeded = "allocated bytes";
+    } else if (count > limits_.allocation_count) {
+        exceeded = "allocation count";
+    }
+    if (exceeded == nullptr) {
+        return;
+    }
+
+    std::fprintf(stderr,
+                 "==%s== per-input %s budget exceeded: input=%zu bytes, time=%.2f ms (limit %.2f), "
+                 "allocated=%llu bytes (limit %llu), allocations=%llu (limit %llu)\n",
+                 target_,
+                 exceeded,
+                 input_size_,
+                 elapsed_ms,
+                 limits_.time_ms,
+                 static_cast<unsigned long long>(bytes),
+                 static_cast<unsigned long long>(limits_.allocated_bytes),
+                 static_cast<unsigned long long>(count),
+                 static_cast<unsigned long long>(limits_.allocation_count));
+    std::abort();
+}
+
+} // namespace csvg::fuzz
+
+void* operator new(size_t size) {
+    return csvg::fuzz::CountedAllocate(size);
+}
+
+void* operator new[](size_t size) {
+    return csvg::fuzz::CountedAllocate(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return csvg::fuzz::CountedAllocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return csvg::fuzz::CountedAllocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
@@ -0,0 +1,52 @@
+#ifndef CHROMIUM_SVG_FUZZ_BUDGET_HPP
+#define CHROMIUM_SVG_FUZZ_BUDGET_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace csvg::fuzz {
+
+// Per-input limits. libFuzzer's -timeout and -malloc_limit_mb only catch
+// pathological inputs at process granularity; these catch an input that is
+// merely much slower or hungrier than its size justifies.
+struct BudgetLimits {
+    double time_ms = 250.0;
+    uint64_t allocated_bytes = 64ull * 1024ull * 1024ull;
+    uint64_t allocation_count = 1000000;
+};
+
+// Reads YEPSVG_FUZZ_TIME_BUDGET_MS, YEPSVG_FUZZ_ALLOC_BUDGET_MB and
+// YEPSVG_FUZZ_ALLOC_COUNT_BUDGET, falling back to |defaults|.
+BudgetLimits LimitsFromEnvironment(const BudgetLimits& defaults = {});
+
+// Bytes and calls routed through operator new since the last reset.
+uint64_t AllocatedBytes();
+uint64_t AllocationCount();
+void ResetAllocationCounters();
+
+// Measures one fuzz input. Aborts with a report when the input exceeds any
+// limit, so libFuzzer records it as a crash and saves the reproducer.
+class ScopedBudget {
+public:
+    ScopedBudget(const char* target, size_t input_size, const BudgetLimits& limits);
+    ~ScopedBudget();
+
+    ScopedBudget(const ScopedBudget&) = delete;
+    ScopedBudget& operator=(const ScopedBudget&) = delete;
+
+private:
+    const char* target_;
+    size_t input_size_;
+    BudgetLimits limits_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+inline std::string InputToString(const uint8_t* data, size_t size) {
+    return std::string(reinterpret_cast<const char*>(data), size);
+}
+
+} // namespace csvg::fuzz
+
+#endif
@@ -0,0 +1,28 @@
+#include "FuzzBudget.hpp"
+
+#include "YepSVGCore/PathData.hpp"
+
+namespace {
+
+class CountingPathSink final : public csvg::PathDataSink {
+public:
+    void MoveTo(double, double) override { ++segments; }
+    void LineTo(double, double) override { ++segments; }
+    void CubicTo(double, double, double, double, double, double) override { ++segments; }
+    void QuadTo(double, double, double, double) override { ++segments; }
+    void ClosePath() override { ++segments; }
+
+    size_t segments = 0;
+};
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    static const csvg::fuzz::BudgetLimits limits = csvg::fuzz::LimitsFromEnvironment();
+    const std::string input = csvg::fuzz::InputToString(data, size);
+
+    csvg::fuzz::ScopedBudget budget("path_data", size, limits);
+    CountingPathSink sink;
+    (void)csvg::PathDataParser().Parse(input, sink);
+    return 0;
+}
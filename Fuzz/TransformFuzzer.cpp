@@ -0,0 +1,12 @@
+#include "FuzzBudget.hpp"
+
+#include "YepSVGCore/Transform.hpp"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    static const csvg::fuzz::BudgetLimits limits = csvg::fuzz::LimitsFromEnvironment();
+    const std::string input = csvg::fuzz::InputToString(data, size);
+
+    csvg::fuzz::ScopedBudget budget("transform_list", size, limits);
+    (void)csvg::TransformParser().Parse(input);
+    return 0;
+}
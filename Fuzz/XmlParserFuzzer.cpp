@@ -0,0 +1,13 @@
+#include "FuzzBudget.hpp"
+
+#include "YepSVGCore/XmlParser.hpp"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    static const csvg::fuzz::BudgetLimits limits = csvg::fuzz::LimitsFromEnvironment();
+    const std::string input = csvg::fuzz::InputToString(data, size);
+
+    csvg::fuzz::ScopedBudget budget("xml_parser", size, limits);
+    csvg::RenderError error;
+    (void)csvg::XmlParser().Parse(input, error);
+    return 0;
+}
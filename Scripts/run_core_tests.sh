@@ -0,0 +1,30 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Builds and runs the native YepSVGCore checks in Tests/YepSVGCoreTests/
+# against the portable sources, with AddressSanitizer and UBSan.
+#
+#   Scripts/run_core_tests.sh
+#
+# Environment:
+#   CXX    compiler (default clang++)
+
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+CORE="$ROOT/Sources/YepSVGCore"
+OUT_DIR="$ROOT/.tmp/core-tests"
+CXX="${CXX:-clang++}"
+
+mkdir -p "$OUT_DIR"
+
+echo "Building font_library..."
+"$CXX" -std=c++17 -O1 -g -fsanitize=address,undefined -Wall -Wextra \
+    -I"$CORE/include" \
+    "$ROOT/Tests/YepSVGCoreTests/FontLibraryTests.cpp" \
+    "$CORE/Transform.cpp" \
+    "$CORE/FontFamilies.cpp" \
+    "$CORE/FontFace.cpp" \
+    "$CORE/FontLibrary.cpp" \
+    -o "$OUT_DIR/font_library"
+
+echo "Running font_library..."
+"$OUT_DIR/font_library"
@@ -0,0 +1,103 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Builds the libFuzzer targets in Fuzz/ against the portable YepSVGCore
+# sources and runs each one for a fixed time.
+#
+#   Scripts/run_fuzzers.sh [target ...]
+#
+# Targets: xml_parser css_parser path_data transform_list data_url document
+#          font_face
+# Environment:
+#   FUZZ_SECONDS                  wall time per target (default 60)
+#   FUZZ_MAX_LEN                  largest generated input in bytes (default 16384)
+#   YEPSVG_FUZZ_TIME_BUDGET_MS    per-input time budget (default 250)
+#   YEPSVG_FUZZ_ALLOC_BUDGET_MB   per-input allocated-bytes budget (default 64)
+#   YEPSVG_FUZZ_ALLOC_COUNT_BUDGET per-input allocation-count budget (default 1000000)
+
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+CORE="$ROOT/Sources/YepSVGCore"
+OUT_DIR="$ROOT/.tmp/fuzz"
+CXX="${CXX:-clang++}"
+FUZZ_SECONDS="${FUZZ_SECONDS:-60}"
+FUZZ_MAX_LEN="${FUZZ_MAX_LEN:-16384}"
+
+PORTABLE_SOURCES=(
+    "$CORE/Attributes.cpp"
+    "$CORE/AttributeValues.cpp"
+    "$CORE/XmlParser.cpp"
+    "$CORE/SvgDom.cpp"
+    "$CORE/DocumentIndex.cpp"
+    "$CORE/FilterGraph.cpp"
+    "$CORE/LayoutEngine.cpp"
+    "$CORE/ResourceResolver.cpp"
+    "$CORE/CssParser.cpp"
+    "$CORE/CssColor.cpp"
+    "$CORE/Stylesheet.cpp"
+    "$CORE/CssCascade.cpp"
+    "$CORE/StyleResolver.cpp"
+    "$CORE/Theme.cpp"
+    "$CORE/Document.cpp"
+    "$CORE/DataUrl.cpp"
+    "$CORE/PathData.cpp"
+    "$CORE/Transform.cpp"
+    "$CORE/NodeTransforms.cpp"
+    "$CORE/GeometryEngine.cpp"
+    "$CORE/PathFlattener.cpp"
+    "$CORE/HitTest.cpp"
+    "$CORE/ElementBounds.cpp"
+    "$CORE/FontFamilies.cpp"
+    "$CORE/FontFace.cpp"
+    "$CORE/FontLibrary.cpp"
+)
+
+source_for_target() {
+    case "$1" in
+        xml_parser) echo "XmlParserFuzzer.cpp" ;;
+        css_parser) echo "CssParserFuzzer.cpp" ;;
+        path_data) echo "PathDataFuzzer.cpp" ;;
+        transform_list) echo "TransformFuzzer.cpp" ;;
+        data_url) echo "DataUrlFuzzer.cpp" ;;
+        document) echo "DocumentFuzzer.cpp" ;;
+        font_face) echo "FontFaceFuzzer.cpp" ;;
+        *) return 1 ;;
+    esac
+}
+
+TARGETS=("$@")
+if [ "${#TARGETS[@]}" -eq 0 ]; then
+    TARGETS=(xml_parser css_parser path_data transform_list data_url document font_face)
+fi
+
+mkdir -p "$OUT_DIR"
+
+for target in "${TARGETS[@]}"; do
+    if ! source="$(source_for_target "$target")"; then
+        echo "Unknown fuzz target: $target" >&2
+        exit 1
+    fi
+
+    binary="$OUT_DIR/$target"
+    corpus="$OUT_DIR/corpus/$target"
+    artifacts="$OUT_DIR/artifacts/$target/"
+    mkdir -p "$corpus" "$artifacts"
+    if [ "$target" = "xml_parser" ] || [ "$target" = "document" ]; then
+        cp "$ROOT"/Fixtures/svg/*.svg "$corpus/"
+    fi
+
+    echo "Building $target..."
+    "$CXX" -std=c++17 -O1 -g -fsanitize=fuzzer,address,undefined \
+        -I"$CORE/include" -I"$ROOT/Fuzz" \
+        "$ROOT/Fuzz/FuzzBudget.cpp" "$ROOT/Fuzz/$source" "${PORTABLE_SOURCES[@]}" \
+        -o "$binary"
+
+    echo "Running $target for ${FUZZ_SECONDS}s..."
+    "$binary" "$corpus" \
+        -max_total_time="$FUZZ_SECONDS" \
+        -max_len="$FUZZ_MAX_LEN" \
+        -timeout=10 \
+        -rss_limit_mb=2048 \
+        -artifact_prefix="$artifacts"
+done
+
+echo "Done. Corpora and crash artifacts are in: $OUT_DIR"
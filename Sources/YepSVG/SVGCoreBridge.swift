@@ -3,12 +3,69 @@ import Foundation
 import UIKit
 import YepSVGCBridge
 
+/// One core renderer and the loader it calls. Parsed stylesheets, text
+/// layouts, glyph masks, decoded images and scratch buffers live in the core
+/// renderer, so callers keep one for as long as they render.
+final class SVGCoreRenderer: @unchecked Sendable {
+    let handle: OpaquePointer
+    private let loaderBox: ExternalResourceLoaderBox?
+
+    init?(loader: (any SVGExternalResourceLoader)?) {
+        guard let created = csvg_renderer_create() else {
+            return nil
+        }
+        handle = created
+        loaderBox = loader.map(ExternalResourceLoaderBox.init)
+        if let loaderBox {
+            csvg_renderer_set_external_resource_loader(
+                created,
+                externalResourceLoaderCallback,
+                Unmanaged.passUnretained(loaderBox).toOpaque()
+            )
+        }
+    }
+
+    deinit {
+        csvg_renderer_destroy(handle)
+    }
+}
+
 enum SVGCoreBridge {
-    static func render(svgData: Data, options: SVGRenderOptions) throws -> UIImage {
-        guard let renderer = csvg_renderer_create() else {
+    static func render(
+        svgData: Data,
+        options: SVGRenderOptions,
+        renderer: SVGCoreRenderer?
+    ) throws -> UIImage {
+        try render(options: options, renderer: renderer) { renderer, cOptions, result in
+            svgData.withUnsafeBytes { rawBuffer in
+                guard let baseAddress = rawBuffer.baseAddress?.assumingMemoryBound(to: UInt8.self) else {
+                    return 0
+                }
+                return csvg_renderer_render(renderer, baseAddress, rawBuffer.count, &cOptions, &result)
+            }
+        }
+    }
+
+    static func render(
+        document: SVGDocument,
+        options: SVGRenderOptions,
+        renderer: SVGCoreRenderer?
+    ) throws -> UIImage {
+        try withExtendedLifetime(document) {
+            try render(options: options, renderer: renderer) { renderer, cOptions, result in
+                csvg_renderer_render_document(renderer, document.handle, &cOptions, &result)
+            }
+        }
+    }
+
+    private static func render(
+        options: SVGRenderOptions,
+        renderer: SVGCoreRenderer?,
+        invoke: (OpaquePointer, inout csvg_render_options_t, inout csvg_render_result_t) -> Int32
+    ) throws -> UIImage {
+        guard let renderer else {
             throw SVGRenderError.renderFailed("Failed to initialize core renderer")
         }
-        defer { csvg_renderer_destroy(renderer) }
 
         var cOptions = csvg_render_options_t()
         csvg_render_options_init_default(&cOptions)
@@ -20,6 +77,7 @@ enum SVGCoreBridge {
         cOptions.scale = Float(options.scale)
         cOptions.default_font_size = Float(options.defaultFontSize)
         cOptions.enable_external_resources = options.enableExternalResources
+        cOptions.theme = options.theme?.handle
 
         if let color = options.backgroundColor,
            let components = color.components {
@@ -38,13 +96,15 @@ enum SVGCoreBridge {
 
         var result = csvg_render_result_t()
         let fontFamily = options.defaultFontFamily
-        let status: Int32 = fontFamily.withCString { fontCString in
-            cOptions.default_font_family = fontCString
-            return svgData.withUnsafeBytes { rawBuffer in
-                guard let baseAddress = rawBuffer.baseAddress?.assumingMemoryBound(to: UInt8.self) else {
-                    return 0
+        let stylesheetHandles: [OpaquePointer?] = options.stylesheets.map { $0.handle }
+        let status: Int32 = withExtendedLifetime((options.theme, options.stylesheets, renderer)) {
+            fontFamily.withCString { fontCString in
+                stylesheetHandles.withUnsafeBufferPointer { stylesheets in
+                    cOptions.default_font_family = fontCString
+                    cOptions.stylesheets = stylesheets.baseAddress
+                    cOptions.stylesheet_count = stylesheets.count
+                    return invoke(renderer.handle, &cOptions, &result)
                 }
-                return csvg_renderer_render(renderer, baseAddress, rawBuffer.count, &cOptions, &result)
             }
         }
         defer { csvg_render_result_free(&result) }
@@ -85,7 +145,7 @@ enum SVGCoreBridge {
         return UIImage(cgImage: cgImage)
     }
 
-    private static func mapError(code: csvg_error_code_t, message: String) -> SVGRenderError {
+    static func mapError(code: csvg_error_code_t, message: String) -> SVGRenderError {
         switch code {
         case CSVG_ERROR_INVALID_DOCUMENT:
             return .invalidDocument(message)
@@ -97,6 +157,11 @@ enum SVGCoreBridge {
             }
             return .externalResourceBlocked(URL(string: "about:invalid")!)
         case CSVG_ERROR_EXTERNAL_RESOURCE_FAILED:
+            let detail = message.replacingOccurrences(of: "External resource failed: ", with: "")
+            let parts = detail.components(separatedBy: ": ")
+            if let url = parts.first.flatMap(URL.init(string:)) {
+                return .externalResourceFailed(url, parts.dropFirst().joined(separator: ": "))
+            }
             return .renderFailed(message)
         case CSVG_ERROR_RENDER_FAILED:
             return .renderFailed(message)
@@ -107,3 +172,65 @@ enum SVGCoreBridge {
         }
     }
 }
+
+/// Lets the core call an async loader from its fetch threads.
+private final class ExternalResourceLoaderBox: @unchecked Sendable {
+    let loader: any SVGExternalResourceLoader
+
+    init(_ loader: any SVGExternalResourceLoader) {
+        self.loader = loader
+    }
+
+    func load(_ request: SVGExternalResourceRequest) -> Result<Data, Error> {
+        let semaphore = DispatchSemaphore(value: 0)
+        let outcome = LoadOutcome()
+        Task.detached { [loader] in
+            do {
+                outcome.result = .success(try await loader.loadResource(request))
+            } catch {
+                outcome.result = .failure(error)
+            }
+            semaphore.signal()
+        }
+        semaphore.wait()
+        return outcome.result ?? .failure(SVGRenderError.renderFailed("Loader did not finish"))
+    }
+}
+
+/// Written by the loading task before it signals, read after the wait.
+private final class LoadOutcome: @unchecked Sendable {
+    var result: Result<Data, Error>?
+}
+
+private let externalResourceLoaderCallback: csvg_external_resource_loader_t = { context, request, outData, outSize, outErrorMessage in
+    guard let context, let request, let cURL = request.pointee.url,
+          let url = URL(string: String(cString: cURL)) else {
+        return 0
+    }
+    let purpose: SVGExternalResourceRequest.Purpose
+    switch request.pointee.purpose {
+    case CSVG_RESOURCE_IMAGE:
+        purpose = .image
+    case CSVG_RESOURCE_STYLESHEET:
+        purpose = .stylesheet
+    case CSVG_RESOURCE_FONT:
+        purpose = .font
+    default:
+        purpose = .other
+    }
+
+    let box = Unmanaged<ExternalResourceLoaderBox>.fromOpaque(context).takeUnretainedValue()
+    switch box.load(SVGExternalResourceRequest(url: url, purpose: purpose)) {
+    case .success(let data):
+        guard let buffer = malloc(max(data.count, 1))?.assumingMemoryBound(to: UInt8.self) else {
+            return 0
+        }
+        data.copyBytes(to: buffer, count: data.count)
+        outData?.pointee = buffer
+        outSize?.pointee = data.count
+        return 1
+    case .failure(let error):
+        outErrorMessage?.pointee = strdup(error.localizedDescription)
+        return 0
+    }
+}
@@ -0,0 +1,46 @@
+import Foundation
+import YepSVGCBridge
+
+/// An SVG parsed once and rendered any number of times, e.g. once per theme.
+///
+/// Remote (http/https) references are fetched through the rendering
+/// `SVGRenderer`'s loader when `enableExternalResources` is set. Each render
+/// requests every remote URL concurrently before painting, skipping images
+/// that renderer has already decoded. Relative references are not rewritten
+/// against any base URL.
+public final class SVGDocument: @unchecked Sendable {
+    let handle: OpaquePointer
+
+    public init(svgData: Data) throws {
+        guard !svgData.isEmpty else {
+            throw SVGRenderError.invalidDocument("Input data is empty")
+        }
+
+        var errorCode = CSVG_ERROR_NONE
+        var errorMessage: UnsafeMutablePointer<CChar>?
+        let created: OpaquePointer? = svgData.withUnsafeBytes { rawBuffer in
+            guard let baseAddress = rawBuffer.baseAddress?.assumingMemoryBound(to: UInt8.self) else {
+                return nil
+            }
+            return csvg_document_create(baseAddress, rawBuffer.count, &errorCode, &errorMessage)
+        }
+        defer { csvg_free_owned_memory(errorMessage) }
+
+        guard let created else {
+            let message = errorMessage.map { String(cString: $0) } ?? "Unknown parse failure"
+            throw SVGCoreBridge.mapError(code: errorCode, message: message)
+        }
+        self.handle = created
+    }
+
+    public convenience init(svgString: String) throws {
+        guard let data = svgString.data(using: .utf8) else {
+            throw SVGRenderError.invalidDocument("Input string is not valid UTF-8")
+        }
+        try self.init(svgData: data)
+    }
+
+    deinit {
+        csvg_document_destroy(handle)
+    }
+}
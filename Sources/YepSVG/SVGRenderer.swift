@@ -2,10 +2,12 @@ import Foundation
 import UIKit
 
 public final class SVGRenderer: @unchecked Sendable {
-    private let loader: (any SVGExternalResourceLoader)?
+    private let core: SVGCoreRenderer?
+    /// Serves renderSync, which has no loader.
+    private static let sharedCore = SVGCoreRenderer(loader: nil)
 
     public init(loader: (any SVGExternalResourceLoader)? = nil) {
-        self.loader = loader
+        self.core = SVGCoreRenderer(loader: loader)
     }
 
     public func render(svgString: String, options: SVGRenderOptions) async throws -> UIImage {
@@ -20,11 +22,10 @@ public final class SVGRenderer: @unchecked Sendable {
             throw SVGRenderError.invalidDocument("Input data is empty")
         }
 
-        try await preflightExternalResourcesIfNeeded(svgData: svgData, options: options)
-
-        return try await Task.detached(priority: .userInitiated) {
-            try Self.renderSync(svgData: svgData, options: options)
-        }.value
+        let core = self.core
+        return try await Self.renderOffCooperativePool {
+            try SVGCoreBridge.render(svgData: svgData, options: options, renderer: core)
+        }
     }
 
     public func render(svgFileURL: URL, options: SVGRenderOptions) async throws -> UIImage {
@@ -39,78 +40,31 @@ public final class SVGRenderer: @unchecked Sendable {
         return try await render(svgData: rewritten, options: options)
     }
 
-    public static func renderSync(svgData: Data, options: SVGRenderOptions) throws -> UIImage {
-        guard !svgData.isEmpty else {
-            throw SVGRenderError.invalidDocument("Input data is empty")
+    /// Renders a document parsed earlier; only styling, layout and painting run again.
+    public func render(document: SVGDocument, options: SVGRenderOptions) async throws -> UIImage {
+        let core = self.core
+        return try await Self.renderOffCooperativePool {
+            try SVGCoreBridge.render(document: document, options: options, renderer: core)
         }
-        return try SVGCoreBridge.render(svgData: svgData, options: options)
     }
 
-    private func preflightExternalResourcesIfNeeded(svgData: Data, options: SVGRenderOptions) async throws {
-        let urls = extractExternalURLs(from: svgData)
-        guard !urls.isEmpty else {
-            return
-        }
-
-        if !options.enableExternalResources {
-            if let blocked = urls.first(where: { $0.scheme?.hasPrefix("http") == true }) {
-                throw SVGRenderError.externalResourceBlocked(blocked)
-            }
-            return
-        }
-
-        guard let loader else {
-            if let blocked = urls.first(where: { $0.scheme?.hasPrefix("http") == true }) {
-                throw SVGRenderError.externalResourceBlocked(blocked)
-            }
-            return
-        }
-
-        for url in urls {
-            let request = SVGExternalResourceRequest(url: url, purpose: inferPurpose(for: url))
-            do {
-                _ = try await loader.loadResource(request)
-            } catch {
-                throw SVGRenderError.externalResourceFailed(url, error.localizedDescription)
-            }
+    public static func renderSync(svgData: Data, options: SVGRenderOptions) throws -> UIImage {
+        guard !svgData.isEmpty else {
+            throw SVGRenderError.invalidDocument("Input data is empty")
         }
+        return try SVGCoreBridge.render(svgData: svgData, options: options, renderer: sharedCore)
     }
 
-    private func extractExternalURLs(from svgData: Data) -> [URL] {
-        guard let text = String(data: svgData, encoding: .utf8) else {
-            return []
-        }
-
-        let pattern = #"(?:href|xlink:href)\s*=\s*"([^"]+)""#
-        guard let regex = try? NSRegularExpression(pattern: pattern) else {
-            return []
-        }
-
-        let range = NSRange(text.startIndex..<text.endIndex, in: text)
-        return regex.matches(in: text, options: [], range: range).compactMap { match in
-            guard let hrefRange = Range(match.range(at: 1), in: text) else {
-                return nil
-            }
-            let value = String(text[hrefRange])
-            if value.hasPrefix("#") {
-                return nil
+    /// The core blocks its thread while the loader fetches, so renders run on a
+    /// dispatch queue instead of tying up a cooperative-pool thread.
+    private static func renderOffCooperativePool(
+        _ body: @escaping @Sendable () throws -> UIImage
+    ) async throws -> UIImage {
+        try await withCheckedThrowingContinuation { continuation in
+            DispatchQueue.global(qos: .userInitiated).async {
+                continuation.resume(with: Result { try body() })
             }
-            return URL(string: value)
-        }
-    }
-
-    private func inferPurpose(for url: URL) -> SVGExternalResourceRequest.Purpose {
-        let ext = url.pathExtension.lowercased()
-        if ["png", "jpg", "jpeg", "gif", "webp", "svg"].contains(ext) {
-            return .image
-        }
-        if ext == "css" {
-            return .stylesheet
-        }
-        if ["ttf", "otf", "woff", "woff2"].contains(ext) {
-            return .font
         }
-        return .other
     }
 
     private func rewriteRelativeResourceReferences(in svgData: Data, relativeTo baseDirectoryURL: URL) -> Data {
@@ -0,0 +1,33 @@
+import Foundation
+import YepSVGCBridge
+
+/// CSS compiled once and shared by every render it is attached to.
+///
+/// Instances are immutable and safe to use from any thread.
+public final class SVGStylesheet: @unchecked Sendable {
+    public enum Origin: Sendable {
+        /// Loses to presentation attributes, like a browser's default styles.
+        case userAgent
+        /// Applies before the document's own `<style>` blocks.
+        case author
+    }
+
+    public let origin: Origin
+    let handle: OpaquePointer
+
+    public init(css: String, origin: Origin = .author) throws {
+        let cOrigin = origin == .userAgent ? CSVG_STYLESHEET_USER_AGENT : CSVG_STYLESHEET_AUTHOR
+        let created = css.withCString { cString in
+            csvg_stylesheet_create(cString, strlen(cString), cOrigin)
+        }
+        guard let created else {
+            throw SVGRenderError.renderFailed("Failed to compile stylesheet")
+        }
+        self.origin = origin
+        self.handle = created
+    }
+
+    deinit {
+        csvg_stylesheet_destroy(handle)
+    }
+}
@@ -0,0 +1,41 @@
+import Foundation
+import YepSVGCBridge
+
+/// Render-time recoloring, applied while styles are resolved.
+///
+/// Color values accept any SVG color syntax (`"red"`, `"#f00"`, `"rgb(255,0,0)"`).
+/// Instances are immutable and safe to share across renders.
+public final class SVGTheme: @unchecked Sendable {
+    let handle: OpaquePointer
+
+    /// - Parameters:
+    ///   - currentColor: Value every `currentColor` resolves to.
+    ///   - colorOverrides: Maps document colors to replacements, compared after parsing.
+    ///   - customProperties: Values for `var(--name)`; keys may omit the leading `--`.
+    public init(
+        currentColor: String? = nil,
+        colorOverrides: [String: String] = [:],
+        customProperties: [String: String] = [:]
+    ) throws {
+        guard let created = csvg_theme_create() else {
+            throw SVGRenderError.renderFailed("Failed to create theme")
+        }
+        self.handle = created
+
+        if let currentColor, !csvg_theme_set_current_color(handle, currentColor) {
+            throw SVGRenderError.invalidDocument("Invalid theme currentColor: \(currentColor)")
+        }
+        for (from, to) in colorOverrides {
+            guard csvg_theme_map_color(handle, from, to) else {
+                throw SVGRenderError.invalidDocument("Invalid theme color override: \(from) -> \(to)")
+            }
+        }
+        for (name, value) in customProperties {
+            csvg_theme_set_custom_property(handle, name, value)
+        }
+    }
+
+    deinit {
+        csvg_theme_destroy(handle)
+    }
+}
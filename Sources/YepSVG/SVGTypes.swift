@@ -8,6 +8,8 @@ public struct SVGRenderOptions: @unchecked Sendable {
     public var defaultFontFamily: String
     public var defaultFontSize: CGFloat
     public var enableExternalResources: Bool
+    public var stylesheets: [SVGStylesheet]
+    public var theme: SVGTheme?
 
     public init(
         viewportSize: CGSize? = nil,
@@ -15,7 +17,9 @@ public struct SVGRenderOptions: @unchecked Sendable {
         backgroundColor: CGColor? = nil,
         defaultFontFamily: String = "Helvetica",
         defaultFontSize: CGFloat = 16,
-        enableExternalResources: Bool = false
+        enableExternalResources: Bool = false,
+        stylesheets: [SVGStylesheet] = [],
+        theme: SVGTheme? = nil
     ) {
         self.viewportSize = viewportSize
         self.scale = scale
@@ -23,6 +27,8 @@ public struct SVGRenderOptions: @unchecked Sendable {
         self.defaultFontFamily = defaultFontFamily
         self.defaultFontSize = defaultFontSize
         self.enableExternalResources = enableExternalResources
+        self.stylesheets = stylesheets
+        self.theme = theme
     }
 
     public static let `default` = SVGRenderOptions()
@@ -1,16 +1,57 @@
 #include "YepSVGCBridge/chromium_svg_c_bridge.h"
 
 #include <cstring>
+#include <initializer_list>
 #include <memory>
+#include <mutex>
 #include <new>
 #include <string>
 
+#include <vector>
+
+#include "YepSVGCore/ElementBounds.hpp"
 #include "YepSVGCore/Engine.hpp"
+#include "YepSVGCore/HitTest.hpp"
+#include "YepSVGCore/LayoutEngine.hpp"
+#include "YepSVGCore/RenderCache.hpp"
+#include "YepSVGCore/Stylesheet.hpp"
+#include "YepSVGCore/Theme.hpp"
 
 struct csvg_renderer {
     csvg::Engine engine;
-    csvg_external_resource_loader_t loader = nullptr;
-    void* loader_context = nullptr;
+    // Guards the stylesheets and cache below, which may change while renders run.
+    mutable std::mutex config_mutex;
+    std::vector<std::shared_ptr<const csvg::Stylesheet>> stylesheets;
+    // Source fingerprints of |stylesheets|, in the same order.
+    std::vector<csvg::RenderCacheKey> stylesheet_fingerprints;
+    std::shared_ptr<csvg::RenderCache> cache;
+    // Pixel buffer passed from one render to the next; a render running
+    // concurrently on the same renderer allocates its own.
+    std::mutex spare_image_mutex;
+    csvg::ImageBuffer spare_image;
+};
+
+struct csvg_stylesheet {
+    std::shared_ptr<const csvg::Stylesheet> compiled;
+    csvg::RenderCacheKey fingerprint;
+};
+
+struct csvg_document {
+    std::unique_ptr<csvg::Document> parsed;
+    // Built on the first query and rebuilt when the layout changes.
+    mutable std::mutex query_mutex;
+    mutable std::shared_ptr<const csvg::HitTestIndex> hit_test_index;
+    mutable std::shared_ptr<const csvg::ElementBoundsIndex> bounds_index;
+};
+
+struct csvg_theme {
+    std::shared_ptr<csvg::Theme> theme = std::make_shared<csvg::Theme>();
+    // Every accepted setter call, for render cache keys.
+    std::string recipe;
+};
+
+struct csvg_render_cache {
+    std::shared_ptr<csvg::RenderCache> cache;
 };
 
 namespace {
@@ -63,9 +104,231 @@ csvg::RenderOptions ToCoreOptions(const csvg_render_options_t* options) {
     }
     core.default_font_size = options->default_font_size > 0.0f ? options->default_font_size : 16.0f;
     core.enable_external_resources = options->enable_external_resources;
+    if (options->theme != nullptr) {
+        core.theme = options->theme->theme;
+    }
+    if (options->stylesheets != nullptr) {
+        for (size_t i = 0; i < options->stylesheet_count; ++i) {
+            const csvg_stylesheet_t* stylesheet = options->stylesheets[i];
+            if (stylesheet != nullptr && stylesheet->compiled != nullptr) {
+                core.stylesheets.push_back(stylesheet->compiled);
+            }
+        }
+    }
     return core;
 }
 
+// The renderer's configuration as one render sees it, copied at its start.
+struct RendererSnapshot {
+    std::vector<std::shared_ptr<const csvg::Stylesheet>> stylesheets;
+    std::vector<csvg::RenderCacheKey> stylesheet_fingerprints;
+    std::shared_ptr<csvg::RenderCache> cache;
+};
+
+RendererSnapshot SnapshotOf(const csvg_renderer_t* renderer) {
+    std::lock_guard<std::mutex> lock(renderer->config_mutex);
+    return RendererSnapshot{renderer->stylesheets, renderer->stylesheet_fingerprints, renderer->cache};
+}
+
+// The renderer's attached stylesheets followed by the render's own.
+csvg::RenderOptions CoreOptionsFor(const RendererSnapshot& snapshot, const csvg_render_options_t* options) {
+    csvg::RenderOptions core = ToCoreOptions(options);
+    core.stylesheets.insert(core.stylesheets.begin(), snapshot.stylesheets.begin(), snapshot.stylesheets.end());
+    return core;
+}
+
+csvg::ResourceLoader WrapResourceLoader(csvg_external_resource_loader_t loader, void* context) {
+    if (loader == nullptr) {
+        return {};
+    }
+    return [loader, context](const csvg::ResourceRequest& request, std::vector<uint8_t>& out_data, std::string& out_error) {
+        csvg_external_resource_request_t c_request;
+        c_request.url = request.url.c_str();
+        c_request.purpose = static_cast<csvg_external_resource_purpose_t>(request.purpose);
+
+        uint8_t* data = nullptr;
+        size_t size = 0;
+        char* message = nullptr;
+        const bool loaded = loader(context, &c_request, &data, &size, &message) == 1 && (data != nullptr || size == 0);
+        if (loaded) {
+            out_data.assign(data, data + size);
+        } else {
+            out_error = message != nullptr ? message : "Loader failed";
+        }
+        std::free(data);
+        std::free(message);
+        return loaded;
+    };
+}
+
+void AppendRecipe(std::string& recipe, char operation, std::initializer_list<const char*> arguments) {
+    recipe += operation;
+    for (const char* argument : arguments) {
+        recipe += argument;
+        recipe += '\0';
+    }
+}
+
+// Covers everything that decides the pixels of csvg_renderer_render except
+// the loader, which is why renders with external resources bypass the cache.
+csvg::RenderCacheKey RenderCacheKeyFor(const RendererSnapshot& snapshot,
+                                       const uint8_t* svg_bytes,
+                                       size_t svg_size,
+                                       const csvg_render_options_t* options,
+                                       const csvg::RenderOptions& core_options) {
+    csvg::RenderFingerprint fingerprint;
+    fingerprint.AddValue(csvg::kRenderOutputVersion);
+    fingerprint.AddValue(core_options.viewport_width);
+    fingerprint.AddValue(core_options.viewport_height);
+    fingerprint.AddValue(core_options.scale);
+    fingerprint.AddValue(core_options.background_red);
+    fingerprint.AddValue(core_options.background_green);
+    fingerprint.AddValue(core_options.background_blue);
+    fingerprint.AddValue(core_options.background_alpha);
+    fingerprint.AddString(core_options.default_font_family);
+    fingerprint.AddValue(core_options.default_font_size);
+    fingerprint.AddValue(core_options.enable_external_resources);
+    fingerprint.AddString(options != nullptr && options->theme != nullptr ? options->theme->recipe : std::string());
+    fingerprint.AddValue(static_cast<uint64_t>(core_options.stylesheets.size()));
+    for (const auto& sheet : snapshot.stylesheet_fingerprints) {
+        fingerprint.AddValue(sheet.high);
+        fingerprint.AddValue(sheet.low);
+    }
+    if (options != nullptr && options->stylesheets != nullptr) {
+        for (size_t i = 0; i < options->stylesheet_count; ++i) {
+            const csvg_stylesheet_t* stylesheet = options->stylesheets[i];
+            if (stylesheet != nullptr && stylesheet->compiled != nullptr) {
+                fingerprint.AddValue(stylesheet->fingerprint.high);
+                fingerprint.AddValue(stylesheet->fingerprint.low);
+            }
+        }
+    }
+    fingerprint.AddValue(static_cast<uint64_t>(svg_size));
+    fingerprint.Add(svg_bytes, svg_size);
+    return fingerprint.Finish();
+}
+
+// Larger output buffers are freed after the render rather than kept.
+constexpr size_t kMaxSpareImageBytes = 64u * 1024u * 1024u;
+
+csvg::ImageBuffer TakeSpareImage(csvg_renderer_t* renderer) {
+    std::lock_guard<std::mutex> lock(renderer->spare_image_mutex);
+    return std::move(renderer->spare_image);
+}
+
+void ReturnSpareImage(csvg_renderer_t* renderer, csvg::ImageBuffer image) {
+    if (image.rgba.capacity() > kMaxSpareImageBytes) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(renderer->spare_image_mutex);
+    if (image.rgba.capacity() > renderer->spare_image.rgba.capacity()) {
+        renderer->spare_image = std::move(image);
+    }
+}
+
+void ResetResult(csvg_render_result_t* out_result) {
+    out_result->width = 0;
+    out_result->height = 0;
+    out_result->rgba = nullptr;
+    out_result->rgba_size = 0;
+    out_result->error_code = CSVG_ERROR_NONE;
+    out_result->error_message = nullptr;
+}
+
+int32_t WritePixels(int32_t width,
+                    int32_t height,
+                    const uint8_t* rgba,
+                    size_t rgba_size,
+                    csvg_render_result_t* out_result) {
+    out_result->width = width;
+    out_result->height = height;
+    out_result->rgba_size = rgba_size;
+    out_result->rgba = static_cast<uint8_t*>(std::malloc(out_result->rgba_size));
+    if (out_result->rgba == nullptr) {
+        out_result->error_code = CSVG_ERROR_RENDER_FAILED;
+        out_result->error_message = CopyCString("Failed to allocate output pixel buffer");
+        return 0;
+    }
+
+    std::memcpy(out_result->rgba, rgba, out_result->rgba_size);
+    return 1;
+}
+
+int32_t WriteResult(bool rendered,
+                    const csvg::ImageBuffer& image,
+                    const csvg::RenderError& error,
+                    csvg_render_result_t* out_result) {
+    if (!rendered) {
+        out_result->error_code = ToBridgeCode(error.code);
+        out_result->error_message = CopyCString(error.message.empty() ? "Unknown render failure" : error.message);
+        return 0;
+    }
+    return WritePixels(image.width, image.height, image.rgba.data(), image.rgba.size(), out_result);
+}
+
+int32_t RenderToResult(csvg_renderer_t* renderer,
+                       const uint8_t* svg_bytes,
+                       size_t svg_size,
+                       const csvg_render_options_t* options,
+                       csvg_render_result_t* out_result,
+                       csvg::PaintProfile* profile) {
+    if (renderer == nullptr || svg_bytes == nullptr || svg_size == 0 || out_result == nullptr) {
+        return 0;
+    }
+    ResetResult(out_result);
+
+    const RendererSnapshot snapshot = SnapshotOf(renderer);
+    csvg::RenderOptions core_options = CoreOptionsFor(snapshot, options);
+
+    // Profiles need a real paint, and remote content can change between runs.
+    const bool use_cache = snapshot.cache != nullptr && profile == nullptr && !core_options.enable_external_resources;
+    csvg::RenderCacheKey cache_key;
+    if (use_cache) {
+        cache_key = RenderCacheKeyFor(snapshot, svg_bytes, svg_size, options, core_options);
+        if (const auto hit = snapshot.cache->Lookup(cache_key)) {
+            return WritePixels(hit->width(), hit->height(), hit->rgba(), hit->rgba_size(), out_result);
+        }
+    }
+
+    const std::string svg_text(reinterpret_cast<const char*>(svg_bytes), svg_size);
+    csvg::ImageBuffer image = TakeSpareImage(renderer);
+    csvg::RenderError error;
+    const bool rendered = renderer->engine.Render(svg_text, core_options, image, error, profile);
+    if (rendered && use_cache) {
+        snapshot.cache->Store(cache_key, image);
+    }
+    const int32_t status = WriteResult(rendered, image, error, out_result);
+    ReturnSpareImage(renderer, std::move(image));
+    return status;
+}
+
+std::shared_ptr<const csvg::HitTestIndex> HitTestIndexFor(const csvg_document_t* document,
+                                                          const csvg::RenderOptions& options) {
+    std::lock_guard<std::mutex> lock(document->query_mutex);
+    if (document->hit_test_index == nullptr || !document->hit_test_index->Matches(options)) {
+        csvg::RenderError error;
+        document->hit_test_index = csvg::HitTestIndex::Build(*document->parsed, options, error);
+    }
+    return document->hit_test_index;
+}
+
+std::shared_ptr<const csvg::ElementBoundsIndex> BoundsIndexFor(const csvg_document_t* document,
+                                                               const csvg::RenderOptions& options) {
+    std::lock_guard<std::mutex> lock(document->query_mutex);
+    if (document->bounds_index == nullptr || !document->bounds_index->Matches(options)) {
+        csvg::RenderError error;
+        document->bounds_index = csvg::ElementBoundsIndex::Build(*document->parsed, options, error);
+    }
+    return document->bounds_index;
+}
+
+csvg_rect_t ToBridgeRect(const csvg::BoundingBox& box) {
+    return csvg_rect_t{static_cast<float>(box.x),
+                       static_cast<float>(box.y),
+                       static_cast<float>(box.width),
+                       static_cast<float>(box.height)};
+}
+
 } // namespace
 
 csvg_renderer_t* csvg_renderer_create(void) {
@@ -82,8 +345,162 @@ void csvg_renderer_set_external_resource_loader(csvg_renderer_t* renderer,
     if (renderer == nullptr) {
         return;
     }
-    renderer->loader = loader;
-    renderer->loader_context = context;
+    renderer->engine.SetResourceLoader(WrapResourceLoader(loader, context));
+}
+
+csvg_render_cache_t* csvg_render_cache_create(const char* directory, uint64_t max_bytes) {
+    if (directory == nullptr) {
+        return nullptr;
+    }
+    csvg::RenderError error;
+    auto opened = csvg::RenderCache::Open(directory, max_bytes, error);
+    if (opened == nullptr) {
+        return nullptr;
+    }
+    auto* cache = new (std::nothrow) csvg_render_cache_t();
+    if (cache != nullptr) {
+        cache->cache = std::move(opened);
+    }
+    return cache;
+}
+
+void csvg_render_cache_destroy(csvg_render_cache_t* cache) {
+    delete cache;
+}
+
+void csvg_renderer_set_render_cache(csvg_renderer_t* renderer, const csvg_render_cache_t* cache) {
+    if (renderer == nullptr) {
+        return;
+    }
+    // Renders already running keep their own reference to the old cache.
+    std::lock_guard<std::mutex> lock(renderer->config_mutex);
+    renderer->cache = cache != nullptr ? cache->cache : nullptr;
+}
+
+csvg_stylesheet_t* csvg_stylesheet_create(const char* css,
+                                          size_t css_size,
+                                          csvg_stylesheet_origin_t origin) {
+    if (css == nullptr && css_size > 0) {
+        return nullptr;
+    }
+    auto* stylesheet = new (std::nothrow) csvg_stylesheet_t();
+    if (stylesheet == nullptr) {
+        return nullptr;
+    }
+    const std::string css_text = css != nullptr ? std::string(css, css_size) : std::string();
+    const auto core_origin = origin == CSVG_STYLESHEET_USER_AGENT ? csvg::StylesheetOrigin::kUserAgent : csvg::StylesheetOrigin::kAuthor;
+    stylesheet->compiled = csvg::Stylesheet::Compile(css_text, core_origin);
+    csvg::RenderFingerprint fingerprint;
+    fingerprint.AddValue(core_origin);
+    fingerprint.AddString(css_text);
+    stylesheet->fingerprint = fingerprint.Finish();
+    return stylesheet;
+}
+
+void csvg_stylesheet_destroy(csvg_stylesheet_t* stylesheet) {
+    delete stylesheet;
+}
+
+void csvg_renderer_attach_stylesheet(csvg_renderer_t* renderer, const csvg_stylesheet_t* stylesheet) {
+    if (renderer == nullptr || stylesheet == nullptr || stylesheet->compiled == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(renderer->config_mutex);
+    renderer->stylesheets.push_back(stylesheet->compiled);
+    renderer->stylesheet_fingerprints.push_back(stylesheet->fingerprint);
+}
+
+void csvg_renderer_clear_stylesheets(csvg_renderer_t* renderer) {
+    if (renderer == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(renderer->config_mutex);
+    renderer->stylesheets.clear();
+    renderer->stylesheet_fingerprints.clear();
+}
+
+csvg_theme_t* csvg_theme_create(void) {
+    return new (std::nothrow) csvg_theme_t();
+}
+
+void csvg_theme_destroy(csvg_theme_t* theme) {
+    delete theme;
+}
+
+bool csvg_theme_set_current_color(csvg_theme_t* theme, const char* color) {
+    if (theme == nullptr || color == nullptr) {
+        return false;
+    }
+    if (!theme->theme->SetCurrentColor(color)) {
+        return false;
+    }
+    AppendRecipe(theme->recipe, 'c', {color});
+    return true;
+}
+
+bool csvg_theme_map_color(csvg_theme_t* theme, const char* from, const char* to) {
+    if (theme == nullptr || from == nullptr || to == nullptr) {
+        return false;
+    }
+    if (!theme->theme->MapColor(from, to)) {
+        return false;
+    }
+    AppendRecipe(theme->recipe, 'm', {from, to});
+    return true;
+}
+
+void csvg_theme_set_custom_property(csvg_theme_t* theme, const char* name, const char* value) {
+    if (theme == nullptr || name == nullptr || value == nullptr) {
+        return;
+    }
+    theme->theme->SetCustomProperty(name, value);
+    AppendRecipe(theme->recipe, 'p', {name, value});
+}
+
+csvg_document_t* csvg_document_create(const uint8_t* svg_bytes,
+                                      size_t svg_size,
+                                      csvg_error_code_t* out_error_code,
+                                      char** out_error_message) {
+    if (out_error_code != nullptr) {
+        *out_error_code = CSVG_ERROR_NONE;
+    }
+    if (out_error_message != nullptr) {
+        *out_error_message = nullptr;
+    }
+
+    csvg::RenderError error;
+    std::unique_ptr<csvg::Document> parsed;
+    if (svg_bytes == nullptr || svg_size == 0) {
+        error.code = csvg::RenderErrorCode::kInvalidDocument;
+        error.message = "Empty SVG input";
+    } else {
+        const std::string svg_text(reinterpret_cast<const char*>(svg_bytes), svg_size);
+        // The hierarchy is built on the first render that brings stylesheets.
+        parsed = csvg::Document::Parse(svg_text, false, error);
+    }
+
+    csvg_document_t* document = nullptr;
+    if (parsed != nullptr) {
+        document = new (std::nothrow) csvg_document_t();
+        if (document != nullptr) {
+            document->parsed = std::move(parsed);
+            return document;
+        }
+        error.code = csvg::RenderErrorCode::kRenderFailed;
+        error.message = "Failed to allocate document";
+    }
+
+    if (out_error_code != nullptr) {
+        *out_error_code = ToBridgeCode(error.code);
+    }
+    if (out_error_message != nullptr) {
+        *out_error_message = CopyCString(error.message.empty() ? "Unknown parse failure" : error.message);
+    }
+    return nullptr;
+}
+
+void csvg_document_destroy(csvg_document_t* document) {
+    delete document;
 }
 
 void csvg_render_options_init_default(csvg_render_options_t* out_options) {
@@ -103,6 +520,130 @@ void csvg_render_options_init_default(csvg_render_options_t* out_options) {
     out_options->default_font_family = "Helvetica";
     out_options->default_font_size = 16.0f;
     out_options->enable_external_resources = false;
+    out_options->theme = nullptr;
+    out_options->stylesheets = nullptr;
+    out_options->stylesheet_count = 0;
+}
+
+void csvg_hit_test_options_init_default(csvg_hit_test_options_t* out_options) {
+    if (out_options == nullptr) {
+        return;
+    }
+
+    out_options->render_options = nullptr;
+    out_options->tolerance = 0.0f;
+    out_options->collect_all = false;
+}
+
+int32_t csvg_document_hit_test(const csvg_document_t* document,
+                               float x,
+                               float y,
+                               const csvg_hit_test_options_t* options,
+                               csvg_hit_test_result_t* out_result) {
+    if (document == nullptr || document->parsed == nullptr || out_result == nullptr) {
+        return 0;
+    }
+    out_result->id = nullptr;
+    out_result->all_ids = nullptr;
+    out_result->all_count = 0;
+
+    csvg_render_options_t default_options;
+    csvg_render_options_init_default(&default_options);
+    const csvg_render_options_t* render_options = &default_options;
+    csvg::HitTestQuery query;
+    if (options != nullptr) {
+        if (options->render_options != nullptr) {
+            render_options = options->render_options;
+        }
+        query.tolerance = options->tolerance;
+        query.collect_all = options->collect_all;
+    }
+
+    const auto index = HitTestIndexFor(document, ToCoreOptions(render_options));
+    if (index == nullptr) {
+        return 0;
+    }
+    const std::vector<std::string> hits = index->HitTest(x, y, query);
+    if (hits.empty()) {
+        return 0;
+    }
+
+    out_result->id = CopyCString(hits.front());
+    if (query.collect_all) {
+        out_result->all_ids = static_cast<char**>(std::calloc(hits.size(), sizeof(char*)));
+        if (out_result->all_ids != nullptr) {
+            out_result->all_count = hits.size();
+            for (size_t i = 0; i < hits.size(); ++i) {
+                out_result->all_ids[i] = CopyCString(hits[i]);
+            }
+        }
+    }
+    return 1;
+}
+
+void csvg_hit_test_result_free(csvg_hit_test_result_t* result) {
+    if (result == nullptr) {
+        return;
+    }
+
+    std::free(result->id);
+    result->id = nullptr;
+    for (size_t i = 0; i < result->all_count; ++i) {
+        std::free(result->all_ids[i]);
+    }
+    std::free(result->all_ids);
+    result->all_ids = nullptr;
+    result->all_count = 0;
+}
+
+bool csvg_document_get_size(const csvg_document_t* document,
+                            const csvg_render_options_t* options,
+                            int32_t* out_width,
+                            int32_t* out_height) {
+    if (document == nullptr || document->parsed == nullptr) {
+        return false;
+    }
+    csvg_render_options_t default_options;
+    csvg_render_options_init_default(&default_options);
+
+    csvg::RenderError error;
+    const auto layout = csvg::LayoutEngine().Compute(document->parsed->svg(),
+                                                     ToCoreOptions(options != nullptr ? options : &default_options),
+                                                     error);
+    if (!layout.has_value()) {
+        return false;
+    }
+    if (out_width != nullptr) {
+        *out_width = layout->width;
+    }
+    if (out_height != nullptr) {
+        *out_height = layout->height;
+    }
+    return true;
+}
+
+bool csvg_document_get_element_bounds(const csvg_document_t* document,
+                                      const char* id,
+                                      const csvg_render_options_t* options,
+                                      csvg_element_bounds_t* out_bounds) {
+    if (document == nullptr || document->parsed == nullptr || id == nullptr || out_bounds == nullptr) {
+        return false;
+    }
+    csvg_render_options_t default_options;
+    csvg_render_options_init_default(&default_options);
+
+    const auto index = BoundsIndexFor(document, ToCoreOptions(options != nullptr ? options : &default_options));
+    if (index == nullptr) {
+        return false;
+    }
+    const csvg::ElementBounds* bounds = index->Find(id);
+    if (bounds == nullptr) {
+        return false;
+    }
+    out_bounds->fill = ToBridgeRect(bounds->fill);
+    out_bounds->stroke = ToBridgeRect(bounds->stroke);
+    out_bounds->device = ToBridgeRect(bounds->device);
+    return true;
 }
 
 int32_t csvg_renderer_render(csvg_renderer_t* renderer,
@@ -110,39 +651,46 @@ int32_t csvg_renderer_render(csvg_renderer_t* renderer,
                              size_t svg_size,
                              const csvg_render_options_t* options,
                              csvg_render_result_t* out_result) {
-    if (renderer == nullptr || svg_bytes == nullptr || svg_size == 0 || out_result == nullptr) {
-        return 0;
-    }
-
-    out_result->width = 0;
-    out_result->height = 0;
-    out_result->rgba = nullptr;
-    out_result->rgba_size = 0;
-    out_result->error_code = CSVG_ERROR_NONE;
-    out_result->error_message = nullptr;
+    return RenderToResult(renderer, svg_bytes, svg_size, options, out_result, nullptr);
+}
 
-    const std::string svg_text(reinterpret_cast<const char*>(svg_bytes), svg_size);
+int32_t csvg_renderer_render_with_profile(csvg_renderer_t* renderer,
+                                          const uint8_t* svg_bytes,
+                                          size_t svg_size,
+                                          const csvg_render_options_t* options,
+                                          csvg_render_result_t* out_result,
+                                          char** out_profile_json) {
+    if (out_profile_json != nullptr) {
+        *out_profile_json = nullptr;
+    }
 
-    csvg::ImageBuffer image;
-    csvg::RenderError error;
-    if (!renderer->engine.Render(svg_text, ToCoreOptions(options), image, error)) {
-        out_result->error_code = ToBridgeCode(error.code);
-        out_result->error_message = CopyCString(error.message.empty() ? "Unknown render failure" : error.message);
-        return 0;
+    // Paint() resets the profile, so a negative time means painting never started.
+    csvg::PaintProfile profile;
+    profile.paint_ms = -1.0;
+    const int32_t status = RenderToResult(renderer, svg_bytes, svg_size, options, out_result, &profile);
+    if (out_profile_json != nullptr && profile.paint_ms >= 0.0) {
+        *out_profile_json = CopyCString(csvg::SerializePaintProfileJson(profile));
     }
+    return status;
+}
 
-    out_result->width = image.width;
-    out_result->height = image.height;
-    out_result->rgba_size = image.rgba.size();
-    out_result->rgba = static_cast<uint8_t*>(std::malloc(out_result->rgba_size));
-    if (out_result->rgba == nullptr) {
-        out_result->error_code = CSVG_ERROR_RENDER_FAILED;
-        out_result->error_message = CopyCString("Failed to allocate output pixel buffer");
+int32_t csvg_renderer_render_document(csvg_renderer_t* renderer,
+                                      const csvg_document_t* document,
+                                      const csvg_render_options_t* options,
+                                      csvg_render_result_t* out_result) {
+    if (renderer == nullptr || document == nullptr || document->parsed == nullptr || out_result == nullptr) {
         return 0;
     }
+    ResetResult(out_result);
 
-    std::memcpy(out_result->rgba, image.rgba.data(), out_result->rgba_size);
-    return 1;
+    csvg::RenderOptions core_options = CoreOptionsFor(SnapshotOf(renderer), options);
+
+    csvg::ImageBuffer image = TakeSpareImage(renderer);
+    csvg::RenderError error;
+    const bool rendered = renderer->engine.Render(*document->parsed, core_options, image, error);
+    const int32_t status = WriteResult(rendered, image, error, out_result);
+    ReturnSpareImage(renderer, std::move(image));
+    return status;
 }
 
 void csvg_render_result_free(csvg_render_result_t* result) {
@@ -10,6 +10,10 @@ extern "C" {
 #endif
 
 typedef struct csvg_renderer csvg_renderer_t;
+typedef struct csvg_stylesheet csvg_stylesheet_t;
+typedef struct csvg_document csvg_document_t;
+typedef struct csvg_theme csvg_theme_t;
+typedef struct csvg_render_cache csvg_render_cache_t;
 
 typedef enum csvg_error_code {
     CSVG_ERROR_NONE = 0,
@@ -27,11 +31,20 @@ typedef enum csvg_external_resource_purpose {
     CSVG_RESOURCE_OTHER = 3,
 } csvg_external_resource_purpose_t;
 
+typedef enum csvg_stylesheet_origin {
+    CSVG_STYLESHEET_USER_AGENT = 0,
+    CSVG_STYLESHEET_AUTHOR = 1,
+} csvg_stylesheet_origin_t;
+
 typedef struct csvg_external_resource_request {
     const char* url;
     csvg_external_resource_purpose_t purpose;
 } csvg_external_resource_request_t;
 
+// Fetches one remote resource. Return 1 and set |out_data| to a malloc'd
+// buffer of |out_size| bytes, which the renderer frees; or return 0 and
+// optionally set |out_error_message| to a malloc'd string. Called from
+// several threads at once during a render, so it must be thread-safe.
 typedef int32_t (*csvg_external_resource_loader_t)(void* context,
                                                    const csvg_external_resource_request_t* request,
                                                    uint8_t** out_data,
@@ -51,8 +64,55 @@ typedef struct csvg_render_options {
     const char* default_font_family;
     float default_font_size;
     bool enable_external_resources;
+
+    // Optional; NULL renders the document's own colors.
+    const csvg_theme_t* theme;
+
+    // Optional; cascaded after the renderer's attached stylesheets, for this
+    // render only. Lets one long-lived renderer serve callers whose sheets differ.
+    const csvg_stylesheet_t* const* stylesheets;
+    size_t stylesheet_count;
 } csvg_render_options_t;
 
+typedef struct csvg_hit_test_options {
+    // Layout to hit-test against, as passed to csvg_renderer_render_document;
+    // points are pixels of that render. NULL uses the default options.
+    const csvg_render_options_t* render_options;
+    // Extra reach in device pixels around every shape, for touch input.
+    float tolerance;
+    // Report every element under the point, not only the topmost.
+    bool collect_all;
+} csvg_hit_test_options_t;
+
+typedef struct csvg_hit_test_result {
+    // Id of the topmost element hit, or NULL on a miss. Elements without an
+    // id report their nearest ancestor's, and content drawn through <use>
+    // reports the <use>; an empty string means no id was found.
+    char* id;
+    // With collect_all, every distinct id hit, topmost first.
+    char** all_ids;
+    size_t all_count;
+} csvg_hit_test_result_t;
+
+typedef struct csvg_rect {
+    float x;
+    float y;
+    float width;
+    float height;
+} csvg_rect_t;
+
+typedef struct csvg_element_bounds {
+    // Geometry of the element and its descendants in the element's own user
+    // space, like SVG's getBBox(). Zero for elements without geometry.
+    csvg_rect_t fill;
+    // |fill| grown by half the stroke width of every stroked shape; joins,
+    // caps and markers are not included.
+    csvg_rect_t stroke;
+    // The stroked geometry in pixels of the render made with the same
+    // options, before clipping.
+    csvg_rect_t device;
+} csvg_element_bounds_t;
+
 typedef struct csvg_render_result {
     int32_t width;
     int32_t height;
@@ -63,14 +123,108 @@ typedef struct csvg_render_result {
     char* error_message;
 } csvg_render_result_t;
 
+// Renders may run on several threads at once. Parsed stylesheets, shaped
+// text, glyph masks, decoded images and scratch buffers persist between
+// renders, so keep one renderer for as long as there is rendering to do.
 csvg_renderer_t* csvg_renderer_create(void);
 void csvg_renderer_destroy(csvg_renderer_t* renderer);
 
+// Remote (http/https) hrefs are fetched through |loader| when
+// enable_external_resources is set, and blocked otherwise or when no loader
+// is set. A render requests every distinct remote URL of the document
+// concurrently before painting and fails with
+// CSVG_ERROR_EXTERNAL_RESOURCE_FAILED if any request fails. Pass NULL to
+// remove the loader.
 void csvg_renderer_set_external_resource_loader(csvg_renderer_t* renderer,
                                                 csvg_external_resource_loader_t loader,
                                                 void* context);
 
+// Rendered pixels kept as raw files in |directory|, which is created if
+// missing and may be shared by renderers in several processes. Keys are
+// 128-bit fingerprints of the SVG bytes, every render option, the theme,
+// every stylesheet and the library's output version. The least
+// recently used renders are evicted once the directory holds more than
+// |max_bytes|. Returns NULL if the directory cannot be used.
+csvg_render_cache_t* csvg_render_cache_create(const char* directory, uint64_t max_bytes);
+void csvg_render_cache_destroy(csvg_render_cache_t* cache);
+
+// csvg_renderer_render looks the render up in |cache| before parsing and
+// stores what it renders. Profiled renders, retained documents and renders
+// with enable_external_resources bypass the cache. Local files a document
+// references are keyed by path, not content. The renderer keeps its own
+// reference; pass NULL to detach.
+void csvg_renderer_set_render_cache(csvg_renderer_t* renderer, const csvg_render_cache_t* cache);
+
+// Parses |css| once into an immutable stylesheet with a prebuilt selector
+// index. One stylesheet may be attached to any number of renderers, on any
+// thread. User-agent rules lose to presentation attributes; author rules
+// apply before the document's own <style> blocks.
+csvg_stylesheet_t* csvg_stylesheet_create(const char* css,
+                                          size_t css_size,
+                                          csvg_stylesheet_origin_t origin);
+void csvg_stylesheet_destroy(csvg_stylesheet_t* stylesheet);
+
+// The renderer keeps its own reference, so the stylesheet may be destroyed
+// once attached. Sheets cascade in attach order. Renders already running
+// keep the sheets they started with.
+void csvg_renderer_attach_stylesheet(csvg_renderer_t* renderer, const csvg_stylesheet_t* stylesheet);
+void csvg_renderer_clear_stylesheets(csvg_renderer_t* renderer);
+
+// Recoloring applied during style resolution. Configure a theme before its
+// first use; afterwards it may be shared by concurrent renders.
+csvg_theme_t* csvg_theme_create(void);
+void csvg_theme_destroy(csvg_theme_t* theme);
+// Every currentColor resolves to |color|. Returns false if it does not parse.
+bool csvg_theme_set_current_color(csvg_theme_t* theme, const char* color);
+// Paints colors equal to |from| (compared after parsing) as |to|.
+bool csvg_theme_map_color(csvg_theme_t* theme, const char* from, const char* to);
+// Value for var(--name); the leading "--" is optional.
+void csvg_theme_set_custom_property(csvg_theme_t* theme, const char* name, const char* value);
+
+// Parses and indexes an SVG once so it can be rendered many times. Returns
+// NULL on failure and reports why through the optional out parameters;
+// release *out_error_message with csvg_free_owned_memory.
+csvg_document_t* csvg_document_create(const uint8_t* svg_bytes,
+                                      size_t svg_size,
+                                      csvg_error_code_t* out_error_code,
+                                      char** out_error_message);
+void csvg_document_destroy(csvg_document_t* document);
+
 void csvg_render_options_init_default(csvg_render_options_t* out_options);
+void csvg_hit_test_options_init_default(csvg_hit_test_options_t* out_options);
+
+// Finds the elements under device point (x, y), honoring transforms, clip
+// paths, fill-rule, stroke width, display, visibility and pointer-events.
+// The first call for a layout compiles the document's geometry into a
+// spatial index kept on the document; later calls with the same layout only
+// query it. Stylesheets in the render options apply, as they do to the
+// render. Safe to call concurrently. Returns 1 when something was hit;
+// release the result with csvg_hit_test_result_free.
+int32_t csvg_document_hit_test(const csvg_document_t* document,
+                               float x,
+                               float y,
+                               const csvg_hit_test_options_t* options,
+                               csvg_hit_test_result_t* out_result);
+void csvg_hit_test_result_free(csvg_hit_test_result_t* result);
+
+// Pixel size csvg_renderer_render_document produces with |options|; NULL
+// options give the document's intrinsic size. Returns false when the
+// document has no valid size.
+bool csvg_document_get_size(const csvg_document_t* document,
+                            const csvg_render_options_t* options,
+                            int32_t* out_width,
+                            int32_t* out_height);
+
+// Bounding boxes of the element with |id| for the layout given by |options|
+// (NULL for defaults), including its stylesheets, computed from geometry
+// without rendering. Like hit
+// testing, the first call for a layout indexes every element with an id and
+// later calls are lookups. Safe to call concurrently. Returns false when no
+// displayed element has |id|; text has no geometry yet.
+bool csvg_document_get_element_bounds(const csvg_document_t* document,
+                                      const char* id,
+                                      const csvg_render_options_t* options,
+                                      csvg_element_bounds_t* out_bounds);
 
 int32_t csvg_renderer_render(csvg_renderer_t* renderer,
                              const uint8_t* svg_bytes,
@@ -78,6 +232,23 @@ int32_t csvg_renderer_render(csvg_renderer_t* renderer,
                              const csvg_render_options_t* options,
                              csvg_render_result_t* out_result);
 
+// Same as csvg_renderer_render, but also records per-element paint costs.
+// On return *out_profile_json holds a JSON report (or NULL if painting never
+// started); release it with csvg_free_owned_memory.
+int32_t csvg_renderer_render_with_profile(csvg_renderer_t* renderer,
+                                          const uint8_t* svg_bytes,
+                                          size_t svg_size,
+                                          const csvg_render_options_t* options,
+                                          csvg_render_result_t* out_result,
+                                          char** out_profile_json);
+
+// Renders a retained document without reparsing it. A document may be
+// rendered by several renderers concurrently.
+int32_t csvg_renderer_render_document(csvg_renderer_t* renderer,
+                                      const csvg_document_t* document,
+                                      const csvg_render_options_t* options,
+                                      csvg_render_result_t* out_result);
+
 void csvg_render_result_free(csvg_render_result_t* result);
 void csvg_free_owned_memory(void* memory);
 
@@ -0,0 +1,252 @@
+#include "YepSVGCore/AttributeValues.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+
+namespace csvg {
+namespace {
+
+bool IsSeparator(char c) {
+    return std::isspace(static_cast<unsigned char>(c)) || c == ',';
+}
+
+std::string_view TrimView(std::string_view value) {
+    while (!value.empty() && std::isspace(static_cast<unsigned char>(value.front()))) {
+        value.remove_prefix(1);
+    }
+    while (!value.empty() && std::isspace(static_cast<unsigned char>(value.back()))) {
+        value.remove_suffix(1);
+    }
+    return value;
+}
+
+std::string Lower(std::string_view value) {
+    std::string out(value);
+    for (auto& c : out) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return out;
+}
+
+LengthUnit ParseUnit(const std::string& unit) {
+    if (unit.empty()) {
+        return LengthUnit::kNone;
+    }
+    if (unit == "%") {
+        return LengthUnit::kPercent;
+    }
+    if (unit == "px") {
+        return LengthUnit::kPx;
+    }
+    if (unit == "pt") {
+        return LengthUnit::kPt;
+    }
+    if (unit == "pc") {
+        return LengthUnit::kPc;
+    }
+    if (unit == "in") {
+        return LengthUnit::kIn;
+    }
+    if (unit == "cm") {
+        return LengthUnit::kCm;
+    }
+    if (unit == "mm") {
+        return LengthUnit::kMm;
+    }
+    if (unit == "q") {
+        return LengthUnit::kQ;
+    }
+    return LengthUnit::kOther;
+}
+
+// strtod wants a terminated buffer; attribute values are short.
+bool ParseNumberAt(const std::string& text, size_t& cursor, double& out) {
+    const char* start = text.c_str() + cursor;
+    char* end_ptr = nullptr;
+    out = std::strtod(start, &end_ptr);
+    if (end_ptr == start) {
+        return false;
+    }
+    cursor = static_cast<size_t>(end_ptr - text.c_str());
+    return true;
+}
+
+} // namespace
+
+double PercentBasis(LengthAxis axis, double viewport_width, double viewport_height) {
+    switch (axis) {
+        case LengthAxis::kX:
+            return viewport_width > 0.0 ? viewport_width : 100.0;
+        case LengthAxis::kY:
+            return viewport_height > 0.0 ? viewport_height : 100.0;
+        case LengthAxis::kDiagonal:
+            if (viewport_width <= 0.0 || viewport_height <= 0.0) {
+                return 100.0;
+            }
+            return std::sqrt((viewport_width * viewport_width + viewport_height * viewport_height) / 2.0);
+    }
+    return 100.0;
+}
+
+double SvgLength::ToPixels(LengthAxis axis, double viewport_width, double viewport_height) const {
+    switch (unit) {
+        case LengthUnit::kPercent:
+            return (value / 100.0) * PercentBasis(axis, viewport_width, viewport_height);
+        case LengthUnit::kPt:
+            return value * (96.0 / 72.0);
+        case LengthUnit::kPc:
+            return value * 16.0;
+        case LengthUnit::kIn:
+            return value * 96.0;
+        case LengthUnit::kCm:
+            return value * (96.0 / 2.54);
+        case LengthUnit::kMm:
+            return value * (96.0 / 25.4);
+        case LengthUnit::kQ:
+            return value * (96.0 / 101.6);
+        case LengthUnit::kNone:
+        case LengthUnit::kPx:
+        case LengthUnit::kOther:
+            return value;
+    }
+    return value;
+}
+
+double SvgLength::ToNumber() const {
+    return unit == LengthUnit::kPercent ? value / 100.0 : value;
+}
+
+std::optional<SvgLength> ParseSvgLength(std::string_view raw) {
+    const std::string text(TrimView(raw));
+    if (text.empty()) {
+        return std::nullopt;
+    }
+
+    SvgLength length;
+    size_t cursor = 0;
+    if (!ParseNumberAt(text, cursor, length.value)) {
+        return std::nullopt;
+    }
+
+    size_t unit_end = cursor;
+    while (unit_end < text.size() && !IsSeparator(text[unit_end])) {
+        ++unit_end;
+    }
+    length.unit = ParseUnit(Lower(std::string_view(text).substr(cursor, unit_end - cursor)));
+    return length;
+}
+
+std::optional<ViewBox> ParseViewBox(std::string_view raw) {
+    const std::string text(raw);
+    double values[4] = {};
+    size_t cursor = 0;
+    for (double& value : values) {
+        while (cursor < text.size() && IsSeparator(text[cursor])) {
+            ++cursor;
+        }
+        if (cursor >= text.size() || !ParseNumberAt(text, cursor, value)) {
+            return std::nullopt;
+        }
+    }
+    return ViewBox{values[0], values[1], values[2], values[3]};
+}
+
+PreserveAspectRatio ParsePreserveAspectRatio(std::string_view raw) {
+    PreserveAspectRatio result;
+
+    std::vector<std::string> words;
+    const std::string text = Lower(raw);
+    size_t cursor = 0;
+    while (cursor < text.size() && words.size() < 3) {
+        while (cursor < text.size() && std::isspace(static_cast<unsigned char>(text[cursor]))) {
+            ++cursor;
+        }
+        const size_t start = cursor;
+        while (cursor < text.size() && !std::isspace(static_cast<unsigned char>(text[cursor]))) {
+            ++cursor;
+        }
+        if (cursor > start) {
+            words.push_back(text.substr(start, cursor - start));
+        }
+    }
+    if (!words.empty() && words.front() == "defer") {
+        words.erase(words.begin());
+    }
+    if (words.empty()) {
+        return result;
+    }
+
+    const std::string& align = words[0];
+    if (align == "none") {
+        result.none = true;
+        result.align_x = 0.0;
+        result.align_y = 0.0;
+        return result;
+    }
+
+    result.slice = words.size() > 1 && words[1] == "slice";
+    result.align_x = 0.0;
+    result.align_y = 0.0;
+    if (align.find("xmid") != std::string::npos) {
+        result.align_x = 0.5;
+    } else if (align.find("xmax") != std::string::npos) {
+        result.align_x = 1.0;
+    }
+    if (align.find("ymid") != std::string::npos) {
+        result.align_y = 0.5;
+    } else if (align.find("ymax") != std::string::npos) {
+        result.align_y = 1.0;
+    }
+    return result;
+}
+
+std::vector<double> ParseNumberList(std::string_view raw) {
+    std::vector<double> values;
+    const std::string text(raw);
+    size_t cursor = 0;
+    while (cursor < text.size()) {
+        while (cursor < text.size() && IsSeparator(text[cursor])) {
+            ++cursor;
+        }
+        if (cursor >= text.size()) {
+            break;
+        }
+        double value = 0.0;
+        if (!ParseNumberAt(text, cursor, value)) {
+            ++cursor;
+            continue;
+        }
+        values.push_back(value);
+    }
+    return values;
+}
+
+AffineMatrix ViewBoxTransform(double viewport_width,
+                              double viewport_height,
+                              const ViewBox& view_box,
+                              const PreserveAspectRatio& preserve) {
+    double scale_x = viewport_width / view_box.width;
+    double scale_y = viewport_height / view_box.height;
+    double translate_x = 0.0;
+    double translate_y = 0.0;
+
+    if (!preserve.none) {
+        const double uniform_scale = preserve.slice
+            ? std::max(scale_x, scale_y)
+            : std::min(scale_x, scale_y);
+        scale_x = uniform_scale;
+        scale_y = uniform_scale;
+        translate_x = (viewport_width - view_box.width * uniform_scale) * preserve.align_x;
+        translate_y = (viewport_height - view_box.height * uniform_scale) * preserve.align_y;
+    }
+
+    AffineMatrix matrix = AffineMatrix::Scale(scale_x, scale_y);
+    matrix.e = translate_x - view_box.x * scale_x;
+    matrix.f = translate_y - view_box.y * scale_y;
+    return matrix;
+}
+
+} // namespace csvg
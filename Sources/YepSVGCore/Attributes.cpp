@@ -0,0 +1,229 @@
+#include "YepSVGCore/Attributes.hpp"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+namespace csvg {
+namespace {
+
+struct AttrEntry {
+    std::string_view name;
+    AttrId id;
+};
+
+constexpr std::array<AttrEntry, static_cast<size_t>(AttrId::kCount) - 1> kAttributeTable = {{
+#define CSVG_ATTRIBUTE_ENTRY(id, name) {name, AttrId::id},
+    CSVG_ATTRIBUTE_LIST(CSVG_ATTRIBUTE_ENTRY)
+#undef CSVG_ATTRIBUTE_ENTRY
+}};
+
+constexpr bool IsSortedByName() {
+    for (size_t i = 1; i < kAttributeTable.size(); ++i) {
+        if (!(kAttributeTable[i - 1].name < kAttributeTable[i].name)) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(IsSortedByName(), "CSVG_ATTRIBUTE_LIST must stay sorted by name");
+
+AttributeValue ParseTypedValue(AttrId id, const std::string& value) {
+    switch (id) {
+        case AttrId::kX:
+        case AttrId::kY:
+        case AttrId::kZ:
+        case AttrId::kWidth:
+        case AttrId::kHeight:
+        case AttrId::kCx:
+        case AttrId::kCy:
+        case AttrId::kR:
+        case AttrId::kRx:
+        case AttrId::kRy:
+        case AttrId::kFx:
+        case AttrId::kFy:
+        case AttrId::kX1:
+        case AttrId::kY1:
+        case AttrId::kX2:
+        case AttrId::kY2:
+        case AttrId::kDx:
+        case AttrId::kDy:
+        case AttrId::kRefX:
+        case AttrId::kRefY:
+        case AttrId::kMarkerWidth:
+        case AttrId::kMarkerHeight:
+        case AttrId::kStartOffset:
+        case AttrId::kTextLength:
+        case AttrId::kOffset:
+        case AttrId::kSlope:
+        case AttrId::kIntercept:
+        case AttrId::kAmplitude:
+        case AttrId::kExponent:
+        case AttrId::kDivisor:
+        case AttrId::kBias:
+        case AttrId::kTargetX:
+        case AttrId::kTargetY:
+        case AttrId::kNumOctaves:
+        case AttrId::kSeed:
+        case AttrId::kScale:
+        case AttrId::kAzimuth:
+        case AttrId::kElevation:
+        case AttrId::kPointsAtX:
+        case AttrId::kPointsAtY:
+        case AttrId::kPointsAtZ:
+        case AttrId::kSpecularExponent:
+        case AttrId::kLimitingConeAngle:
+        case AttrId::kSurfaceScale:
+        case AttrId::kDiffuseConstant:
+        case AttrId::kSpecularConstant:
+        case AttrId::kK1:
+        case AttrId::kK2:
+        case AttrId::kK3:
+        case AttrId::kK4:
+            if (auto length = ParseSvgLength(value)) {
+                return *length;
+            }
+            return std::monostate{};
+        case AttrId::kViewBox:
+            if (auto view_box = ParseViewBox(value)) {
+                return *view_box;
+            }
+            return std::monostate{};
+        case AttrId::kPreserveAspectRatio:
+            return ParsePreserveAspectRatio(value);
+        case AttrId::kTransform:
+        case AttrId::kGradientTransform:
+        case AttrId::kPatternTransform:
+            return TransformParser().Parse(value);
+        case AttrId::kPoints:
+            return ParseNumberList(value);
+        default:
+            return std::monostate{};
+    }
+}
+
+} // namespace
+
+AttrId LookupAttrId(std::string_view name) {
+    const auto it = std::lower_bound(kAttributeTable.begin(), kAttributeTable.end(), name, [](const AttrEntry& entry, std::string_view key) {
+        return entry.name < key;
+    });
+    if (it != kAttributeTable.end() && it->name == name) {
+        return it->id;
+    }
+    return AttrId::kUnknown;
+}
+
+std::string_view AttrName(AttrId id) {
+    const auto index = static_cast<size_t>(id);
+    if (index == 0 || index >= static_cast<size_t>(AttrId::kCount)) {
+        return {};
+    }
+    // Enum order follows the list, so ids index the table directly.
+    return kAttributeTable[index - 1].name;
+}
+
+AttributeMap::const_iterator AttributeMap::find(AttrId id) const {
+    if (id == AttrId::kUnknown) {
+        return end();
+    }
+    for (size_t i = 0; i < known_count_; ++i) {
+        if (ids_[i] == id) {
+            return entries_.begin() + static_cast<std::ptrdiff_t>(i);
+        }
+        if (ids_[i] > id) {
+            break;
+        }
+    }
+    return end();
+}
+
+AttributeMap::const_iterator AttributeMap::find(std::string_view name) const {
+    const AttrId id = LookupAttrId(name);
+    if (id != AttrId::kUnknown) {
+        return find(id);
+    }
+    const auto first = entries_.begin() + static_cast<std::ptrdiff_t>(known_count_);
+    const auto it = std::lower_bound(first, entries_.end(), name, [](const value_type& entry, std::string_view key) {
+        return std::string_view(entry.first) < key;
+    });
+    if (it != entries_.end() && it->first == name) {
+        return it;
+    }
+    return end();
+}
+
+const std::string& AttributeMap::at(AttrId id) const {
+    const auto it = find(id);
+    if (it == end()) {
+        throw std::out_of_range("AttributeMap::at");
+    }
+    return it->second;
+}
+
+const std::string& AttributeMap::at(std::string_view name) const {
+    const auto it = find(name);
+    if (it == end()) {
+        throw std::out_of_range("AttributeMap::at");
+    }
+    return it->second;
+}
+
+const std::string* AttributeMap::Get(AttrId id) const {
+    const auto it = find(id);
+    return it != end() ? &it->second : nullptr;
+}
+
+const SvgLength* AttributeMap::GetLength(AttrId id) const {
+    const auto it = find(id);
+    return it != end() ? std::get_if<SvgLength>(&values_[static_cast<size_t>(it - begin())]) : nullptr;
+}
+
+const ViewBox* AttributeMap::GetViewBox(AttrId id) const {
+    const auto it = find(id);
+    return it != end() ? std::get_if<ViewBox>(&values_[static_cast<size_t>(it - begin())]) : nullptr;
+}
+
+const PreserveAspectRatio* AttributeMap::GetPreserveAspectRatio(AttrId id) const {
+    const auto it = find(id);
+    return it != end() ? std::get_if<PreserveAspectRatio>(&values_[static_cast<size_t>(it - begin())]) : nullptr;
+}
+
+const AffineMatrix* AttributeMap::GetTransform(AttrId id) const {
+    const auto it = find(id);
+    return it != end() ? std::get_if<AffineMatrix>(&values_[static_cast<size_t>(it - begin())]) : nullptr;
+}
+
+const std::vector<double>* AttributeMap::GetNumberList(AttrId id) const {
+    const auto it = find(id);
+    return it != end() ? std::get_if<std::vector<double>>(&values_[static_cast<size_t>(it - begin())]) : nullptr;
+}
+
+void AttributeMap::Set(std::string name, std::string value) {
+    const AttrId id = LookupAttrId(name);
+    size_t position = 0;
+    if (id != AttrId::kUnknown) {
+        position = static_cast<size_t>(std::lower_bound(ids_.begin(), ids_.begin() + static_cast<std::ptrdiff_t>(known_count_), id) - ids_.begin());
+        if (position < known_count_ && ids_[position] == id) {
+            values_[position] = ParseTypedValue(id, value);
+            entries_[position].second = std::move(value);
+            return;
+        }
+        values_.insert(values_.begin() + static_cast<std::ptrdiff_t>(position), ParseTypedValue(id, value));
+        ++known_count_;
+    } else {
+        const auto first = entries_.begin() + static_cast<std::ptrdiff_t>(known_count_);
+        const auto it = std::lower_bound(first, entries_.end(), name, [](const value_type& entry, const std::string& key) {
+            return entry.first < key;
+        });
+        if (it != entries_.end() && it->first == name) {
+            it->second = std::move(value);
+            return;
+        }
+        position = static_cast<size_t>(it - entries_.begin());
+    }
+    entries_.insert(entries_.begin() + static_cast<std::ptrdiff_t>(position), value_type(std::move(name), std::move(value)));
+    ids_.insert(ids_.begin() + static_cast<std::ptrdiff_t>(position), id);
+}
+
+} // namespace csvg
@@ -0,0 +1,251 @@
+#include "YepSVGCore/CssCascade.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+
+namespace csvg {
+namespace {
+
+std::string Lower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
+
+std::string CssLocalName(const std::string& name) {
+    const auto separator = name.rfind(':');
+    if (separator == std::string::npos) {
+        return Lower(name);
+    }
+    return Lower(name.substr(separator + 1));
+}
+
+bool HasClass(const std::string& class_value, const std::string& class_name) {
+    std::stringstream stream(class_value);
+    std::string token;
+    while (stream >> token) {
+        if (token == class_name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MatchesCssAttributeSelector(const XmlNode* node, const CssAttributeSelector& selector) {
+    if (node == nullptr) {
+        return false;
+    }
+    const auto attr_it = node->attributes.find(selector.name);
+    if (attr_it == node->attributes.end()) {
+        return false;
+    }
+    const std::string attr_value = attr_it->second;
+
+    switch (selector.op) {
+        case CssAttributeOperator::kExists:
+            return true;
+        case CssAttributeOperator::kEquals:
+            return attr_value == selector.value;
+        case CssAttributeOperator::kIncludes: {
+            std::stringstream stream(attr_value);
+            std::string token;
+            while (stream >> token) {
+                if (token == selector.value) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        case CssAttributeOperator::kDashMatch:
+            return attr_value == selector.value ||
+                (attr_value.size() > selector.value.size() &&
+                 attr_value.compare(0, selector.value.size(), selector.value) == 0 &&
+                 attr_value[selector.value.size()] == '-');
+    }
+    return false;
+}
+
+bool MatchesCssSimpleSelector(const XmlNode* node,
+                              const CssSimpleSelector& selector,
+                              const CssCascade& cascade) {
+    if (node == nullptr) {
+        return false;
+    }
+    if (selector.tag != "*" && CssLocalName(node->name) != selector.tag) {
+        return false;
+    }
+    if (selector.id.has_value()) {
+        const auto id_it = node->attributes.find(AttrId::kId);
+        if (id_it == node->attributes.end() || id_it->second != *selector.id) {
+            return false;
+        }
+    }
+    for (const auto& class_name : selector.classes) {
+        const auto class_it = node->attributes.find(AttrId::kClass);
+        if (class_it == node->attributes.end() || !HasClass(class_it->second, class_name)) {
+            return false;
+        }
+    }
+    for (const auto& attr_selector : selector.attributes) {
+        if (!MatchesCssAttributeSelector(node, attr_selector)) {
+            return false;
+        }
+    }
+    if (selector.first_child) {
+        const auto index_it = cascade.index_in_parent->find(node);
+        if (index_it == cascade.index_in_parent->end() || index_it->second != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const XmlNode* CssParentOf(const CssCascade& cascade, const XmlNode* node) {
+    if (node == nullptr) {
+        return nullptr;
+    }
+    const auto it = cascade.parent_by_node->find(node);
+    if (it == cascade.parent_by_node->end()) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+const XmlNode* CssPreviousSibling(const CssCascade& cascade, const XmlNode* node) {
+    const auto parent = CssParentOf(cascade, node);
+    if (parent == nullptr) {
+        return nullptr;
+    }
+    const auto index_it = cascade.index_in_parent->find(node);
+    if (index_it == cascade.index_in_parent->end() || index_it->second == 0) {
+        return nullptr;
+    }
+    const size_t sibling_index = index_it->second - 1;
+    if (sibling_index >= parent->children.size()) {
+        return nullptr;
+    }
+    return &parent->children[sibling_index];
+}
+
+bool MatchesCssSelectorAtStep(const CssSelector& selector,
+                              size_t step_index,
+                              const XmlNode* node,
+                              const CssCascade& cascade) {
+    if (!MatchesCssSimpleSelector(node, selector.steps[step_index].simple, cascade)) {
+        return false;
+    }
+    if (step_index + 1 >= selector.steps.size()) {
+        return true;
+    }
+
+    const auto combinator = selector.steps[step_index].combinator_to_prev;
+    if (combinator == CssCombinator::kChild) {
+        const auto parent = CssParentOf(cascade, node);
+        return parent != nullptr && MatchesCssSelectorAtStep(selector, step_index + 1, parent, cascade);
+    }
+    if (combinator == CssCombinator::kAdjacent) {
+        const auto previous_sibling = CssPreviousSibling(cascade, node);
+        return previous_sibling != nullptr && MatchesCssSelectorAtStep(selector, step_index + 1, previous_sibling, cascade);
+    }
+    if (combinator == CssCombinator::kDescendant) {
+        auto ancestor = CssParentOf(cascade, node);
+        while (ancestor != nullptr) {
+            if (MatchesCssSelectorAtStep(selector, step_index + 1, ancestor, cascade)) {
+                return true;
+            }
+            ancestor = CssParentOf(cascade, ancestor);
+        }
+        return false;
+    }
+    return false;
+}
+
+bool MatchesCssSelector(const CssSelector& selector, const XmlNode* node, const CssCascade& cascade) {
+    if (selector.steps.empty() || node == nullptr) {
+        return false;
+    }
+    return MatchesCssSelectorAtStep(selector, 0, node, cascade);
+}
+
+} // namespace
+
+CssCascade BuildCssCascade(const DocumentIndex& index, const RenderOptions& options) {
+    CssCascade cascade;
+    cascade.parent_by_node = &index.parent_by_node;
+    cascade.index_in_parent = &index.index_in_parent;
+
+    for (const auto& sheet : options.stylesheets) {
+        if (sheet != nullptr && !sheet->empty()) {
+            cascade.sheets.push_back(sheet.get());
+        }
+    }
+    if (!index.css_blocks.empty()) {
+        cascade.document_sheet = Stylesheet::Compile(index.css_blocks, StylesheetOrigin::kAuthor);
+        if (!cascade.document_sheet->empty()) {
+            cascade.sheets.push_back(cascade.document_sheet.get());
+        }
+    }
+    return cascade;
+}
+
+PropertyMap ResolveMatchedCssProperties(const XmlNode& node, const CssCascade& cascade) {
+    struct Winner {
+        std::string value;
+        StylesheetOrigin origin = StylesheetOrigin::kUserAgent;
+        int specificity = 0;
+        size_t sheet_index = 0;
+        size_t source_order = 0;
+    };
+
+    PropertyMap resolved;
+
+    std::map<std::string, Winner> winners;
+    std::vector<CssSelectorRef> candidates;
+    for (size_t sheet_index = 0; sheet_index < cascade.sheets.size(); ++sheet_index) {
+        const Stylesheet& sheet = *cascade.sheets[sheet_index];
+        candidates.clear();
+        sheet.CollectCandidates(node, candidates);
+
+        size_t i = 0;
+        while (i < candidates.size()) {
+            const uint32_t rule_index = candidates[i].rule_index;
+            const CssRule& rule = sheet.rules()[rule_index];
+            int matched_specificity = -1;
+            for (; i < candidates.size() && candidates[i].rule_index == rule_index; ++i) {
+                const CssSelector& selector = rule.selectors[candidates[i].selector_index];
+                if (selector.specificity > matched_specificity && MatchesCssSelector(selector, &node, cascade)) {
+                    matched_specificity = selector.specificity;
+                }
+            }
+            if (matched_specificity < 0) {
+                continue;
+            }
+
+            const Winner candidate{std::string(), sheet.origin(), matched_specificity, sheet_index, rule.source_order};
+            for (const auto& [property, value] : rule.declarations) {
+                // Presentation attributes override user-agent rules.
+                if (sheet.origin() == StylesheetOrigin::kUserAgent && node.attributes.count(property) > 0) {
+                    continue;
+                }
+                auto current = winners.find(property);
+                if (current == winners.end() ||
+                    std::tie(candidate.origin, candidate.specificity, candidate.sheet_index, candidate.source_order) >=
+                        std::tie(current->second.origin, current->second.specificity, current->second.sheet_index, current->second.source_order)) {
+                    Winner winner = candidate;
+                    winner.value = value;
+                    winners[property] = std::move(winner);
+                }
+            }
+        }
+    }
+
+    for (const auto& [property, winner] : winners) {
+        resolved[property] = winner.value;
+    }
+    return resolved;
+}
+
+} // namespace csvg
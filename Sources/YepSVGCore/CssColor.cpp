@@ -0,0 +1,429 @@
+#include "YepSVGCore/CssColor.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace csvg {
+namespace {
+
+struct ColorKeyword {
+    std::string_view name;
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+    uint8_t a;
+};
+
+constexpr ColorKeyword kColorKeywords[] = {
+    {"aliceblue", 240, 248, 255, 255},
+    {"antiquewhite", 250, 235, 215, 255},
+    {"aqua", 0, 255, 255, 255},
+    {"aquamarine", 127, 255, 212, 255},
+    {"azure", 240, 255, 255, 255},
+    {"beige", 245, 245, 220, 255},
+    {"bisque", 255, 228, 196, 255},
+    {"black", 0, 0, 0, 255},
+    {"blanchedalmond", 255, 235, 205, 255},
+    {"blue", 0, 0, 255, 255},
+    {"blueviolet", 138, 43, 226, 255},
+    {"brown", 165, 42, 42, 255},
+    {"burlywood", 222, 184, 135, 255},
+    {"cadetblue", 95, 158, 160, 255},
+    {"chartreuse", 127, 255, 0, 255},
+    {"chocolate", 210, 105, 30, 255},
+    {"coral", 255, 127, 80, 255},
+    {"cornflowerblue", 100, 149, 237, 255},
+    {"cornsilk", 255, 248, 220, 255},
+    {"crimson", 220, 20, 60, 255},
+    {"cyan", 0, 255, 255, 255},
+    {"darkblue", 0, 0, 139, 255},
+    {"darkcyan", 0, 139, 139, 255},
+    {"darkgoldenrod", 184, 134, 11, 255},
+    {"darkgray", 169, 169, 169, 255},
+    {"darkgreen", 0, 100, 0, 255},
+    {"darkgrey", 169, 169, 169, 255},
+    {"darkkhaki", 189, 183, 107, 255},
+    {"darkmagenta", 139, 0, 139, 255},
+    {"darkolivegreen", 85, 107, 47, 255},
+    {"darkorange", 255, 140, 0, 255},
+    {"darkorchid", 153, 50, 204, 255},
+    {"darkred", 139, 0, 0, 255},
+    {"darksalmon", 233, 150, 122, 255},
+    {"darkseagreen", 143, 188, 143, 255},
+    {"darkslateblue", 72, 61, 139, 255},
+    {"darkslategray", 47, 79, 79, 255},
+    {"darkslategrey", 47, 79, 79, 255},
+    {"darkturquoise", 0, 206, 209, 255},
+    {"darkviolet", 148, 0, 211, 255},
+    {"deeppink", 255, 20, 147, 255},
+    {"deepskyblue", 0, 191, 255, 255},
+    {"dimgray", 105, 105, 105, 255},
+    {"dimgrey", 105, 105, 105, 255},
+    {"dodgerblue", 30, 144, 255, 255},
+    {"firebrick", 178, 34, 34, 255},
+    {"floralwhite", 255, 250, 240, 255},
+    {"forestgreen", 34, 139, 34, 255},
+    {"fuchsia", 255, 0, 255, 255},
+    {"gainsboro", 220, 220, 220, 255},
+    {"ghostwhite", 248, 248, 255, 255},
+    {"gold", 255, 215, 0, 255},
+    {"goldenrod", 218, 165, 32, 255},
+    {"gray", 128, 128, 128, 255},
+    {"green", 0, 128, 0, 255},
+    {"greenyellow", 173, 255, 47, 255},
+    {"grey", 128, 128, 128, 255},
+    {"honeydew", 240, 255, 240, 255},
+    {"hotpink", 255, 105, 180, 255},
+    {"indianred", 205, 92, 92, 255},
+    {"indigo", 75, 0, 130, 255},
+    {"ivory", 255, 255, 240, 255},
+    {"khaki", 240, 230, 140, 255},
+    {"lavender", 230, 230, 250, 255},
+    {"lavenderblush", 255, 240, 245, 255},
+    {"lawngreen", 124, 252, 0, 255},
+    {"lemonchiffon", 255, 250, 205, 255},
+    {"lightblue", 173, 216, 230, 255},
+    {"lightcoral", 240, 128, 128, 255},
+    {"lightcyan", 224, 255, 255, 255},
+    {"lightgoldenrodyellow", 250, 250, 210, 255},
+    {"lightgray", 211, 211, 211, 255},
+    {"lightgreen", 144, 238, 144, 255},
+    {"lightgrey", 211, 211, 211, 255},
+    {"lightpink", 255, 182, 193, 255},
+    {"lightsalmon", 255, 160, 122, 255},
+    {"lightseagreen", 32, 178, 170, 255},
+    {"lightskyblue", 135, 206, 250, 255},
+    {"lightslategray", 119, 136, 153, 255},
+    {"lightslategrey", 119, 136, 153, 255},
+    {"lightsteelblue", 176, 196, 222, 255},
+    {"lightyellow", 255, 255, 224, 255},
+    {"lime", 0, 255, 0, 255},
+    {"limegreen", 50, 205, 50, 255},
+    {"linen", 250, 240, 230, 255},
+    {"magenta", 255, 0, 255, 255},
+    {"maroon", 128, 0, 0, 255},
+    {"mediumaquamarine", 102, 205, 170, 255},
+    {"mediumblue", 0, 0, 205, 255},
+    {"mediumorchid", 186, 85, 211, 255},
+    {"mediumpurple", 147, 112, 219, 255},
+    {"mediumseagreen", 60, 179, 113, 255},
+    {"mediumslateblue", 123, 104, 238, 255},
+    {"mediumspringgreen", 0, 250, 154, 255},
+    {"mediumturquoise", 72, 209, 204, 255},
+    {"mediumvioletred", 199, 21, 133, 255},
+    {"midnightblue", 25, 25, 112, 255},
+    {"mintcream", 245, 255, 250, 255},
+    {"mistyrose", 255, 228, 225, 255},
+    {"moccasin", 255, 228, 181, 255},
+    {"navajowhite", 255, 222, 173, 255},
+    {"navy", 0, 0, 128, 255},
+    {"oldlace", 253, 245, 230, 255},
+    {"olive", 128, 128, 0, 255},
+    {"olivedrab", 107, 142, 35, 255},
+    {"orange", 255, 165, 0, 255},
+    {"orangered", 255, 69, 0, 255},
+    {"orchid", 218, 112, 214, 255},
+    {"palegoldenrod", 238, 232, 170, 255},
+    {"palegreen", 152, 251, 152, 255},
+    {"paleturquoise", 175, 238, 238, 255},
+    {"palevioletred", 219, 112, 147, 255},
+    {"papayawhip", 255, 239, 213, 255},
+    {"peachpuff", 255, 218, 185, 255},
+    {"peru", 205, 133, 63, 255},
+    {"pink", 255, 192, 203, 255},
+    {"plum", 221, 160, 221, 255},
+    {"powderblue", 176, 224, 230, 255},
+    {"purple", 128, 0, 128, 255},
+    {"rebeccapurple", 102, 51, 153, 255},
+    {"red", 255, 0, 0, 255},
+    {"rosybrown", 188, 143, 143, 255},
+    {"royalblue", 65, 105, 225, 255},
+    {"saddlebrown", 139, 69, 19, 255},
+    {"salmon", 250, 128, 114, 255},
+    {"sandybrown", 244, 164, 96, 255},
+    {"seagreen", 46, 139, 87, 255},
+    {"seashell", 255, 245, 238, 255},
+    {"sienna", 160, 82, 45, 255},
+    {"silver", 192, 192, 192, 255},
+    {"skyblue", 135, 206, 235, 255},
+    {"slateblue", 106, 90, 205, 255},
+    {"slategray", 112, 128, 144, 255},
+    {"slategrey", 112, 128, 144, 255},
+    {"snow", 255, 250, 250, 255},
+    {"springgreen", 0, 255, 127, 255},
+    {"steelblue", 70, 130, 180, 255},
+    {"tan", 210, 180, 140, 255},
+    {"teal", 0, 128, 128, 255},
+    {"thistle", 216, 191, 216, 255},
+    {"tomato", 255, 99, 71, 255},
+    {"turquoise", 64, 224, 208, 255},
+    {"violet", 238, 130, 238, 255},
+    {"wheat", 245, 222, 179, 255},
+    {"white", 255, 255, 255, 255},
+    {"whitesmoke", 245, 245, 245, 255},
+    {"yellow", 255, 255, 0, 255},
+    {"yellowgreen", 154, 205, 50, 255},
+    {"transparent", 0, 0, 0, 0},
+    // Legacy system colors used by the W3C color-prop fixtures.
+    {"activeborder", 0, 0, 0, 255},
+    {"activecaption", 0, 0, 128, 255},
+    {"appworkspace", 0, 92, 92, 255},
+    {"background", 0, 92, 92, 255},
+    {"buttonface", 192, 192, 192, 255},
+    {"buttonhighlight", 255, 255, 255, 255},
+    {"buttonshadow", 160, 160, 160, 255},
+    {"buttontext", 0, 0, 0, 255},
+    {"captiontext", 255, 255, 255, 255},
+    {"graytext", 109, 109, 109, 255},
+    {"highlight", 0, 0, 128, 255},
+    {"highlighttext", 255, 255, 255, 255},
+    {"inactiveborder", 192, 192, 192, 255},
+    {"inactivecaption", 128, 128, 128, 255},
+    {"inactivecaptiontext", 192, 192, 192, 255},
+    {"infobackground", 255, 255, 225, 255},
+    {"infotext", 0, 0, 0, 255},
+    {"menu", 192, 192, 192, 255},
+    {"menutext", 0, 0, 0, 255},
+    {"scrollbar", 200, 200, 200, 255},
+    {"threeddarkshadow", 0, 0, 0, 255},
+    {"threedface", 192, 192, 192, 255},
+    {"threedhighlight", 255, 255, 255, 255},
+    {"threedlightshadow", 227, 227, 227, 255},
+    {"threedshadow", 160, 160, 160, 255},
+    {"window", 255, 255, 255, 255},
+    {"windowframe", 0, 0, 0, 255},
+    {"windowtext", 0, 0, 0, 255},
+};
+
+constexpr size_t kKeywordCount = sizeof(kColorKeywords) / sizeof(kColorKeywords[0]);
+constexpr size_t kMaxKeywordLength = 20;
+
+constexpr char AsciiLower(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// FNV-1a over the lowercased name. The seed was searched offline so that
+// every keyword lands in its own slot; the static_assert below re-checks it.
+constexpr uint32_t kKeywordSeed = 1483;
+constexpr uint32_t kSlotBits = 11;
+constexpr uint8_t kEmptySlot = 0xFF;
+
+constexpr uint32_t KeywordSlot(std::string_view name) {
+    uint32_t hash = 2166136261u ^ kKeywordSeed;
+    for (const char c : name) {
+        hash ^= static_cast<uint8_t>(AsciiLower(c));
+        hash *= 16777619u;
+    }
+    return hash >> (32 - kSlotBits);
+}
+
+struct KeywordSlots {
+    std::array<uint8_t, size_t{1} << kSlotBits> index{};
+    bool perfect = true;
+};
+
+constexpr KeywordSlots BuildKeywordSlots() {
+    KeywordSlots slots;
+    for (auto& entry : slots.index) {
+        entry = kEmptySlot;
+    }
+    for (size_t i = 0; i < kKeywordCount; ++i) {
+        auto& entry = slots.index[KeywordSlot(kColorKeywords[i].name)];
+        if (entry != kEmptySlot || kColorKeywords[i].name.size() > kMaxKeywordLength) {
+            slots.perfect = false;
+        }
+        entry = static_cast<uint8_t>(i);
+    }
+    return slots;
+}
+
+constexpr KeywordSlots kKeywordSlots = BuildKeywordSlots();
+static_assert(kKeywordCount < kEmptySlot, "keyword indices must fit in a byte");
+static_assert(kKeywordSlots.perfect, "color keyword hash has collisions; pick a new kKeywordSeed");
+
+bool IsCssSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+std::string_view TrimView(std::string_view value) {
+    while (!value.empty() && IsCssSpace(value.front())) {
+        value.remove_prefix(1);
+    }
+    while (!value.empty() && IsCssSpace(value.back())) {
+        value.remove_suffix(1);
+    }
+    return value;
+}
+
+bool EqualsIgnoringCase(std::string_view value, std::string_view lower_literal) {
+    if (value.size() != lower_literal.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < value.size(); ++i) {
+        if (AsciiLower(value[i]) != lower_literal[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool StartsWithIgnoringCase(std::string_view value, std::string_view lower_literal) {
+    return value.size() >= lower_literal.size() && EqualsIgnoringCase(value.substr(0, lower_literal.size()), lower_literal);
+}
+
+Color MakeColor(float r, float g, float b, float a) {
+    Color color;
+    color.is_valid = true;
+    color.r = r;
+    color.g = g;
+    color.b = b;
+    color.a = a;
+    return color;
+}
+
+int HexDigit(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c = AsciiLower(c);
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+Color ParseHexColor(std::string_view hex) {
+    int digits[8] = {};
+    for (size_t i = 0; i < hex.size(); ++i) {
+        digits[i] = HexDigit(hex[i]);
+        if (digits[i] < 0) {
+            return {};
+        }
+    }
+
+    float channels[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+    if (hex.size() == 3 || hex.size() == 4) {
+        for (size_t i = 0; i < hex.size(); ++i) {
+            channels[i] = static_cast<float>(digits[i] * 17) / 255.0f;
+        }
+    } else {
+        for (size_t i = 0; i < hex.size() / 2; ++i) {
+            channels[i] = static_cast<float>(digits[i * 2] * 16 + digits[i * 2 + 1]) / 255.0f;
+        }
+    }
+    return MakeColor(channels[0], channels[1], channels[2], channels[3]);
+}
+
+// strtof needs a terminated string; components are copied to the stack.
+std::optional<float> ParseComponentNumber(std::string_view token) {
+    char buffer[32];
+    const size_t length = std::min(token.size(), sizeof(buffer) - 1);
+    std::memcpy(buffer, token.data(), length);
+    buffer[length] = '\0';
+
+    char* end_ptr = nullptr;
+    const float parsed = std::strtof(buffer, &end_ptr);
+    if (end_ptr == buffer) {
+        return std::nullopt;
+    }
+    return parsed;
+}
+
+float ParseByteComponent(std::string_view token) {
+    if (token.back() == '%') {
+        const float ratio = ParseComponentNumber(token.substr(0, token.size() - 1)).value_or(0.0f) / 100.0f;
+        return std::clamp(ratio, 0.0f, 1.0f);
+    }
+    return std::clamp(ParseComponentNumber(token).value_or(0.0f) / 255.0f, 0.0f, 1.0f);
+}
+
+float ParseAlphaComponent(std::string_view token) {
+    if (token.back() == '%') {
+        const float ratio = ParseComponentNumber(token.substr(0, token.size() - 1)).value_or(100.0f) / 100.0f;
+        return std::clamp(ratio, 0.0f, 1.0f);
+    }
+    return std::clamp(ParseComponentNumber(token).value_or(1.0f), 0.0f, 1.0f);
+}
+
+// rgb()/rgba() with comma, space or slash separators; missing components make
+// the color invalid and extra ones are ignored.
+Color ParseRgbFunction(std::string_view value) {
+    const auto open = value.find('(');
+    const auto close = value.rfind(')');
+    if (open == std::string_view::npos || close == std::string_view::npos || close <= open + 1) {
+        return {};
+    }
+
+    std::string_view args[4];
+    size_t count = 0;
+    size_t i = open + 1;
+    while (i < close && count < 4) {
+        while (i < close && (value[i] == ',' || value[i] == '/' || IsCssSpace(value[i]))) {
+            ++i;
+        }
+        const size_t start = i;
+        while (i < close && value[i] != ',' && value[i] != '/' && !IsCssSpace(value[i])) {
+            ++i;
+        }
+        if (i > start) {
+            args[count++] = value.substr(start, i - start);
+        }
+    }
+    if (count < 3) {
+        return {};
+    }
+    return MakeColor(ParseByteComponent(args[0]),
+                     ParseByteComponent(args[1]),
+                     ParseByteComponent(args[2]),
+                     count >= 4 ? ParseAlphaComponent(args[3]) : 1.0f);
+}
+
+} // namespace
+
+std::optional<Color> LookupColorKeyword(std::string_view name) {
+    if (name.empty() || name.size() > kMaxKeywordLength) {
+        return std::nullopt;
+    }
+    const uint8_t index = kKeywordSlots.index[KeywordSlot(name)];
+    if (index == kEmptySlot || !EqualsIgnoringCase(name, kColorKeywords[index].name)) {
+        return std::nullopt;
+    }
+    const ColorKeyword& keyword = kColorKeywords[index];
+    return MakeColor(static_cast<float>(keyword.r) / 255.0f,
+                     static_cast<float>(keyword.g) / 255.0f,
+                     static_cast<float>(keyword.b) / 255.0f,
+                     static_cast<float>(keyword.a) / 255.0f);
+}
+
+Color ParseCssColor(std::string_view value) {
+    value = TrimView(value);
+    if (value.empty()) {
+        return {};
+    }
+
+    if (value[0] == '#') {
+        const auto hex = value.substr(1);
+        if (hex.size() == 3 || hex.size() == 4 || hex.size() == 6 || hex.size() == 8) {
+            return ParseHexColor(hex);
+        }
+        return {};
+    }
+
+    if (EqualsIgnoringCase(value, "none")) {
+        Color color;
+        color.is_none = true;
+        color.is_valid = true;
+        return color;
+    }
+
+    if (StartsWithIgnoringCase(value, "rgb(") || StartsWithIgnoringCase(value, "rgba(")) {
+        return ParseRgbFunction(value);
+    }
+
+    return LookupColorKeyword(value).value_or(Color{});
+}
+
+} // namespace csvg
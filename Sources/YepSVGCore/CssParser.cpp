@@ -0,0 +1,414 @@
+#include "YepSVGCore/CssParser.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+namespace csvg {
+namespace {
+
+std::string Trim(const std::string& value) {
+    const auto begin = value.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    const auto end = value.find_last_not_of(" \t\r\n");
+    return value.substr(begin, end - begin + 1);
+}
+
+std::string Lower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
+
+std::string CssLocalName(const std::string& name) {
+    const auto separator = name.rfind(':');
+    if (separator == std::string::npos) {
+        return Lower(name);
+    }
+    return Lower(name.substr(separator + 1));
+}
+
+std::string RemoveCssComments(const std::string& css_text) {
+    std::string out;
+    out.reserve(css_text.size());
+    size_t cursor = 0;
+    while (cursor < css_text.size()) {
+        const auto comment_start = css_text.find("/*", cursor);
+        if (comment_start == std::string::npos) {
+            out.append(css_text.substr(cursor));
+            break;
+        }
+        out.append(css_text.substr(cursor, comment_start - cursor));
+        const auto comment_end = css_text.find("*/", comment_start + 2);
+        if (comment_end == std::string::npos) {
+            break;
+        }
+        cursor = comment_end + 2;
+    }
+    return out;
+}
+
+std::vector<std::string> SplitCssTopLevel(const std::string& text, char delimiter) {
+    std::vector<std::string> tokens;
+    std::string current;
+    int bracket_depth = 0;
+    int paren_depth = 0;
+    bool in_single_quote = false;
+    bool in_double_quote = false;
+
+    for (char c : text) {
+        if (!in_double_quote && c == '\'') {
+            in_single_quote = !in_single_quote;
+            current.push_back(c);
+            continue;
+        }
+        if (!in_single_quote && c == '"') {
+            in_double_quote = !in_double_quote;
+            current.push_back(c);
+            continue;
+        }
+        if (in_single_quote || in_double_quote) {
+            current.push_back(c);
+            continue;
+        }
+
+        if (c == '[') {
+            ++bracket_depth;
+        } else if (c == ']' && bracket_depth > 0) {
+            --bracket_depth;
+        } else if (c == '(') {
+            ++paren_depth;
+        } else if (c == ')' && paren_depth > 0) {
+            --paren_depth;
+        }
+
+        if (c == delimiter && bracket_depth == 0 && paren_depth == 0) {
+            const auto trimmed = Trim(current);
+            if (!trimmed.empty()) {
+                tokens.push_back(trimmed);
+            }
+            current.clear();
+            continue;
+        }
+        current.push_back(c);
+    }
+
+    const auto trailing = Trim(current);
+    if (!trailing.empty()) {
+        tokens.push_back(trailing);
+    }
+    return tokens;
+}
+
+bool IsCssNameStart(char c) {
+    return std::isalpha(static_cast<unsigned char>(c)) || c == '_' || c == '-';
+}
+
+bool IsCssNameChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '-' || c == ':';
+}
+
+std::optional<std::string> ParseCssName(const std::string& token, size_t& index) {
+    if (index >= token.size() || !IsCssNameStart(token[index])) {
+        return std::nullopt;
+    }
+    const size_t start = index;
+    ++index;
+    while (index < token.size() && IsCssNameChar(token[index])) {
+        ++index;
+    }
+    return token.substr(start, index - start);
+}
+
+bool ParseCssAttributeSelectorToken(const std::string& raw, CssAttributeSelector& out) {
+    const auto trimmed = Trim(raw);
+    if (trimmed.empty()) {
+        return false;
+    }
+
+    size_t index = 0;
+    auto name = ParseCssName(trimmed, index);
+    if (!name.has_value()) {
+        return false;
+    }
+    out.name = *name;
+    out.op = CssAttributeOperator::kExists;
+    out.value.clear();
+
+    while (index < trimmed.size() && std::isspace(static_cast<unsigned char>(trimmed[index]))) {
+        ++index;
+    }
+    if (index >= trimmed.size()) {
+        return true;
+    }
+
+    if (trimmed.compare(index, 2, "~=") == 0) {
+        out.op = CssAttributeOperator::kIncludes;
+        index += 2;
+    } else if (trimmed.compare(index, 2, "|=") == 0) {
+        out.op = CssAttributeOperator::kDashMatch;
+        index += 2;
+    } else if (trimmed[index] == '=') {
+        out.op = CssAttributeOperator::kEquals;
+        ++index;
+    } else {
+        return false;
+    }
+
+    while (index < trimmed.size() && std::isspace(static_cast<unsigned char>(trimmed[index]))) {
+        ++index;
+    }
+    if (index >= trimmed.size()) {
+        return false;
+    }
+
+    if (trimmed[index] == '\'' || trimmed[index] == '"') {
+        const char quote = trimmed[index++];
+        const size_t start = index;
+        while (index < trimmed.size() && trimmed[index] != quote) {
+            ++index;
+        }
+        if (index >= trimmed.size()) {
+            return false;
+        }
+        out.value = trimmed.substr(start, index - start);
+    } else {
+        out.value = Trim(trimmed.substr(index));
+    }
+    return true;
+}
+
+std::optional<CssSimpleSelector> ParseCssSimpleSelector(const std::string& token, int& specificity) {
+    CssSimpleSelector simple;
+    const auto trimmed = Trim(token);
+    if (trimmed.empty()) {
+        return std::nullopt;
+    }
+
+    size_t index = 0;
+    if (trimmed[index] == '*') {
+        simple.tag = "*";
+        ++index;
+    } else if (auto tag = ParseCssName(trimmed, index); tag.has_value()) {
+        simple.tag = CssLocalName(*tag);
+        ++specificity;
+    }
+
+    while (index < trimmed.size()) {
+        const char c = trimmed[index];
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            ++index;
+            continue;
+        }
+
+        if (c == '#') {
+            ++index;
+            auto id = ParseCssName(trimmed, index);
+            if (!id.has_value()) {
+                return std::nullopt;
+            }
+            simple.id = *id;
+            specificity += 100;
+            continue;
+        }
+
+        if (c == '.') {
+            ++index;
+            auto klass = ParseCssName(trimmed, index);
+            if (!klass.has_value()) {
+                return std::nullopt;
+            }
+            simple.classes.push_back(*klass);
+            specificity += 10;
+            continue;
+        }
+
+        if (c == '[') {
+            const auto close = trimmed.find(']', index + 1);
+            if (close == std::string::npos) {
+                return std::nullopt;
+            }
+            CssAttributeSelector attr;
+            if (!ParseCssAttributeSelectorToken(trimmed.substr(index + 1, close - index - 1), attr)) {
+                return std::nullopt;
+            }
+            simple.attributes.push_back(std::move(attr));
+            specificity += 10;
+            index = close + 1;
+            continue;
+        }
+
+        if (c == ':') {
+            ++index;
+            auto pseudo = ParseCssName(trimmed, index);
+            if (!pseudo.has_value()) {
+                return std::nullopt;
+            }
+            if (Lower(*pseudo) != "first-child") {
+                return std::nullopt;
+            }
+            simple.first_child = true;
+            specificity += 10;
+            continue;
+        }
+
+        return std::nullopt;
+    }
+
+    return simple;
+}
+
+std::optional<CssSelector> ParseCssSelectorText(const std::string& selector_text) {
+    std::vector<std::string> compounds;
+    std::vector<CssCombinator> combinators;
+
+    size_t index = 0;
+    while (index < selector_text.size()) {
+        while (index < selector_text.size() && std::isspace(static_cast<unsigned char>(selector_text[index]))) {
+            ++index;
+        }
+        if (index >= selector_text.size()) {
+            break;
+        }
+
+        const size_t start = index;
+        while (index < selector_text.size() &&
+               selector_text[index] != '>' &&
+               selector_text[index] != '+' &&
+               !std::isspace(static_cast<unsigned char>(selector_text[index]))) {
+            ++index;
+        }
+        const auto compound = Trim(selector_text.substr(start, index - start));
+        if (compound.empty()) {
+            return std::nullopt;
+        }
+        compounds.push_back(compound);
+
+        size_t space_begin = index;
+        while (index < selector_text.size() && std::isspace(static_cast<unsigned char>(selector_text[index]))) {
+            ++index;
+        }
+        const bool had_space = index > space_begin;
+        if (index >= selector_text.size()) {
+            break;
+        }
+
+        if (selector_text[index] == '>') {
+            combinators.push_back(CssCombinator::kChild);
+            ++index;
+            continue;
+        }
+        if (selector_text[index] == '+') {
+            combinators.push_back(CssCombinator::kAdjacent);
+            ++index;
+            continue;
+        }
+        if (had_space) {
+            combinators.push_back(CssCombinator::kDescendant);
+            continue;
+        }
+        return std::nullopt;
+    }
+
+    if (compounds.empty() || combinators.size() + 1 != compounds.size()) {
+        return std::nullopt;
+    }
+
+    CssSelector selector;
+    int specificity = 0;
+    std::vector<CssSimpleSelector> parsed;
+    parsed.reserve(compounds.size());
+    for (const auto& compound : compounds) {
+        auto simple = ParseCssSimpleSelector(compound, specificity);
+        if (!simple.has_value()) {
+            return std::nullopt;
+        }
+        parsed.push_back(std::move(*simple));
+    }
+
+    selector.steps.reserve(parsed.size());
+    for (size_t left = parsed.size(); left > 0; --left) {
+        const size_t i = left - 1;
+        CssSelectorStep step;
+        step.simple = parsed[i];
+        if (i > 0) {
+            step.combinator_to_prev = combinators[i - 1];
+        }
+        selector.steps.push_back(std::move(step));
+    }
+    selector.specificity = specificity;
+    return selector;
+}
+
+PropertyMap ParseCssDeclarationText(const std::string& declarations_text) {
+    PropertyMap declarations;
+    for (const auto& declaration : SplitCssTopLevel(declarations_text, ';')) {
+        const auto separator = declaration.find(':');
+        if (separator == std::string::npos) {
+            continue;
+        }
+        const std::string name = Lower(Trim(declaration.substr(0, separator)));
+        std::string value = Trim(declaration.substr(separator + 1));
+        if (name.empty() || value.empty()) {
+            continue;
+        }
+        const auto important = Lower(value);
+        const auto bang_pos = important.rfind("!important");
+        if (bang_pos != std::string::npos && bang_pos + 10 == important.size()) {
+            value = Trim(value.substr(0, bang_pos));
+        }
+        declarations[name] = value;
+    }
+    return declarations;
+}
+
+} // namespace
+
+std::optional<CssSelector> CssParser::ParseSelector(const std::string& selector_text) const {
+    return ParseCssSelectorText(selector_text);
+}
+
+PropertyMap CssParser::ParseDeclarations(const std::string& declarations_text) const {
+    return ParseCssDeclarationText(declarations_text);
+}
+
+void CssParser::ParseRules(const std::string& css_text, size_t& source_order, std::vector<CssRule>& rules) const {
+    const std::string stripped = RemoveCssComments(css_text);
+    size_t cursor = 0;
+    while (cursor < stripped.size()) {
+        const auto open = stripped.find('{', cursor);
+        if (open == std::string::npos) {
+            break;
+        }
+        const auto close = stripped.find('}', open + 1);
+        if (close == std::string::npos) {
+            break;
+        }
+
+        const auto selector_text = Trim(stripped.substr(cursor, open - cursor));
+        const auto declaration_text = stripped.substr(open + 1, close - open - 1);
+        cursor = close + 1;
+
+        if (selector_text.empty()) {
+            continue;
+        }
+
+        CssRule rule;
+        rule.source_order = ++source_order;
+        rule.declarations = ParseCssDeclarationText(declaration_text);
+        if (rule.declarations.empty()) {
+            continue;
+        }
+
+        for (const auto& selector_token : SplitCssTopLevel(selector_text, ',')) {
+            if (auto selector = ParseCssSelectorText(selector_token); selector.has_value()) {
+                rule.selectors.push_back(std::move(*selector));
+            }
+        }
+        if (!rule.selectors.empty()) {
+            rules.push_back(std::move(rule));
+        }
+    }
+}
+
+} // namespace csvg
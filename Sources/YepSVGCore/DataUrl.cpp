@@ -0,0 +1,212 @@
+#include "YepSVGCore/DataUrl.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <string>
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace csvg {
+namespace {
+
+std::string Lower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
+
+bool IsHexDigit(char c) {
+    return (c >= '0' && c <= '9') ||
+           (c >= 'a' && c <= 'f') ||
+           (c >= 'A' && c <= 'F');
+}
+
+uint8_t HexValue(char c) {
+    if (c >= '0' && c <= '9') {
+        return static_cast<uint8_t>(c - '0');
+    }
+    if (c >= 'a' && c <= 'f') {
+        return static_cast<uint8_t>(10 + (c - 'a'));
+    }
+    return static_cast<uint8_t>(10 + (c - 'A'));
+}
+
+std::string PercentDecode(std::string_view value) {
+    std::string decoded;
+    decoded.reserve(value.size());
+    for (size_t i = 0; i < value.size(); ++i) {
+        const char c = value[i];
+        if (c == '%' && i + 2 < value.size() && IsHexDigit(value[i + 1]) && IsHexDigit(value[i + 2])) {
+            const auto high = HexValue(value[i + 1]);
+            const auto low = HexValue(value[i + 2]);
+            decoded.push_back(static_cast<char>((high << 4) | low));
+            i += 2;
+        } else if (c == '+') {
+            decoded.push_back(' ');
+        } else {
+            decoded.push_back(c);
+        }
+    }
+    return decoded;
+}
+
+constexpr uint8_t kInvalid = 0xFF;
+constexpr uint8_t kPadding = 0xFE;
+
+struct Base64Table {
+    uint8_t values[256];
+};
+
+constexpr Base64Table MakeBase64Table() {
+    Base64Table table{};
+    for (int i = 0; i < 256; ++i) {
+        table.values[i] = kInvalid;
+    }
+    for (int i = 0; i < 26; ++i) {
+        table.values['A' + i] = static_cast<uint8_t>(i);
+        table.values['a' + i] = static_cast<uint8_t>(26 + i);
+    }
+    for (int i = 0; i < 10; ++i) {
+        table.values['0' + i] = static_cast<uint8_t>(52 + i);
+    }
+    table.values[static_cast<int>('+')] = 62;
+    table.values[static_cast<int>('/')] = 63;
+    table.values[static_cast<int>('=')] = kPadding;
+    return table;
+}
+
+// Sextet per byte; everything at or above 64 stops the fast paths.
+constexpr Base64Table kBase64 = MakeBase64Table();
+
+bool IsBase64Whitespace(uint8_t c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+// 64 characters to 48 bytes per iteration. Stops before the first block
+// holding padding, whitespace or a byte outside the alphabet.
+size_t DecodeBlocks(const uint8_t* input, size_t size, uint8_t*& out) {
+    const uint8_t* table = kBase64.values;
+    const uint8x16x4_t low = {{vld1q_u8(table), vld1q_u8(table + 16), vld1q_u8(table + 32), vld1q_u8(table + 48)}};
+    const uint8x16x4_t high = {{vld1q_u8(table + 64), vld1q_u8(table + 80), vld1q_u8(table + 96), vld1q_u8(table + 112)}};
+    const uint8x16_t invalid = vdupq_n_u8(kInvalid);
+    const uint8x16_t high_offset = vdupq_n_u8(64);
+
+    size_t consumed = 0;
+    while (consumed + 64 <= size) {
+        const uint8x16x4_t chars = vld4q_u8(input + consumed);
+        uint8x16x4_t sextets;
+        uint8x16_t combined = vdupq_n_u8(0);
+        for (int lane = 0; lane < 4; ++lane) {
+            // Bytes 0-63 hit |low|, 64-127 hit |high| and anything else
+            // keeps |invalid|: out-of-range table indices leave the lane as is.
+            uint8x16_t value = vqtbx4q_u8(invalid, low, chars.val[lane]);
+            value = vqtbx4q_u8(value, high, vsubq_u8(chars.val[lane], high_offset));
+            sextets.val[lane] = value;
+            combined = vorrq_u8(combined, value);
+        }
+        if (vmaxvq_u8(combined) >= 64) {
+            break;
+        }
+        uint8x16x3_t bytes;
+        bytes.val[0] = vorrq_u8(vshlq_n_u8(sextets.val[0], 2), vshrq_n_u8(sextets.val[1], 4));
+        bytes.val[1] = vorrq_u8(vshlq_n_u8(sextets.val[1], 4), vshrq_n_u8(sextets.val[2], 2));
+        bytes.val[2] = vorrq_u8(vshlq_n_u8(sextets.val[2], 6), sextets.val[3]);
+        vst3q_u8(out, bytes);
+        out += 48;
+        consumed += 64;
+    }
+    return consumed;
+}
+#endif
+
+// Four characters to three bytes per iteration; stops like DecodeBlocks.
+size_t DecodeQuads(const uint8_t* input, size_t size, uint8_t*& out) {
+    size_t consumed = 0;
+    while (consumed + 4 <= size) {
+        const uint32_t a = kBase64.values[input[consumed]];
+        const uint32_t b = kBase64.values[input[consumed + 1]];
+        const uint32_t c = kBase64.values[input[consumed + 2]];
+        const uint32_t d = kBase64.values[input[consumed + 3]];
+        if ((a | b | c | d) >= 64) {
+            break;
+        }
+        const uint32_t word = (a << 18) | (b << 12) | (c << 6) | d;
+        out[0] = static_cast<uint8_t>(word >> 16);
+        out[1] = static_cast<uint8_t>(word >> 8);
+        out[2] = static_cast<uint8_t>(word);
+        out += 3;
+        consumed += 4;
+    }
+    return consumed;
+}
+
+} // namespace
+
+std::optional<std::vector<uint8_t>> DataUrlDecoder::DecodeBase64(std::string_view input) {
+    const auto* data = reinterpret_cast<const uint8_t*>(input.data());
+    const size_t size = input.size();
+    std::vector<uint8_t> output(size / 4 * 3 + 3);
+    uint8_t* out = output.data();
+
+    uint32_t buffer = 0;
+    int bits_collected = 0;
+    size_t i = 0;
+    while (i < size) {
+        // Whole quads take the fast paths; line breaks, padding and stray
+        // bytes fall through to the scalar step below.
+        if (bits_collected == 0) {
+#if defined(__ARM_NEON) && defined(__aarch64__)
+            i += DecodeBlocks(data + i, size - i, out);
+#endif
+            i += DecodeQuads(data + i, size - i, out);
+            if (i >= size) {
+                break;
+            }
+        }
+
+        const uint8_t c = data[i++];
+        const uint8_t code = kBase64.values[c];
+        if (code == kPadding) {
+            break;
+        }
+        if (code == kInvalid) {
+            if (IsBase64Whitespace(c)) {
+                continue;
+            }
+            return std::nullopt;
+        }
+        buffer = ((buffer << 6) | code) & 0xFFFFFFu;
+        bits_collected += 6;
+        if (bits_collected >= 8) {
+            bits_collected -= 8;
+            *out++ = static_cast<uint8_t>((buffer >> bits_collected) & 0xFF);
+        }
+    }
+    output.resize(static_cast<size_t>(out - output.data()));
+    return output;
+}
+
+std::optional<std::vector<uint8_t>> DataUrlDecoder::Decode(std::string_view href) {
+    if (href.substr(0, 5) != "data:") {
+        return std::nullopt;
+    }
+
+    const auto comma = href.find(',');
+    if (comma == std::string_view::npos || comma <= 5) {
+        return std::nullopt;
+    }
+
+    const std::string metadata = Lower(std::string(href.substr(5, comma - 5)));
+    const std::string_view payload = href.substr(comma + 1);
+    const bool is_base64 = metadata.find(";base64") != std::string::npos;
+    if (is_base64) {
+        return DecodeBase64(payload);
+    }
+
+    const auto decoded = PercentDecode(payload);
+    return std::vector<uint8_t>(decoded.begin(), decoded.end());
+}
+
+} // namespace csvg
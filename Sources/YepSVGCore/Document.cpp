@@ -0,0 +1,36 @@
+#include "YepSVGCore/Document.hpp"
+
+#include "YepSVGCore/SvgDom.hpp"
+#include "YepSVGCore/XmlParser.hpp"
+
+namespace csvg {
+
+std::unique_ptr<Document> Document::Parse(const std::string& svg_text, bool index_hierarchy, RenderError& error) {
+    error = {};
+
+    auto xml_root = XmlParser().Parse(svg_text, error);
+    if (!xml_root.has_value()) {
+        return nullptr;
+    }
+
+    auto svg = SvgDom().Build(*xml_root, error);
+    if (!svg.has_value()) {
+        return nullptr;
+    }
+
+    std::unique_ptr<Document> document(new Document());
+    document->svg_ = std::move(*svg);
+    document->index_ = DocumentIndexer().Build(document->svg_, index_hierarchy);
+    document->has_hierarchy_ = index_hierarchy || document->index_.features.uses_css;
+    return document;
+}
+
+const DocumentIndex& Document::IndexFor(const RenderOptions& options) const {
+    if (options.stylesheets.empty() || has_hierarchy_) {
+        return index_;
+    }
+    std::call_once(hierarchy_once_, [this] { DocumentIndexer().BuildHierarchy(svg_, index_); });
+    return index_;
+}
+
+} // namespace csvg
@@ -0,0 +1,106 @@
+#include "YepSVGCore/DocumentIndex.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+namespace csvg {
+namespace {
+
+std::string Lower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
+
+std::string LocalName(const std::string& name) {
+    const auto separator = name.rfind(':');
+    if (separator == std::string::npos) {
+        return Lower(name);
+    }
+    return Lower(name.substr(separator + 1));
+}
+
+std::string Trim(const std::string& value) {
+    const auto begin = value.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    const auto end = value.find_last_not_of(" \t\r\n");
+    return value.substr(begin, end - begin + 1);
+}
+
+void IndexNode(const XmlNode& node, DocumentIndex& document_index) {
+    ++document_index.node_count;
+
+    const ResourcePurpose purpose = node.name == "image" || node.name == "feImage"
+        ? ResourcePurpose::kImage
+        : ResourcePurpose::kOther;
+    if (const auto href_it = node.attributes.find(AttrId::kHref); href_it != node.attributes.end()) {
+        document_index.external_urls.push_back(ExternalReference{href_it->second, purpose});
+    }
+    if (const auto xlink_it = node.attributes.find(AttrId::kXlinkHref); xlink_it != node.attributes.end()) {
+        document_index.external_urls.push_back(ExternalReference{xlink_it->second, purpose});
+    }
+    if (const auto id_it = node.attributes.find(AttrId::kId); id_it != node.attributes.end() && !id_it->second.empty()) {
+        document_index.nodes_by_id.emplace(id_it->second, &node);
+    }
+
+    if (node.name == "linearGradient" || node.name == "radialGradient") {
+        document_index.gradient_nodes.push_back(&node);
+    }
+
+    const std::string lower_name = Lower(node.name);
+    if (lower_name == "pattern") {
+        document_index.pattern_nodes.push_back(&node);
+    } else if (lower_name == "color-profile") {
+        document_index.color_profile_nodes.push_back(&node);
+    }
+
+    const std::string local_name = LocalName(node.name);
+    if (local_name == "filter") {
+        document_index.filter_nodes.push_back(&node);
+    } else if (local_name == "style") {
+        auto trimmed = Trim(node.text);
+        if (!trimmed.empty()) {
+            document_index.css_blocks.push_back(std::move(trimmed));
+            document_index.features.uses_css = true;
+        }
+    }
+
+    for (size_t i = 0; i < node.children.size(); ++i) {
+        IndexNode(node.children[i], document_index);
+    }
+}
+
+void IndexHierarchy(const XmlNode& node, DocumentIndex& document_index) {
+    for (size_t i = 0; i < node.children.size(); ++i) {
+        const XmlNode& child = node.children[i];
+        document_index.parent_by_node.emplace(&child, &node);
+        document_index.index_in_parent.emplace(&child, i);
+        IndexHierarchy(child, document_index);
+    }
+}
+
+} // namespace
+
+DocumentIndex DocumentIndexer::Build(const SvgDocument& document, bool index_hierarchy) const {
+    DocumentIndex document_index;
+    IndexNode(document.root, document_index);
+
+    // Structural lookups are only consulted by selector matching, so skip the
+    // hash maps entirely when no stylesheet can apply.
+    if (document_index.features.uses_css || index_hierarchy) {
+        BuildHierarchy(document, document_index);
+    }
+    return document_index;
+}
+
+void DocumentIndexer::BuildHierarchy(const SvgDocument& document, DocumentIndex& document_index) const {
+    if (!document_index.parent_by_node.empty()) {
+        return;
+    }
+    document_index.parent_by_node.reserve(document_index.node_count);
+    document_index.index_in_parent.reserve(document_index.node_count);
+    IndexHierarchy(document.root, document_index);
+}
+
+} // namespace csvg
@@ -0,0 +1,379 @@
+#include "YepSVGCore/ElementBounds.hpp"
+
+#include "YepSVGCore/CssCascade.hpp"
+#include "YepSVGCore/GeometryEngine.hpp"
+#include "YepSVGCore/LayoutEngine.hpp"
+#include "YepSVGCore/NodeTransforms.hpp"
+#include "YepSVGCore/PathFlattener.hpp"
+#include "YepSVGCore/StyleResolver.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <optional>
+#include <sstream>
+#include <unordered_set>
+#include <vector>
+
+namespace csvg {
+namespace {
+
+struct VisitState {
+    const ResolvedStyle* style = nullptr;
+    // Parent user space to device pixels.
+    AffineMatrix matrix;
+    double viewport_width = 0.0;
+    double viewport_height = 0.0;
+    bool in_use = false;
+    bool nested = false;
+};
+
+struct Extent {
+    double min_x = INFINITY;
+    double min_y = INFINITY;
+    double max_x = -INFINITY;
+    double max_y = -INFINITY;
+
+    bool empty() const { return !(min_x <= max_x) || !(min_y <= max_y); }
+
+    void Add(double x, double y) {
+        min_x = std::min(min_x, x);
+        min_y = std::min(min_y, y);
+        max_x = std::max(max_x, x);
+        max_y = std::max(max_y, y);
+    }
+
+    void Add(const Extent& other, double outset) {
+        if (other.empty()) {
+            return;
+        }
+        Add(other.min_x - outset, other.min_y - outset);
+        Add(other.max_x + outset, other.max_y + outset);
+    }
+
+    BoundingBox ToBox() const {
+        if (empty()) {
+            return BoundingBox{};
+        }
+        return BoundingBox{min_x, min_y, max_x - min_x, max_y - min_y};
+    }
+};
+
+std::string Trim(const std::string& value) {
+    const auto begin = value.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    const auto end = value.find_last_not_of(" \t\r\n");
+    return value.substr(begin, end - begin + 1);
+}
+
+std::string Lower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
+
+std::optional<std::string> ReadDisplay(const XmlNode& node, const PropertyMap& matched_css_properties) {
+    if (const std::string* style_attr = node.attributes.Get(AttrId::kStyle)) {
+        std::stringstream stream(*style_attr);
+        std::string token;
+        std::optional<std::string> inline_display;
+        while (std::getline(stream, token, ';')) {
+            const auto separator = token.find(':');
+            if (separator != std::string::npos && Lower(Trim(token.substr(0, separator))) == "display") {
+                inline_display = Trim(token.substr(separator + 1));
+            }
+        }
+        if (inline_display.has_value() && !inline_display->empty()) {
+            return inline_display;
+        }
+    }
+    if (const auto it = matched_css_properties.find(AttrName(AttrId::kDisplay)); it != matched_css_properties.end()) {
+        return it->second;
+    }
+    if (const std::string* value = node.attributes.Get(AttrId::kDisplay)) {
+        return *value;
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> ExtractHrefId(const XmlNode& node) {
+    const std::string* href = node.attributes.Get(AttrId::kHref);
+    if (href == nullptr) {
+        href = node.attributes.Get(AttrId::kXlinkHref);
+    }
+    if (href == nullptr) {
+        return std::nullopt;
+    }
+    const std::string value = Trim(*href);
+    if (value.size() < 2 || value.front() != '#') {
+        return std::nullopt;
+    }
+    return value.substr(1);
+}
+
+double LengthAttr(const XmlNode& node, AttrId key, double fallback, LengthAxis axis, double viewport_width, double viewport_height) {
+    const SvgLength* length = node.attributes.GetLength(key);
+    return length != nullptr ? length->ToPixels(axis, viewport_width, viewport_height) : fallback;
+}
+
+double MatrixScale(const AffineMatrix& matrix) {
+    return std::sqrt(std::fabs(matrix.a * matrix.d - matrix.b * matrix.c));
+}
+
+bool Invert(const AffineMatrix& matrix, AffineMatrix& inverse) {
+    const double det = matrix.a * matrix.d - matrix.b * matrix.c;
+    if (!std::isfinite(det) || !(std::fabs(det) > 1e-12)) {
+        return false;
+    }
+    inverse.a = matrix.d / det;
+    inverse.b = -matrix.b / det;
+    inverse.c = -matrix.c / det;
+    inverse.d = matrix.a / det;
+    inverse.e = (matrix.c * matrix.f - matrix.d * matrix.e) / det;
+    inverse.f = (matrix.b * matrix.e - matrix.a * matrix.f) / det;
+    return true;
+}
+
+bool IsResourceElement(const std::string& lower_name) {
+    return lower_name == "defs" ||
+        lower_name == "lineargradient" ||
+        lower_name == "radialgradient" ||
+        lower_name == "stop" ||
+        lower_name == "pattern" ||
+        lower_name == "clippath" ||
+        lower_name == "mask" ||
+        lower_name == "marker" ||
+        lower_name == "color-profile";
+}
+
+} // namespace
+
+class ElementBoundsIndex::Builder {
+public:
+    Builder(const DocumentIndex& document_index, const CssCascade* cascade, const RenderOptions& options)
+        : document_index_(document_index), cascade_(cascade), options_(options) {}
+
+    void Visit(const XmlNode& node, const VisitState& parent);
+    std::unordered_map<std::string, ElementBounds> Finish() const;
+
+private:
+    struct Entry {
+        const std::string* id = nullptr;
+        Extent fill;
+        Extent stroke;
+        Extent device;
+    };
+
+    // An element with an id whose box collects the shapes beneath it.
+    struct Frame {
+        size_t entry = 0;
+        // Device pixels to the element's user space.
+        AffineMatrix inverse;
+        bool invertible = false;
+    };
+
+    void AddShape(const ShapeGeometry& geometry, const ResolvedStyle& style, const AffineMatrix& matrix);
+
+    const DocumentIndex& document_index_;
+    const CssCascade* cascade_ = nullptr;
+    const RenderOptions& options_;
+    StyleResolver style_resolver_;
+    std::vector<Entry> entries_;
+    std::vector<Frame> frames_;
+    std::unordered_set<std::string> seen_ids_;
+    std::unordered_set<const XmlNode*> active_uses_;
+    std::vector<Point> points_;
+};
+
+void ElementBoundsIndex::Builder::Visit(const XmlNode& node, const VisitState& parent) {
+    const PropertyMap matched_css_properties = cascade_ != nullptr ? ResolveMatchedCssProperties(node, *cascade_) : PropertyMap{};
+    if (const auto display = ReadDisplay(node, matched_css_properties);
+        display.has_value() && Lower(Trim(*display)) == "none") {
+        return;
+    }
+    if (IsResourceElement(Lower(node.name))) {
+        return;
+    }
+    const ResolvedStyle style = style_resolver_.Resolve(node, parent.style, options_, &matched_css_properties);
+
+    VisitState state = parent;
+    state.style = &style;
+    state.nested = true;
+    if (const AffineMatrix* transform = node.attributes.GetTransform(AttrId::kTransform)) {
+        state.matrix = AffineMatrix::Concat(*transform, state.matrix);
+    }
+
+    bool opened_frame = false;
+    if (!state.in_use) {
+        if (const std::string* id = node.attributes.Get(AttrId::kId);
+            id != nullptr && !id->empty() && seen_ids_.insert(*id).second) {
+            Frame frame;
+            frame.entry = entries_.size();
+            frame.invertible = Invert(state.matrix, frame.inverse);
+            entries_.emplace_back().id = id;
+            frames_.push_back(frame);
+            opened_frame = true;
+        }
+    }
+
+    const bool is_svg = node.name == "svg";
+    if (node.name == "use") {
+        const auto href_id = ExtractHrefId(node);
+        const auto target_it = href_id.has_value() ? document_index_.nodes_by_id.find(*href_id) : document_index_.nodes_by_id.end();
+        if (target_it != document_index_.nodes_by_id.end() && target_it->second != nullptr &&
+            active_uses_.count(target_it->second) == 0) {
+            const double x = LengthAttr(node, AttrId::kX, 0.0, LengthAxis::kX, state.viewport_width, state.viewport_height);
+            const double y = LengthAttr(node, AttrId::kY, 0.0, LengthAxis::kY, state.viewport_width, state.viewport_height);
+            state.matrix = AffineMatrix::Concat(AffineMatrix::Translation(x, y), state.matrix);
+            state.in_use = true;
+            active_uses_.insert(target_it->second);
+            Visit(*target_it->second, state);
+            active_uses_.erase(target_it->second);
+        }
+    } else if (is_svg && parent.nested) {
+        const double vw = state.viewport_width;
+        const double vh = state.viewport_height;
+        const double x = LengthAttr(node, AttrId::kX, 0.0, LengthAxis::kX, vw, vh);
+        const double y = LengthAttr(node, AttrId::kY, 0.0, LengthAxis::kY, vw, vh);
+        const double width = LengthAttr(node, AttrId::kWidth, vw > 0.0 ? vw : 100.0, LengthAxis::kX, vw, vh);
+        const double height = LengthAttr(node, AttrId::kHeight, vh > 0.0 ? vh : 100.0, LengthAxis::kY, vw, vh);
+        if (width > 0.0 && height > 0.0) {
+            state.matrix = AffineMatrix::Concat(AffineMatrix::Translation(x, y), state.matrix);
+            state.viewport_width = width;
+            state.viewport_height = height;
+            if (const ViewBox* view_box = node.attributes.GetViewBox(AttrId::kViewBox); view_box != nullptr && view_box->IsValid()) {
+                const PreserveAspectRatio* preserve = node.attributes.GetPreserveAspectRatio(AttrId::kPreserveAspectRatio);
+                state.matrix = AffineMatrix::Concat(
+                    ViewBoxTransform(width, height, *view_box, preserve != nullptr ? *preserve : PreserveAspectRatio{}),
+                    state.matrix);
+                state.viewport_width = view_box->width;
+                state.viewport_height = view_box->height;
+            }
+            for (const auto& child : node.children) {
+                Visit(child, state);
+            }
+        }
+    } else {
+        if (!is_svg) {
+            if (const auto geometry = GeometryEngine(state.viewport_width, state.viewport_height).Build(node)) {
+                AddShape(*geometry, style, state.matrix);
+            }
+        }
+        for (const auto& child : node.children) {
+            Visit(child, state);
+        }
+    }
+
+    if (opened_frame) {
+        frames_.pop_back();
+    }
+}
+
+void ElementBoundsIndex::Builder::AddShape(const ShapeGeometry& geometry, const ResolvedStyle& style, const AffineMatrix& matrix) {
+    if (frames_.empty() || geometry.type == ShapeType::kText || geometry.type == ShapeType::kUnknown) {
+        return;
+    }
+
+    const bool is_image = geometry.type == ShapeType::kImage;
+    ShapeGeometry outline = geometry;
+    if (is_image) {
+        outline.type = ShapeType::kRect;
+        outline.rx = 0.0;
+        outline.ry = 0.0;
+    }
+
+    PathFlattener flattener(FlatteningTolerance(MatrixScale(matrix)));
+    if (!EmitShapeOutline(outline, flattener)) {
+        return;
+    }
+    const FlattenedPath path = flattener.Finish();
+    points_.clear();
+    for (const auto& segment : path.segments()) {
+        points_.push_back(segment.start);
+        points_.push_back(segment.end);
+    }
+    if (points_.empty()) {
+        return;
+    }
+
+    const bool stroked = !is_image &&
+        style.stroke_width > 0.0f &&
+        ((style.stroke.is_valid && !style.stroke.is_none) || Lower(Trim(style.stroke_paint)).rfind("url(", 0) == 0);
+    const double stroke_radius = stroked ? 0.5 * static_cast<double>(style.stroke_width) : 0.0;
+
+    Extent device;
+    for (const Point& point : points_) {
+        double x = 0.0;
+        double y = 0.0;
+        matrix.Map(point.x, point.y, x, y);
+        device.Add(x, y);
+    }
+    const double device_outset = stroke_radius * MatrixScale(matrix);
+
+    for (const Frame& frame : frames_) {
+        Entry& entry = entries_[frame.entry];
+        entry.device.Add(device, device_outset);
+        if (!frame.invertible) {
+            continue;
+        }
+        const AffineMatrix to_frame = AffineMatrix::Concat(matrix, frame.inverse);
+        Extent fill;
+        for (const Point& point : points_) {
+            double x = 0.0;
+            double y = 0.0;
+            to_frame.Map(point.x, point.y, x, y);
+            fill.Add(x, y);
+        }
+        entry.fill.Add(fill, 0.0);
+        entry.stroke.Add(fill, stroke_radius * MatrixScale(to_frame));
+    }
+}
+
+std::unordered_map<std::string, ElementBounds> ElementBoundsIndex::Builder::Finish() const {
+    std::unordered_map<std::string, ElementBounds> bounds;
+    bounds.reserve(entries_.size());
+    for (const Entry& entry : entries_) {
+        bounds.emplace(*entry.id, ElementBounds{entry.fill.ToBox(), entry.stroke.ToBox(), entry.device.ToBox()});
+    }
+    return bounds;
+}
+
+std::unique_ptr<ElementBoundsIndex> ElementBoundsIndex::Build(const Document& document, const RenderOptions& options, RenderError& error) {
+    const auto layout = LayoutEngine().Compute(document.svg(), options, error);
+    if (!layout.has_value()) {
+        return nullptr;
+    }
+
+    std::unique_ptr<ElementBoundsIndex> index(new ElementBoundsIndex());
+    index->options_ = options;
+
+    const DocumentIndex& document_index = document.IndexFor(options);
+    const CssCascade cascade = BuildCssCascade(document_index, options);
+    Builder builder(document_index, cascade.sheets.empty() ? nullptr : &cascade, options);
+    VisitState root;
+    root.matrix = NodeTransformCache::RootMatrix(document.svg().root, *layout);
+    root.viewport_width = layout->view_box_width;
+    root.viewport_height = layout->view_box_height;
+    builder.Visit(document.svg().root, root);
+
+    index->bounds_ = builder.Finish();
+    return index;
+}
+
+bool ElementBoundsIndex::Matches(const RenderOptions& options) const {
+    return options.viewport_width == options_.viewport_width &&
+        options.viewport_height == options_.viewport_height &&
+        options.scale == options_.scale &&
+        options.default_font_size == options_.default_font_size &&
+        options.default_font_family == options_.default_font_family &&
+        options.stylesheets == options_.stylesheets &&
+        options.theme == options_.theme;
+}
+
+const ElementBounds* ElementBoundsIndex::Find(const std::string& id) const {
+    const auto it = bounds_.find(id);
+    return it != bounds_.end() ? &it->second : nullptr;
+}
+
+} // namespace csvg
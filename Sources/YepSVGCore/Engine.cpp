@@ -1,51 +1,101 @@
 #include "YepSVGCore/Engine.hpp"
 
+#include "YepSVGCore/DocumentIndex.hpp"
 #include "YepSVGCore/FilterGraph.hpp"
+#include "YepSVGCore/GlyphAtlas.hpp"
+#include "YepSVGCore/ImageDecodeCache.hpp"
 #include "YepSVGCore/LayoutEngine.hpp"
 #include "YepSVGCore/PaintEngine.hpp"
 #include "YepSVGCore/ResourceResolver.hpp"
 #include "YepSVGCore/RasterBackendCG.hpp"
-#include "YepSVGCore/SvgDom.hpp"
-#include "YepSVGCore/XmlParser.hpp"
+#include "YepSVGCore/RenderScratch.hpp"
+#include "YepSVGCore/TextLayout.hpp"
+
+#include <algorithm>
+#include <optional>
 
 namespace csvg {
+namespace {
+
+// Surfaces above this are freed after the render rather than kept for the
+// next one.
+constexpr size_t kMaxRetainedSurfaceBytes = 64u * 1024u * 1024u;
+
+// Keeps the capacity the caller's buffer already has.
+void ClearImage(ImageBuffer& image) {
+    image.width = 0;
+    image.height = 0;
+    image.rgba.clear();
+}
+
+} // namespace
 
-Engine::Engine() = default;
+Engine::Engine()
+    : text_layouts_(std::make_shared<TextLayoutCache>()),
+      glyph_atlas_(std::make_shared<GlyphAtlas>()),
+      images_(std::make_shared<ImageDecodeCache>()),
+      scratch_(std::make_shared<RenderScratch>()) {}
+
+void Engine::SetResourceLoader(ResourceLoader loader) {
+    loader_ = std::move(loader);
+}
 
 bool Engine::Render(const std::string& svg_text,
                     const RenderOptions& options,
                     ImageBuffer& out_image,
-                    RenderError& out_error) const {
+                    RenderError& out_error,
+                    PaintProfile* out_profile) const {
+    ClearImage(out_image);
+    const auto document = Document::Parse(svg_text, !options.stylesheets.empty(), out_error);
+    if (document == nullptr) {
+        return false;
+    }
+    return Render(*document, options, out_image, out_error, out_profile);
+}
+
+bool Engine::Render(const Document& document,
+                    const RenderOptions& options,
+                    ImageBuffer& out_image,
+                    RenderError& out_error,
+                    PaintProfile* out_profile) const {
     out_error = {};
-    out_image = {};
+    ClearImage(out_image);
 
-    XmlParser xml_parser;
-    SvgDom dom_builder;
     LayoutEngine layout_engine;
     FilterGraph filter_graph;
     ResourceResolver resource_resolver;
     PaintEngine paint_engine;
 
-    auto xml_root = xml_parser.Parse(svg_text, out_error);
-    if (!xml_root.has_value()) {
-        return false;
-    }
-
-    auto document = dom_builder.Build(*xml_root, out_error);
-    if (!document.has_value()) {
+    const DocumentIndex& index = document.IndexFor(options);
+    const bool has_loader = static_cast<bool>(loader_);
+    if (!resource_resolver.ValidatePolicy(index.external_urls, options, has_loader, out_error)) {
         return false;
     }
 
-    const auto urls = resource_resolver.CollectExternalURLs(document->root);
-    if (!resource_resolver.ValidatePolicy(urls, options, out_error)) {
-        return false;
+    FetchedResources fetched;
+    if (options.enable_external_resources && has_loader) {
+        auto requests = resource_resolver.CollectRemoteRequests(index.external_urls);
+        requests.erase(std::remove_if(requests.begin(),
+                                      requests.end(),
+                                      [this](const ResourceRequest& request) {
+                                          return request.purpose == ResourcePurpose::kImage && images_->HasSource(request.url);
+                                      }),
+                       requests.end());
+        if (!resource_resolver.Fetch(requests, loader_, fetched, out_error)) {
+            return false;
+        }
+        for (const auto& [url, resource] : fetched) {
+            if (resource.purpose == ResourcePurpose::kImage) {
+                images_->AddEncoded(url, *resource.bytes);
+            }
+        }
     }
 
-    if (!filter_graph.ValidateFilterSupport(document->root, flags_, out_error)) {
+    if (!filter_graph.ValidateFilterSupport(index, flags_, out_error)) {
         return false;
     }
 
-    auto layout = layout_engine.Compute(*document, options, out_error);
+    auto layout = layout_engine.Compute(document.svg(), options, out_error);
     if (!layout.has_value()) {
         return false;
     }
@@ -58,16 +108,19 @@ bool Engine::Render(const std::string& svg_text,
     background.b = options.background_blue;
     background.a = options.background_alpha;
 
-    RasterSurface surface(layout->width, layout->height, background);
-    if (!paint_engine.Paint(*document, *layout, options, flags_, surface, out_error)) {
-        return false;
-    }
+    // A render already running on this renderer holds the shared scratch.
+    std::unique_lock<std::mutex> scratch_lock(scratch_->in_use, std::try_to_lock);
+    std::optional<RenderScratch> local_scratch;
+    RenderScratch& scratch = scratch_lock.owns_lock() ? *scratch_ : local_scratch.emplace();
 
-    if (!surface.Extract(out_image, out_error)) {
-        return false;
+    RasterSurface& surface = scratch.surface;
+    surface.Reset(layout->width, layout->height, background);
+    const bool painted = paint_engine.Paint(document.svg(), index, *layout, options, flags_, surface, out_error, out_profile, text_layouts_.get(), glyph_atlas_.get(), images_.get(), &fetched, &scratch);
+    const bool extracted = painted && surface.Extract(out_image, out_error);
+    if (surface.byte_capacity() > kMaxRetainedSurfaceBytes) {
+        surface.Release();
     }
-
-    return true;
+    return extracted;
 }
 
 } // namespace csvg
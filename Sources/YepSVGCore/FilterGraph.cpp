@@ -20,9 +20,11 @@ std::string LocalName(const std::string& name) {
     return Lower(name.substr(separator + 1));
 }
 
-bool TraverseFilterNodes(const XmlNode& node, const std::set<std::string>& supported, RenderError& error) {
-    if (LocalName(node.name) == "filter") {
-        for (const auto& child : node.children) {
+bool ValidateFilterNodes(const std::vector<const XmlNode*>& filter_nodes,
+                         const std::set<std::string>& supported,
+                         RenderError& error) {
+    for (const auto* filter_node : filter_nodes) {
+        for (const auto& child : filter_node->children) {
             const auto primitive_name = LocalName(child.name);
             if (supported.find(primitive_name) == supported.end()) {
                 error.code = RenderErrorCode::kUnsupportedFeature;
@@ -31,18 +33,12 @@ bool TraverseFilterNodes(const XmlNode& node, const std::set<std::string>& suppo
             }
         }
     }
-
-    for (const auto& child : node.children) {
-        if (!TraverseFilterNodes(child, supported, error)) {
-            return false;
-        }
-    }
     return true;
 }
 
 } // namespace
 
-bool FilterGraph::ValidateFilterSupport(const XmlNode& node, const CompatFlags& flags, RenderError& error) const {
+bool FilterGraph::ValidateFilterSupport(const DocumentIndex& index, const CompatFlags& flags, RenderError& error) const {
     static const std::set<std::string> kSupported = {
         "fegaussianblur",
         "feoffset",
@@ -64,7 +60,7 @@ bool FilterGraph::ValidateFilterSupport(const XmlNode& node, const CompatFlags&
     };
 
     error = {};
-    if (TraverseFilterNodes(node, kSupported, error)) {
+    if (ValidateFilterNodes(index.filter_nodes, kSupported, error)) {
         return true;
     }
 
@@ -0,0 +1,1352 @@
+#include "YepSVGCore/FontFace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace csvg {
+namespace {
+
+constexpr uint32_t kTagTtcf = 0x74746366;   // 'ttcf'
+constexpr uint32_t kTagOtto = 0x4F54544F;   // 'OTTO'
+constexpr uint32_t kTagTrue = 0x74727565;   // 'true'
+constexpr uint32_t kVersion1 = 0x00010000;
+
+constexpr int kMaxCompositeDepth = 8;
+constexpr int kMaxSubrDepth = 10;
+constexpr size_t kMaxCffStack = 48;
+// Glyphs with more points, components or charstring operators than this are
+// treated as malformed; nesting alone could otherwise make them exponential.
+constexpr size_t kMaxGlyphPoints = 1 << 16;
+constexpr size_t kMaxGlyphComponents = 1024;
+constexpr size_t kMaxCharstringOps = 1 << 16;
+
+constexpr uint32_t Tag(char a, char b, char c, char d) {
+    return (static_cast<uint32_t>(static_cast<uint8_t>(a)) << 24) |
+        (static_cast<uint32_t>(static_cast<uint8_t>(b)) << 16) |
+        (static_cast<uint32_t>(static_cast<uint8_t>(c)) << 8) |
+        static_cast<uint32_t>(static_cast<uint8_t>(d));
+}
+
+bool InBounds(const std::vector<uint8_t>& data, uint64_t offset, uint64_t length) {
+    return offset <= data.size() && length <= data.size() - offset;
+}
+
+uint8_t ReadU8(const std::vector<uint8_t>& data, uint64_t offset) {
+    return offset < data.size() ? data[offset] : 0;
+}
+
+uint16_t ReadU16(const std::vector<uint8_t>& data, uint64_t offset) {
+    if (!InBounds(data, offset, 2)) {
+        return 0;
+    }
+    return static_cast<uint16_t>((data[offset] << 8) | data[offset + 1]);
+}
+
+int16_t ReadS16(const std::vector<uint8_t>& data, uint64_t offset) {
+    return static_cast<int16_t>(ReadU16(data, offset));
+}
+
+uint32_t ReadU32(const std::vector<uint8_t>& data, uint64_t offset) {
+    if (!InBounds(data, offset, 4)) {
+        return 0;
+    }
+    return (static_cast<uint32_t>(data[offset]) << 24) |
+        (static_cast<uint32_t>(data[offset + 1]) << 16) |
+        (static_cast<uint32_t>(data[offset + 2]) << 8) |
+        static_cast<uint32_t>(data[offset + 3]);
+}
+
+uint32_t ReadOffset(const std::vector<uint8_t>& data, uint64_t offset, uint8_t size) {
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < size; ++i) {
+        value = (value << 8) | ReadU8(data, offset + i);
+    }
+    return value;
+}
+
+double F2Dot14(int16_t value) {
+    return static_cast<double>(value) / 16384.0;
+}
+
+void AppendUtf8(uint32_t codepoint, std::string& out) {
+    if (codepoint < 0x80) {
+        out.push_back(static_cast<char>(codepoint));
+    } else if (codepoint < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (codepoint >> 6)));
+        out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    } else if (codepoint < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (codepoint >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (codepoint >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    }
+}
+
+std::string DecodeUtf16BE(const std::vector<uint8_t>& data, uint64_t offset, uint32_t length) {
+    std::string out;
+    for (uint32_t i = 0; i + 1 < length; i += 2) {
+        uint32_t unit = ReadU16(data, offset + i);
+        if (unit >= 0xD800 && unit < 0xDC00 && i + 3 < length) {
+            const uint32_t low = ReadU16(data, offset + i + 2);
+            if (low >= 0xDC00 && low < 0xE000) {
+                unit = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+                i += 2;
+            }
+        }
+        AppendUtf8(unit, out);
+    }
+    return out;
+}
+
+// Accumulates contours into a GlyphOutline through a fixed matrix.
+class OutlineWriter {
+public:
+    OutlineWriter(GlyphOutline& outline, const AffineMatrix& matrix) : outline_(outline), matrix_(matrix) {}
+
+    void MoveTo(double x, double y) {
+        Close();
+        Push(GlyphOutline::Verb::kMove, {{x, y}});
+        open_ = true;
+    }
+    void LineTo(double x, double y) {
+        if (open_) {
+            Push(GlyphOutline::Verb::kLine, {{x, y}});
+        }
+    }
+    void QuadTo(double x1, double y1, double x, double y) {
+        if (open_) {
+            Push(GlyphOutline::Verb::kQuad, {{x1, y1}, {x, y}});
+        }
+    }
+    void CubicTo(double x1, double y1, double x2, double y2, double x, double y) {
+        if (open_) {
+            Push(GlyphOutline::Verb::kCubic, {{x1, y1}, {x2, y2}, {x, y}});
+        }
+    }
+    void Close() {
+        if (open_) {
+            outline_.verbs.push_back(GlyphOutline::Verb::kClose);
+            open_ = false;
+        }
+    }
+
+private:
+    void Push(GlyphOutline::Verb verb, std::initializer_list<Point> points) {
+        outline_.verbs.push_back(verb);
+        for (const Point& point : points) {
+            Point mapped;
+            matrix_.Map(point.x, point.y, mapped.x, mapped.y);
+            outline_.points.push_back(mapped);
+        }
+    }
+
+    GlyphOutline& outline_;
+    const AffineMatrix& matrix_;
+    bool open_ = false;
+};
+
+int32_t SubrBias(uint32_t count) {
+    if (count < 1240) {
+        return 107;
+    }
+    if (count < 33900) {
+        return 1131;
+    }
+    return 32768;
+}
+
+// Operands of one CFF DICT operator; 12 x operators are 1200 + x.
+struct DictEntry {
+    int op = -1;
+    std::array<double, 48> operands{};
+    size_t count = 0;
+};
+
+// Calls |visit| for every operator of the DICT in [begin, end). Returns
+// false on malformed data.
+template <typename Visitor>
+bool ParseDict(const std::vector<uint8_t>& data, uint64_t begin, uint64_t end, Visitor&& visit) {
+    DictEntry entry;
+    uint64_t pos = begin;
+    while (pos < end) {
+        const uint8_t b0 = data[pos++];
+        double value = 0.0;
+        if (b0 <= 21) {
+            entry.op = b0;
+            if (b0 == 12) {
+                if (pos >= end) {
+                    return false;
+                }
+                entry.op = 1200 + data[pos++];
+            }
+            visit(entry);
+            entry.count = 0;
+            continue;
+        }
+        if (b0 == 28) {
+            if (pos + 2 > end) {
+                return false;
+            }
+            value = ReadS16(data, pos);
+            pos += 2;
+        } else if (b0 == 29) {
+            if (pos + 4 > end) {
+                return false;
+            }
+            value = static_cast<int32_t>(ReadU32(data, pos));
+            pos += 4;
+        } else if (b0 == 30) {
+            // Real number: nibbles until 0xf.
+            std::string text;
+            bool done = false;
+            while (pos < end && !done) {
+                const uint8_t byte = data[pos++];
+                for (const uint8_t nibble : {static_cast<uint8_t>(byte >> 4), static_cast<uint8_t>(byte & 0x0F)}) {
+                    if (nibble <= 9) {
+                        text.push_back(static_cast<char>('0' + nibble));
+                    } else if (nibble == 0xA) {
+                        text.push_back('.');
+                    } else if (nibble == 0xB) {
+                        text.push_back('E');
+                    } else if (nibble == 0xC) {
+                        text += "E-";
+                    } else if (nibble == 0xE) {
+                        text.push_back('-');
+                    } else if (nibble == 0xF) {
+                        done = true;
+                        break;
+                    }
+                }
+            }
+            value = std::strtod(text.c_str(), nullptr);
+        } else if (b0 >= 32 && b0 <= 246) {
+            value = static_cast<int>(b0) - 139;
+        } else if (b0 >= 247 && b0 <= 250) {
+            if (pos >= end) {
+                return false;
+            }
+            value = (static_cast<int>(b0) - 247) * 256 + data[pos++] + 108;
+        } else if (b0 >= 251 && b0 <= 254) {
+            if (pos >= end) {
+                return false;
+            }
+            value = -(static_cast<int>(b0) - 251) * 256 - data[pos++] - 108;
+        } else {
+            return false;
+        }
+        if (entry.count >= entry.operands.size()) {
+            return false;
+        }
+        entry.operands[entry.count++] = value;
+    }
+    return true;
+}
+
+} // namespace
+
+void GlyphOutline::Emit(const AffineMatrix& matrix, PathDataSink& sink) const {
+    size_t index = 0;
+    const auto next = [&](double& x, double& y) {
+        const Point& point = points[index++];
+        matrix.Map(point.x, point.y, x, y);
+    };
+    for (const Verb verb : verbs) {
+        double x = 0.0;
+        double y = 0.0;
+        double x1 = 0.0;
+        double y1 = 0.0;
+        double x2 = 0.0;
+        double y2 = 0.0;
+        switch (verb) {
+            case Verb::kMove:
+                next(x, y);
+                sink.MoveTo(x, y);
+                break;
+            case Verb::kLine:
+                next(x, y);
+                sink.LineTo(x, y);
+                break;
+            case Verb::kQuad:
+                next(x1, y1);
+                next(x, y);
+                sink.QuadTo(x1, y1, x, y);
+                break;
+            case Verb::kCubic:
+                next(x1, y1);
+                next(x2, y2);
+                next(x, y);
+                sink.CubicTo(x1, y1, x2, y2, x, y);
+                break;
+            case Verb::kClose:
+                sink.ClosePath();
+                break;
+        }
+    }
+}
+
+uint32_t FontFace::FaceCount(const std::vector<uint8_t>& data) {
+    const uint32_t tag = ReadU32(data, 0);
+    if (tag == kTagTtcf) {
+        const uint32_t count = ReadU32(data, 8);
+        return InBounds(data, 12, static_cast<uint64_t>(count) * 4) ? count : 0;
+    }
+    return (tag == kVersion1 || tag == kTagOtto || tag == kTagTrue) ? 1 : 0;
+}
+
+std::shared_ptr<const FontFace> FontFace::Parse(std::shared_ptr<const std::vector<uint8_t>> data,
+                                                uint32_t index,
+                                                RenderError& error) {
+    error = {};
+    const auto fail = [&error](const char* message) {
+        error.code = RenderErrorCode::kInvalidDocument;
+        error.message = message;
+        return nullptr;
+    };
+    if (data == nullptr || index >= FaceCount(*data)) {
+        return fail("Not a TrueType or OpenType font");
+    }
+    const std::vector<uint8_t>& bytes = *data;
+
+    uint64_t directory = 0;
+    if (ReadU32(bytes, 0) == kTagTtcf) {
+        directory = ReadU32(bytes, 12 + static_cast<uint64_t>(index) * 4);
+    }
+    const uint16_t table_count = ReadU16(bytes, directory + 4);
+    if (!InBounds(bytes, directory + 12, static_cast<uint64_t>(table_count) * 16)) {
+        return fail("Truncated font table directory");
+    }
+
+    std::shared_ptr<FontFace> face(new FontFace());
+    face->data_ = data;
+    Range head;
+    Range maxp;
+    Range hhea;
+    Range cmap;
+    Range name;
+    Range os2;
+    Range kern;
+    Range post;
+    for (uint16_t i = 0; i < table_count; ++i) {
+        const uint64_t record = directory + 12 + static_cast<uint64_t>(i) * 16;
+        const Range range{ReadU32(bytes, record + 8), ReadU32(bytes, record + 12)};
+        if (!InBounds(bytes, range.offset, range.length)) {
+            continue;
+        }
+        switch (ReadU32(bytes, record)) {
+            case Tag('h', 'e', 'a', 'd'): head = range; break;
+            case Tag('m', 'a', 'x', 'p'): maxp = range; break;
+            case Tag('h', 'h', 'e', 'a'): hhea = range; break;
+            case Tag('h', 'm', 't', 'x'): face->hmtx_ = range; break;
+            case Tag('c', 'm', 'a', 'p'): cmap = range; break;
+            case Tag('n', 'a', 'm', 'e'): name = range; break;
+            case Tag('O', 'S', '/', '2'): os2 = range; break;
+            case Tag('k', 'e', 'r', 'n'): kern = range; break;
+            case Tag('p', 'o', 's', 't'): post = range; break;
+            case Tag('l', 'o', 'c', 'a'): face->loca_ = range; break;
+            case Tag('g', 'l', 'y', 'f'): face->glyf_ = range; break;
+            case Tag('C', 'F', 'F', ' '): face->cff_ = range; break;
+            default: break;
+        }
+    }
+
+    if (head.length < 54 || maxp.length < 6 || hhea.length < 36 || cmap.length < 4) {
+        return fail("Font is missing required tables");
+    }
+    face->units_per_em_ = ReadU16(bytes, head.offset + 18);
+    if (face->units_per_em_ < 16 || face->units_per_em_ > 16384) {
+        return fail("Font has an invalid unitsPerEm");
+    }
+    face->long_loca_ = ReadS16(bytes, head.offset + 50) != 0;
+    const uint16_t mac_style = ReadU16(bytes, head.offset + 44);
+    face->glyph_count_ = ReadU16(bytes, maxp.offset + 4);
+    face->ascender_ = ReadS16(bytes, hhea.offset + 4);
+    face->descender_ = ReadS16(bytes, hhea.offset + 6);
+    face->metric_count_ = std::min(ReadU16(bytes, hhea.offset + 34), face->glyph_count_);
+    if (face->glyph_count_ == 0 || face->metric_count_ == 0 ||
+        face->hmtx_.length < static_cast<uint32_t>(face->metric_count_) * 4) {
+        return fail("Font has no horizontal metrics");
+    }
+
+    if (os2.length >= 64) {
+        face->weight_ = std::clamp(static_cast<int>(ReadU16(bytes, os2.offset + 4)), 1, 1000);
+        const uint16_t selection = ReadU16(bytes, os2.offset + 62);
+        face->italic_ = (selection & 0x0201) != 0;
+        // sFamilyClass 1-5 and 7 have serifs. PANOSE applies to Latin text
+        // faces only: serif styles 2-10, proportion 9 is monospaced.
+        const uint8_t family_class = ReadU8(bytes, os2.offset + 30);
+        const bool latin_panose = ReadU8(bytes, os2.offset + 32) == 2;
+        const uint8_t serif_style = ReadU8(bytes, os2.offset + 33);
+        if (family_class != 0) {
+            face->serif_ = (family_class >= 1 && family_class <= 5) || family_class == 7;
+        } else {
+            face->serif_ = latin_panose && serif_style >= 2 && serif_style <= 10;
+        }
+        face->fixed_pitch_ = latin_panose && ReadU8(bytes, os2.offset + 35) == 9;
+    } else {
+        face->weight_ = (mac_style & 0x1) != 0 ? 700 : 400;
+        face->italic_ = (mac_style & 0x2) != 0;
+    }
+
+    if (post.length >= 16 && ReadU32(bytes, post.offset + 12) != 0) {
+        face->fixed_pitch_ = true;
+    }
+
+    // Names: prefer Windows Unicode English, typographic family over legacy.
+    if (name.length >= 6) {
+        const uint16_t count = ReadU16(bytes, name.offset + 2);
+        const uint64_t strings = name.offset + ReadU16(bytes, name.offset + 4);
+        int best_score = -1;
+        for (uint16_t i = 0; i < count; ++i) {
+            const uint64_t record = name.offset + 6 + static_cast<uint64_t>(i) * 12;
+            if (record + 12 > static_cast<uint64_t>(name.offset) + name.length) {
+                break;
+            }
+            const uint16_t platform = ReadU16(bytes, record);
+            const uint16_t encoding = ReadU16(bytes, record + 2);
+            const uint16_t language = ReadU16(bytes, record + 4);
+            const uint16_t name_id = ReadU16(bytes, record + 6);
+            const uint16_t length = ReadU16(bytes, record + 8);
+            const uint64_t offset = strings + ReadU16(bytes, record + 10);
+            if ((name_id != 1 && name_id != 16) || !InBounds(bytes, offset, length)) {
+                continue;
+            }
+            const bool unicode = platform == 0 || (platform == 3 && (encoding == 1 || encoding == 10));
+            const bool mac_roman = platform == 1 && encoding == 0;
+            if (!unicode && !mac_roman) {
+                continue;
+            }
+            const int score = (name_id == 16 ? 4 : 0) + (unicode ? 2 : 0) + (platform != 3 || language == 0x0409 ? 1 : 0);
+            if (score <= best_score) {
+                continue;
+            }
+            std::string value;
+            if (unicode) {
+                value = DecodeUtf16BE(bytes, offset, length);
+            } else {
+                for (uint16_t c = 0; c < length; ++c) {
+                    const uint8_t ch = bytes[offset + c];
+                    value.push_back(ch < 0x80 ? static_cast<char>(ch) : '?');
+                }
+            }
+            if (!value.empty()) {
+                face->family_ = std::move(value);
+                best_score = score;
+            }
+        }
+    }
+
+    // Character map: prefer full-repertoire format 12, else BMP format 4.
+    {
+        const uint16_t count = ReadU16(bytes, cmap.offset + 2);
+        int best_score = 0;
+        for (uint16_t i = 0; i < count; ++i) {
+            const uint64_t record = cmap.offset + 4 + static_cast<uint64_t>(i) * 8;
+            if (record + 8 > static_cast<uint64_t>(cmap.offset) + cmap.length) {
+                break;
+            }
+            const uint16_t platform = ReadU16(bytes, record);
+            const uint16_t encoding = ReadU16(bytes, record + 2);
+            const uint64_t offset = static_cast<uint64_t>(cmap.offset) + ReadU32(bytes, record + 4);
+            const uint16_t format = ReadU16(bytes, offset);
+            uint32_t length = 0;
+            if (format == 4) {
+                length = ReadU16(bytes, offset + 2);
+            } else if (format == 12) {
+                length = ReadU32(bytes, offset + 4);
+            } else {
+                continue;
+            }
+            if (!InBounds(bytes, offset, length)) {
+                continue;
+            }
+            const bool unicode = platform == 0 || (platform == 3 && (encoding == 1 || encoding == 10));
+            const bool symbol = platform == 3 && encoding == 0;
+            if (!unicode && !symbol) {
+                continue;
+            }
+            const int score = (format == 12 ? 4 : 2) + (unicode ? 1 : 0);
+            if (score > best_score) {
+                best_score = score;
+                face->cmap_subtable_ = Range{static_cast<uint32_t>(offset), length};
+                face->cmap_format_ = format;
+            }
+        }
+        if (face->cmap_format_ == 0) {
+            return fail("Font has no Unicode character map");
+        }
+    }
+
+    // Format 0 'kern' subtables with horizontal, non-cross-stream pairs.
+    if (kern.length >= 4 && ReadU16(bytes, kern.offset) == 0) {
+        const uint16_t count = ReadU16(bytes, kern.offset + 2);
+        uint64_t subtable = kern.offset + 4;
+        const uint64_t kern_end = static_cast<uint64_t>(kern.offset) + kern.length;
+        for (uint16_t i = 0; i < count && subtable + 6 <= kern_end; ++i) {
+            const uint16_t length = ReadU16(bytes, subtable + 2);
+            const uint16_t coverage = ReadU16(bytes, subtable + 4);
+            if ((coverage >> 8) == 0 && (coverage & 0x1) != 0 && (coverage & 0x4) == 0) {
+                const uint16_t pairs = ReadU16(bytes, subtable + 6);
+                const uint64_t first = subtable + 14;
+                for (uint16_t p = 0; p < pairs && first + (static_cast<uint64_t>(p) + 1) * 6 <= kern_end; ++p) {
+                    const uint64_t pair = first + static_cast<uint64_t>(p) * 6;
+                    face->kerning_.emplace_back(ReadU32(bytes, pair), ReadS16(bytes, pair + 4));
+                }
+            }
+            if (length < 6) {
+                break;
+            }
+            subtable += length;
+        }
+        std::stable_sort(face->kerning_.begin(), face->kerning_.end(), [](const auto& a, const auto& b) {
+            return a.first < b.first;
+        });
+    }
+
+    if (face->glyf_.length > 0 && face->loca_.length > 0) {
+        const uint32_t entry = face->long_loca_ ? 4 : 2;
+        if (face->loca_.length / entry < static_cast<uint32_t>(face->glyph_count_) + 1) {
+            return fail("Font 'loca' table is truncated");
+        }
+    } else if (face->cff_.length > 0) {
+        if (!face->ParseCff(error)) {
+            return nullptr;
+        }
+    } else {
+        return fail("Font has no supported glyph outlines");
+    }
+    return face;
+}
+
+uint16_t FontFace::GlyphForCodepoint(uint32_t codepoint) const {
+    const std::vector<uint8_t>& bytes = *data_;
+    const uint64_t table = cmap_subtable_.offset;
+    uint32_t glyph = 0;
+    if (cmap_format_ == 12) {
+        const uint32_t groups = ReadU32(bytes, table + 12);
+        const uint64_t max_groups = cmap_subtable_.length >= 16 ? (cmap_subtable_.length - 16) / 12 : 0;
+        uint32_t low = 0;
+        uint32_t high = static_cast<uint32_t>(std::min<uint64_t>(groups, max_groups));
+        while (low < high) {
+            const uint32_t mid = low + (high - low) / 2;
+            const uint64_t group = table + 16 + static_cast<uint64_t>(mid) * 12;
+            const uint32_t start = ReadU32(bytes, group);
+            const uint32_t end = ReadU32(bytes, group + 4);
+            if (codepoint < start) {
+                high = mid;
+            } else if (codepoint > end) {
+                low = mid + 1;
+            } else {
+                glyph = ReadU32(bytes, group + 8) + (codepoint - start);
+                break;
+            }
+        }
+    } else if (cmap_format_ == 4 && codepoint <= 0xFFFF) {
+        const uint32_t seg_count = ReadU16(bytes, table + 6) / 2;
+        const uint64_t end_codes = table + 14;
+        const uint64_t start_codes = end_codes + seg_count * 2 + 2;
+        const uint64_t deltas = start_codes + seg_count * 2;
+        const uint64_t range_offsets = deltas + seg_count * 2;
+        if (range_offsets + seg_count * 2 > static_cast<uint64_t>(table) + cmap_subtable_.length) {
+            return 0;
+        }
+        uint32_t low = 0;
+        uint32_t high = seg_count;
+        while (low < high) {
+            const uint32_t mid = low + (high - low) / 2;
+            if (ReadU16(bytes, end_codes + mid * 2) < codepoint) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        if (low < seg_count) {
+            const uint16_t start = ReadU16(bytes, start_codes + low * 2);
+            if (start <= codepoint) {
+                const uint16_t delta = ReadU16(bytes, deltas + low * 2);
+                const uint64_t range_offset_at = range_offsets + low * 2;
+                const uint16_t range_offset = ReadU16(bytes, range_offset_at);
+                if (range_offset == 0) {
+                    glyph = (codepoint + delta) & 0xFFFF;
+                } else {
+                    glyph = ReadU16(bytes, range_offset_at + range_offset + (codepoint - start) * 2);
+                    if (glyph != 0) {
+                        glyph = (glyph + delta) & 0xFFFF;
+                    }
+                }
+            }
+        }
+    }
+    return glyph < glyph_count_ ? static_cast<uint16_t>(glyph) : 0;
+}
+
+uint16_t FontFace::AdvanceWidth(uint16_t glyph) const {
+    const uint16_t metric = std::min<uint16_t>(glyph, static_cast<uint16_t>(metric_count_ - 1));
+    return ReadU16(*data_, static_cast<uint64_t>(hmtx_.offset) + metric * 4);
+}
+
+int16_t FontFace::Kerning(uint16_t left, uint16_t right) const {
+    if (kerning_.empty()) {
+        return 0;
+    }
+    const uint32_t key = (static_cast<uint32_t>(left) << 16) | right;
+    const auto it = std::lower_bound(kerning_.begin(), kerning_.end(), key, [](const auto& pair, uint32_t value) {
+        return pair.first < value;
+    });
+    return it != kerning_.end() && it->first == key ? it->second : 0;
+}
+
+bool FontFace::BuildOutline(uint16_t glyph, GlyphOutline& outline) const {
+    if (glyph >= glyph_count_) {
+        return false;
+    }
+    if (glyf_.length > 0) {
+        size_t components = 0;
+        return BuildTrueTypeOutline(glyph, AffineMatrix{}, 0, components, outline);
+    }
+    return BuildCffOutline(glyph, outline);
+}
+
+bool FontFace::BuildTrueTypeOutline(uint16_t glyph,
+                                    const AffineMatrix& matrix,
+                                    int depth,
+                                    size_t& components,
+                                    GlyphOutline& outline) const {
+    const std::vector<uint8_t>& bytes = *data_;
+    if (glyph >= glyph_count_ || depth > kMaxCompositeDepth || ++components > kMaxGlyphComponents ||
+        outline.points.size() > kMaxGlyphPoints) {
+        return false;
+    }
+    uint64_t begin = 0;
+    uint64_t end = 0;
+    if (long_loca_) {
+        begin = ReadU32(bytes, static_cast<uint64_t>(loca_.offset) + glyph * 4u);
+        end = ReadU32(bytes, static_cast<uint64_t>(loca_.offset) + (glyph + 1u) * 4u);
+    } else {
+        begin = static_cast<uint64_t>(ReadU16(bytes, static_cast<uint64_t>(loca_.offset) + glyph * 2u)) * 2;
+        end = static_cast<uint64_t>(ReadU16(bytes, static_cast<uint64_t>(loca_.offset) + (glyph + 1u) * 2u)) * 2;
+    }
+    if (end <= begin) {
+        return true;
+    }
+    if (end > glyf_.length || end - begin < 10) {
+        return false;
+    }
+    const uint64_t start = glyf_.offset + begin;
+    const uint64_t limit = glyf_.offset + end;
+    const int16_t contour_count = ReadS16(bytes, start);
+
+    if (contour_count < 0) {
+        uint64_t pos = start + 10;
+        uint16_t flags = 0;
+        do {
+            if (pos + 4 > limit) {
+                return false;
+            }
+            flags = ReadU16(bytes, pos);
+            const uint16_t component = ReadU16(bytes, pos + 2);
+            pos += 4;
+            double dx = 0.0;
+            double dy = 0.0;
+            const bool words = (flags & 0x0001) != 0;
+            const bool xy_values = (flags & 0x0002) != 0;
+            if (words) {
+                if (pos + 4 > limit) {
+                    return false;
+                }
+                if (xy_values) {
+                    dx = ReadS16(bytes, pos);
+                    dy = ReadS16(bytes, pos + 2);
+                }
+                pos += 4;
+            } else {
+                if (pos + 2 > limit) {
+                    return false;
+                }
+                if (xy_values) {
+                    dx = static_cast<int8_t>(bytes[pos]);
+                    dy = static_cast<int8_t>(bytes[pos + 1]);
+                }
+                pos += 2;
+            }
+            AffineMatrix transform;
+            if ((flags & 0x0008) != 0) {
+                if (pos + 2 > limit) {
+                    return false;
+                }
+                transform.a = transform.d = F2Dot14(ReadS16(bytes, pos));
+                pos += 2;
+            } else if ((flags & 0x0040) != 0) {
+                if (pos + 4 > limit) {
+                    return false;
+                }
+                transform.a = F2Dot14(ReadS16(bytes, pos));
+                transform.d = F2Dot14(ReadS16(bytes, pos + 2));
+                pos += 4;
+            } else if ((flags & 0x0080) != 0) {
+                if (pos + 8 > limit) {
+                    return false;
+                }
+                transform.a = F2Dot14(ReadS16(bytes, pos));
+                transform.b = F2Dot14(ReadS16(bytes, pos + 2));
+                transform.c = F2Dot14(ReadS16(bytes, pos + 4));
+                transform.d = F2Dot14(ReadS16(bytes, pos + 6));
+                pos += 8;
+            }
+            transform.e = dx;
+            transform.f = dy;
+            if (!BuildTrueTypeOutline(component, AffineMatrix::Concat(transform, matrix), depth + 1, components, outline)) {
+                return false;
+            }
+        } while ((flags & 0x0020) != 0);
+        return true;
+    }
+
+    // Simple glyph: end points, instructions, flags, then x and y deltas.
+    uint64_t pos = start + 10;
+    if (pos + static_cast<uint64_t>(contour_count) * 2 + 2 > limit) {
+        return false;
+    }
+    std::vector<uint16_t> end_points(static_cast<size_t>(contour_count));
+    for (int16_t i = 0; i < contour_count; ++i) {
+        end_points[static_cast<size_t>(i)] = ReadU16(bytes, pos);
+        if (i > 0 && end_points[static_cast<size_t>(i)] < end_points[static_cast<size_t>(i - 1)]) {
+            return false;
+        }
+        pos += 2;
+    }
+    if (contour_count == 0) {
+        return true;
+    }
+    const size_t point_count = static_cast<size_t>(end_points.back()) + 1;
+    if (point_count > kMaxGlyphPoints) {
+        return false;
+    }
+    pos += 2 + ReadU16(bytes, pos);
+
+    std::vector<uint8_t> flags(point_count);
+    for (size_t i = 0; i < point_count;) {
+        if (pos >= limit) {
+            return false;
+        }
+        const uint8_t flag = bytes[pos++];
+        size_t repeat = 1;
+        if ((flag & 0x08) != 0) {
+            if (pos >= limit) {
+                return false;
+            }
+            repeat += bytes[pos++];
+        }
+        for (size_t r = 0; r < repeat && i < point_count; ++r) {
+            flags[i++] = flag;
+        }
+    }
+
+    std::vector<Point> points(point_count);
+    for (int axis = 0; axis < 2; ++axis) {
+        const uint8_t short_bit = axis == 0 ? 0x02 : 0x04;
+        const uint8_t same_bit = axis == 0 ? 0x10 : 0x20;
+        double value = 0.0;
+        for (size_t i = 0; i < point_count; ++i) {
+            const uint8_t flag = flags[i];
+            if ((flag & short_bit) != 0) {
+                if (pos >= limit) {
+                    return false;
+                }
+                const double delta = bytes[pos++];
+                value += (flag & same_bit) != 0 ? delta : -delta;
+            } else if ((flag & same_bit) == 0) {
+                if (pos + 2 > limit) {
+                    return false;
+                }
+                value += ReadS16(bytes, pos);
+                pos += 2;
+            }
+            (axis == 0 ? points[i].x : points[i].y) = value;
+        }
+    }
+
+    // Quadratic contours: consecutive off-curve points imply an on-curve
+    // midpoint between them.
+    OutlineWriter writer(outline, matrix);
+    size_t contour_start = 0;
+    for (const uint16_t contour_end : end_points) {
+        const size_t count = static_cast<size_t>(contour_end) + 1 - contour_start;
+        const auto at = [&](size_t i) -> const Point& { return points[contour_start + (i % count)]; };
+        const auto on_curve = [&](size_t i) { return (flags[contour_start + (i % count)] & 0x01) != 0; };
+        const auto midpoint = [](const Point& a, const Point& b) { return Point{(a.x + b.x) * 0.5, (a.y + b.y) * 0.5}; };
+
+        size_t first_on = count;
+        for (size_t i = 0; i < count; ++i) {
+            if (on_curve(i)) {
+                first_on = i;
+                break;
+            }
+        }
+        const Point begin_point = first_on < count ? at(first_on) : midpoint(at(count - 1), at(0));
+        writer.MoveTo(begin_point.x, begin_point.y);
+
+        Point control;
+        bool has_control = false;
+        const size_t first = first_on < count ? first_on + 1 : 0;
+        for (size_t step = 0; step < count; ++step) {
+            const size_t i = first + step;
+            const Point& point = at(i);
+            if (first_on < count && step + 1 == count) {
+                break;
+            }
+            if (on_curve(i)) {
+                if (has_control) {
+                    writer.QuadTo(control.x, control.y, point.x, point.y);
+                } else {
+                    writer.LineTo(point.x, point.y);
+                }
+                has_control = false;
+            } else {
+                if (has_control) {
+                    const Point mid = midpoint(control, point);
+                    writer.QuadTo(control.x, control.y, mid.x, mid.y);
+                }
+                control = point;
+                has_control = true;
+            }
+        }
+        if (has_control) {
+            writer.QuadTo(control.x, control.y, begin_point.x, begin_point.y);
+        } else {
+            writer.LineTo(begin_point.x, begin_point.y);
+        }
+        writer.Close();
+        contour_start = static_cast<size_t>(contour_end) + 1;
+    }
+    return true;
+}
+
+bool FontFace::ReadIndex(uint32_t offset, CffIndex& index, uint32_t* end) const {
+    const std::vector<uint8_t>& bytes = *data_;
+    const uint64_t cff_end = static_cast<uint64_t>(cff_.offset) + cff_.length;
+    if (offset + 2ull > cff_end) {
+        return false;
+    }
+    index = CffIndex{};
+    index.count = ReadU16(bytes, offset);
+    if (index.count == 0) {
+        if (end != nullptr) {
+            *end = offset + 2;
+        }
+        return true;
+    }
+    index.offset_size = ReadU8(bytes, offset + 2ull);
+    if (index.offset_size < 1 || index.offset_size > 4) {
+        return false;
+    }
+    index.offsets = offset + 3;
+    const uint64_t data_start = static_cast<uint64_t>(index.offsets) + (index.count + 1ull) * index.offset_size - 1;
+    if (data_start > cff_end) {
+        return false;
+    }
+    index.data = static_cast<uint32_t>(data_start);
+    const uint64_t last = ReadOffset(bytes, index.offsets + static_cast<uint64_t>(index.count) * index.offset_size, index.offset_size);
+    if (data_start + last > cff_end) {
+        return false;
+    }
+    if (end != nullptr) {
+        *end = static_cast<uint32_t>(data_start + last);
+    }
+    return true;
+}
+
+bool FontFace::IndexObject(const CffIndex& index, uint32_t item, Range& range) const {
+    if (item >= index.count) {
+        return false;
+    }
+    const std::vector<uint8_t>& bytes = *data_;
+    const uint64_t at = index.offsets + static_cast<uint64_t>(item) * index.offset_size;
+    const uint32_t begin = ReadOffset(bytes, at, index.offset_size);
+    const uint32_t end = ReadOffset(bytes, at + index.offset_size, index.offset_size);
+    const uint64_t cff_end = static_cast<uint64_t>(cff_.offset) + cff_.length;
+    if (begin < 1 || end < begin || index.data + static_cast<uint64_t>(end) > cff_end) {
+        return false;
+    }
+    range = Range{index.data + begin, end - begin};
+    return true;
+}
+
+bool FontFace::ParsePrivate(const Range& dict, CffPrivate& out) const {
+    const std::vector<uint8_t>& bytes = *data_;
+    double size = 0.0;
+    double offset = 0.0;
+    bool has_private = false;
+    if (!ParseDict(bytes, dict.offset, static_cast<uint64_t>(dict.offset) + dict.length, [&](const DictEntry& entry) {
+            if (entry.op == 18 && entry.count >= 2) {
+                size = entry.operands[0];
+                offset = entry.operands[1];
+                has_private = true;
+            }
+        })) {
+        return false;
+    }
+    out = CffPrivate{};
+    if (!has_private) {
+        return true;
+    }
+    if (size < 0.0 || offset < 0.0 || offset + size > cff_.length) {
+        return false;
+    }
+    const uint64_t private_start = cff_.offset + static_cast<uint64_t>(offset);
+    double subrs = 0.0;
+    if (!ParseDict(bytes, private_start, private_start + static_cast<uint64_t>(size), [&](const DictEntry& entry) {
+            if (entry.op == 19 && entry.count >= 1) {
+                subrs = entry.operands[0];
+            }
+        })) {
+        return false;
+    }
+    if (subrs > 0.0) {
+        const uint64_t subrs_offset = private_start + static_cast<uint64_t>(subrs);
+        if (subrs_offset >= static_cast<uint64_t>(cff_.offset) + cff_.length ||
+            !ReadIndex(static_cast<uint32_t>(subrs_offset), out.subrs, nullptr)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FontFace::ParseCff(RenderError& error) {
+    const auto fail = [&error](const char* message) {
+        error.code = RenderErrorCode::kInvalidDocument;
+        error.message = message;
+        return false;
+    };
+    const std::vector<uint8_t>& bytes = *data_;
+    if (cff_.length < 4 || ReadU8(bytes, cff_.offset) != 1) {
+        return fail("Unsupported CFF version");
+    }
+    CffIndex names;
+    CffIndex top_dicts;
+    CffIndex strings;
+    uint32_t next = cff_.offset + ReadU8(bytes, cff_.offset + 2ull);
+    if (!ReadIndex(next, names, &next) ||
+        !ReadIndex(next, top_dicts, &next) ||
+        !ReadIndex(next, strings, &next) ||
+        !ReadIndex(next, global_subrs_, &next)) {
+        return fail("Malformed CFF header");
+    }
+    Range top;
+    if (!IndexObject(top_dicts, 0, top)) {
+        return fail("CFF font has no Top DICT");
+    }
+
+    double char_strings = 0.0;
+    double fd_array = 0.0;
+    double fd_select = 0.0;
+    if (!ParseDict(bytes, top.offset, static_cast<uint64_t>(top.offset) + top.length, [&](const DictEntry& entry) {
+            if (entry.count == 0) {
+                return;
+            }
+            if (entry.op == 17) {
+                char_strings = entry.operands[0];
+            } else if (entry.op == 1230) {
+                cid_keyed_ = true;
+            } else if (entry.op == 1236) {
+                fd_array = entry.operands[0];
+            } else if (entry.op == 1237) {
+                fd_select = entry.operands[0];
+            }
+        })) {
+        return fail("Malformed CFF Top DICT");
+    }
+    const auto in_cff = [this](double offset) { return offset > 0.0 && offset < cff_.length; };
+    if (!in_cff(char_strings) ||
+        !ReadIndex(cff_.offset + static_cast<uint32_t>(char_strings), char_strings_, nullptr) ||
+        char_strings_.count < glyph_count_) {
+        return fail("Malformed CFF CharStrings");
+    }
+
+    if (cid_keyed_) {
+        CffIndex font_dicts;
+        if (!in_cff(fd_array) || !in_cff(fd_select) ||
+            !ReadIndex(cff_.offset + static_cast<uint32_t>(fd_array), font_dicts, nullptr) ||
+            font_dicts.count == 0 || font_dicts.count > 256) {
+            return fail("Malformed CID-keyed CFF font");
+        }
+        fd_select_ = cff_.offset + static_cast<uint32_t>(fd_select);
+        privates_.resize(font_dicts.count);
+        for (uint32_t i = 0; i < font_dicts.count; ++i) {
+            Range dict;
+            if (!IndexObject(font_dicts, i, dict) || !ParsePrivate(dict, privates_[i])) {
+                return fail("Malformed CFF Font DICT");
+            }
+        }
+    } else {
+        privates_.resize(1);
+        if (!ParsePrivate(top, privates_[0])) {
+            return fail("Malformed CFF Private DICT");
+        }
+    }
+    return true;
+}
+
+uint8_t FontFace::FontDictForGlyph(uint16_t glyph) const {
+    if (!cid_keyed_) {
+        return 0;
+    }
+    const std::vector<uint8_t>& bytes = *data_;
+    const uint64_t cff_end = static_cast<uint64_t>(cff_.offset) + cff_.length;
+    const uint8_t format = ReadU8(bytes, fd_select_);
+    if (format == 0) {
+        return fd_select_ + 1ull + glyph < cff_end ? ReadU8(bytes, fd_select_ + 1ull + glyph) : 0;
+    }
+    if (format == 3) {
+        const uint16_t ranges = ReadU16(bytes, fd_select_ + 1ull);
+        for (uint16_t i = 0; i < ranges; ++i) {
+            const uint64_t range = fd_select_ + 3ull + i * 3ull;
+            if (range + 5 > cff_end) {
+                break;
+            }
+            const uint16_t first = ReadU16(bytes, range);
+            const uint16_t next_first = ReadU16(bytes, range + 3);
+            if (glyph >= first && glyph < next_first) {
+                return ReadU8(bytes, range + 2);
+            }
+        }
+    }
+    return 0;
+}
+
+namespace {
+
+// Type 2 charstring interpreter: only path construction is modelled; hints
+// are counted so hintmask bytes can be skipped.
+class CharstringRunner {
+public:
+    CharstringRunner(const std::vector<uint8_t>& bytes, OutlineWriter& writer) : bytes_(bytes), writer_(writer) {}
+
+    template <typename SubrLookup>
+    bool Run(uint32_t offset, uint32_t length, int depth, SubrLookup&& lookup) {
+        if (depth > kMaxSubrDepth) {
+            return false;
+        }
+        uint64_t pos = offset;
+        const uint64_t end = static_cast<uint64_t>(offset) + length;
+        while (pos < end && !ended_) {
+            if (++ops_ > kMaxCharstringOps) {
+                return false;
+            }
+            const uint8_t b0 = bytes_[pos++];
+            if (b0 == 28 || b0 >= 32) {
+                double value = 0.0;
+                if (b0 == 28) {
+                    if (pos + 2 > end) {
+                        return false;
+                    }
+                    value = ReadS16(bytes_, pos);
+                    pos += 2;
+                } else if (b0 <= 246) {
+                    value = static_cast<int>(b0) - 139;
+                } else if (b0 <= 250) {
+                    if (pos >= end) {
+                        return false;
+                    }
+                    value = (static_cast<int>(b0) - 247) * 256 + bytes_[pos++] + 108;
+                } else if (b0 <= 254) {
+                    if (pos >= end) {
+                        return false;
+                    }
+                    value = -(static_cast<int>(b0) - 251) * 256 - bytes_[pos++] - 108;
+                } else {
+                    if (pos + 4 > end) {
+                        return false;
+                    }
+                    value = static_cast<int32_t>(ReadU32(bytes_, pos)) / 65536.0;
+                    pos += 4;
+                }
+                if (count_ >= kMaxCffStack) {
+                    return false;
+                }
+                stack_[count_++] = value;
+                continue;
+            }
+
+            switch (b0) {
+                case 1:
+                case 3:
+                case 18:
+                case 23:
+                    CountStems();
+                    break;
+                case 19:
+                case 20:
+                    CountStems();
+                    pos += (stems_ + 7) / 8;
+                    break;
+                case 21: {
+                    const size_t i = TakeWidth(count_ > 2);
+                    if (count_ < i + 2) {
+                        return false;
+                    }
+                    MoveBy(stack_[i], stack_[i + 1]);
+                    break;
+                }
+                case 22: {
+                    const size_t i = TakeWidth(count_ > 1);
+                    if (count_ < i + 1) {
+                        return false;
+                    }
+                    MoveBy(stack_[i], 0.0);
+                    break;
+                }
+                case 4: {
+                    const size_t i = TakeWidth(count_ > 1);
+                    if (count_ < i + 1) {
+                        return false;
+                    }
+                    MoveBy(0.0, stack_[i]);
+                    break;
+                }
+                case 5:
+                    for (size_t i = 0; i + 1 < count_; i += 2) {
+                        LineBy(stack_[i], stack_[i + 1]);
+                    }
+                    break;
+                case 6:
+                case 7: {
+                    bool horizontal = b0 == 6;
+                    for (size_t i = 0; i < count_; ++i) {
+                        LineBy(horizontal ? stack_[i] : 0.0, horizontal ? 0.0 : stack_[i]);
+                        horizontal = !horizontal;
+                    }
+                    break;
+                }
+                case 8:
+                    for (size_t i = 0; i + 5 < count_; i += 6) {
+                        CurveBy(i);
+                    }
+                    break;
+                case 24: {
+                    size_t i = 0;
+                    for (; i + 8 <= count_; i += 6) {
+                        CurveBy(i);
+                    }
+                    if (i + 1 < count_) {
+                        LineBy(stack_[i], stack_[i + 1]);
+                    }
+                    break;
+                }
+                case 25: {
+                    size_t i = 0;
+                    for (; i + 8 <= count_; i += 2) {
+                        LineBy(stack_[i], stack_[i + 1]);
+                    }
+                    if (i + 5 < count_) {
+                        CurveBy(i);
+                    }
+                    break;
+                }
+                case 26:
+                case 27: {
+                    // vvcurveto / hhcurveto: an odd leading operand offsets
+                    // the first curve across its main direction.
+                    const bool horizontal = b0 == 27;
+                    size_t i = count_ % 2;
+                    double across = i == 1 ? stack_[0] : 0.0;
+                    for (; i + 3 < count_; i += 4) {
+                        const double a = stack_[i];
+                        if (horizontal) {
+                            Curve(a, across, stack_[i + 1], stack_[i + 2], stack_[i + 3], 0.0);
+                        } else {
+                            Curve(across, a, stack_[i + 1], stack_[i + 2], 0.0, stack_[i + 3]);
+                        }
+                        across = 0.0;
+                    }
+                    break;
+                }
+                case 30:
+                case 31: {
+                    bool horizontal = b0 == 31;
+                    for (size_t i = 0; i + 3 < count_;) {
+                        const bool last = count_ - i == 5;
+                        const double extra = last ? stack_[i + 4] : 0.0;
+                        if (horizontal) {
+                            Curve(stack_[i], 0.0, stack_[i + 1], stack_[i + 2], extra, stack_[i + 3]);
+                        } else {
+                            Curve(0.0, stack_[i], stack_[i + 1], stack_[i + 2], stack_[i + 3], extra);
+                        }
+                        i += last ? 5 : 4;
+                        horizontal = !horizontal;
+                    }
+                    break;
+                }
+                case 10:
+                case 29: {
+                    if (count_ == 0) {
+                        return false;
+                    }
+                    const double index = stack_[--count_];
+                    uint32_t sub_offset = 0;
+                    uint32_t sub_length = 0;
+                    if (!lookup(b0 == 29, index, sub_offset, sub_length) ||
+                        !Run(sub_offset, sub_length, depth + 1, lookup)) {
+                        return false;
+                    }
+                    continue;
+                }
+                case 11:
+                    return true;
+                case 14:
+                    (void)TakeWidth(count_ == 1 || count_ == 5);
+                    writer_.Close();
+                    ended_ = true;
+                    return true;
+                case 12: {
+                    if (pos >= end) {
+                        return false;
+                    }
+                    const uint8_t b1 = bytes_[pos++];
+                    Flex(b1);
+                    break;
+                }
+                default:
+                    break;
+            }
+            count_ = 0;
+        }
+        return true;
+    }
+
+    bool ended() const { return ended_; }
+
+private:
+    size_t TakeWidth(bool has_width) {
+        const bool first = !width_seen_;
+        width_seen_ = true;
+        return first && has_width ? 1 : 0;
+    }
+
+    void CountStems() {
+        const size_t first = TakeWidth(count_ % 2 == 1);
+        stems_ += (count_ - first) / 2;
+    }
+
+    void MoveBy(double dx, double dy) {
+        x_ += dx;
+        y_ += dy;
+        writer_.MoveTo(x_, y_);
+    }
+
+    void LineBy(double dx, double dy) {
+        x_ += dx;
+        y_ += dy;
+        writer_.LineTo(x_, y_);
+    }
+
+    void Curve(double dx1, double dy1, double dx2, double dy2, double dx3, double dy3) {
+        const double x1 = x_ + dx1;
+        const double y1 = y_ + dy1;
+        const double x2 = x1 + dx2;
+        const double y2 = y1 + dy2;
+        x_ = x2 + dx3;
+        y_ = y2 + dy3;
+        writer_.CubicTo(x1, y1, x2, y2, x_, y_);
+    }
+
+    void CurveBy(size_t i) {
+        Curve(stack_[i], stack_[i + 1], stack_[i + 2], stack_[i + 3], stack_[i + 4], stack_[i + 5]);
+    }
+
+    void Flex(uint8_t op) {
+        const double* s = stack_.data();
+        const double start_y = y_;
+        if (op == 35 && count_ >= 12) {
+            CurveBy(0);
+            CurveBy(6);
+        } else if (op == 34 && count_ >= 7) {
+            Curve(s[0], 0.0, s[1], s[2], s[3], 0.0);
+            Curve(s[4], 0.0, s[5], start_y - y_, s[6], 0.0);
+        } else if (op == 36 && count_ >= 9) {
+            Curve(s[0], s[1], s[2], s[3], s[4], 0.0);
+            const double x1 = x_ + s[5];
+            const double y1 = y_;
+            const double x2 = x1 + s[6];
+            const double y2 = y1 + s[7];
+            x_ = x2 + s[8];
+            y_ = start_y;
+            writer_.CubicTo(x1, y1, x2, y2, x_, y_);
+        } else if (op == 37 && count_ >= 11) {
+            const double start_x = x_;
+            double dx = 0.0;
+            double dy = 0.0;
+            for (size_t i = 0; i < 10; i += 2) {
+                dx += s[i];
+                dy += s[i + 1];
+            }
+            Curve(s[0], s[1], s[2], s[3], s[4], s[5]);
+            const double x1 = x_ + s[6];
+            const double y1 = y_ + s[7];
+            const double x2 = x1 + s[8];
+            const double y2 = y1 + s[9];
+            if (std::fabs(dx) > std::fabs(dy)) {
+                x_ = x2 + s[10];
+                y_ = start_y;
+            } else {
+                x_ = start_x;
+                y_ = y2 + s[10];
+            }
+            writer_.CubicTo(x1, y1, x2, y2, x_, y_);
+        }
+    }
+
+    const std::vector<uint8_t>& bytes_;
+    OutlineWriter& writer_;
+    std::array<double, kMaxCffStack> stack_{};
+    size_t count_ = 0;
+    size_t stems_ = 0;
+    size_t ops_ = 0;
+    double x_ = 0.0;
+    double y_ = 0.0;
+    bool width_seen_ = false;
+    bool ended_ = false;
+};
+
+} // namespace
+
+bool FontFace::BuildCffOutline(uint16_t glyph, GlyphOutline& outline) const {
+    Range char_string;
+    if (!IndexObject(char_strings_, glyph, char_string)) {
+        return false;
+    }
+    const uint8_t font_dict = FontDictForGlyph(glyph);
+    if (font_dict >= privates_.size()) {
+        return false;
+    }
+    const CffIndex& local_subrs = privates_[font_dict].subrs;
+
+    const AffineMatrix identity;
+    OutlineWriter writer(outline, identity);
+    CharstringRunner runner(*data_, writer);
+    const auto lookup = [&](bool global, double index, uint32_t& offset, uint32_t& length) {
+        const CffIndex& subrs = global ? global_subrs_ : local_subrs;
+        const double biased = index + SubrBias(subrs.count);
+        if (!(biased >= 0.0) || biased >= static_cast<double>(subrs.count)) {
+            return false;
+        }
+        Range range;
+        if (!IndexObject(subrs, static_cast<uint32_t>(biased), range)) {
+            return false;
+        }
+        offset = range.offset;
+        length = range.length;
+        return true;
+    };
+    if (!runner.Run(char_string.offset, char_string.length, 0, lookup)) {
+        return false;
+    }
+    writer.Close();
+    return true;
+}
+
+} // namespace csvg
@@ -0,0 +1,140 @@
+#include "YepSVGCore/FontFamilies.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+
+namespace csvg {
+namespace {
+
+std::string Trim(const std::string& value) {
+    const auto begin = value.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    const auto end = value.find_last_not_of(" \t\r\n");
+    return value.substr(begin, end - begin + 1);
+}
+
+std::string Lower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
+
+std::string ResolveGenericFontFamily(const std::string& family) {
+    const std::string normalized = Lower(Trim(family));
+    if (normalized == "sans-serif") {
+        return "Helvetica";
+    }
+    if (normalized == "serif") {
+        return "Times New Roman";
+    }
+    if (normalized == "monospace") {
+        return "Courier";
+    }
+    return Trim(family);
+}
+
+std::string SystemFallbackFamily() {
+    return "Helvetica";
+}
+
+bool IsGenericFamily(const std::string& v) {
+    const std::string s = Lower(Trim(v));
+    return s == "serif" ||
+           s == "sans-serif" ||
+           s == "monospace" ||
+           s == "cursive" ||
+           s == "fantasy" ||
+           s == "system-ui" ||
+           s == "ui-serif" ||
+           s == "ui-sans-serif" ||
+           s == "ui-monospace" ||
+           s == "ui-rounded" ||
+           s == "emoji" ||
+           s == "math" ||
+           s == "fangsong";
+}
+std::string MapGenericToAppleFamily(const std::string& generic) {
+    const std::string g = Lower(Trim(generic));
+    if (g == "sans-serif" || g == "ui-sans-serif" || g == "system-ui") return "Helvetica";
+    if (g == "serif" || g == "ui-serif") return "Times New Roman";
+    if (g == "monospace" || g == "ui-monospace") return "Courier";
+    if (g == "ui-rounded") return "Helvetica";
+    if (g == "cursive") return "Snell Roundhand";
+    if (g == "fantasy") return "Papyrus";
+    if (g == "emoji") return "Apple Color Emoji";
+    return "";
+}
+
+// Families of a CSS font-family list in order, trimmed and unquoted.
+std::vector<std::string> SplitFontFamilies(const std::string& font_family) {
+    std::vector<std::string> families;
+    std::stringstream stream(font_family);
+    std::string candidate;
+    while (std::getline(stream, candidate, ',')) {
+        candidate = Trim(candidate);
+        if (candidate.size() >= 2 &&
+            ((candidate.front() == '"' && candidate.back() == '"') ||
+             (candidate.front() == '\'' && candidate.back() == '\''))) {
+            candidate = Trim(candidate.substr(1, candidate.size() - 2));
+        }
+        if (!candidate.empty()) {
+            families.push_back(candidate);
+        }
+    }
+    return families;
+}
+
+} // namespace
+
+std::vector<std::string> ResolveTextFontFamilies(const std::string& font_family) {
+    std::vector<std::string> families;
+    for (const auto& candidate : SplitFontFamilies(font_family)) {
+        families.push_back(ResolveGenericFontFamily(candidate));
+    }
+    if (families.empty()) {
+        families.push_back(SystemFallbackFamily());
+    }
+    return families;
+}
+
+std::string FirstGenericFontFamily(const std::string& font_family_css) {
+    for (const auto& candidate : SplitFontFamilies(font_family_css)) {
+        if (IsGenericFamily(candidate)) {
+            return Lower(candidate);
+        }
+    }
+    return "";
+}
+
+std::string ResolveCssFontFamily(const std::string& font_family_css,
+                                 const std::function<bool(const std::string&)>& family_exists) {
+    const auto candidates = ResolveTextFontFamilies(font_family_css);
+
+    for (const auto& raw : candidates) {
+        const std::string name = Trim(raw);
+        if (name.empty()) continue;
+
+        if (IsGenericFamily(name)) {
+            const std::string mapped = MapGenericToAppleFamily(name);
+            if (!mapped.empty() && family_exists(mapped)) {
+                return mapped;
+            }
+            continue;
+        }
+
+        if (family_exists(name)) {
+            return name;
+        }
+    }
+
+    const std::string fallback = SystemFallbackFamily();
+    if (!fallback.empty() && family_exists(fallback)) {
+        return fallback;
+    }
+
+    return !candidates.empty() ? candidates.front() : SystemFallbackFamily();
+}
+
+} // namespace csvg
@@ -0,0 +1,311 @@
+#include "YepSVGCore/FontLibrary.hpp"
+
+#include "YepSVGCore/FontFamilies.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <tuple>
+
+namespace csvg {
+namespace {
+
+// Bounds memory for libraries that see unbounded distinct glyphs; the whole
+// table is dropped and rebuilt from the glyphs still in use.
+constexpr size_t kMaxOutlines = 16384;
+
+std::string Trim(const std::string& value) {
+    const auto begin = value.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    const auto end = value.find_last_not_of(" \t\r\n");
+    return value.substr(begin, end - begin + 1);
+}
+
+std::string Lower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
+
+bool IsFontFileExtension(std::string extension) {
+    extension = Lower(extension);
+    return extension == ".ttf" || extension == ".otf" || extension == ".ttc" || extension == ".otc";
+}
+
+// Lower is better. CSS Fonts 4 §5.2: between 400 and 500 try up to 500,
+// then lighter, then heavier; below 400 lighter first; above 500 heavier.
+std::tuple<int, int> WeightDistance(int desired, int actual) {
+    if (actual == desired) {
+        return {0, 0};
+    }
+    if (desired >= 400 && desired <= 500) {
+        if (actual > desired && actual <= 500) {
+            return {1, actual - desired};
+        }
+        if (actual < desired) {
+            return {2, desired - actual};
+        }
+        return {3, actual - desired};
+    }
+    if (desired < 400) {
+        return actual < desired ? std::make_tuple(1, desired - actual) : std::make_tuple(2, actual - desired);
+    }
+    return actual > desired ? std::make_tuple(1, actual - desired) : std::make_tuple(2, desired - actual);
+}
+
+enum class FaceClass {
+    kSansSerif,
+    kSerif,
+    kMonospace,
+    kOther,
+};
+
+FaceClass ClassOfFace(const FontFace& face) {
+    if (face.fixed_pitch()) {
+        return FaceClass::kMonospace;
+    }
+    return face.serif() ? FaceClass::kSerif : FaceClass::kSansSerif;
+}
+
+// Lists without a generic family fall back to the sans-serif system family.
+FaceClass ClassOfGeneric(const std::string& generic) {
+    if (generic.empty() || generic == "sans-serif" || generic == "ui-sans-serif" || generic == "system-ui" ||
+        generic == "ui-rounded") {
+        return FaceClass::kSansSerif;
+    }
+    if (generic == "serif" || generic == "ui-serif") {
+        return FaceClass::kSerif;
+    }
+    if (generic == "monospace" || generic == "ui-monospace") {
+        return FaceClass::kMonospace;
+    }
+    return FaceClass::kOther;
+}
+
+// Decodes one UTF-8 sequence at |pos|; malformed bytes become U+FFFD.
+uint32_t NextCodepoint(const std::string& text, size_t& pos) {
+    const auto byte = [&](size_t i) { return static_cast<uint8_t>(text[i]); };
+    const uint8_t lead = byte(pos++);
+    if (lead < 0x80) {
+        return lead;
+    }
+    size_t extra = 0;
+    uint32_t codepoint = 0;
+    if ((lead & 0xE0) == 0xC0) {
+        extra = 1;
+        codepoint = lead & 0x1F;
+    } else if ((lead & 0xF0) == 0xE0) {
+        extra = 2;
+        codepoint = lead & 0x0F;
+    } else if ((lead & 0xF8) == 0xF0) {
+        extra = 3;
+        codepoint = lead & 0x07;
+    } else {
+        return 0xFFFD;
+    }
+    for (size_t i = 0; i < extra; ++i) {
+        if (pos >= text.size() || (byte(pos) & 0xC0) != 0x80) {
+            return 0xFFFD;
+        }
+        codepoint = (codepoint << 6) | (byte(pos++) & 0x3F);
+    }
+    return codepoint <= 0x10FFFF ? codepoint : 0xFFFD;
+}
+
+} // namespace
+
+size_t FontLibrary::AddFontData(std::vector<uint8_t> data, RenderError& error) {
+    error = {};
+    const auto bytes = std::make_shared<const std::vector<uint8_t>>(std::move(data));
+    const uint32_t count = FontFace::FaceCount(*bytes);
+    std::vector<std::shared_ptr<const FontFace>> parsed;
+    for (uint32_t i = 0; i < count; ++i) {
+        RenderError face_error;
+        if (auto face = FontFace::Parse(bytes, i, face_error)) {
+            parsed.push_back(std::move(face));
+        } else if (error.code == RenderErrorCode::kNone) {
+            error = face_error;
+        }
+    }
+    if (parsed.empty()) {
+        if (error.code == RenderErrorCode::kNone) {
+            error.code = RenderErrorCode::kInvalidDocument;
+            error.message = "Not a TrueType or OpenType font";
+        }
+        return 0;
+    }
+    error = {};
+    std::lock_guard<std::mutex> lock(mutex_);
+    faces_.insert(faces_.end(), parsed.begin(), parsed.end());
+    return parsed.size();
+}
+
+size_t FontLibrary::AddFontFile(const std::string& path, RenderError& error) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input.is_open()) {
+        error.code = RenderErrorCode::kExternalResourceFailed;
+        error.message = "Unable to open font file: " + path;
+        return 0;
+    }
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    return AddFontData(std::move(bytes), error);
+}
+
+size_t FontLibrary::AddFontDirectory(const std::string& path) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    std::vector<std::string> files;
+    for (fs::recursive_directory_iterator it(path, fs::directory_options::skip_permission_denied, ec), end;
+         !ec && it != end;
+         it.increment(ec)) {
+        if (it->is_regular_file(ec) && IsFontFileExtension(it->path().extension().string())) {
+            files.push_back(it->path().string());
+        }
+    }
+    // Registration order decides fallback order, so keep it stable.
+    std::sort(files.begin(), files.end());
+    size_t added = 0;
+    for (const auto& file : files) {
+        RenderError error;
+        added += AddFontFile(file, error);
+    }
+    return added;
+}
+
+size_t FontLibrary::face_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return faces_.size();
+}
+
+std::shared_ptr<const FontFace> FontLibrary::Match(const std::string& font_family_css, int weight, bool italic) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (faces_.empty()) {
+        return nullptr;
+    }
+    const auto family_exists = [this](const std::string& family) {
+        const std::string wanted = Lower(Trim(family));
+        return std::any_of(faces_.begin(), faces_.end(), [&](const auto& face) {
+            return Lower(Trim(face->family())) == wanted;
+        });
+    };
+    const std::string family = Lower(Trim(ResolveCssFontFamily(font_family_css, family_exists)));
+
+    const auto closest = [&](const auto& accepts) {
+        std::shared_ptr<const FontFace> best;
+        std::tuple<int, int, int> best_score;
+        for (const auto& face : faces_) {
+            if (!accepts(*face)) {
+                continue;
+            }
+            const auto [rank, distance] = WeightDistance(weight, face->weight());
+            const std::tuple<int, int, int> score{face->italic() == italic ? 0 : 1, rank, distance};
+            if (best == nullptr || score < best_score) {
+                best = face;
+                best_score = score;
+            }
+        }
+        return best;
+    };
+    if (auto face = closest([&](const FontFace& face) { return Lower(Trim(face.family())) == family; })) {
+        return face;
+    }
+    // No registered family matched: stand in with a face of the generic
+    // family's class, else any face, still matching weight and style.
+    const FaceClass wanted = ClassOfGeneric(FirstGenericFontFamily(font_family_css));
+    if (auto face = closest([&](const FontFace& face) { return ClassOfFace(face) == wanted; })) {
+        return face;
+    }
+    return closest([](const FontFace&) { return true; });
+}
+
+std::shared_ptr<const GlyphOutline> FontLibrary::Outline(const FontFace& face, uint16_t glyph) const {
+    const OutlineKey key{&face, glyph};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (const auto it = outlines_.find(key); it != outlines_.end()) {
+            return it->second;
+        }
+    }
+    auto outline = std::make_shared<GlyphOutline>();
+    if (!face.BuildOutline(glyph, *outline)) {
+        outline.reset();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (outlines_.size() >= kMaxOutlines) {
+        outlines_.clear();
+    }
+    outlines_.emplace(key, outline);
+    return outline;
+}
+
+ShapedText FontLibrary::Shape(const std::string& text,
+                              const FontFace& face,
+                              double font_size,
+                              double letter_spacing,
+                              double word_spacing) const {
+    ShapedText shaped;
+    if (!(font_size > 0.0) || !std::isfinite(font_size)) {
+        return shaped;
+    }
+    shaped.ascent = face.ascender() * font_size / face.units_per_em();
+    shaped.descent = -face.descender() * font_size / face.units_per_em();
+
+    std::vector<std::shared_ptr<const FontFace>> fallbacks;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        fallbacks = faces_;
+    }
+
+    double pen = 0.0;
+    const FontFace* previous_face = nullptr;
+    uint16_t previous_glyph = 0;
+    for (size_t pos = 0; pos < text.size();) {
+        const uint32_t codepoint = NextCodepoint(text, pos);
+        const FontFace* glyph_face = &face;
+        uint16_t glyph = face.GlyphForCodepoint(codepoint);
+        if (glyph == 0 && codepoint >= 0x20) {
+            for (const auto& fallback : fallbacks) {
+                if (const uint16_t found = fallback->GlyphForCodepoint(codepoint); found != 0) {
+                    glyph_face = fallback.get();
+                    glyph = found;
+                    break;
+                }
+            }
+        }
+        const double scale = font_size / glyph_face->units_per_em();
+        if (previous_face == glyph_face) {
+            pen += glyph_face->Kerning(previous_glyph, glyph) * scale;
+        }
+        shaped.glyphs.push_back(ShapedGlyph{glyph_face, glyph, pen});
+        pen += glyph_face->AdvanceWidth(glyph) * scale + letter_spacing;
+        if (codepoint == ' ') {
+            pen += word_spacing;
+        }
+        previous_face = glyph_face;
+        previous_glyph = glyph;
+    }
+    shaped.width = pen;
+    return shaped;
+}
+
+void FontLibrary::EmitText(const ShapedText& shaped, double font_size, double x, double y, PathDataSink& sink) const {
+    for (const ShapedGlyph& glyph : shaped.glyphs) {
+        const auto outline = Outline(*glyph.face, glyph.glyph);
+        if (outline == nullptr) {
+            continue;
+        }
+        const double scale = font_size / glyph.face->units_per_em();
+        AffineMatrix matrix;
+        matrix.a = scale;
+        matrix.d = -scale;
+        matrix.e = x + glyph.x;
+        matrix.f = y;
+        outline->Emit(matrix, sink);
+    }
+}
+
+} // namespace csvg
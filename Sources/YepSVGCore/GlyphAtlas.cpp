@@ -0,0 +1,301 @@
+#include "YepSVGCore/GlyphAtlas.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace csvg {
+namespace {
+
+// Largest single glyph mask; anything bigger is drawn as a path.
+constexpr int kMaxGlyphExtent = 128;
+// Largest composited line mask, in device pixels.
+constexpr int64_t kMaxLinePixels = 4 * 1024 * 1024;
+constexpr double kAxisEpsilon = 1e-6;
+
+std::string FontName(CTFontRef font) {
+    CFStringRef name = CTFontCopyPostScriptName(font);
+    if (name == nullptr) {
+        return "";
+    }
+    char buffer[256];
+    std::string out;
+    if (CFStringGetCString(name, buffer, sizeof(buffer), kCFStringEncodingUTF8)) {
+        out = buffer;
+    }
+    CFRelease(name);
+    return out;
+}
+
+} // namespace
+
+GlyphAtlas::~GlyphAtlas() {
+    Reset();
+}
+
+void GlyphAtlas::Reset() {
+    for (const auto& entry : strikes_) {
+        CFRelease(entry.second.font);
+    }
+    strikes_.clear();
+    pages_.clear();
+}
+
+GlyphAtlas::Strike* GlyphAtlas::StrikeFor(CTFontRef font, double device_size) {
+    std::string key = FontName(font);
+    if (key.empty()) {
+        return nullptr;
+    }
+    const float size = static_cast<float>(device_size);
+    char size_bytes[sizeof(float)];
+    std::memcpy(size_bytes, &size, sizeof(float));
+    key.push_back('\0');
+    key.append(size_bytes, sizeof(float));
+
+    if (const auto it = strikes_.find(key); it != strikes_.end()) {
+        return &it->second;
+    }
+    CTFontRef device_font = CTFontCreateCopyWithAttributes(font, static_cast<CGFloat>(device_size), nullptr, nullptr);
+    if (device_font == nullptr) {
+        return nullptr;
+    }
+    Strike& strike = strikes_[key];
+    strike.font = device_font;
+    return &strike;
+}
+
+bool GlyphAtlas::Allocate(int width, int height, Entry& entry) {
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (!pages_.empty()) {
+            Page& page = pages_.back();
+            if (page.shelf_x + width > kPageSize) {
+                page.shelf_y += page.shelf_height;
+                page.shelf_x = 0;
+                page.shelf_height = 0;
+            }
+            if (page.shelf_y + height <= kPageSize) {
+                entry.page = static_cast<uint16_t>(pages_.size() - 1);
+                entry.x = static_cast<uint16_t>(page.shelf_x);
+                entry.y = static_cast<uint16_t>(page.shelf_y);
+                page.shelf_x += width;
+                page.shelf_height = std::max(page.shelf_height, height);
+                return true;
+            }
+        }
+        if (pages_.size() >= kMaxPages) {
+            return false;
+        }
+        pages_.emplace_back().coverage.assign(static_cast<size_t>(kPageSize) * kPageSize, 0);
+    }
+    return false;
+}
+
+GlyphAtlas::LookupResult GlyphAtlas::Lookup(Strike& strike, CGGlyph glyph, int bucket_x, int bucket_y, Entry& entry) {
+    const uint32_t key = (static_cast<uint32_t>(glyph) << 8) | (static_cast<uint32_t>(bucket_y) << 4) | static_cast<uint32_t>(bucket_x);
+    if (const auto it = strike.entries.find(key); it != strike.entries.end()) {
+        entry = it->second;
+        return LookupResult::kFound;
+    }
+
+    entry = Entry{};
+    CGRect bounds = CGRectZero;
+    CTFontGetBoundingRectsForGlyphs(strike.font, kCTFontOrientationHorizontal, &glyph, &bounds, 1);
+    if (!CGRectIsEmpty(bounds) && !CGRectIsNull(bounds)) {
+        const double offset_x = static_cast<double>(bucket_x) / kSubpixelSteps;
+        const double offset_y = static_cast<double>(bucket_y) / kSubpixelSteps;
+        // One pixel of padding keeps antialiased edges inside the mask.
+        const int left = static_cast<int>(std::floor(CGRectGetMinX(bounds) + offset_x)) - 1;
+        const int bottom = static_cast<int>(std::floor(CGRectGetMinY(bounds) + offset_y)) - 1;
+        const int right = static_cast<int>(std::ceil(CGRectGetMaxX(bounds) + offset_x)) + 1;
+        const int top = static_cast<int>(std::ceil(CGRectGetMaxY(bounds) + offset_y)) + 1;
+        const int width = right - left;
+        const int height = top - bottom;
+        if (width > kMaxGlyphExtent || height > kMaxGlyphExtent) {
+            return LookupResult::kIneligible;
+        }
+        if (!Allocate(width, height, entry)) {
+            return LookupResult::kAtlasFull;
+        }
+        entry.width = static_cast<uint16_t>(width);
+        entry.height = static_cast<uint16_t>(height);
+        entry.left = static_cast<int16_t>(left);
+        entry.bottom = static_cast<int16_t>(bottom);
+
+        // Rasterize straight into the page; bitmap rows run top down.
+        Page& page = pages_[entry.page];
+        uint8_t* origin = page.coverage.data() + static_cast<size_t>(entry.y) * kPageSize + entry.x;
+        CGContextRef bitmap = CGBitmapContextCreate(origin,
+                                                    static_cast<size_t>(width),
+                                                    static_cast<size_t>(height),
+                                                    8,
+                                                    kPageSize,
+                                                    nullptr,
+                                                    static_cast<CGBitmapInfo>(kCGImageAlphaOnly));
+        if (bitmap == nullptr) {
+            return LookupResult::kIneligible;
+        }
+        CGContextSetShouldAntialias(bitmap, true);
+        CGContextSetShouldSmoothFonts(bitmap, false);
+        CGContextSetAllowsFontSubpixelPositioning(bitmap, true);
+        CGContextSetShouldSubpixelPositionFonts(bitmap, true);
+        CGContextSetShouldSubpixelQuantizeFonts(bitmap, false);
+        CGContextSetGrayFillColor(bitmap, 0.0, 1.0);
+        const CGPoint position = CGPointMake(static_cast<CGFloat>(offset_x - left), static_cast<CGFloat>(offset_y - bottom));
+        CTFontDrawGlyphs(strike.font, &glyph, &position, 1, bitmap);
+        CGContextRelease(bitmap);
+    }
+    strike.entries.emplace(key, entry);
+    return LookupResult::kFound;
+}
+
+bool GlyphAtlas::DrawLine(CGContextRef context, const TextLayout& layout, double x, double y, CGColorRef color) {
+    CTLineRef line = layout.line();
+    if (line == nullptr || CGBitmapContextGetData(context) == nullptr) {
+        return false;
+    }
+    // Text space is user space translated to (x, y) with y flipped up; it
+    // must map to device pixels by a uniform scale and a translation.
+    const CGAffineTransform ctm = CGContextGetCTM(context);
+    const double scale = ctm.a;
+    if (std::fabs(ctm.b) > kAxisEpsilon || std::fabs(ctm.c) > kAxisEpsilon || !(scale > 0.0) ||
+        std::fabs(ctm.a + ctm.d) > kAxisEpsilon * scale) {
+        return false;
+    }
+    const double origin_x = ctm.a * x + ctm.tx;
+    const double origin_y = ctm.d * y + ctm.ty;
+
+    struct Glyph {
+        Entry entry;
+        int pen_x = 0;
+        int pen_y = 0;
+    };
+    std::vector<Glyph> glyphs;
+    int min_x = 0;
+    int min_y = 0;
+    int max_x = 0;
+    int max_y = 0;
+    std::vector<uint8_t> coverage;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        CFArrayRef runs = CTLineGetGlyphRuns(line);
+        const CFIndex run_count = runs != nullptr ? CFArrayGetCount(runs) : 0;
+        // When the pages fill up mid-line, start over once with an empty
+        // atlas; entries collected so far point into the dropped pages.
+        for (int attempt = 0;; ++attempt) {
+            glyphs.clear();
+            bool eligible = true;
+            bool atlas_full = false;
+            std::vector<CGGlyph> run_glyphs;
+            std::vector<CGPoint> run_positions;
+            for (CFIndex r = 0; r < run_count && eligible; ++r) {
+                const auto* run = static_cast<CTRunRef>(CFArrayGetValueAtIndex(runs, r));
+                if ((CTRunGetStatus(run) & kCTRunStatusHasNonIdentityMatrix) != 0) {
+                    eligible = false;
+                    break;
+                }
+                const auto* font = static_cast<CTFontRef>(CFDictionaryGetValue(CTRunGetAttributes(run), kCTFontAttributeName));
+                const double device_size = font != nullptr ? CTFontGetSize(font) * scale : 0.0;
+                if (!(device_size > 0.0) || device_size > kMaxDeviceFontSize) {
+                    eligible = false;
+                    break;
+                }
+                Strike* strike = StrikeFor(font, device_size);
+                if (strike == nullptr) {
+                    eligible = false;
+                    break;
+                }
+                const CFIndex count = CTRunGetGlyphCount(run);
+                run_glyphs.resize(static_cast<size_t>(count));
+                run_positions.resize(static_cast<size_t>(count));
+                CTRunGetGlyphs(run, CFRangeMake(0, count), run_glyphs.data());
+                CTRunGetPositions(run, CFRangeMake(0, count), run_positions.data());
+                for (CFIndex i = 0; i < count; ++i) {
+                    // Snap the device pen to the nearest quarter pixel.
+                    const long qx = std::lround((origin_x + run_positions[i].x * scale) * kSubpixelSteps);
+                    const long qy = std::lround((origin_y + run_positions[i].y * scale) * kSubpixelSteps);
+                    Glyph glyph;
+                    glyph.pen_x = static_cast<int>(std::floor(static_cast<double>(qx) / kSubpixelSteps));
+                    glyph.pen_y = static_cast<int>(std::floor(static_cast<double>(qy) / kSubpixelSteps));
+                    const int bucket_x = static_cast<int>(qx - static_cast<long>(glyph.pen_x) * kSubpixelSteps);
+                    const int bucket_y = static_cast<int>(qy - static_cast<long>(glyph.pen_y) * kSubpixelSteps);
+                    const LookupResult found = Lookup(*strike, run_glyphs[i], bucket_x, bucket_y, glyph.entry);
+                    if (found != LookupResult::kFound) {
+                        eligible = false;
+                        atlas_full = found == LookupResult::kAtlasFull;
+                        break;
+                    }
+                    if (glyph.entry.width > 0) {
+                        glyphs.push_back(glyph);
+                    }
+                }
+            }
+            if (eligible) {
+                break;
+            }
+            // Lines the atlas cannot hold anyway must not evict everything else.
+            if (attempt > 0 || !atlas_full) {
+                return false;
+            }
+            Reset();
+        }
+        if (glyphs.empty()) {
+            return true;
+        }
+
+        min_x = max_x = glyphs.front().pen_x + glyphs.front().entry.left;
+        min_y = max_y = glyphs.front().pen_y + glyphs.front().entry.bottom;
+        for (const Glyph& glyph : glyphs) {
+            min_x = std::min(min_x, glyph.pen_x + glyph.entry.left);
+            min_y = std::min(min_y, glyph.pen_y + glyph.entry.bottom);
+            max_x = std::max(max_x, glyph.pen_x + glyph.entry.left + glyph.entry.width);
+            max_y = std::max(max_y, glyph.pen_y + glyph.entry.bottom + glyph.entry.height);
+        }
+        if (static_cast<int64_t>(max_x - min_x) * (max_y - min_y) > kMaxLinePixels) {
+            return false;
+        }
+
+        // Union of the glyph masks, rows top down like the pages.
+        const int width = max_x - min_x;
+        coverage.assign(static_cast<size_t>(width) * static_cast<size_t>(max_y - min_y), 0);
+        for (const Glyph& glyph : glyphs) {
+            const Entry& entry = glyph.entry;
+            const uint8_t* source = pages_[entry.page].coverage.data() + static_cast<size_t>(entry.y) * kPageSize + entry.x;
+            const int column = glyph.pen_x + entry.left - min_x;
+            const int row = max_y - (glyph.pen_y + entry.bottom + entry.height);
+            for (int r = 0; r < entry.height; ++r) {
+                const uint8_t* source_row = source + static_cast<size_t>(r) * kPageSize;
+                uint8_t* target = coverage.data() + static_cast<size_t>(row + r) * width + column;
+                for (int c = 0; c < entry.width; ++c) {
+                    target[c] = std::max(target[c], source_row[c]);
+                }
+            }
+        }
+    }
+
+    const size_t width = static_cast<size_t>(max_x - min_x);
+    const size_t height = static_cast<size_t>(max_y - min_y);
+    CGColorSpaceRef gray_space = CGColorSpaceCreateDeviceGray();
+    CGContextRef mask_context = CGBitmapContextCreate(coverage.data(), width, height, 8, width, gray_space, kCGImageAlphaNone);
+    CGColorSpaceRelease(gray_space);
+    if (mask_context == nullptr) {
+        return false;
+    }
+    CGImageRef mask = CGBitmapContextCreateImage(mask_context);
+    CGContextRelease(mask_context);
+    if (mask == nullptr) {
+        return false;
+    }
+
+    // Fill in device pixels through the composited mask.
+    const CGRect rect = CGRectMake(min_x, min_y, static_cast<CGFloat>(width), static_cast<CGFloat>(height));
+    CGContextSaveGState(context);
+    CGContextConcatCTM(context, CGAffineTransformInvert(ctm));
+    CGContextClipToMask(context, rect, mask);
+    CGContextSetFillColorWithColor(context, color);
+    CGContextFillRect(context, rect);
+    CGContextRestoreGState(context);
+    CGImageRelease(mask);
+    return true;
+}
+
+} // namespace csvg
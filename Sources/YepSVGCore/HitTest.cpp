@@ -0,0 +1,791 @@
+#include "YepSVGCore/HitTest.hpp"
+
+#include "YepSVGCore/CssCascade.hpp"
+#include "YepSVGCore/GeometryEngine.hpp"
+#include "YepSVGCore/LayoutEngine.hpp"
+#include "YepSVGCore/NodeTransforms.hpp"
+#include "YepSVGCore/PathFlattener.hpp"
+#include "YepSVGCore/StyleResolver.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <optional>
+#include <sstream>
+#include <unordered_set>
+
+namespace csvg {
+namespace {
+
+// Buckets are roughly one per shape; shapes spanning more cells than this
+// are kept aside and tested on every query instead.
+constexpr uint32_t kMaxGridSide = 1024;
+constexpr size_t kMaxCellsPerShape = 1024;
+
+enum class PointerEvents {
+    kVisiblePainted,
+    kVisibleFill,
+    kVisibleStroke,
+    kVisible,
+    kPainted,
+    kFill,
+    kStroke,
+    kAll,
+    kNone,
+};
+
+struct VisitState {
+    const ResolvedStyle* style = nullptr;
+    // Parent user space to device pixels.
+    AffineMatrix matrix;
+    double viewport_width = 0.0;
+    double viewport_height = 0.0;
+    int32_t clip = -1;
+    uint32_t id = 0;
+    bool in_use = false;
+    bool nested = false;
+    bool visible = true;
+    PointerEvents pointer_events = PointerEvents::kVisiblePainted;
+};
+
+std::string Trim(const std::string& value) {
+    const auto begin = value.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    const auto end = value.find_last_not_of(" \t\r\n");
+    return value.substr(begin, end - begin + 1);
+}
+
+std::string Lower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
+
+PropertyMap ParseInlineStyle(const std::string& style_text) {
+    PropertyMap out;
+    std::stringstream stream(style_text);
+    std::string token;
+    while (std::getline(stream, token, ';')) {
+        const auto separator = token.find(':');
+        if (separator == std::string::npos) {
+            continue;
+        }
+        const auto key = Lower(Trim(token.substr(0, separator)));
+        const auto value = Trim(token.substr(separator + 1));
+        if (!key.empty() && !value.empty()) {
+            out[key] = value;
+        }
+    }
+    return out;
+}
+
+std::optional<std::string> ReadProperty(const XmlNode& node,
+                                        const PropertyMap& inline_style,
+                                        const PropertyMap& matched_css_properties,
+                                        AttrId key) {
+    const std::string_view name = AttrName(key);
+    if (const auto it = inline_style.find(name); it != inline_style.end()) {
+        return it->second;
+    }
+    if (const auto it = matched_css_properties.find(name); it != matched_css_properties.end()) {
+        return it->second;
+    }
+    if (const auto* value = node.attributes.Get(key); value != nullptr) {
+        return *value;
+    }
+    return std::nullopt;
+}
+
+PointerEvents ParsePointerEvents(const std::string& raw, PointerEvents inherited) {
+    const std::string value = Lower(Trim(raw));
+    if (value == "visiblepainted" || value == "auto") {
+        return PointerEvents::kVisiblePainted;
+    }
+    if (value == "visiblefill") {
+        return PointerEvents::kVisibleFill;
+    }
+    if (value == "visiblestroke") {
+        return PointerEvents::kVisibleStroke;
+    }
+    if (value == "visible") {
+        return PointerEvents::kVisible;
+    }
+    if (value == "painted") {
+        return PointerEvents::kPainted;
+    }
+    if (value == "fill") {
+        return PointerEvents::kFill;
+    }
+    if (value == "stroke") {
+        return PointerEvents::kStroke;
+    }
+    if (value == "all") {
+        return PointerEvents::kAll;
+    }
+    if (value == "none") {
+        return PointerEvents::kNone;
+    }
+    return inherited;
+}
+
+std::optional<std::string> ExtractUrlId(const std::string& raw) {
+    const std::string value = Trim(raw);
+    if (Lower(value).rfind("url(", 0) != 0) {
+        return std::nullopt;
+    }
+    const auto close = value.find(')');
+    if (close == std::string::npos || close <= 4) {
+        return std::nullopt;
+    }
+    std::string inside = Trim(value.substr(4, close - 4));
+    if (inside.size() >= 2 &&
+        ((inside.front() == '\'' && inside.back() == '\'') || (inside.front() == '"' && inside.back() == '"'))) {
+        inside = inside.substr(1, inside.size() - 2);
+    }
+    if (!inside.empty() && inside.front() == '#') {
+        inside.erase(inside.begin());
+    }
+    if (inside.empty()) {
+        return std::nullopt;
+    }
+    return inside;
+}
+
+std::optional<std::string> ExtractHrefId(const XmlNode& node) {
+    const std::string* href = node.attributes.Get(AttrId::kHref);
+    if (href == nullptr) {
+        href = node.attributes.Get(AttrId::kXlinkHref);
+    }
+    if (href == nullptr) {
+        return std::nullopt;
+    }
+    const std::string value = Trim(*href);
+    if (value.size() < 2 || value.front() != '#') {
+        return std::nullopt;
+    }
+    return value.substr(1);
+}
+
+double LengthAttr(const XmlNode& node, AttrId key, double fallback, LengthAxis axis, double viewport_width, double viewport_height) {
+    const SvgLength* length = node.attributes.GetLength(key);
+    return length != nullptr ? length->ToPixels(axis, viewport_width, viewport_height) : fallback;
+}
+
+double MatrixScale(const AffineMatrix& matrix) {
+    return std::sqrt(std::fabs(matrix.a * matrix.d - matrix.b * matrix.c));
+}
+
+bool IsResourceElement(const std::string& lower_name) {
+    return lower_name == "defs" ||
+        lower_name == "lineargradient" ||
+        lower_name == "radialgradient" ||
+        lower_name == "stop" ||
+        lower_name == "pattern" ||
+        lower_name == "clippath" ||
+        lower_name == "mask" ||
+        lower_name == "marker" ||
+        lower_name == "color-profile";
+}
+
+// Forwards path commands mapped through |matrix|; affine maps keep Bézier
+// control points valid, so curves are flattened in device space.
+class DeviceSink final : public PathDataSink {
+public:
+    DeviceSink(const AffineMatrix& matrix, PathDataSink& target) : matrix_(matrix), target_(target) {}
+
+    void MoveTo(double x, double y) override {
+        Map(x, y);
+        target_.MoveTo(x, y);
+    }
+    void LineTo(double x, double y) override {
+        Map(x, y);
+        target_.LineTo(x, y);
+    }
+    void CubicTo(double x1, double y1, double x2, double y2, double x, double y) override {
+        Map(x1, y1);
+        Map(x2, y2);
+        Map(x, y);
+        target_.CubicTo(x1, y1, x2, y2, x, y);
+    }
+    void QuadTo(double x1, double y1, double x, double y) override {
+        Map(x1, y1);
+        Map(x, y);
+        target_.QuadTo(x1, y1, x, y);
+    }
+    void ClosePath() override {
+        target_.ClosePath();
+    }
+
+private:
+    void Map(double& x, double& y) const {
+        matrix_.Map(x, y, x, y);
+    }
+
+    const AffineMatrix& matrix_;
+    PathDataSink& target_;
+};
+
+double SegmentDistanceSquared(const Point& a, const Point& b, double x, double y) {
+    const double dx = b.x - a.x;
+    const double dy = b.y - a.y;
+    const double length_squared = dx * dx + dy * dy;
+    double t = 0.0;
+    if (length_squared > 0.0) {
+        t = std::clamp(((x - a.x) * dx + (y - a.y) * dy) / length_squared, 0.0, 1.0);
+    }
+    const double px = a.x + dx * t - x;
+    const double py = a.y + dy * t - y;
+    return px * px + py * py;
+}
+
+} // namespace
+
+class HitTestIndex::Builder {
+public:
+    Builder(HitTestIndex& index, const DocumentIndex& document_index, const CssCascade* cascade, const RenderOptions& options)
+        : index_(index), document_index_(document_index), cascade_(cascade), options_(options) {}
+
+    void Visit(const XmlNode& node, const VisitState& parent);
+
+private:
+    bool AppendOutline(const ShapeGeometry& geometry, const AffineMatrix& matrix, Area& area, Box& bounds);
+    int32_t AddClip(const XmlNode& clip_node, const std::optional<ShapeGeometry>& clipped_geometry, const VisitState& state);
+    int32_t AddViewportClip(double x, double y, double width, double height, const VisitState& state);
+    void AddShape(const ShapeGeometry& geometry, const ResolvedStyle& style, const VisitState& state);
+    uint32_t AddId(const std::string& id);
+
+    HitTestIndex& index_;
+    const DocumentIndex& document_index_;
+    const CssCascade* cascade_ = nullptr;
+    const RenderOptions& options_;
+    StyleResolver style_resolver_;
+    std::unordered_set<const XmlNode*> active_uses_;
+};
+
+void HitTestIndex::Builder::Visit(const XmlNode& node, const VisitState& parent) {
+    const PropertyMap matched_css_properties = cascade_ != nullptr ? ResolveMatchedCssProperties(node, *cascade_) : PropertyMap{};
+    const ResolvedStyle style = style_resolver_.Resolve(node, parent.style, options_, &matched_css_properties);
+    const std::string* style_attr = node.attributes.Get(AttrId::kStyle);
+    const PropertyMap inline_style = style_attr != nullptr ? ParseInlineStyle(*style_attr) : PropertyMap{};
+
+    if (const auto display = ReadProperty(node, inline_style, matched_css_properties, AttrId::kDisplay);
+        display.has_value() && Lower(Trim(*display)) == "none") {
+        return;
+    }
+    const std::string lower_name = Lower(node.name);
+    if (IsResourceElement(lower_name)) {
+        return;
+    }
+
+    VisitState state = parent;
+    state.style = &style;
+    state.nested = true;
+    if (const auto visibility = ReadProperty(node, inline_style, matched_css_properties, AttrId::kVisibility)) {
+        const std::string value = Lower(Trim(*visibility));
+        if (value == "hidden" || value == "collapse") {
+            state.visible = false;
+        } else if (value == "visible") {
+            state.visible = true;
+        }
+    }
+    if (const auto pointer_events = ReadProperty(node, inline_style, matched_css_properties, AttrId::kPointerEvents)) {
+        state.pointer_events = ParsePointerEvents(*pointer_events, state.pointer_events);
+    }
+    if (!state.in_use) {
+        if (const std::string* id = node.attributes.Get(AttrId::kId); id != nullptr && !id->empty()) {
+            state.id = AddId(*id);
+        }
+    }
+    if (const AffineMatrix* transform = node.attributes.GetTransform(AttrId::kTransform)) {
+        state.matrix = AffineMatrix::Concat(*transform, state.matrix);
+    }
+
+    const GeometryEngine geometry_engine(state.viewport_width, state.viewport_height);
+    const bool is_svg = node.name == "svg";
+    std::optional<ShapeGeometry> geometry;
+    if (!is_svg && node.name != "use") {
+        geometry = geometry_engine.Build(node);
+    }
+
+    if (const auto clip_value = ReadProperty(node, inline_style, matched_css_properties, AttrId::kClipPath)) {
+        if (const auto clip_id = ExtractUrlId(*clip_value)) {
+            const auto clip_it = document_index_.nodes_by_id.find(*clip_id);
+            if (clip_it != document_index_.nodes_by_id.end() && clip_it->second != nullptr &&
+                Lower(clip_it->second->name) == "clippath") {
+                state.clip = AddClip(*clip_it->second, geometry, state);
+            }
+        }
+    }
+
+    if (node.name == "use") {
+        const auto href_id = ExtractHrefId(node);
+        if (!href_id.has_value()) {
+            return;
+        }
+        const auto target_it = document_index_.nodes_by_id.find(*href_id);
+        if (target_it == document_index_.nodes_by_id.end() || target_it->second == nullptr ||
+            active_uses_.count(target_it->second) > 0) {
+            return;
+        }
+        const double x = LengthAttr(node, AttrId::kX, 0.0, LengthAxis::kX, state.viewport_width, state.viewport_height);
+        const double y = LengthAttr(node, AttrId::kY, 0.0, LengthAxis::kY, state.viewport_width, state.viewport_height);
+        state.matrix = AffineMatrix::Concat(AffineMatrix::Translation(x, y), state.matrix);
+        state.in_use = true;
+        active_uses_.insert(target_it->second);
+        Visit(*target_it->second, state);
+        active_uses_.erase(target_it->second);
+        return;
+    }
+
+    if (is_svg && parent.nested) {
+        const double vw = state.viewport_width;
+        const double vh = state.viewport_height;
+        const double x = LengthAttr(node, AttrId::kX, 0.0, LengthAxis::kX, vw, vh);
+        const double y = LengthAttr(node, AttrId::kY, 0.0, LengthAxis::kY, vw, vh);
+        const double width = LengthAttr(node, AttrId::kWidth, vw > 0.0 ? vw : 100.0, LengthAxis::kX, vw, vh);
+        const double height = LengthAttr(node, AttrId::kHeight, vh > 0.0 ? vh : 100.0, LengthAxis::kY, vw, vh);
+        if (!(width > 0.0) || !(height > 0.0)) {
+            return;
+        }
+        state.matrix = AffineMatrix::Concat(AffineMatrix::Translation(x, y), state.matrix);
+        state.clip = AddViewportClip(0.0, 0.0, width, height, state);
+        state.viewport_width = width;
+        state.viewport_height = height;
+        if (const ViewBox* view_box = node.attributes.GetViewBox(AttrId::kViewBox); view_box != nullptr && view_box->IsValid()) {
+            const PreserveAspectRatio* preserve = node.attributes.GetPreserveAspectRatio(AttrId::kPreserveAspectRatio);
+            state.matrix = AffineMatrix::Concat(ViewBoxTransform(width, height, *view_box, preserve != nullptr ? *preserve : PreserveAspectRatio{}),
+                                                state.matrix);
+            state.viewport_width = view_box->width;
+            state.viewport_height = view_box->height;
+        }
+    }
+
+    if (geometry.has_value() && geometry->type != ShapeType::kText && geometry->type != ShapeType::kUnknown) {
+        AddShape(*geometry, style, state);
+    }
+
+    for (const auto& child : node.children) {
+        Visit(child, state);
+    }
+}
+
+bool HitTestIndex::Builder::AppendOutline(const ShapeGeometry& geometry, const AffineMatrix& matrix, Area& area, Box& bounds) {
+    PathFlattener flattener(FlatteningTolerance(1.0));
+    DeviceSink sink(matrix, flattener);
+    if (!EmitShapeOutline(geometry, sink)) {
+        return false;
+    }
+    const FlattenedPath path = flattener.Finish();
+    const auto& segments = path.segments();
+
+    area.contour_begin = static_cast<uint32_t>(index_.contours_.size());
+    const size_t first_point = index_.points_.size();
+    for (const auto& subpath : path.subpaths()) {
+        Contour contour;
+        contour.begin = static_cast<uint32_t>(index_.points_.size());
+        index_.points_.push_back(segments[subpath.begin].start);
+        for (size_t i = subpath.begin; i < subpath.end; ++i) {
+            index_.points_.push_back(segments[i].end);
+        }
+        contour.count = static_cast<uint32_t>(index_.points_.size()) - contour.begin;
+        index_.contours_.push_back(contour);
+    }
+    area.contour_count = static_cast<uint32_t>(index_.contours_.size()) - area.contour_begin;
+    if (area.contour_count == 0) {
+        return false;
+    }
+
+    bounds = Box{index_.points_[first_point].x, index_.points_[first_point].y,
+                 index_.points_[first_point].x, index_.points_[first_point].y};
+    for (size_t i = first_point; i < index_.points_.size(); ++i) {
+        const Point& point = index_.points_[i];
+        bounds.min_x = std::min(bounds.min_x, point.x);
+        bounds.min_y = std::min(bounds.min_y, point.y);
+        bounds.max_x = std::max(bounds.max_x, point.x);
+        bounds.max_y = std::max(bounds.max_y, point.y);
+    }
+    return true;
+}
+
+int32_t HitTestIndex::Builder::AddClip(const XmlNode& clip_node,
+                                       const std::optional<ShapeGeometry>& clipped_geometry,
+                                       const VisitState& state) {
+    if (clip_node.children.empty()) {
+        return state.clip;
+    }
+
+    AffineMatrix matrix = state.matrix;
+    const std::string* units = clip_node.attributes.Get(AttrId::kClipPathUnits);
+    if (units != nullptr && Lower(Trim(*units)) == "objectboundingbox") {
+        Box bbox{0.0, 0.0, state.viewport_width, state.viewport_height};
+        if (clipped_geometry.has_value()) {
+            PathFlattener flattener(FlatteningTolerance(MatrixScale(state.matrix)));
+            if (EmitShapeOutline(*clipped_geometry, flattener)) {
+                const FlattenedPath outline = flattener.Finish();
+                if (!outline.segments().empty()) {
+                    const Point& first = outline.segments().front().start;
+                    bbox = Box{first.x, first.y, first.x, first.y};
+                    for (const auto& segment : outline.segments()) {
+                        bbox.min_x = std::min(bbox.min_x, segment.end.x);
+                        bbox.min_y = std::min(bbox.min_y, segment.end.y);
+                        bbox.max_x = std::max(bbox.max_x, segment.end.x);
+                        bbox.max_y = std::max(bbox.max_y, segment.end.y);
+                    }
+                }
+            }
+        }
+        const AffineMatrix unit_box{bbox.max_x - bbox.min_x, 0.0, 0.0, bbox.max_y - bbox.min_y, bbox.min_x, bbox.min_y};
+        matrix = AffineMatrix::Concat(unit_box, matrix);
+    }
+
+    ClipRegion region;
+    region.parent = state.clip;
+    region.area_begin = static_cast<uint32_t>(index_.clip_areas_.size());
+    const GeometryEngine geometry_engine(state.viewport_width, state.viewport_height);
+    for (const auto& child : clip_node.children) {
+        const auto geometry = geometry_engine.Build(child);
+        if (!geometry.has_value()) {
+            continue;
+        }
+        Area area;
+        Box bounds;
+        if (!AppendOutline(*geometry, matrix, area, bounds)) {
+            continue;
+        }
+        const std::string* clip_rule = child.attributes.Get(AttrId::kClipRule);
+        area.even_odd = clip_rule != nullptr && Lower(Trim(*clip_rule)) == "evenodd";
+        if (index_.clip_areas_.size() == region.area_begin) {
+            region.bounds = bounds;
+        } else {
+            region.bounds.min_x = std::min(region.bounds.min_x, bounds.min_x);
+            region.bounds.min_y = std::min(region.bounds.min_y, bounds.min_y);
+            region.bounds.max_x = std::max(region.bounds.max_x, bounds.max_x);
+            region.bounds.max_y = std::max(region.bounds.max_y, bounds.max_y);
+        }
+        index_.clip_areas_.push_back(area);
+    }
+    region.area_count = static_cast<uint32_t>(index_.clip_areas_.size()) - region.area_begin;
+    // Painting applies no clip when none of the children has an outline.
+    if (region.area_count == 0) {
+        return state.clip;
+    }
+    index_.clips_.push_back(region);
+    return static_cast<int32_t>(index_.clips_.size() - 1);
+}
+
+int32_t HitTestIndex::Builder::AddViewportClip(double x, double y, double width, double height, const VisitState& state) {
+    ShapeGeometry rect;
+    rect.type = ShapeType::kRect;
+    rect.x = x;
+    rect.y = y;
+    rect.width = width;
+    rect.height = height;
+
+    ClipRegion region;
+    region.parent = state.clip;
+    region.area_begin = static_cast<uint32_t>(index_.clip_areas_.size());
+    Area area;
+    if (!AppendOutline(rect, state.matrix, area, region.bounds)) {
+        return state.clip;
+    }
+    index_.clip_areas_.push_back(area);
+    region.area_count = 1;
+    index_.clips_.push_back(region);
+    return static_cast<int32_t>(index_.clips_.size() - 1);
+}
+
+void HitTestIndex::Builder::AddShape(const ShapeGeometry& geometry, const ResolvedStyle& style, const VisitState& state) {
+    const PointerEvents pointer_events = state.pointer_events;
+    if (pointer_events == PointerEvents::kNone) {
+        return;
+    }
+    const bool needs_visible = pointer_events == PointerEvents::kVisiblePainted ||
+        pointer_events == PointerEvents::kVisibleFill ||
+        pointer_events == PointerEvents::kVisibleStroke ||
+        pointer_events == PointerEvents::kVisible;
+    if (needs_visible && !state.visible) {
+        return;
+    }
+
+    // Images are hit anywhere inside their viewport, like a filled rect.
+    const bool is_image = geometry.type == ShapeType::kImage;
+    const bool has_fill = is_image ||
+        (style.fill.is_valid && !style.fill.is_none) ||
+        Lower(Trim(style.fill_paint)).rfind("url(", 0) == 0;
+    const bool has_stroke = !is_image && style.stroke.is_valid && !style.stroke.is_none;
+
+    bool fill = false;
+    bool stroke = false;
+    switch (pointer_events) {
+        case PointerEvents::kVisiblePainted:
+        case PointerEvents::kPainted:
+            fill = has_fill;
+            stroke = has_stroke;
+            break;
+        case PointerEvents::kVisibleFill:
+        case PointerEvents::kFill:
+            fill = true;
+            break;
+        case PointerEvents::kVisibleStroke:
+        case PointerEvents::kStroke:
+            stroke = !is_image;
+            break;
+        case PointerEvents::kVisible:
+        case PointerEvents::kAll:
+            fill = true;
+            stroke = !is_image;
+            break;
+        case PointerEvents::kNone:
+            break;
+    }
+    if (stroke && !(style.stroke_width > 0.0f)) {
+        stroke = false;
+    }
+    if (!fill && !stroke) {
+        return;
+    }
+
+    ShapeGeometry outline = geometry;
+    if (is_image) {
+        outline.type = ShapeType::kRect;
+        outline.rx = 0.0;
+        outline.ry = 0.0;
+    }
+
+    Shape shape;
+    if (!AppendOutline(outline, state.matrix, shape.area, shape.bounds)) {
+        return;
+    }
+    shape.area.even_odd = style.fill_rule == "evenodd";
+    shape.fill = fill;
+    if (stroke) {
+        shape.stroke_radius = 0.5 * static_cast<double>(style.stroke_width) * MatrixScale(state.matrix);
+        shape.bounds.min_x -= shape.stroke_radius;
+        shape.bounds.min_y -= shape.stroke_radius;
+        shape.bounds.max_x += shape.stroke_radius;
+        shape.bounds.max_y += shape.stroke_radius;
+    }
+    shape.clip = state.clip;
+    shape.id = state.id;
+    index_.shapes_.push_back(shape);
+}
+
+uint32_t HitTestIndex::Builder::AddId(const std::string& id) {
+    index_.ids_.push_back(id);
+    return static_cast<uint32_t>(index_.ids_.size() - 1);
+}
+
+std::unique_ptr<HitTestIndex> HitTestIndex::Build(const Document& document, const RenderOptions& options, RenderError& error) {
+    const auto layout = LayoutEngine().Compute(document.svg(), options, error);
+    if (!layout.has_value()) {
+        return nullptr;
+    }
+
+    std::unique_ptr<HitTestIndex> index(new HitTestIndex());
+    index->options_ = options;
+    index->width_ = static_cast<double>(layout->width);
+    index->height_ = static_cast<double>(layout->height);
+    index->ids_.emplace_back();
+
+    const DocumentIndex& document_index = document.IndexFor(options);
+    const CssCascade cascade = BuildCssCascade(document_index, options);
+    Builder builder(*index, document_index, cascade.sheets.empty() ? nullptr : &cascade, options);
+    VisitState root;
+    root.matrix = NodeTransformCache::RootMatrix(document.svg().root, *layout);
+    root.viewport_width = layout->view_box_width;
+    root.viewport_height = layout->view_box_height;
+    builder.Visit(document.svg().root, root);
+
+    index->BuildGrid();
+    return index;
+}
+
+bool HitTestIndex::Matches(const RenderOptions& options) const {
+    return options.viewport_width == options_.viewport_width &&
+        options.viewport_height == options_.viewport_height &&
+        options.scale == options_.scale &&
+        options.default_font_size == options_.default_font_size &&
+        options.default_font_family == options_.default_font_family &&
+        options.stylesheets == options_.stylesheets &&
+        options.theme == options_.theme;
+}
+
+void HitTestIndex::BuildGrid() {
+    const size_t count = shapes_.size();
+    if (count == 0 || !(width_ > 0.0) || !(height_ > 0.0)) {
+        return;
+    }
+
+    const double columns = std::round(std::sqrt(static_cast<double>(count) * width_ / height_));
+    grid_columns_ = static_cast<uint32_t>(std::clamp(columns, 1.0, static_cast<double>(kMaxGridSide)));
+    grid_rows_ = static_cast<uint32_t>(std::clamp(std::round(static_cast<double>(count) / grid_columns_),
+                                                  1.0,
+                                                  static_cast<double>(kMaxGridSide)));
+    cell_width_ = width_ / grid_columns_;
+    cell_height_ = height_ / grid_rows_;
+
+    const auto column_of = [this](double x) {
+        return static_cast<uint32_t>(std::clamp(std::floor(x / cell_width_), 0.0, static_cast<double>(grid_columns_ - 1)));
+    };
+    const auto row_of = [this](double y) {
+        return static_cast<uint32_t>(std::clamp(std::floor(y / cell_height_), 0.0, static_cast<double>(grid_rows_ - 1)));
+    };
+
+    // Two passes: count per cell, then fill in paint order.
+    cell_offsets_.assign(static_cast<size_t>(grid_columns_) * grid_rows_ + 1, 0);
+    for (uint32_t pass = 0; pass < 2; ++pass) {
+        std::vector<uint32_t> cursor;
+        if (pass == 1) {
+            for (size_t i = 1; i < cell_offsets_.size(); ++i) {
+                cell_offsets_[i] += cell_offsets_[i - 1];
+            }
+            cell_items_.resize(cell_offsets_.back());
+            cursor.assign(cell_offsets_.begin(), cell_offsets_.end() - 1);
+        }
+        for (uint32_t shape_index = 0; shape_index < count; ++shape_index) {
+            const Box& bounds = shapes_[shape_index].bounds;
+            const uint32_t c0 = column_of(bounds.min_x);
+            const uint32_t c1 = column_of(bounds.max_x);
+            const uint32_t r0 = row_of(bounds.min_y);
+            const uint32_t r1 = row_of(bounds.max_y);
+            if (static_cast<size_t>(c1 - c0 + 1) * (r1 - r0 + 1) > kMaxCellsPerShape) {
+                if (pass == 0) {
+                    large_items_.push_back(shape_index);
+                }
+                continue;
+            }
+            for (uint32_t row = r0; row <= r1; ++row) {
+                for (uint32_t column = c0; column <= c1; ++column) {
+                    const size_t cell = static_cast<size_t>(row) * grid_columns_ + column;
+                    if (pass == 0) {
+                        ++cell_offsets_[cell + 1];
+                    } else {
+                        cell_items_[cursor[cell]++] = shape_index;
+                    }
+                }
+            }
+        }
+    }
+}
+
+bool HitTestIndex::AreaContains(const Area& area, double x, double y, double tolerance) const {
+    int winding = 0;
+    int crossings = 0;
+    for (uint32_t c = area.contour_begin; c < area.contour_begin + area.contour_count; ++c) {
+        const Contour& contour = contours_[c];
+        const Point* points = points_.data() + contour.begin;
+        for (uint32_t i = 0; i < contour.count; ++i) {
+            const Point& a = points[i];
+            const Point& b = points[i + 1 < contour.count ? i + 1 : 0];
+            const double cross = (b.x - a.x) * (y - a.y) - (x - a.x) * (b.y - a.y);
+            if (a.y <= y) {
+                if (b.y > y && cross > 0.0) {
+                    ++winding;
+                    ++crossings;
+                }
+            } else if (b.y <= y && cross < 0.0) {
+                --winding;
+                ++crossings;
+            }
+        }
+    }
+    const bool inside = area.even_odd ? (crossings & 1) != 0 : winding != 0;
+    if (inside) {
+        return true;
+    }
+    return tolerance > 0.0 && DistanceToEdges(area, x, y, true) <= tolerance;
+}
+
+double HitTestIndex::DistanceToEdges(const Area& area, double x, double y, bool close) const {
+    double best = INFINITY;
+    for (uint32_t c = area.contour_begin; c < area.contour_begin + area.contour_count; ++c) {
+        const Contour& contour = contours_[c];
+        const Point* points = points_.data() + contour.begin;
+        for (uint32_t i = 0; i + 1 < contour.count; ++i) {
+            best = std::min(best, SegmentDistanceSquared(points[i], points[i + 1], x, y));
+        }
+        if (close && contour.count > 1) {
+            best = std::min(best, SegmentDistanceSquared(points[contour.count - 1], points[0], x, y));
+        }
+    }
+    return std::sqrt(best);
+}
+
+bool HitTestIndex::ClipContains(int32_t clip, double x, double y) const {
+    while (clip >= 0) {
+        const ClipRegion& region = clips_[static_cast<size_t>(clip)];
+        if (x < region.bounds.min_x || x > region.bounds.max_x || y < region.bounds.min_y || y > region.bounds.max_y) {
+            return false;
+        }
+        bool inside = false;
+        for (uint32_t i = region.area_begin; i < region.area_begin + region.area_count && !inside; ++i) {
+            inside = AreaContains(clip_areas_[i], x, y, 0.0);
+        }
+        if (!inside) {
+            return false;
+        }
+        clip = region.parent;
+    }
+    return true;
+}
+
+bool HitTestIndex::ShapeContains(const Shape& shape, double x, double y, double tolerance) const {
+    if (shape.fill && AreaContains(shape.area, x, y, tolerance)) {
+        return true;
+    }
+    return shape.stroke_radius >= 0.0 && DistanceToEdges(shape.area, x, y, false) <= shape.stroke_radius + tolerance;
+}
+
+std::vector<std::string> HitTestIndex::HitTest(double x, double y, const HitTestQuery& query) const {
+    std::vector<std::string> hits;
+    if (shapes_.empty() || !std::isfinite(x) || !std::isfinite(y)) {
+        return hits;
+    }
+    const double tolerance = std::isfinite(query.tolerance) ? std::max(query.tolerance, 0.0) : 0.0;
+
+    std::vector<uint32_t> candidates(large_items_);
+    if (grid_columns_ > 0) {
+        const auto column_of = [this](double value) {
+            return static_cast<uint32_t>(std::clamp(std::floor(value / cell_width_), 0.0, static_cast<double>(grid_columns_ - 1)));
+        };
+        const auto row_of = [this](double value) {
+            return static_cast<uint32_t>(std::clamp(std::floor(value / cell_height_), 0.0, static_cast<double>(grid_rows_ - 1)));
+        };
+        const uint32_t c0 = column_of(x - tolerance);
+        const uint32_t c1 = column_of(x + tolerance);
+        const uint32_t r0 = row_of(y - tolerance);
+        const uint32_t r1 = row_of(y + tolerance);
+        for (uint32_t row = r0; row <= r1; ++row) {
+            for (uint32_t column = c0; column <= c1; ++column) {
+                const size_t cell = static_cast<size_t>(row) * grid_columns_ + column;
+                candidates.insert(candidates.end(),
+                                  cell_items_.begin() + cell_offsets_[cell],
+                                  cell_items_.begin() + cell_offsets_[cell + 1]);
+            }
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), std::greater<uint32_t>());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    for (const uint32_t shape_index : candidates) {
+        const Shape& shape = shapes_[shape_index];
+        if (x < shape.bounds.min_x - tolerance || x > shape.bounds.max_x + tolerance ||
+            y < shape.bounds.min_y - tolerance || y > shape.bounds.max_y + tolerance) {
+            continue;
+        }
+        if (!ClipContains(shape.clip, x, y) || !ShapeContains(shape, x, y, tolerance)) {
+            continue;
+        }
+        const std::string& id = ids_[shape.id];
+        if (std::find(hits.begin(), hits.end(), id) == hits.end()) {
+            hits.push_back(id);
+        }
+        if (!query.collect_all) {
+            break;
+        }
+    }
+    return hits;
+}
+
+} // namespace csvg
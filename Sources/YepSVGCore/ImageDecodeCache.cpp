@@ -0,0 +1,261 @@
+#include "YepSVGCore/ImageDecodeCache.hpp"
+
+#include "YepSVGCore/DataUrl.hpp"
+
+#include <algorithm>
+
+namespace csvg {
+namespace {
+
+// Smallest decode requested; tiny draws share one small thumbnail.
+constexpr size_t kMinDecodeSize = 64;
+// Bounds memory for renderers that see unbounded distinct images; decoded
+// pixels are dropped first, then the whole table.
+constexpr size_t kMaxDecodedBytes = 256u * 1024u * 1024u;
+constexpr size_t kMaxEntries = 256;
+
+size_t DecodeSizeFor(size_t requested) {
+    size_t size = kMinDecodeSize;
+    while (size < requested && size < (static_cast<size_t>(1) << 30)) {
+        size <<= 1;
+    }
+    return size;
+}
+
+size_t ReadPixelDimension(CFDictionaryRef properties, CFStringRef key) {
+    const auto* number = static_cast<CFNumberRef>(CFDictionaryGetValue(properties, key));
+    int64_t value = 0;
+    if (number == nullptr || !CFNumberGetValue(number, kCFNumberSInt64Type, &value) || value <= 0) {
+        return 0;
+    }
+    return static_cast<size_t>(value);
+}
+
+size_t ImageBytes(CGImageRef image) {
+    return image != nullptr ? CGImageGetBytesPerRow(image) * CGImageGetHeight(image) : 0;
+}
+
+CGImageRef DecodeImage(CGImageSourceRef source, size_t max_pixel_size) {
+    if (max_pixel_size == 0) {
+        const void* keys[] = {kCGImageSourceShouldCacheImmediately};
+        const void* values[] = {kCFBooleanTrue};
+        CFDictionaryRef options = CFDictionaryCreate(kCFAllocatorDefault,
+                                                     keys,
+                                                     values,
+                                                     1,
+                                                     &kCFTypeDictionaryKeyCallBacks,
+                                                     &kCFTypeDictionaryValueCallBacks);
+        CGImageRef image = CGImageSourceCreateImageAtIndex(source, 0, options);
+        if (options != nullptr) {
+            CFRelease(options);
+        }
+        return image;
+    }
+
+    // A thumbnail decode lets JPEG scale in the DCT and never materializes
+    // the full-resolution bitmap. EXIF orientation is ignored, as for full
+    // decodes.
+    const int64_t size_value = static_cast<int64_t>(max_pixel_size);
+    CFNumberRef size = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt64Type, &size_value);
+    const void* keys[] = {kCGImageSourceCreateThumbnailFromImageAlways,
+                          kCGImageSourceCreateThumbnailWithTransform,
+                          kCGImageSourceShouldCacheImmediately,
+                          kCGImageSourceThumbnailMaxPixelSize};
+    const void* values[] = {kCFBooleanTrue, kCFBooleanFalse, kCFBooleanTrue, size};
+    CFDictionaryRef options = CFDictionaryCreate(kCFAllocatorDefault,
+                                                 keys,
+                                                 values,
+                                                 size != nullptr ? 4 : 3,
+                                                 &kCFTypeDictionaryKeyCallBacks,
+                                                 &kCFTypeDictionaryValueCallBacks);
+    CGImageRef image = CGImageSourceCreateThumbnailAtIndex(source, 0, options);
+    if (options != nullptr) {
+        CFRelease(options);
+    }
+    if (size != nullptr) {
+        CFRelease(size);
+    }
+    return image;
+}
+
+} // namespace
+
+CGImageSourceRef CreateImageSourceForHref(std::string_view href) {
+    if (href.empty()) {
+        return nullptr;
+    }
+
+    if (href.substr(0, 5) == "data:") {
+        const auto bytes = DataUrlDecoder::Decode(href);
+        if (!bytes.has_value() || bytes->empty()) {
+            return nullptr;
+        }
+        CFDataRef data = CFDataCreate(kCFAllocatorDefault, bytes->data(), static_cast<CFIndex>(bytes->size()));
+        if (data == nullptr) {
+            return nullptr;
+        }
+        CGImageSourceRef source = CGImageSourceCreateWithData(data, nullptr);
+        CFRelease(data);
+        return source;
+    }
+
+    if (href.substr(0, 7) == "http://" || href.substr(0, 8) == "https://") {
+        return nullptr;
+    }
+
+    CFURLRef url = nullptr;
+    if (href.substr(0, 7) == "file://") {
+        url = CFURLCreateWithBytes(kCFAllocatorDefault,
+                                   reinterpret_cast<const UInt8*>(href.data()),
+                                   static_cast<CFIndex>(href.size()),
+                                   kCFStringEncodingUTF8,
+                                   nullptr);
+    } else {
+        url = CFURLCreateFromFileSystemRepresentation(kCFAllocatorDefault,
+                                                      reinterpret_cast<const UInt8*>(href.data()),
+                                                      static_cast<CFIndex>(href.size()),
+                                                      false);
+    }
+    if (url == nullptr) {
+        return nullptr;
+    }
+    CGImageSourceRef source = CGImageSourceCreateWithURL(url, nullptr);
+    CFRelease(url);
+    return source;
+}
+
+ImageDecodeCache::~ImageDecodeCache() {
+    Clear();
+}
+
+void ImageDecodeCache::Clear() {
+    for (auto& [href, entry] : entries_) {
+        if (entry->image != nullptr) {
+            CGImageRelease(entry->image);
+        }
+        if (entry->source != nullptr) {
+            CFRelease(entry->source);
+        }
+    }
+    entries_.clear();
+    decoded_bytes_ = 0;
+}
+
+ImageDecodeCache::Entry& ImageDecodeCache::EntryFor(std::string_view href) {
+    if (const auto it = entries_.find(href); it != entries_.end()) {
+        return *it->second;
+    }
+    return InsertEntry(href, CreateImageSourceForHref(href));
+}
+
+ImageDecodeCache::Entry& ImageDecodeCache::InsertEntry(std::string_view href, CGImageSourceRef source) {
+    if (const auto it = entries_.find(href); it != entries_.end()) {
+        // Only a failed open is replaced, so it holds nothing decoded.
+        entries_.erase(it);
+    }
+    if (entries_.size() >= kMaxEntries) {
+        Clear();
+    }
+    auto owned = std::make_unique<Entry>();
+    owned->href = std::string(href);
+    Entry& entry = *owned;
+    entries_.emplace(std::string_view(entry.href), std::move(owned));
+    entry.source = source;
+    if (entry.source != nullptr) {
+        CFDictionaryRef properties = CGImageSourceCopyPropertiesAtIndex(entry.source, 0, nullptr);
+        if (properties != nullptr) {
+            entry.width = ReadPixelDimension(properties, kCGImagePropertyPixelWidth);
+            entry.height = ReadPixelDimension(properties, kCGImagePropertyPixelHeight);
+            CFRelease(properties);
+        }
+    }
+    return entry;
+}
+
+void ImageDecodeCache::AddEncoded(std::string_view href, const std::vector<uint8_t>& data) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (const auto it = entries_.find(href); it != entries_.end() && it->second->source != nullptr) {
+        return;
+    }
+    CGImageSourceRef source = nullptr;
+    if (!data.empty()) {
+        CFDataRef bytes = CFDataCreate(kCFAllocatorDefault, data.data(), static_cast<CFIndex>(data.size()));
+        if (bytes != nullptr) {
+            source = CGImageSourceCreateWithData(bytes, nullptr);
+            CFRelease(bytes);
+        }
+    }
+    InsertEntry(href, source);
+}
+
+bool ImageDecodeCache::HasSource(std::string_view href) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = entries_.find(href);
+    return it != entries_.end() && it->second->source != nullptr;
+}
+
+bool ImageDecodeCache::Dimensions(std::string_view href, size_t& width, size_t& height) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Entry& entry = EntryFor(href);
+    width = entry.width;
+    height = entry.height;
+    return entry.source != nullptr && width > 0 && height > 0;
+}
+
+CGImageRef ImageDecodeCache::CopyImage(std::string_view href, size_t max_pixel_size) {
+    CGImageSourceRef source = nullptr;
+    size_t decode_size = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const Entry& entry = EntryFor(href);
+        if (entry.source == nullptr) {
+            return nullptr;
+        }
+        const size_t longer = std::max(entry.width, entry.height);
+        decode_size = max_pixel_size > 0 ? DecodeSizeFor(max_pixel_size) : 0;
+        if (longer == 0 || decode_size >= longer) {
+            decode_size = 0;
+        }
+        const size_t wanted = decode_size > 0 ? decode_size : longer;
+        if (entry.image != nullptr && entry.decoded_size >= wanted) {
+            return CGImageRetain(entry.image);
+        }
+        source = entry.source;
+        CFRetain(source);
+    }
+
+    // Decode without holding the lock so other images proceed in parallel.
+    CGImageRef image = DecodeImage(source, decode_size);
+    CFRelease(source);
+    if (image == nullptr) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const size_t bytes = ImageBytes(image);
+    const size_t decoded_size = decode_size > 0 ? decode_size : std::max(CGImageGetWidth(image), CGImageGetHeight(image));
+    if (decoded_bytes_ + bytes > kMaxDecodedBytes) {
+        for (auto& [key, other] : entries_) {
+            if (other->image != nullptr) {
+                CGImageRelease(other->image);
+                other->image = nullptr;
+                other->decoded_size = 0;
+            }
+        }
+        decoded_bytes_ = 0;
+    }
+    Entry& entry = EntryFor(href);
+    // Another thread may have stored a larger decode meanwhile.
+    if (entry.image == nullptr || entry.decoded_size < decoded_size) {
+        if (entry.image != nullptr) {
+            decoded_bytes_ -= std::min(decoded_bytes_, ImageBytes(entry.image));
+            CGImageRelease(entry.image);
+        }
+        entry.image = CGImageRetain(image);
+        entry.decoded_size = decoded_size;
+        decoded_bytes_ += bytes;
+    }
+    return image;
+}
+
+} // namespace csvg
@@ -1,41 +1,21 @@
 #include "YepSVGCore/LayoutEngine.hpp"
 
-#include <cstdlib>
-#include <sstream>
 #include <string>
 
 namespace csvg {
 namespace {
 
-double ParseDimension(const std::map<std::string, std::string>& attrs, const std::string& key, double fallback) {
-    const auto it = attrs.find(key);
-    if (it == attrs.end()) {
+// Root width/height: percentages resolve against the fallback size and any
+// unit suffix is ignored.
+double ParseDimension(const AttributeMap& attrs, AttrId key, double fallback) {
+    const SvgLength* length = attrs.GetLength(key);
+    if (length == nullptr) {
         return fallback;
     }
-
-    const std::string raw = it->second;
-    if (raw.empty()) {
-        return fallback;
-    }
-
-    std::string cleaned;
-    cleaned.reserve(raw.size());
-    for (char c : raw) {
-        if ((c >= '0' && c <= '9') || c == '.' || c == '-' || c == '+') {
-            cleaned.push_back(c);
-        }
-    }
-
-    char* end_ptr = nullptr;
-    const double parsed = std::strtod(cleaned.c_str(), &end_ptr);
-    if (end_ptr == cleaned.c_str()) {
-        return fallback;
-    }
-
-    if (raw.find('%') != std::string::npos) {
-        return fallback * parsed / 100.0;
+    if (length->unit == LengthUnit::kPercent) {
+        return fallback * length->value / 100.0;
     }
-    return parsed;
+    return length->value;
 }
 
 } // namespace
@@ -46,10 +26,11 @@ std::optional<LayoutResult> LayoutEngine::Compute(const SvgDocument& document, c
     LayoutResult layout;
     const auto& attrs = document.root.attributes;
 
-    const auto viewbox_it = attrs.find("viewBox");
-    if (viewbox_it != attrs.end()) {
-        std::stringstream stream(viewbox_it->second);
-        stream >> layout.view_box_x >> layout.view_box_y >> layout.view_box_width >> layout.view_box_height;
+    if (const ViewBox* view_box = attrs.GetViewBox(AttrId::kViewBox)) {
+        layout.view_box_x = view_box->x;
+        layout.view_box_y = view_box->y;
+        layout.view_box_width = view_box->width;
+        layout.view_box_height = view_box->height;
     }
 
     const bool has_viewbox = layout.view_box_width > 0.0 && layout.view_box_height > 0.0;
@@ -59,8 +40,8 @@ std::optional<LayoutResult> LayoutEngine::Compute(const SvgDocument& document, c
     const double fallback_height = options.viewport_height > 0 ? static_cast<double>(options.viewport_height)
                                                                : (has_viewbox ? layout.view_box_height : 150.0);
 
-    layout.width = static_cast<int32_t>(ParseDimension(attrs, "width", fallback_width));
-    layout.height = static_cast<int32_t>(ParseDimension(attrs, "height", fallback_height));
+    layout.width = static_cast<int32_t>(ParseDimension(attrs, AttrId::kWidth, fallback_width));
+    layout.height = static_cast<int32_t>(ParseDimension(attrs, AttrId::kHeight, fallback_height));
 
     if (layout.width <= 0 || layout.height <= 0) {
         error.code = RenderErrorCode::kInvalidDocument;
@@ -0,0 +1,80 @@
+#include "YepSVGCore/NodeTransforms.hpp"
+
+namespace csvg {
+namespace {
+
+double LengthAttr(const XmlNode& node, AttrId key, double fallback, LengthAxis axis, double viewport_width, double viewport_height) {
+    const SvgLength* length = node.attributes.GetLength(key);
+    return length != nullptr ? length->ToPixels(axis, viewport_width, viewport_height) : fallback;
+}
+
+} // namespace
+
+NodeTransformCache::NodeTransformCache(const XmlNode& root,
+                                       const AffineMatrix& root_matrix,
+                                       double viewport_width,
+                                       double viewport_height)
+    : root_matrix_(root_matrix) {
+    Build(root, root_matrix, viewport_width, viewport_height, false);
+}
+
+NodeTransformCache::NodeTransformCache(const XmlNode& root, const LayoutResult& layout)
+    : NodeTransformCache(root, RootMatrix(root, layout), layout.view_box_width, layout.view_box_height) {}
+
+AffineMatrix NodeTransformCache::RootMatrix(const XmlNode& root, const LayoutResult& layout) {
+    const ViewBox view_box{layout.view_box_x, layout.view_box_y, layout.view_box_width, layout.view_box_height};
+    if (!view_box.IsValid()) {
+        return {};
+    }
+    const PreserveAspectRatio* preserve = root.attributes.GetPreserveAspectRatio(AttrId::kPreserveAspectRatio);
+    return ViewBoxTransform(static_cast<double>(layout.width),
+                            static_cast<double>(layout.height),
+                            view_box,
+                            preserve != nullptr ? *preserve : PreserveAspectRatio{});
+}
+
+const AffineMatrix* NodeTransformCache::UserToDevice(const XmlNode& node) const {
+    const auto it = matrices_.find(&node);
+    return it != matrices_.end() ? &it->second : nullptr;
+}
+
+void NodeTransformCache::Build(const XmlNode& node,
+                               const AffineMatrix& parent,
+                               double viewport_width,
+                               double viewport_height,
+                               bool nested) {
+    AffineMatrix matrix = parent;
+    if (const AffineMatrix* transform = node.attributes.GetTransform(AttrId::kTransform)) {
+        matrix = AffineMatrix::Concat(*transform, matrix);
+    }
+
+    double child_viewport_width = viewport_width;
+    double child_viewport_height = viewport_height;
+    if (nested && node.name == "svg") {
+        const double x = LengthAttr(node, AttrId::kX, 0.0, LengthAxis::kX, viewport_width, viewport_height);
+        const double y = LengthAttr(node, AttrId::kY, 0.0, LengthAxis::kY, viewport_width, viewport_height);
+        const double width = LengthAttr(node, AttrId::kWidth, viewport_width > 0.0 ? viewport_width : 100.0, LengthAxis::kX, viewport_width, viewport_height);
+        const double height = LengthAttr(node, AttrId::kHeight, viewport_height > 0.0 ? viewport_height : 100.0, LengthAxis::kY, viewport_width, viewport_height);
+        if (!(width > 0.0) || !(height > 0.0)) {
+            return;
+        }
+
+        matrix = AffineMatrix::Concat(AffineMatrix::Translation(x, y), matrix);
+        child_viewport_width = width;
+        child_viewport_height = height;
+        if (const ViewBox* view_box = node.attributes.GetViewBox(AttrId::kViewBox); view_box != nullptr && view_box->IsValid()) {
+            const PreserveAspectRatio* preserve = node.attributes.GetPreserveAspectRatio(AttrId::kPreserveAspectRatio);
+            matrix = AffineMatrix::Concat(ViewBoxTransform(width, height, *view_box, preserve != nullptr ? *preserve : PreserveAspectRatio{}),
+                                          matrix);
+            child_viewport_width = view_box->width;
+            child_viewport_height = view_box->height;
+        }
+    }
+
+    matrices_.emplace(&node, matrix);
+    for (const auto& child : node.children) {
+        Build(child, matrix, child_viewport_width, child_viewport_height, true);
+    }
+}
+
+} // namespace csvg
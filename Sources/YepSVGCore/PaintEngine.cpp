@@ -1,22 +1,42 @@
 #include "YepSVGCore/PaintEngine.hpp"
 
+#include "YepSVGCore/CssCascade.hpp"
+#include "YepSVGCore/DataUrl.hpp"
+#include "YepSVGCore/GlyphAtlas.hpp"
+#include "YepSVGCore/ImageDecodeCache.hpp"
+#include "YepSVGCore/NodeTransforms.hpp"
+#include "YepSVGCore/PathData.hpp"
+#include "YepSVGCore/PathFlattener.hpp"
+#include "YepSVGCore/RenderScratch.hpp"
+#include "YepSVGCore/Stylesheet.hpp"
+#include "YepSVGCore/SurfacePool.hpp"
+#include "YepSVGCore/TextLayout.hpp"
+#include "YepSVGCore/Theme.hpp"
+#include "YepSVGCore/Transform.hpp"
+
 #include <ImageIO/ImageIO.h>
 #include <CoreText/CoreText.h>
 
 #include <algorithm>
 #include <array>
 #include <cctype>
+#include <chrono>
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
+#include <deque>
 #include <fstream>
 #include <set>
 #include <map>
+#include <memory>
 #include <numeric>
 #include <optional>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <tuple>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace csvg {
@@ -70,1151 +90,291 @@ using PatternMap = std::map<std::string, PatternDefinition>;
 using NodeIdMap = std::map<std::string, const XmlNode*>;
 using ColorProfileMap = std::map<std::string, std::string>;
 
-enum class CssCombinator {
-    kNone,
-    kDescendant,
-    kChild,
-    kAdjacent,
-};
-
-enum class CssAttributeOperator {
-    kExists,
-    kEquals,
-    kIncludes,
-    kDashMatch,
-};
-
-struct CssAttributeSelector {
-    std::string name;
-    CssAttributeOperator op = CssAttributeOperator::kExists;
-    std::string value;
+class PaintProfileRecorder;
+
+// Everything one render reads besides its arguments. Paint installs a context
+// for the calling thread and restores the previous one when it returns, so
+// concurrent renders never see each other's state.
+struct PaintContext {
+    const CssCascade* cascade = nullptr;
+    const Theme* theme = nullptr;
+    // Outlines flattened during the current Paint, shared by every textPath.
+    FlattenedPathCache* path_cache = nullptr;
+    // Shaped text runs; owned by the renderer when it provides one, else by Paint.
+    TextLayoutCache* text_layouts = nullptr;
+    // Small-glyph coverage masks; only set when the renderer provides one.
+    GlyphAtlas* glyph_atlas = nullptr;
+    // Decoded raster images; owned by the renderer when it provides one, else by Paint.
+    ImageDecodeCache* images = nullptr;
+    // Remote resources fetched for this render, keyed by trimmed URL.
+    const FetchedResources* fetched = nullptr;
+    // Offscreen pixel buffers; owned by the renderer's scratch when it provides one, else by Paint.
+    SurfacePool* surface_pool = nullptr;
+    PaintProfileRecorder* profiler = nullptr;
 };
 
-struct CssSimpleSelector {
-    std::string tag = "*";
-    std::optional<std::string> id;
-    std::vector<std::string> classes;
-    std::vector<CssAttributeSelector> attributes;
-    bool first_child = false;
-};
+thread_local PaintContext g_paint;
 
-struct CssSelectorStep {
-    CssSimpleSelector simple;
-    CssCombinator combinator_to_prev = CssCombinator::kNone;
-};
+using ProfileClock = std::chrono::steady_clock;
 
-struct CssSelector {
-    std::vector<CssSelectorStep> steps;
-    int specificity = 0;
+enum class PaintCostKind {
+    kFilter,
+    kMask,
+    kClip,
+    kPattern,
 };
 
-struct CssRule {
-    std::vector<CssSelector> selectors;
-    std::map<std::string, std::string> declarations;
-    size_t source_order = 0;
-};
-
-struct CssStylesheet {
-    std::vector<CssRule> rules;
-    std::unordered_map<const XmlNode*, const XmlNode*> parent_by_node;
-    std::unordered_map<const XmlNode*, size_t> index_in_parent;
-};
-
-const CssStylesheet* g_active_stylesheet = nullptr;
-
-std::string Trim(const std::string& value) {
-    const auto begin = value.find_first_not_of(" \t\r\n");
-    if (begin == std::string::npos) {
-        return "";
-    }
-    const auto end = value.find_last_not_of(" \t\r\n");
-    return value.substr(begin, end - begin + 1);
-}
-
-std::string Lower(std::string value) {
-    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
-    return value;
+double ElapsedMilliseconds(ProfileClock::time_point start) {
+    return std::chrono::duration<double, std::milli>(ProfileClock::now() - start).count();
 }
 
-std::string CssLocalName(const std::string& name) {
-    const auto separator = name.rfind(':');
-    if (separator == std::string::npos) {
-        return Lower(name);
-    }
-    return Lower(name.substr(separator + 1));
-}
+class PaintProfileRecorder {
+public:
+    explicit PaintProfileRecorder(PaintProfile& profile) : profile_(profile) {}
 
-std::string RemoveCssComments(const std::string& css_text) {
-    std::string out;
-    out.reserve(css_text.size());
-    size_t cursor = 0;
-    while (cursor < css_text.size()) {
-        const auto comment_start = css_text.find("/*", cursor);
-        if (comment_start == std::string::npos) {
-            out.append(css_text.substr(cursor));
-            break;
-        }
-        out.append(css_text.substr(cursor, comment_start - cursor));
-        const auto comment_end = css_text.find("*/", comment_start + 2);
-        if (comment_end == std::string::npos) {
-            break;
+    void Enter(const XmlNode& node) {
+        const auto [it, inserted] = entry_by_node_.try_emplace(&node, profile_.entries.size());
+        if (inserted) {
+            profile_.entries.emplace_back();
+            depths_.push_back(0);
         }
-        cursor = comment_end + 2;
+        ++profile_.entries[it->second].paint_count;
+        ++depths_[it->second];
+        frames_.push_back(Frame{it->second, ProfileClock::now(), 0.0});
     }
-    return out;
-}
-
-std::vector<std::string> SplitCssTopLevel(const std::string& text, char delimiter) {
-    std::vector<std::string> tokens;
-    std::string current;
-    int bracket_depth = 0;
-    int paren_depth = 0;
-    bool in_single_quote = false;
-    bool in_double_quote = false;
 
-    for (char c : text) {
-        if (!in_double_quote && c == '\'') {
-            in_single_quote = !in_single_quote;
-            current.push_back(c);
-            continue;
+    void Leave() {
+        if (frames_.empty()) {
+            return;
         }
-        if (!in_single_quote && c == '"') {
-            in_double_quote = !in_double_quote;
-            current.push_back(c);
-            continue;
+        const Frame frame = frames_.back();
+        frames_.pop_back();
+        const double elapsed = ElapsedMilliseconds(frame.start);
+        auto& entry = profile_.entries[frame.entry];
+        entry.exclusive_ms += std::max(0.0, elapsed - frame.child_ms);
+        // Filters re-enter PaintNode for the same element; only the outermost
+        // visit contributes inclusive time so it is not double counted.
+        if (--depths_[frame.entry] == 0) {
+            entry.inclusive_ms += elapsed;
         }
-        if (in_single_quote || in_double_quote) {
-            current.push_back(c);
-            continue;
+        if (!frames_.empty()) {
+            frames_.back().child_ms += elapsed;
         }
-
-        if (c == '[') {
-            ++bracket_depth;
-        } else if (c == ']' && bracket_depth > 0) {
-            --bracket_depth;
-        } else if (c == '(') {
-            ++paren_depth;
-        } else if (c == ')' && paren_depth > 0) {
-            --paren_depth;
-        }
-
-        if (c == delimiter && bracket_depth == 0 && paren_depth == 0) {
-            const auto trimmed = Trim(current);
-            if (!trimmed.empty()) {
-                tokens.push_back(trimmed);
-            }
-            current.clear();
-            continue;
-        }
-        current.push_back(c);
-    }
-
-    const auto trailing = Trim(current);
-    if (!trailing.empty()) {
-        tokens.push_back(trailing);
-    }
-    return tokens;
-}
-
-bool IsCssNameStart(char c) {
-    return std::isalpha(static_cast<unsigned char>(c)) || c == '_' || c == '-';
-}
-
-bool IsCssNameChar(char c) {
-    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '-' || c == ':';
-}
-
-std::optional<std::string> ParseCssName(const std::string& token, size_t& index) {
-    if (index >= token.size() || !IsCssNameStart(token[index])) {
-        return std::nullopt;
-    }
-    const size_t start = index;
-    ++index;
-    while (index < token.size() && IsCssNameChar(token[index])) {
-        ++index;
-    }
-    return token.substr(start, index - start);
-}
-
-bool ParseCssAttributeSelectorToken(const std::string& raw, CssAttributeSelector& out) {
-    const auto trimmed = Trim(raw);
-    if (trimmed.empty()) {
-        return false;
     }
 
-    size_t index = 0;
-    auto name = ParseCssName(trimmed, index);
-    if (!name.has_value()) {
-        return false;
-    }
-    out.name = *name;
-    out.op = CssAttributeOperator::kExists;
-    out.value.clear();
-
-    while (index < trimmed.size() && std::isspace(static_cast<unsigned char>(trimmed[index]))) {
-        ++index;
-    }
-    if (index >= trimmed.size()) {
-        return true;
-    }
-
-    if (trimmed.compare(index, 2, "~=") == 0) {
-        out.op = CssAttributeOperator::kIncludes;
-        index += 2;
-    } else if (trimmed.compare(index, 2, "|=") == 0) {
-        out.op = CssAttributeOperator::kDashMatch;
-        index += 2;
-    } else if (trimmed[index] == '=') {
-        out.op = CssAttributeOperator::kEquals;
-        ++index;
-    } else {
-        return false;
-    }
-
-    while (index < trimmed.size() && std::isspace(static_cast<unsigned char>(trimmed[index]))) {
-        ++index;
-    }
-    if (index >= trimmed.size()) {
-        return false;
-    }
-
-    if (trimmed[index] == '\'' || trimmed[index] == '"') {
-        const char quote = trimmed[index++];
-        const size_t start = index;
-        while (index < trimmed.size() && trimmed[index] != quote) {
-            ++index;
-        }
-        if (index >= trimmed.size()) {
-            return false;
+    void AddOffscreenPixels(size_t width, size_t height) {
+        const uint64_t pixels = static_cast<uint64_t>(width) * static_cast<uint64_t>(height);
+        profile_.offscreen_pixels += pixels;
+        if (!frames_.empty()) {
+            profile_.entries[frames_.back().entry].offscreen_pixels += pixels;
         }
-        out.value = trimmed.substr(start, index - start);
-    } else {
-        out.value = Trim(trimmed.substr(index));
-    }
-    return true;
-}
-
-std::optional<CssSimpleSelector> ParseCssSimpleSelector(const std::string& token, int& specificity) {
-    CssSimpleSelector simple;
-    const auto trimmed = Trim(token);
-    if (trimmed.empty()) {
-        return std::nullopt;
-    }
-
-    size_t index = 0;
-    if (trimmed[index] == '*') {
-        simple.tag = "*";
-        ++index;
-    } else if (auto tag = ParseCssName(trimmed, index); tag.has_value()) {
-        simple.tag = CssLocalName(*tag);
-        ++specificity;
     }
 
-    while (index < trimmed.size()) {
-        const char c = trimmed[index];
-        if (std::isspace(static_cast<unsigned char>(c))) {
-            ++index;
-            continue;
-        }
-
-        if (c == '#') {
-            ++index;
-            auto id = ParseCssName(trimmed, index);
-            if (!id.has_value()) {
-                return std::nullopt;
-            }
-            simple.id = *id;
-            specificity += 100;
-            continue;
-        }
-
-        if (c == '.') {
-            ++index;
-            auto klass = ParseCssName(trimmed, index);
-            if (!klass.has_value()) {
-                return std::nullopt;
-            }
-            simple.classes.push_back(*klass);
-            specificity += 10;
-            continue;
-        }
-
-        if (c == '[') {
-            const auto close = trimmed.find(']', index + 1);
-            if (close == std::string::npos) {
-                return std::nullopt;
-            }
-            CssAttributeSelector attr;
-            if (!ParseCssAttributeSelectorToken(trimmed.substr(index + 1, close - index - 1), attr)) {
-                return std::nullopt;
-            }
-            simple.attributes.push_back(std::move(attr));
-            specificity += 10;
-            index = close + 1;
-            continue;
-        }
-
-        if (c == ':') {
-            ++index;
-            auto pseudo = ParseCssName(trimmed, index);
-            if (!pseudo.has_value()) {
-                return std::nullopt;
-            }
-            if (Lower(*pseudo) != "first-child") {
-                return std::nullopt;
-            }
-            simple.first_child = true;
-            specificity += 10;
-            continue;
+    void AddDecodedImagePixels(size_t width, size_t height) {
+        const uint64_t pixels = static_cast<uint64_t>(width) * static_cast<uint64_t>(height);
+        profile_.decoded_image_pixels += pixels;
+        if (!frames_.empty()) {
+            profile_.entries[frames_.back().entry].decoded_image_pixels += pixels;
         }
-
-        return std::nullopt;
     }
 
-    return simple;
-}
-
-std::optional<CssSelector> ParseCssSelector(const std::string& selector_text) {
-    std::vector<std::string> compounds;
-    std::vector<CssCombinator> combinators;
-
-    size_t index = 0;
-    while (index < selector_text.size()) {
-        while (index < selector_text.size() && std::isspace(static_cast<unsigned char>(selector_text[index]))) {
-            ++index;
-        }
-        if (index >= selector_text.size()) {
-            break;
-        }
-
-        const size_t start = index;
-        while (index < selector_text.size() &&
-               selector_text[index] != '>' &&
-               selector_text[index] != '+' &&
-               !std::isspace(static_cast<unsigned char>(selector_text[index]))) {
-            ++index;
-        }
-        const auto compound = Trim(selector_text.substr(start, index - start));
-        if (compound.empty()) {
-            return std::nullopt;
-        }
-        compounds.push_back(compound);
-
-        size_t space_begin = index;
-        while (index < selector_text.size() && std::isspace(static_cast<unsigned char>(selector_text[index]))) {
-            ++index;
-        }
-        const bool had_space = index > space_begin;
-        if (index >= selector_text.size()) {
-            break;
-        }
-
-        if (selector_text[index] == '>') {
-            combinators.push_back(CssCombinator::kChild);
-            ++index;
-            continue;
-        }
-        if (selector_text[index] == '+') {
-            combinators.push_back(CssCombinator::kAdjacent);
-            ++index;
-            continue;
+    void AddCost(PaintCostKind kind, double milliseconds) {
+        if (frames_.empty()) {
+            return;
         }
-        if (had_space) {
-            combinators.push_back(CssCombinator::kDescendant);
-            continue;
+        auto& entry = profile_.entries[frames_.back().entry];
+        switch (kind) {
+            case PaintCostKind::kFilter:
+                entry.filter_ms += milliseconds;
+                break;
+            case PaintCostKind::kMask:
+                entry.mask_ms += milliseconds;
+                break;
+            case PaintCostKind::kClip:
+                entry.clip_ms += milliseconds;
+                break;
+            case PaintCostKind::kPattern:
+                entry.pattern_ms += milliseconds;
+                break;
         }
-        return std::nullopt;
     }
 
-    if (compounds.empty() || combinators.size() + 1 != compounds.size()) {
-        return std::nullopt;
-    }
+    void Finish(const XmlNode& root) {
+        std::vector<size_t> document_order;
+        document_order.reserve(profile_.entries.size());
+        AssignPaths(root, "", 1, document_order);
 
-    CssSelector selector;
-    int specificity = 0;
-    std::vector<CssSimpleSelector> parsed;
-    parsed.reserve(compounds.size());
-    for (const auto& compound : compounds) {
-        auto simple = ParseCssSimpleSelector(compound, specificity);
-        if (!simple.has_value()) {
-            return std::nullopt;
+        std::vector<PaintProfileEntry> ordered;
+        ordered.reserve(profile_.entries.size());
+        for (const auto index : document_order) {
+            ordered.push_back(std::move(profile_.entries[index]));
         }
-        parsed.push_back(std::move(*simple));
+        profile_.entries = std::move(ordered);
     }
 
-    selector.steps.reserve(parsed.size());
-    for (size_t left = parsed.size(); left > 0; --left) {
-        const size_t i = left - 1;
-        CssSelectorStep step;
-        step.simple = parsed[i];
-        if (i > 0) {
-            step.combinator_to_prev = combinators[i - 1];
-        }
-        selector.steps.push_back(std::move(step));
-    }
-    selector.specificity = specificity;
-    return selector;
-}
+private:
+    struct Frame {
+        size_t entry = 0;
+        ProfileClock::time_point start;
+        double child_ms = 0.0;
+    };
 
-std::map<std::string, std::string> ParseCssDeclarations(const std::string& declarations_text) {
-    std::map<std::string, std::string> declarations;
-    for (const auto& declaration : SplitCssTopLevel(declarations_text, ';')) {
-        const auto separator = declaration.find(':');
-        if (separator == std::string::npos) {
-            continue;
-        }
-        const std::string name = Lower(Trim(declaration.substr(0, separator)));
-        std::string value = Trim(declaration.substr(separator + 1));
-        if (name.empty() || value.empty()) {
-            continue;
-        }
-        const auto important = Lower(value);
-        const auto bang_pos = important.rfind("!important");
-        if (bang_pos != std::string::npos && bang_pos + 10 == important.size()) {
-            value = Trim(value.substr(0, bang_pos));
+    void AssignPaths(const XmlNode& node,
+                     const std::string& parent_path,
+                     size_t position,
+                     std::vector<size_t>& document_order) {
+        const std::string path = parent_path + "/" + node.name + "[" + std::to_string(position) + "]";
+        if (const auto it = entry_by_node_.find(&node); it != entry_by_node_.end()) {
+            auto& entry = profile_.entries[it->second];
+            entry.path = path;
+            entry.tag = node.name;
+            if (const auto id_it = node.attributes.find(AttrId::kId); id_it != node.attributes.end()) {
+                entry.id = id_it->second;
+            }
+            document_order.push_back(it->second);
         }
-        declarations[name] = value;
-    }
-    return declarations;
-}
-
-void CollectNodeHierarchyMaps(const XmlNode& node,
-                              const XmlNode* parent,
-                              size_t index,
-                              CssStylesheet& stylesheet) {
-    if (parent != nullptr) {
-        stylesheet.parent_by_node[&node] = parent;
-        stylesheet.index_in_parent[&node] = index;
-    }
-    for (size_t i = 0; i < node.children.size(); ++i) {
-        CollectNodeHierarchyMaps(node.children[i], &node, i, stylesheet);
-    }
-}
 
-void CollectEmbeddedCssBlocks(const XmlNode& node, std::vector<std::string>& css_blocks) {
-    if (CssLocalName(node.name) == "style") {
-        const auto trimmed = Trim(node.text);
-        if (!trimmed.empty()) {
-            css_blocks.push_back(trimmed);
+        std::map<std::string, size_t> positions_by_name;
+        for (const auto& child : node.children) {
+            AssignPaths(child, path, ++positions_by_name[child.name], document_order);
         }
     }
-    for (const auto& child : node.children) {
-        CollectEmbeddedCssBlocks(child, css_blocks);
-    }
-}
-
-CssStylesheet BuildCssStylesheet(const XmlNode& root) {
-    CssStylesheet stylesheet;
-    CollectNodeHierarchyMaps(root, nullptr, 0, stylesheet);
-
-    std::vector<std::string> css_blocks;
-    CollectEmbeddedCssBlocks(root, css_blocks);
-    if (css_blocks.empty()) {
-        return stylesheet;
-    }
 
-    size_t source_order = 0;
-    for (const auto& block : css_blocks) {
-        const std::string css_text = RemoveCssComments(block);
-        size_t cursor = 0;
-        while (cursor < css_text.size()) {
-            const auto open = css_text.find('{', cursor);
-            if (open == std::string::npos) {
-                break;
-            }
-            const auto close = css_text.find('}', open + 1);
-            if (close == std::string::npos) {
-                break;
-            }
-
-            const auto selector_text = Trim(css_text.substr(cursor, open - cursor));
-            const auto declaration_text = css_text.substr(open + 1, close - open - 1);
-            cursor = close + 1;
-
-            if (selector_text.empty()) {
-                continue;
-            }
-
-            CssRule rule;
-            rule.source_order = ++source_order;
-            rule.declarations = ParseCssDeclarations(declaration_text);
-            if (rule.declarations.empty()) {
-                continue;
-            }
+    PaintProfile& profile_;
+    std::unordered_map<const XmlNode*, size_t> entry_by_node_;
+    std::vector<size_t> depths_;
+    std::vector<Frame> frames_;
+};
 
-            for (const auto& selector_token : SplitCssTopLevel(selector_text, ',')) {
-                if (auto selector = ParseCssSelector(selector_token); selector.has_value()) {
-                    rule.selectors.push_back(std::move(*selector));
-                }
-            }
-            if (!rule.selectors.empty()) {
-                stylesheet.rules.push_back(std::move(rule));
-            }
+class ScopedNodeProfile {
+public:
+    explicit ScopedNodeProfile(const XmlNode& node) : recorder_(g_paint.profiler) {
+        if (recorder_ != nullptr) {
+            recorder_->Enter(node);
         }
     }
-    return stylesheet;
-}
-
-bool HasClass(const std::string& class_value, const std::string& class_name) {
-    std::stringstream stream(class_value);
-    std::string token;
-    while (stream >> token) {
-        if (token == class_name) {
-            return true;
+    ~ScopedNodeProfile() {
+        if (recorder_ != nullptr) {
+            recorder_->Leave();
         }
     }
-    return false;
-}
 
-bool MatchesCssAttributeSelector(const XmlNode* node, const CssAttributeSelector& selector) {
-    if (node == nullptr) {
-        return false;
-    }
-    const auto attr_it = node->attributes.find(selector.name);
-    if (attr_it == node->attributes.end()) {
-        return false;
-    }
-    const std::string attr_value = attr_it->second;
+    ScopedNodeProfile(const ScopedNodeProfile&) = delete;
+    ScopedNodeProfile& operator=(const ScopedNodeProfile&) = delete;
 
-    switch (selector.op) {
-        case CssAttributeOperator::kExists:
-            return true;
-        case CssAttributeOperator::kEquals:
-            return attr_value == selector.value;
-        case CssAttributeOperator::kIncludes: {
-            std::stringstream stream(attr_value);
-            std::string token;
-            while (stream >> token) {
-                if (token == selector.value) {
-                    return true;
-                }
-            }
-            return false;
-        }
-        case CssAttributeOperator::kDashMatch:
-            return attr_value == selector.value ||
-                (attr_value.size() > selector.value.size() &&
-                 attr_value.compare(0, selector.value.size(), selector.value) == 0 &&
-                 attr_value[selector.value.size()] == '-');
-    }
-    return false;
-}
+private:
+    PaintProfileRecorder* recorder_ = nullptr;
+};
 
-bool MatchesCssSimpleSelector(const XmlNode* node,
-                              const CssSimpleSelector& selector,
-                              const CssStylesheet& stylesheet) {
-    if (node == nullptr) {
-        return false;
-    }
-    if (selector.tag != "*" && CssLocalName(node->name) != selector.tag) {
-        return false;
-    }
-    if (selector.id.has_value()) {
-        const auto id_it = node->attributes.find("id");
-        if (id_it == node->attributes.end() || id_it->second != *selector.id) {
-            return false;
+class ScopedPaintCost {
+public:
+    explicit ScopedPaintCost(PaintCostKind kind) : recorder_(g_paint.profiler), kind_(kind) {
+        if (recorder_ != nullptr) {
+            start_ = ProfileClock::now();
         }
     }
-    for (const auto& class_name : selector.classes) {
-        const auto class_it = node->attributes.find("class");
-        if (class_it == node->attributes.end() || !HasClass(class_it->second, class_name)) {
-            return false;
-        }
-    }
-    for (const auto& attr_selector : selector.attributes) {
-        if (!MatchesCssAttributeSelector(node, attr_selector)) {
-            return false;
-        }
-    }
-    if (selector.first_child) {
-        const auto index_it = stylesheet.index_in_parent.find(node);
-        if (index_it == stylesheet.index_in_parent.end() || index_it->second != 0) {
-            return false;
+    ~ScopedPaintCost() {
+        if (recorder_ != nullptr) {
+            recorder_->AddCost(kind_, ElapsedMilliseconds(start_));
         }
     }
-    return true;
-}
 
-const XmlNode* CssParentOf(const CssStylesheet& stylesheet, const XmlNode* node) {
-    if (node == nullptr) {
-        return nullptr;
-    }
-    const auto it = stylesheet.parent_by_node.find(node);
-    if (it == stylesheet.parent_by_node.end()) {
-        return nullptr;
-    }
-    return it->second;
-}
+    ScopedPaintCost(const ScopedPaintCost&) = delete;
+    ScopedPaintCost& operator=(const ScopedPaintCost&) = delete;
 
-const XmlNode* CssPreviousSibling(const CssStylesheet& stylesheet, const XmlNode* node) {
-    const auto parent = CssParentOf(stylesheet, node);
-    if (parent == nullptr) {
-        return nullptr;
-    }
-    const auto index_it = stylesheet.index_in_parent.find(node);
-    if (index_it == stylesheet.index_in_parent.end() || index_it->second == 0) {
-        return nullptr;
-    }
-    const size_t sibling_index = index_it->second - 1;
-    if (sibling_index >= parent->children.size()) {
-        return nullptr;
+    void Cancel() {
+        recorder_ = nullptr;
     }
-    return &parent->children[sibling_index];
-}
 
-bool MatchesCssSelectorAtStep(const CssSelector& selector,
-                              size_t step_index,
-                              const XmlNode* node,
-                              const CssStylesheet& stylesheet) {
-    if (!MatchesCssSimpleSelector(node, selector.steps[step_index].simple, stylesheet)) {
-        return false;
-    }
-    if (step_index + 1 >= selector.steps.size()) {
-        return true;
-    }
+private:
+    PaintProfileRecorder* recorder_ = nullptr;
+    PaintCostKind kind_;
+    ProfileClock::time_point start_;
+};
 
-    const auto combinator = selector.steps[step_index].combinator_to_prev;
-    if (combinator == CssCombinator::kChild) {
-        const auto parent = CssParentOf(stylesheet, node);
-        return parent != nullptr && MatchesCssSelectorAtStep(selector, step_index + 1, parent, stylesheet);
-    }
-    if (combinator == CssCombinator::kAdjacent) {
-        const auto previous_sibling = CssPreviousSibling(stylesheet, node);
-        return previous_sibling != nullptr && MatchesCssSelectorAtStep(selector, step_index + 1, previous_sibling, stylesheet);
+void ProfileOffscreenPixels(size_t width, size_t height) {
+    if (g_paint.profiler != nullptr) {
+        g_paint.profiler->AddOffscreenPixels(width, height);
     }
-    if (combinator == CssCombinator::kDescendant) {
-        auto ancestor = CssParentOf(stylesheet, node);
-        while (ancestor != nullptr) {
-            if (MatchesCssSelectorAtStep(selector, step_index + 1, ancestor, stylesheet)) {
-                return true;
-            }
-            ancestor = CssParentOf(stylesheet, ancestor);
-        }
-        return false;
-    }
-    return false;
 }
 
-bool MatchesCssSelector(const CssSelector& selector, const XmlNode* node, const CssStylesheet& stylesheet) {
-    if (selector.steps.empty() || node == nullptr) {
-        return false;
+void ProfileDecodedImagePixels(size_t width, size_t height) {
+    if (g_paint.profiler != nullptr) {
+        g_paint.profiler->AddDecodedImagePixels(width, height);
     }
-    return MatchesCssSelectorAtStep(selector, 0, node, stylesheet);
 }
 
-std::map<std::string, std::string> ResolveMatchedCssProperties(const XmlNode& node) {
-    struct Winner {
-        std::string value;
-        int specificity = 0;
-        size_t source_order = 0;
-    };
-
-    std::map<std::string, std::string> resolved;
-    if (g_active_stylesheet == nullptr) {
-        return resolved;
-    }
-
-    std::map<std::string, Winner> winners;
-    for (const auto& rule : g_active_stylesheet->rules) {
-        int matched_specificity = -1;
-        for (const auto& selector : rule.selectors) {
-            if (MatchesCssSelector(selector, &node, *g_active_stylesheet)) {
-                matched_specificity = std::max(matched_specificity, selector.specificity);
-            }
-        }
-        if (matched_specificity < 0) {
-            continue;
-        }
-
-        for (const auto& [property, value] : rule.declarations) {
-            auto current = winners.find(property);
-            if (current == winners.end() ||
-                matched_specificity > current->second.specificity ||
-                (matched_specificity == current->second.specificity && rule.source_order >= current->second.source_order)) {
-                winners[property] = Winner{value, matched_specificity, rule.source_order};
-            }
-        }
-    }
-
-    for (const auto& [property, winner] : winners) {
-        resolved[property] = winner.value;
+std::string Trim(const std::string& value) {
+    const auto begin = value.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        return "";
     }
-    return resolved;
-}
-
-bool IsNumberStart(char c) {
-    return std::isdigit(static_cast<unsigned char>(c)) || c == '-' || c == '+' || c == '.';
+    const auto end = value.find_last_not_of(" \t\r\n");
+    return value.substr(begin, end - begin + 1);
 }
 
-void SkipPathDelimiters(const std::string& text, size_t& index) {
-    while (index < text.size()) {
-        const char c = text[index];
-        if (std::isspace(static_cast<unsigned char>(c)) || c == ',') {
-            ++index;
-            continue;
-        }
-        break;
+std::string_view TrimView(std::string_view value) {
+    const auto begin = value.find_first_not_of(" \t\r\n");
+    if (begin == std::string_view::npos) {
+        return {};
     }
+    const auto end = value.find_last_not_of(" \t\r\n");
+    return value.substr(begin, end - begin + 1);
 }
 
-bool ParsePathNumber(const std::string& text, size_t& index, double& out) {
-    SkipPathDelimiters(text, index);
-    if (index >= text.size()) {
-        return false;
-    }
-
-    const char* start = text.c_str() + index;
-    char* end_ptr = nullptr;
-    out = std::strtod(start, &end_ptr);
-    if (end_ptr == start) {
-        return false;
-    }
-    index = static_cast<size_t>(end_ptr - text.c_str());
-    return true;
+std::string Lower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
 }
 
-bool HasMorePathNumbers(const std::string& text, size_t index) {
-    SkipPathDelimiters(text, index);
-    if (index >= text.size()) {
-        return false;
+PropertyMap ResolveMatchedCssProperties(const XmlNode& node) {
+    if (g_paint.cascade == nullptr) {
+        return {};
     }
-    return IsNumberStart(text[index]);
+    return csvg::ResolveMatchedCssProperties(node, *g_paint.cascade);
 }
 
-constexpr double kArcEpsilon = 1e-9;
+class CGContextPathSink : public PathDataSink {
+public:
+    explicit CGContextPathSink(CGContextRef context) : context_(context) {}
 
-bool NearlyEqual(double a, double b) {
-    return std::fabs(a - b) <= kArcEpsilon;
-}
-
-double SignedVectorAngle(double ux, double uy, double vx, double vy) {
-    return std::atan2((ux * vy) - (uy * vx), (ux * vx) + (uy * vy));
-}
-
-CGPoint MapUnitArcPoint(double ux,
-                        double uy,
-                        double cx,
-                        double cy,
-                        double rx,
-                        double ry,
-                        double cos_phi,
-                        double sin_phi) {
-    const double x = cx + (rx * ux * cos_phi) - (ry * uy * sin_phi);
-    const double y = cy + (rx * ux * sin_phi) + (ry * uy * cos_phi);
-    return CGPointMake(static_cast<CGFloat>(x), static_cast<CGFloat>(y));
-}
-
-void AddArcAsBezier(CGContextRef context,
-                    double x1,
-                    double y1,
-                    double rx,
-                    double ry,
-                    double x_axis_rotation_degrees,
-                    bool large_arc_flag,
-                    bool sweep_flag,
-                    double x2,
-                    double y2) {
-    if (NearlyEqual(x1, x2) && NearlyEqual(y1, y2)) {
-        return;
+    void MoveTo(double x, double y) override {
+        CGContextMoveToPoint(context_, static_cast<CGFloat>(x), static_cast<CGFloat>(y));
     }
-
-    rx = std::fabs(rx);
-    ry = std::fabs(ry);
-    if (rx < kArcEpsilon || ry < kArcEpsilon) {
-        CGContextAddLineToPoint(context, static_cast<CGFloat>(x2), static_cast<CGFloat>(y2));
-        return;
+    void LineTo(double x, double y) override {
+        CGContextAddLineToPoint(context_, static_cast<CGFloat>(x), static_cast<CGFloat>(y));
     }
-
-    const double phi = x_axis_rotation_degrees * M_PI / 180.0;
-    const double cos_phi = std::cos(phi);
-    const double sin_phi = std::sin(phi);
-
-    const double dx2 = (x1 - x2) / 2.0;
-    const double dy2 = (y1 - y2) / 2.0;
-    const double x1p = (cos_phi * dx2) + (sin_phi * dy2);
-    const double y1p = (-sin_phi * dx2) + (cos_phi * dy2);
-
-    const double x1p2 = x1p * x1p;
-    const double y1p2 = y1p * y1p;
-
-    double rx2 = rx * rx;
-    double ry2 = ry * ry;
-    const double lambda = (x1p2 / rx2) + (y1p2 / ry2);
-    if (lambda > 1.0) {
-        const double scale = std::sqrt(lambda);
-        rx *= scale;
-        ry *= scale;
-        rx2 = rx * rx;
-        ry2 = ry * ry;
+    void CubicTo(double x1, double y1, double x2, double y2, double x, double y) override {
+        CGContextAddCurveToPoint(context_,
+                                 static_cast<CGFloat>(x1),
+                                 static_cast<CGFloat>(y1),
+                                 static_cast<CGFloat>(x2),
+                                 static_cast<CGFloat>(y2),
+                                 static_cast<CGFloat>(x),
+                                 static_cast<CGFloat>(y));
     }
-
-    const double numerator = (rx2 * ry2) - (rx2 * y1p2) - (ry2 * x1p2);
-    const double denominator = (rx2 * y1p2) + (ry2 * x1p2);
-    if (std::fabs(denominator) < kArcEpsilon) {
-        CGContextAddLineToPoint(context, static_cast<CGFloat>(x2), static_cast<CGFloat>(y2));
-        return;
+    void QuadTo(double x1, double y1, double x, double y) override {
+        CGContextAddQuadCurveToPoint(context_,
+                                     static_cast<CGFloat>(x1),
+                                     static_cast<CGFloat>(y1),
+                                     static_cast<CGFloat>(x),
+                                     static_cast<CGFloat>(y));
     }
-
-    double center_scale = std::sqrt(std::max(0.0, numerator / denominator));
-    if (large_arc_flag == sweep_flag) {
-        center_scale = -center_scale;
+    void ClosePath() override {
+        CGContextClosePath(context_);
     }
 
-    const double cxp = center_scale * ((rx * y1p) / ry);
-    const double cyp = center_scale * (-(ry * x1p) / rx);
-
-    const double cx = (cos_phi * cxp) - (sin_phi * cyp) + ((x1 + x2) / 2.0);
-    const double cy = (sin_phi * cxp) + (cos_phi * cyp) + ((y1 + y2) / 2.0);
-
-    const double ux = (x1p - cxp) / rx;
-    const double uy = (y1p - cyp) / ry;
-    const double vx = (-x1p - cxp) / rx;
-    const double vy = (-y1p - cyp) / ry;
-
-    double start_angle = std::atan2(uy, ux);
-    double delta_angle = SignedVectorAngle(ux, uy, vx, vy);
-    if (!sweep_flag && delta_angle > 0.0) {
-        delta_angle -= 2.0 * M_PI;
-    } else if (sweep_flag && delta_angle < 0.0) {
-        delta_angle += 2.0 * M_PI;
-    }
-
-    const int segment_count = std::max(1, static_cast<int>(std::ceil(std::fabs(delta_angle) / (M_PI / 2.0))));
-    const double segment_angle = delta_angle / static_cast<double>(segment_count);
-
-    for (int i = 0; i < segment_count; ++i) {
-        const double theta1 = start_angle + (segment_angle * static_cast<double>(i));
-        const double theta2 = theta1 + segment_angle;
-        const double alpha = (4.0 / 3.0) * std::tan((theta2 - theta1) / 4.0);
-
-        const double cos_theta1 = std::cos(theta1);
-        const double sin_theta1 = std::sin(theta1);
-        const double cos_theta2 = std::cos(theta2);
-        const double sin_theta2 = std::sin(theta2);
-
-        const double cp1x_u = cos_theta1 - (alpha * sin_theta1);
-        const double cp1y_u = sin_theta1 + (alpha * cos_theta1);
-        const double cp2x_u = cos_theta2 + (alpha * sin_theta2);
-        const double cp2y_u = sin_theta2 - (alpha * cos_theta2);
-
-        const CGPoint cp1 = MapUnitArcPoint(cp1x_u, cp1y_u, cx, cy, rx, ry, cos_phi, sin_phi);
-        const CGPoint cp2 = MapUnitArcPoint(cp2x_u, cp2y_u, cx, cy, rx, ry, cos_phi, sin_phi);
-        const CGPoint end = MapUnitArcPoint(cos_theta2, sin_theta2, cx, cy, rx, ry, cos_phi, sin_phi);
-
-        CGContextAddCurveToPoint(context, cp1.x, cp1.y, cp2.x, cp2.y, end.x, end.y);
-    }
-}
+private:
+    CGContextRef context_ = nullptr;
+};
 
 bool BuildPathFromData(CGContextRef context, const std::string& path_data) {
-    size_t index = 0;
-    char command = '\0';
-
-    double current_x = 0.0;
-    double current_y = 0.0;
-    double start_x = 0.0;
-    double start_y = 0.0;
-
-    double last_cubic_ctrl_x = 0.0;
-    double last_cubic_ctrl_y = 0.0;
-    double last_quad_ctrl_x = 0.0;
-    double last_quad_ctrl_y = 0.0;
-    bool has_last_cubic = false;
-    bool has_last_quad = false;
-
-    while (index < path_data.size()) {
-        SkipPathDelimiters(path_data, index);
-        if (index >= path_data.size()) {
-            break;
-        }
-
-        const char token = path_data[index];
-        if (std::isalpha(static_cast<unsigned char>(token))) {
-            command = token;
-            ++index;
-        } else if (command == '\0') {
-            ++index;
-            continue;
-        }
-
-        const bool relative = std::islower(static_cast<unsigned char>(command));
-        const char upper = static_cast<char>(std::toupper(static_cast<unsigned char>(command)));
-
-        if (upper == 'M') {
-            double x = 0.0;
-            double y = 0.0;
-            if (!ParsePathNumber(path_data, index, x) || !ParsePathNumber(path_data, index, y)) {
-                break;
-            }
-            if (relative) {
-                x += current_x;
-                y += current_y;
-            }
-            CGContextMoveToPoint(context, static_cast<CGFloat>(x), static_cast<CGFloat>(y));
-            current_x = x;
-            current_y = y;
-            start_x = x;
-            start_y = y;
-
-            while (HasMorePathNumbers(path_data, index)) {
-                if (!ParsePathNumber(path_data, index, x) || !ParsePathNumber(path_data, index, y)) {
-                    break;
-                }
-                if (relative) {
-                    x += current_x;
-                    y += current_y;
-                }
-                CGContextAddLineToPoint(context, static_cast<CGFloat>(x), static_cast<CGFloat>(y));
-                current_x = x;
-                current_y = y;
-            }
-            has_last_cubic = false;
-            has_last_quad = false;
-            continue;
-        }
-
-        if (upper == 'L') {
-            double x = 0.0;
-            double y = 0.0;
-            while (ParsePathNumber(path_data, index, x) && ParsePathNumber(path_data, index, y)) {
-                if (relative) {
-                    x += current_x;
-                    y += current_y;
-                }
-                CGContextAddLineToPoint(context, static_cast<CGFloat>(x), static_cast<CGFloat>(y));
-                current_x = x;
-                current_y = y;
-            }
-            has_last_cubic = false;
-            has_last_quad = false;
-            continue;
-        }
-
-        if (upper == 'H') {
-            double x = 0.0;
-            while (ParsePathNumber(path_data, index, x)) {
-                if (relative) {
-                    x += current_x;
-                }
-                CGContextAddLineToPoint(context, static_cast<CGFloat>(x), static_cast<CGFloat>(current_y));
-                current_x = x;
-            }
-            has_last_cubic = false;
-            has_last_quad = false;
-            continue;
-        }
-
-        if (upper == 'V') {
-            double y = 0.0;
-            while (ParsePathNumber(path_data, index, y)) {
-                if (relative) {
-                    y += current_y;
-                }
-                CGContextAddLineToPoint(context, static_cast<CGFloat>(current_x), static_cast<CGFloat>(y));
-                current_y = y;
-            }
-            has_last_cubic = false;
-            has_last_quad = false;
-            continue;
-        }
-
-        if (upper == 'C') {
-            double x1 = 0.0;
-            double y1 = 0.0;
-            double x2 = 0.0;
-            double y2 = 0.0;
-            double x = 0.0;
-            double y = 0.0;
-            while (ParsePathNumber(path_data, index, x1) &&
-                   ParsePathNumber(path_data, index, y1) &&
-                   ParsePathNumber(path_data, index, x2) &&
-                   ParsePathNumber(path_data, index, y2) &&
-                   ParsePathNumber(path_data, index, x) &&
-                   ParsePathNumber(path_data, index, y)) {
-                if (relative) {
-                    x1 += current_x;
-                    y1 += current_y;
-                    x2 += current_x;
-                    y2 += current_y;
-                    x += current_x;
-                    y += current_y;
-                }
-                CGContextAddCurveToPoint(context,
-                                         static_cast<CGFloat>(x1),
-                                         static_cast<CGFloat>(y1),
-                                         static_cast<CGFloat>(x2),
-                                         static_cast<CGFloat>(y2),
-                                         static_cast<CGFloat>(x),
-                                         static_cast<CGFloat>(y));
-                current_x = x;
-                current_y = y;
-                last_cubic_ctrl_x = x2;
-                last_cubic_ctrl_y = y2;
-                has_last_cubic = true;
-                has_last_quad = false;
-            }
-            continue;
-        }
-
-        if (upper == 'S') {
-            double x2 = 0.0;
-            double y2 = 0.0;
-            double x = 0.0;
-            double y = 0.0;
-            while (ParsePathNumber(path_data, index, x2) &&
-                   ParsePathNumber(path_data, index, y2) &&
-                   ParsePathNumber(path_data, index, x) &&
-                   ParsePathNumber(path_data, index, y)) {
-                double x1 = current_x;
-                double y1 = current_y;
-                if (has_last_cubic) {
-                    x1 = 2.0 * current_x - last_cubic_ctrl_x;
-                    y1 = 2.0 * current_y - last_cubic_ctrl_y;
-                }
-
-                if (relative) {
-                    x2 += current_x;
-                    y2 += current_y;
-                    x += current_x;
-                    y += current_y;
-                }
-
-                CGContextAddCurveToPoint(context,
-                                         static_cast<CGFloat>(x1),
-                                         static_cast<CGFloat>(y1),
-                                         static_cast<CGFloat>(x2),
-                                         static_cast<CGFloat>(y2),
-                                         static_cast<CGFloat>(x),
-                                         static_cast<CGFloat>(y));
-
-                current_x = x;
-                current_y = y;
-                last_cubic_ctrl_x = x2;
-                last_cubic_ctrl_y = y2;
-                has_last_cubic = true;
-                has_last_quad = false;
-            }
-            continue;
-        }
-
-        if (upper == 'Q') {
-            double x1 = 0.0;
-            double y1 = 0.0;
-            double x = 0.0;
-            double y = 0.0;
-            while (ParsePathNumber(path_data, index, x1) &&
-                   ParsePathNumber(path_data, index, y1) &&
-                   ParsePathNumber(path_data, index, x) &&
-                   ParsePathNumber(path_data, index, y)) {
-                if (relative) {
-                    x1 += current_x;
-                    y1 += current_y;
-                    x += current_x;
-                    y += current_y;
-                }
-
-                CGContextAddQuadCurveToPoint(context,
-                                             static_cast<CGFloat>(x1),
-                                             static_cast<CGFloat>(y1),
-                                             static_cast<CGFloat>(x),
-                                             static_cast<CGFloat>(y));
-
-                current_x = x;
-                current_y = y;
-                last_quad_ctrl_x = x1;
-                last_quad_ctrl_y = y1;
-                has_last_quad = true;
-                has_last_cubic = false;
-            }
-            continue;
-        }
-
-        if (upper == 'T') {
-            double x = 0.0;
-            double y = 0.0;
-            while (ParsePathNumber(path_data, index, x) && ParsePathNumber(path_data, index, y)) {
-                double x1 = current_x;
-                double y1 = current_y;
-                if (has_last_quad) {
-                    x1 = 2.0 * current_x - last_quad_ctrl_x;
-                    y1 = 2.0 * current_y - last_quad_ctrl_y;
-                }
-
-                if (relative) {
-                    x += current_x;
-                    y += current_y;
-                }
-
-                CGContextAddQuadCurveToPoint(context,
-                                             static_cast<CGFloat>(x1),
-                                             static_cast<CGFloat>(y1),
-                                             static_cast<CGFloat>(x),
-                                             static_cast<CGFloat>(y));
-
-                current_x = x;
-                current_y = y;
-                last_quad_ctrl_x = x1;
-                last_quad_ctrl_y = y1;
-                has_last_quad = true;
-                has_last_cubic = false;
-            }
-            continue;
-        }
-
-        if (upper == 'A') {
-            double rx = 0.0;
-            double ry = 0.0;
-            double angle = 0.0;
-            double large_arc = 0.0;
-            double sweep = 0.0;
-            double x = 0.0;
-            double y = 0.0;
-            while (ParsePathNumber(path_data, index, rx) &&
-                   ParsePathNumber(path_data, index, ry) &&
-                   ParsePathNumber(path_data, index, angle) &&
-                   ParsePathNumber(path_data, index, large_arc) &&
-                   ParsePathNumber(path_data, index, sweep) &&
-                   ParsePathNumber(path_data, index, x) &&
-                   ParsePathNumber(path_data, index, y)) {
-                if (relative) {
-                    x += current_x;
-                    y += current_y;
-                }
-
-                AddArcAsBezier(context,
-                               current_x,
-                               current_y,
-                               rx,
-                               ry,
-                               angle,
-                               std::fabs(large_arc) > 0.0,
-                               std::fabs(sweep) > 0.0,
-                               x,
-                               y);
-                current_x = x;
-                current_y = y;
-            }
-            has_last_cubic = false;
-            has_last_quad = false;
-            continue;
-        }
-
-        if (upper == 'Z') {
-            CGContextClosePath(context);
-            current_x = start_x;
-            current_y = start_y;
-            has_last_cubic = false;
-            has_last_quad = false;
-            continue;
-        }
-
-        ++index;
-    }
-
-    return true;
+    CGContextPathSink sink(context);
+    return PathDataParser().Parse(path_data, sink);
 }
 
-std::map<std::string, std::string> ParseInlineStyle(const std::string& style_text) {
-    std::map<std::string, std::string> out;
+PropertyMap ParseInlineStyle(const std::string& style_text) {
+    PropertyMap out;
     std::stringstream stream(style_text);
     std::string token;
     while (std::getline(stream, token, ';')) {
@@ -1231,154 +391,61 @@ std::map<std::string, std::string> ParseInlineStyle(const std::string& style_tex
     return out;
 }
 
-std::optional<std::string> ReadAttrOrStyle(const XmlNode& node,
-                                           const std::map<std::string, std::string>& inline_style,
-                                           const std::map<std::string, std::string>* matched_css_properties,
-                                           const std::string& key) {
-    const auto inline_it = inline_style.find(key);
+std::optional<std::string> ReadDeclaredAttrOrStyle(const XmlNode& node,
+                                                   const PropertyMap& inline_style,
+                                                   const PropertyMap* matched_css_properties,
+                                                   AttrId key) {
+    const std::string_view name = AttrName(key);
+    const auto inline_it = inline_style.find(name);
     if (inline_it != inline_style.end()) {
         return inline_it->second;
     }
     if (matched_css_properties != nullptr) {
-        const auto matched_it = matched_css_properties->find(key);
+        const auto matched_it = matched_css_properties->find(name);
         if (matched_it != matched_css_properties->end()) {
             return matched_it->second;
         }
     }
-    const auto attr_it = node.attributes.find(key);
-    if (attr_it != node.attributes.end()) {
-        return attr_it->second;
+    if (const auto* value = node.attributes.Get(key); value != nullptr) {
+        return *value;
     }
     return std::nullopt;
 }
 
-double ParseCoordinate(const std::string& raw, double fallback) {
-    const auto trimmed = Trim(raw);
-    if (trimmed.empty()) {
-        return fallback;
-    }
-
-    char* end_ptr = nullptr;
-    const double parsed = std::strtod(trimmed.c_str(), &end_ptr);
-    if (end_ptr == trimmed.c_str()) {
-        return fallback;
-    }
-
-    if (*end_ptr == '%') {
-        return parsed / 100.0;
-    }
-    return parsed;
-}
-
-double ParseOffset(const std::string& raw) {
-    const auto trimmed = Trim(raw);
-    if (trimmed.empty()) {
-        return 0.0;
-    }
-
-    char* end_ptr = nullptr;
-    const double parsed = std::strtod(trimmed.c_str(), &end_ptr);
-    if (end_ptr == trimmed.c_str()) {
-        return 0.0;
-    }
-
-    if (*end_ptr == '%') {
-        return std::clamp(parsed / 100.0, 0.0, 1.0);
-    }
-    return std::clamp(parsed, 0.0, 1.0);
-}
-
-double ParseDouble(const std::string& raw, double fallback) {
-    const auto trimmed = Trim(raw);
-    if (trimmed.empty()) {
-        return fallback;
-    }
-
-    char* end_ptr = nullptr;
-    const double parsed = std::strtod(trimmed.c_str(), &end_ptr);
-    if (end_ptr == trimmed.c_str()) {
-        return fallback;
-    }
-
-    if (*end_ptr == '%') {
-        return parsed / 100.0;
-    }
-    return parsed;
-}
-
-double ParseObjectBoundingBoxLength(const std::string& raw, double fallback) {
-    const auto trimmed = Trim(raw);
-    if (trimmed.empty()) {
-        return fallback;
-    }
-
-    char* end_ptr = nullptr;
-    const double parsed = std::strtod(trimmed.c_str(), &end_ptr);
-    if (end_ptr == trimmed.c_str()) {
-        return fallback;
-    }
-
-    if (*end_ptr == '%') {
-        return parsed / 100.0;
-    }
-    return parsed;
-}
-
-enum class SvgLengthAxis {
-    kX,
-    kY,
-    kDiagonal,
-};
-
-double NormalizeViewportDiagonal(double width, double height) {
-    if (width <= 0.0 || height <= 0.0) {
-        return 100.0;
+std::optional<std::string> ReadAttrOrStyle(const XmlNode& node,
+                                           const PropertyMap& inline_style,
+                                           const PropertyMap* matched_css_properties,
+                                           AttrId key) {
+    auto value = ReadDeclaredAttrOrStyle(node, inline_style, matched_css_properties, key);
+    if (g_paint.theme != nullptr && value.has_value() && value->find("var(") != std::string::npos) {
+        value = g_paint.theme->SubstituteVariables(*value);
     }
-    return std::sqrt((width * width + height * height) / 2.0);
+    return value;
 }
 
-double PercentLengthBasis(SvgLengthAxis axis, double viewport_width, double viewport_height) {
-    switch (axis) {
-        case SvgLengthAxis::kX:
-            return viewport_width > 0.0 ? viewport_width : 100.0;
-        case SvgLengthAxis::kY:
-            return viewport_height > 0.0 ? viewport_height : 100.0;
-        case SvgLengthAxis::kDiagonal:
-            return NormalizeViewportDiagonal(viewport_width, viewport_height);
-    }
-    return 100.0;
+Color ThemedColor(const Color& color) {
+    return g_paint.theme != nullptr ? g_paint.theme->Apply(color) : color;
 }
 
-double ConvertLengthToPixels(double value, const std::string& unit) {
-    if (unit.empty() || unit == "px") {
-        return value;
-    }
-    if (unit == "pt") {
-        return value * (96.0 / 72.0);
-    }
-    if (unit == "pc") {
-        return value * 16.0;
-    }
-    if (unit == "in") {
-        return value * 96.0;
-    }
-    if (unit == "cm") {
-        return value * (96.0 / 2.54);
+double ParseOffset(const std::string& raw) {
+    const auto trimmed = Trim(raw);
+    if (trimmed.empty()) {
+        return 0.0;
     }
-    if (unit == "mm") {
-        return value * (96.0 / 25.4);
+
+    char* end_ptr = nullptr;
+    const double parsed = std::strtod(trimmed.c_str(), &end_ptr);
+    if (end_ptr == trimmed.c_str()) {
+        return 0.0;
     }
-    if (unit == "q") {
-        return value * (96.0 / 101.6);
+
+    if (*end_ptr == '%') {
+        return std::clamp(parsed / 100.0, 0.0, 1.0);
     }
-    return value;
+    return std::clamp(parsed, 0.0, 1.0);
 }
 
-double ParseSVGLength(const std::string& raw,
-                      double fallback,
-                      SvgLengthAxis axis,
-                      double viewport_width,
-                      double viewport_height) {
+double ParseDouble(const std::string& raw, double fallback) {
     const auto trimmed = Trim(raw);
     if (trimmed.empty()) {
         return fallback;
@@ -1390,365 +457,106 @@ double ParseSVGLength(const std::string& raw,
         return fallback;
     }
 
-    const std::string suffix = Lower(Trim(std::string(end_ptr)));
-    if (suffix == "%") {
-        const double basis = PercentLengthBasis(axis, viewport_width, viewport_height);
-        return (parsed / 100.0) * basis;
+    if (*end_ptr == '%') {
+        return parsed / 100.0;
     }
-    return ConvertLengthToPixels(parsed, suffix);
+    return parsed;
 }
 
-double ParseSVGLengthAttr(const std::map<std::string, std::string>& attributes,
-                          const std::string& key,
+double ParseSVGLengthAttr(const AttributeMap& attributes,
+                          AttrId key,
                           double fallback,
-                          SvgLengthAxis axis,
+                          LengthAxis axis,
                           double viewport_width,
                           double viewport_height) {
-    const auto it = attributes.find(key);
-    if (it == attributes.end()) {
-        return fallback;
-    }
-    return ParseSVGLength(it->second, fallback, axis, viewport_width, viewport_height);
-}
-
-bool ParseViewBoxValue(const std::string& raw,
-                       double& view_box_x,
-                       double& view_box_y,
-                       double& view_box_width,
-                       double& view_box_height) {
-    std::string normalized = raw;
-    std::replace(normalized.begin(), normalized.end(), ',', ' ');
-
-    std::stringstream parser(normalized);
-    if (!(parser >> view_box_x >> view_box_y >> view_box_width >> view_box_height)) {
-        return false;
-    }
-    return view_box_width > 0.0 && view_box_height > 0.0;
+    const SvgLength* length = attributes.GetLength(key);
+    return length != nullptr ? length->ToPixels(axis, viewport_width, viewport_height) : fallback;
 }
 
-CGAffineTransform ComputeViewBoxTransform(double viewport_width,
-                                          double viewport_height,
-                                          double view_box_x,
-                                          double view_box_y,
-                                          double view_box_width,
-                                          double view_box_height,
-                                          const std::string& preserve_raw) {
-    const double scale_x = viewport_width / view_box_width;
-    const double scale_y = viewport_height / view_box_height;
-
-    std::string preserve_value = Lower(Trim(preserve_raw));
-    if (preserve_value.empty()) {
-        preserve_value = "xmidymid meet";
-    }
-
-    double final_scale_x = scale_x;
-    double final_scale_y = scale_y;
-    double translate_x = -view_box_x * scale_x;
-    double translate_y = -view_box_y * scale_y;
-
-    if (preserve_value != "none") {
-        std::stringstream parser(preserve_value);
-        std::string align = "xmidymid";
-        std::string meet_or_slice = "meet";
-        parser >> align >> meet_or_slice;
-        if (align == "defer") {
-            parser >> align >> meet_or_slice;
-        }
-        if (align.empty()) {
-            align = "xmidymid";
-        }
-        if (meet_or_slice != "slice") {
-            meet_or_slice = "meet";
-        }
-
-        const double uniform_scale = meet_or_slice == "slice"
-            ? std::max(scale_x, scale_y)
-            : std::min(scale_x, scale_y);
-        final_scale_x = uniform_scale;
-        final_scale_y = uniform_scale;
-
-        const double content_width = view_box_width * uniform_scale;
-        const double content_height = view_box_height * uniform_scale;
-        const double extra_x = viewport_width - content_width;
-        const double extra_y = viewport_height - content_height;
-
-        double align_x = 0.0;
-        double align_y = 0.0;
-        if (align.find("xmid") != std::string::npos) {
-            align_x = extra_x * 0.5;
-        } else if (align.find("xmax") != std::string::npos) {
-            align_x = extra_x;
-        }
-        if (align.find("ymid") != std::string::npos) {
-            align_y = extra_y * 0.5;
-        } else if (align.find("ymax") != std::string::npos) {
-            align_y = extra_y;
-        }
-
-        translate_x = align_x - (view_box_x * uniform_scale);
-        translate_y = align_y - (view_box_y * uniform_scale);
-    }
-
-    return CGAffineTransformMake(static_cast<CGFloat>(final_scale_x),
-                                 0.0,
-                                 0.0,
-                                 static_cast<CGFloat>(final_scale_y),
-                                 static_cast<CGFloat>(translate_x),
-                                 static_cast<CGFloat>(translate_y));
-}
-
-struct PreserveAspectRatioSpec {
-    bool none = false;
-    bool slice = false;
-    double align_x = 0.5;
-    double align_y = 0.5;
-};
-
-PreserveAspectRatioSpec ParsePreserveAspectRatioSpec(const std::string& preserve_raw) {
-    PreserveAspectRatioSpec spec;
-    std::string preserve_value = Lower(Trim(preserve_raw));
-    if (preserve_value.empty()) {
-        preserve_value = "xmidymid meet";
-    }
-
-    std::stringstream parser(preserve_value);
-    std::string align = "xmidymid";
-    std::string meet_or_slice = "meet";
-    parser >> align >> meet_or_slice;
-    if (align == "defer") {
-        parser >> align >> meet_or_slice;
-    }
-    if (align.empty()) {
-        align = "xmidymid";
-    }
-
-    if (align == "none") {
-        spec.none = true;
-        spec.slice = false;
-        spec.align_x = 0.0;
-        spec.align_y = 0.0;
-        return spec;
-    }
-
-    spec.slice = meet_or_slice == "slice";
-    spec.align_x = 0.0;
-    spec.align_y = 0.0;
-    if (align.find("xmid") != std::string::npos) {
-        spec.align_x = 0.5;
-    } else if (align.find("xmax") != std::string::npos) {
-        spec.align_x = 1.0;
-    }
-    if (align.find("ymid") != std::string::npos) {
-        spec.align_y = 0.5;
-    } else if (align.find("ymax") != std::string::npos) {
-        spec.align_y = 1.0;
-    }
-    return spec;
+// Plain numeric attribute; percentages read as fractions.
+double ParseNumberAttr(const AttributeMap& attributes, AttrId key, double fallback) {
+    const SvgLength* length = attributes.GetLength(key);
+    return length != nullptr ? length->ToNumber() : fallback;
 }
 
-bool IsHexDigit(char c) {
-    return (c >= '0' && c <= '9') ||
-           (c >= 'a' && c <= 'f') ||
-           (c >= 'A' && c <= 'F');
+PreserveAspectRatio PreserveAspectRatioOf(const XmlNode& node) {
+    const PreserveAspectRatio* preserve = node.attributes.GetPreserveAspectRatio(AttrId::kPreserveAspectRatio);
+    return preserve != nullptr ? *preserve : PreserveAspectRatio{};
 }
 
-uint8_t HexValue(char c) {
-    if (c >= '0' && c <= '9') {
-        return static_cast<uint8_t>(c - '0');
-    }
-    if (c >= 'a' && c <= 'f') {
-        return static_cast<uint8_t>(10 + (c - 'a'));
-    }
-    return static_cast<uint8_t>(10 + (c - 'A'));
+CGAffineTransform ToCGAffineTransform(const AffineMatrix& matrix) {
+    return CGAffineTransformMake(static_cast<CGFloat>(matrix.a),
+                                 static_cast<CGFloat>(matrix.b),
+                                 static_cast<CGFloat>(matrix.c),
+                                 static_cast<CGFloat>(matrix.d),
+                                 static_cast<CGFloat>(matrix.e),
+                                 static_cast<CGFloat>(matrix.f));
 }
 
-std::string PercentDecode(const std::string& value) {
-    std::string decoded;
-    decoded.reserve(value.size());
-    for (size_t i = 0; i < value.size(); ++i) {
-        const char c = value[i];
-        if (c == '%' && i + 2 < value.size() && IsHexDigit(value[i + 1]) && IsHexDigit(value[i + 2])) {
-            const auto high = HexValue(value[i + 1]);
-            const auto low = HexValue(value[i + 2]);
-            decoded.push_back(static_cast<char>((high << 4) | low));
-            i += 2;
-        } else if (c == '+') {
-            decoded.push_back(' ');
-        } else {
-            decoded.push_back(c);
-        }
-    }
-    return decoded;
-}
-
-std::optional<std::vector<uint8_t>> DecodeBase64(const std::string& input) {
-    static const int8_t kLookup[256] = {
-        -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-        -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-        -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,62,-1,-1,-1,63,
-        52,53,54,55,56,57,58,59,60,61,-1,-1,-1,-2,-1,-1,
-        -1,0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,
-        15,16,17,18,19,20,21,22,23,24,25,-1,-1,-1,-1,-1,
-        -1,26,27,28,29,30,31,32,33,34,35,36,37,38,39,40,
-        41,42,43,44,45,46,47,48,49,50,51,-1,-1,-1,-1,-1,
-        -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-        -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-        -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-        -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-        -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-        -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-        -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-        -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1
-    };
-
-    std::vector<uint8_t> output;
-    output.reserve((input.size() * 3) / 4);
-
-    int32_t buffer = 0;
-    int bits_collected = 0;
-    for (unsigned char c : input) {
-        const int8_t code = kLookup[c];
-        if (code == -1) {
-            if (std::isspace(c) != 0) {
-                continue;
-            }
-            return std::nullopt;
-        }
-        if (code == -2) {
-            break;
-        }
-        buffer = (buffer << 6) | code;
-        bits_collected += 6;
-        if (bits_collected >= 8) {
-            bits_collected -= 8;
-            output.push_back(static_cast<uint8_t>((buffer >> bits_collected) & 0xFF));
-        }
-    }
-    return output;
+CGAffineTransform ComputeViewBoxTransform(double viewport_width,
+                                          double viewport_height,
+                                          const ViewBox& view_box,
+                                          const PreserveAspectRatio& preserve) {
+    return ToCGAffineTransform(ViewBoxTransform(viewport_width, viewport_height, view_box, preserve));
 }
 
-std::optional<std::vector<uint8_t>> DecodeDataURL(const std::string& href) {
-    if (href.rfind("data:", 0) != 0) {
-        return std::nullopt;
-    }
-
-    const auto comma = href.find(',');
-    if (comma == std::string::npos || comma <= 5) {
-        return std::nullopt;
-    }
-
-    const std::string metadata = Lower(href.substr(5, comma - 5));
-    const std::string payload = href.substr(comma + 1);
-    const bool is_base64 = metadata.find(";base64") != std::string::npos;
-    if (is_base64) {
-        return DecodeBase64(payload);
-    }
-
-    const auto decoded = PercentDecode(payload);
-    return std::vector<uint8_t>(decoded.begin(), decoded.end());
+bool ImageDimensionsFromHref(std::string_view raw_href, size_t& width, size_t& height) {
+    const auto href = TrimView(raw_href);
+    return !href.empty() && g_paint.images != nullptr && g_paint.images->Dimensions(href, width, height);
 }
 
-CGImageRef CreateImageFromData(const std::vector<uint8_t>& bytes) {
-    if (bytes.empty()) {
-        return nullptr;
-    }
-
-    CFDataRef data = CFDataCreate(kCFAllocatorDefault, bytes.data(), static_cast<CFIndex>(bytes.size()));
-    if (data == nullptr) {
+// Decodes |raw_href| no larger than needed to cover |max_pixel_size| device
+// pixels along its longer side; 0 decodes at full resolution.
+CGImageRef LoadImageFromHref(std::string_view raw_href, size_t max_pixel_size) {
+    const auto href = TrimView(raw_href);
+    if (href.empty() || g_paint.images == nullptr) {
         return nullptr;
     }
-
-    CGImageSourceRef source = CGImageSourceCreateWithData(data, nullptr);
-    CFRelease(data);
-    if (source == nullptr) {
-        return nullptr;
+    CGImageRef image = g_paint.images->CopyImage(href, max_pixel_size);
+    if (image != nullptr) {
+        ProfileDecodedImagePixels(CGImageGetWidth(image), CGImageGetHeight(image));
     }
-
-    CGImageRef image = CGImageSourceCreateImageAtIndex(source, 0, nullptr);
-    CFRelease(source);
     return image;
 }
 
-CGImageRef LoadImageFromHref(const std::string& raw_href) {
-    const auto href = Trim(raw_href);
-    if (href.empty()) {
-        return nullptr;
-    }
-
-    if (href.rfind("data:", 0) == 0) {
-        const auto bytes = DecodeDataURL(href);
-        if (!bytes.has_value()) {
-            return nullptr;
-        }
-        return CreateImageFromData(*bytes);
-    }
-
-    if (href.rfind("file://", 0) == 0) {
-        CFURLRef url = CFURLCreateWithBytes(kCFAllocatorDefault,
-                                            reinterpret_cast<const UInt8*>(href.data()),
-                                            static_cast<CFIndex>(href.size()),
-                                            kCFStringEncodingUTF8,
-                                            nullptr);
-        if (url == nullptr) {
-            return nullptr;
-        }
-        CGImageSourceRef source = CGImageSourceCreateWithURL(url, nullptr);
-        CFRelease(url);
-        if (source == nullptr) {
-            return nullptr;
-        }
-        CGImageRef image = CGImageSourceCreateImageAtIndex(source, 0, nullptr);
-        CFRelease(source);
-        return image;
-    }
-
-    if (href.rfind("http://", 0) == 0 || href.rfind("https://", 0) == 0) {
-        return nullptr;
-    }
-
-    CFURLRef url = CFURLCreateFromFileSystemRepresentation(kCFAllocatorDefault,
-                                                            reinterpret_cast<const UInt8*>(href.data()),
-                                                            static_cast<CFIndex>(href.size()),
-                                                            false);
-    if (url == nullptr) {
-        return nullptr;
-    }
-    CGImageSourceRef source = CGImageSourceCreateWithURL(url, nullptr);
-    CFRelease(url);
-    if (source == nullptr) {
-        return nullptr;
+size_t DevicePixelSize(double width, double height, const CGAffineTransform& ctm) {
+    const double device_width = width * std::hypot(static_cast<double>(ctm.a), static_cast<double>(ctm.b));
+    const double device_height = height * std::hypot(static_cast<double>(ctm.c), static_cast<double>(ctm.d));
+    const double size = std::ceil(std::max(device_width, device_height));
+    // Unbounded or degenerate transforms fall back to a full decode.
+    if (!std::isfinite(size) || size <= 0.0 || size > static_cast<double>(1 << 20)) {
+        return 0;
     }
-    CGImageRef image = CGImageSourceCreateImageAtIndex(source, 0, nullptr);
-    CFRelease(source);
-    return image;
+    return static_cast<size_t>(size);
 }
 
 std::optional<std::string> ExtractHrefID(const XmlNode& node) {
-    const auto href_it = node.attributes.find("href");
-    const auto xlink_href_it = node.attributes.find("xlink:href");
-    std::string value;
+    const auto href_it = node.attributes.find(AttrId::kHref);
+    const auto xlink_href_it = node.attributes.find(AttrId::kXlinkHref);
+    std::string_view value;
     if (href_it != node.attributes.end()) {
-        value = Trim(href_it->second);
+        value = TrimView(href_it->second);
     } else if (xlink_href_it != node.attributes.end()) {
-        value = Trim(xlink_href_it->second);
+        value = TrimView(xlink_href_it->second);
     }
     if (value.empty() || value.front() != '#' || value.size() < 2) {
         return std::nullopt;
     }
-    return value.substr(1);
+    return std::string(value.substr(1));
 }
 
-std::optional<std::string> ExtractHrefValue(const XmlNode& node) {
-    const auto href_it = node.attributes.find("href");
-    const auto xlink_href_it = node.attributes.find("xlink:href");
+// Views the node's attribute, so large data: URLs are not copied.
+std::optional<std::string_view> ExtractHrefValue(const XmlNode& node) {
+    const auto href_it = node.attributes.find(AttrId::kHref);
+    const auto xlink_href_it = node.attributes.find(AttrId::kXlinkHref);
     if (href_it != node.attributes.end()) {
-        const auto value = Trim(href_it->second);
+        const auto value = TrimView(href_it->second);
         if (!value.empty()) {
             return value;
         }
     }
     if (xlink_href_it != node.attributes.end()) {
-        const auto value = Trim(xlink_href_it->second);
+        const auto value = TrimView(xlink_href_it->second);
         if (!value.empty()) {
             return value;
         }
@@ -1795,7 +603,12 @@ std::optional<std::vector<uint8_t>> LoadBytesFromHref(const std::string& raw_hre
         return std::nullopt;
     }
     if (href.rfind("data:", 0) == 0) {
-        return DecodeDataURL(href);
+        return DataUrlDecoder::Decode(href);
+    }
+    if (g_paint.fetched != nullptr) {
+        if (const auto it = g_paint.fetched->find(href); it != g_paint.fetched->end()) {
+            return *it->second.bytes;
+        }
     }
     const auto path = ResolveLocalFilePathFromHref(href);
     if (!path.has_value()) {
@@ -1813,8 +626,9 @@ std::optional<std::vector<uint8_t>> LoadBytesFromHref(const std::string& raw_hre
     return bytes;
 }
 
-void CollectColorProfiles(const XmlNode& node, ColorProfileMap& profiles) {
-    if (Lower(node.name) == "color-profile") {
+void CollectColorProfiles(const std::vector<const XmlNode*>& profile_nodes, ColorProfileMap& profiles) {
+    for (const auto* profile_node : profile_nodes) {
+        const XmlNode& node = *profile_node;
         const auto href = ExtractHrefValue(node);
         if (href.has_value()) {
             const auto add_key = [&](const std::string& raw_key) {
@@ -1822,20 +636,17 @@ void CollectColorProfiles(const XmlNode& node, ColorProfileMap& profiles) {
                 if (key.empty()) {
                     return;
                 }
-                profiles[key] = *href;
-                profiles[Lower(key)] = *href;
+                profiles[key] = std::string(*href);
+                profiles[Lower(key)] = std::string(*href);
             };
-            if (const auto id_it = node.attributes.find("id"); id_it != node.attributes.end()) {
+            if (const auto id_it = node.attributes.find(AttrId::kId); id_it != node.attributes.end()) {
                 add_key(id_it->second);
             }
-            if (const auto name_it = node.attributes.find("name"); name_it != node.attributes.end()) {
+            if (const auto name_it = node.attributes.find(AttrId::kName); name_it != node.attributes.end()) {
                 add_key(name_it->second);
             }
         }
     }
-    for (const auto& child : node.children) {
-        CollectColorProfiles(child, profiles);
-    }
 }
 
 std::optional<std::string> ExtractColorProfileReference(const std::string& raw_value) {
@@ -1987,102 +798,6 @@ CGImageRef ConvertImageFromAssignedICCProfile(CGImageRef image, CGColorSpaceRef
     return converted;
 }
 
-CGAffineTransform ParseTransformList(const std::string& raw) {
-    CGAffineTransform transform = CGAffineTransformIdentity;
-    size_t i = 0;
-
-    while (i < raw.size()) {
-        while (i < raw.size() && (std::isspace(static_cast<unsigned char>(raw[i])) || raw[i] == ',')) {
-            ++i;
-        }
-        if (i >= raw.size()) {
-            break;
-        }
-
-        const size_t name_start = i;
-        while (i < raw.size() && std::isalpha(static_cast<unsigned char>(raw[i]))) {
-            ++i;
-        }
-        if (i <= name_start) {
-            ++i;
-            continue;
-        }
-
-        const std::string name = Lower(raw.substr(name_start, i - name_start));
-        while (i < raw.size() && std::isspace(static_cast<unsigned char>(raw[i]))) {
-            ++i;
-        }
-        if (i >= raw.size() || raw[i] != '(') {
-            continue;
-        }
-        ++i;
-
-        std::vector<double> params;
-        while (i < raw.size() && raw[i] != ')') {
-            while (i < raw.size() && (std::isspace(static_cast<unsigned char>(raw[i])) || raw[i] == ',')) {
-                ++i;
-            }
-            if (i >= raw.size() || raw[i] == ')') {
-                break;
-            }
-
-            const char* start = raw.c_str() + i;
-            char* end_ptr = nullptr;
-            const double value = std::strtod(start, &end_ptr);
-            if (end_ptr == start) {
-                ++i;
-                continue;
-            }
-            params.push_back(value);
-            i = static_cast<size_t>(end_ptr - raw.c_str());
-        }
-
-        if (i < raw.size() && raw[i] == ')') {
-            ++i;
-        }
-
-        CGAffineTransform current = CGAffineTransformIdentity;
-        if (name == "matrix" && params.size() >= 6) {
-            current = CGAffineTransformMake(static_cast<CGFloat>(params[0]),
-                                            static_cast<CGFloat>(params[1]),
-                                            static_cast<CGFloat>(params[2]),
-                                            static_cast<CGFloat>(params[3]),
-                                            static_cast<CGFloat>(params[4]),
-                                            static_cast<CGFloat>(params[5]));
-        } else if (name == "translate" && !params.empty()) {
-            const double tx = params[0];
-            const double ty = params.size() > 1 ? params[1] : 0.0;
-            current = CGAffineTransformMakeTranslation(static_cast<CGFloat>(tx), static_cast<CGFloat>(ty));
-        } else if (name == "scale" && !params.empty()) {
-            const double sx = params[0];
-            const double sy = params.size() > 1 ? params[1] : sx;
-            current = CGAffineTransformMakeScale(static_cast<CGFloat>(sx), static_cast<CGFloat>(sy));
-        } else if (name == "rotate" && !params.empty()) {
-            const double angle_rad = params[0] * M_PI / 180.0;
-            if (params.size() > 2) {
-                const double cx = params[1];
-                const double cy = params[2];
-                current = CGAffineTransformIdentity;
-                current = CGAffineTransformTranslate(current, static_cast<CGFloat>(cx), static_cast<CGFloat>(cy));
-                current = CGAffineTransformRotate(current, static_cast<CGFloat>(angle_rad));
-                current = CGAffineTransformTranslate(current, static_cast<CGFloat>(-cx), static_cast<CGFloat>(-cy));
-            } else {
-                current = CGAffineTransformMakeRotation(static_cast<CGFloat>(angle_rad));
-            }
-        } else if (name == "skewx" && !params.empty()) {
-            const CGFloat tangent = static_cast<CGFloat>(std::tan(params[0] * M_PI / 180.0));
-            current = CGAffineTransformMake(1.0f, 0.0f, tangent, 1.0f, 0.0f, 0.0f);
-        } else if (name == "skewy" && !params.empty()) {
-            const CGFloat tangent = static_cast<CGFloat>(std::tan(params[0] * M_PI / 180.0));
-            current = CGAffineTransformMake(1.0f, tangent, 0.0f, 1.0f, 0.0f, 0.0f);
-        }
-
-        // SVG applies listed transforms from left-to-right.
-        transform = CGAffineTransformConcat(current, transform);
-    }
-
-    return transform;
-}
 
 std::optional<std::string> ExtractPaintURLId(const std::string& paint) {
     const std::string trimmed = Trim(paint);
@@ -2110,61 +825,55 @@ std::optional<std::string> ExtractPaintURLId(const std::string& paint) {
     return inside;
 }
 
-void CollectGradients(const XmlNode& node, GradientMap& gradients) {
-    if (node.name == "linearGradient" || node.name == "radialGradient") {
+void CollectGradients(const std::vector<const XmlNode*>& gradient_nodes, GradientMap& gradients) {
+    for (const auto* gradient_node : gradient_nodes) {
+        const XmlNode& node = *gradient_node;
         GradientDefinition gradient;
         gradient.type = node.name == "linearGradient" ? GradientType::kLinear : GradientType::kRadial;
 
-        const auto gradient_style_it = node.attributes.find("style");
+        const auto gradient_style_it = node.attributes.find(AttrId::kStyle);
         const auto gradient_inline_style = gradient_style_it != node.attributes.end()
             ? ParseInlineStyle(gradient_style_it->second)
-            : std::map<std::string, std::string>{};
+            : PropertyMap{};
 
         Color gradient_color = StyleResolver::ParseColor("black");
-        if (const auto color_value = ReadAttrOrStyle(node, gradient_inline_style, nullptr, "color"); color_value.has_value()) {
+        if (const auto color_value = ReadAttrOrStyle(node, gradient_inline_style, nullptr, AttrId::kColor); color_value.has_value()) {
             const auto parsed = StyleResolver::ParseColor(*color_value);
             if (parsed.is_valid && !parsed.is_none) {
-                gradient_color = parsed;
+                gradient_color = ThemedColor(parsed);
             }
         }
+        if (g_paint.theme != nullptr && g_paint.theme->current_color().has_value()) {
+            gradient_color = *g_paint.theme->current_color();
+        }
 
-        const auto id_it = node.attributes.find("id");
+        const auto id_it = node.attributes.find(AttrId::kId);
         if (id_it != node.attributes.end()) {
             gradient.id = id_it->second;
         }
 
-        const auto units_it = node.attributes.find("gradientUnits");
+        const auto units_it = node.attributes.find(AttrId::kGradientUnits);
         if (units_it != node.attributes.end()) {
             gradient.user_space_units = Lower(Trim(units_it->second)) == "userspaceonuse";
         }
 
-        const auto transform_it = node.attributes.find("gradientTransform");
-        if (transform_it != node.attributes.end()) {
-            gradient.transform = ParseTransformList(transform_it->second);
+        if (const AffineMatrix* transform = node.attributes.GetTransform(AttrId::kGradientTransform)) {
+            gradient.transform = ToCGAffineTransform(*transform);
         }
 
         if (gradient.type == GradientType::kLinear) {
-            const auto x1_it = node.attributes.find("x1");
-            const auto y1_it = node.attributes.find("y1");
-            const auto x2_it = node.attributes.find("x2");
-            const auto y2_it = node.attributes.find("y2");
-
-            gradient.x1 = x1_it != node.attributes.end() ? ParseCoordinate(x1_it->second, 0.0) : 0.0;
-            gradient.y1 = y1_it != node.attributes.end() ? ParseCoordinate(y1_it->second, 0.0) : 0.0;
-            gradient.x2 = x2_it != node.attributes.end() ? ParseCoordinate(x2_it->second, 1.0) : 1.0;
-            gradient.y2 = y2_it != node.attributes.end() ? ParseCoordinate(y2_it->second, 0.0) : 0.0;
+
+            gradient.x1 = ParseNumberAttr(node.attributes, AttrId::kX1, 0.0);
+            gradient.y1 = ParseNumberAttr(node.attributes, AttrId::kY1, 0.0);
+            gradient.x2 = ParseNumberAttr(node.attributes, AttrId::kX2, 1.0);
+            gradient.y2 = ParseNumberAttr(node.attributes, AttrId::kY2, 0.0);
         } else {
-            const auto cx_it = node.attributes.find("cx");
-            const auto cy_it = node.attributes.find("cy");
-            const auto r_it = node.attributes.find("r");
-            const auto fx_it = node.attributes.find("fx");
-            const auto fy_it = node.attributes.find("fy");
 
-            gradient.cx = cx_it != node.attributes.end() ? ParseCoordinate(cx_it->second, 0.5) : 0.5;
-            gradient.cy = cy_it != node.attributes.end() ? ParseCoordinate(cy_it->second, 0.5) : 0.5;
-            gradient.r = r_it != node.attributes.end() ? ParseCoordinate(r_it->second, 0.5) : 0.5;
-            gradient.fx = fx_it != node.attributes.end() ? ParseCoordinate(fx_it->second, gradient.cx) : gradient.cx;
-            gradient.fy = fy_it != node.attributes.end() ? ParseCoordinate(fy_it->second, gradient.cy) : gradient.cy;
+            gradient.cx = ParseNumberAttr(node.attributes, AttrId::kCx, 0.5);
+            gradient.cy = ParseNumberAttr(node.attributes, AttrId::kCy, 0.5);
+            gradient.r = ParseNumberAttr(node.attributes, AttrId::kR, 0.5);
+            gradient.fx = ParseNumberAttr(node.attributes, AttrId::kFx, gradient.cx);
+            gradient.fy = ParseNumberAttr(node.attributes, AttrId::kFy, gradient.cy);
         }
 
         for (const auto& stop_node : node.children) {
@@ -2172,8 +881,8 @@ void CollectGradients(const XmlNode& node, GradientMap& gradients) {
                 continue;
             }
 
-            const auto style_it = stop_node.attributes.find("style");
-            const auto inline_style = style_it != stop_node.attributes.end() ? ParseInlineStyle(style_it->second) : std::map<std::string, std::string>{};
+            const auto style_it = stop_node.attributes.find(AttrId::kStyle);
+            const auto inline_style = style_it != stop_node.attributes.end() ? ParseInlineStyle(style_it->second) : PropertyMap{};
 
             GradientStop stop;
             stop.offset = 0.0;
@@ -2181,30 +890,33 @@ void CollectGradients(const XmlNode& node, GradientMap& gradients) {
             stop.opacity = 1.0;
 
             Color stop_current_color = gradient_color;
-            if (const auto stop_color_prop = ReadAttrOrStyle(stop_node, inline_style, nullptr, "color"); stop_color_prop.has_value()) {
+            if (const auto stop_color_prop = ReadAttrOrStyle(stop_node, inline_style, nullptr, AttrId::kColor); stop_color_prop.has_value()) {
                 const auto parsed = StyleResolver::ParseColor(*stop_color_prop);
                 if (parsed.is_valid && !parsed.is_none) {
-                    stop_current_color = parsed;
+                    stop_current_color = ThemedColor(parsed);
                 }
             }
+            if (g_paint.theme != nullptr && g_paint.theme->current_color().has_value()) {
+                stop_current_color = *g_paint.theme->current_color();
+            }
 
-            if (const auto offset = ReadAttrOrStyle(stop_node, inline_style, nullptr, "offset"); offset.has_value()) {
+            if (const auto offset = ReadAttrOrStyle(stop_node, inline_style, nullptr, AttrId::kOffset); offset.has_value()) {
                 stop.offset = ParseOffset(*offset);
             }
 
-            if (const auto stop_color = ReadAttrOrStyle(stop_node, inline_style, nullptr, "stop-color"); stop_color.has_value()) {
+            if (const auto stop_color = ReadAttrOrStyle(stop_node, inline_style, nullptr, AttrId::kStopColor); stop_color.has_value()) {
                 const auto stop_color_lower = Lower(Trim(*stop_color));
                 if (stop_color_lower == "currentcolor") {
                     stop.color = stop_current_color;
                 } else {
                     const auto parsed_color = StyleResolver::ParseColor(*stop_color);
                     if (parsed_color.is_valid) {
-                        stop.color = parsed_color;
+                        stop.color = ThemedColor(parsed_color);
                     }
                 }
             }
 
-            if (const auto stop_opacity = ReadAttrOrStyle(stop_node, inline_style, nullptr, "stop-opacity"); stop_opacity.has_value()) {
+            if (const auto stop_opacity = ReadAttrOrStyle(stop_node, inline_style, nullptr, AttrId::kStopOpacity); stop_opacity.has_value()) {
                 stop.opacity = std::clamp(ParseDouble(*stop_opacity, 1.0), 0.0, 1.0);
             }
 
@@ -2231,123 +943,370 @@ void CollectGradients(const XmlNode& node, GradientMap& gradients) {
             gradients[gradient.id] = gradient;
         }
     }
-
-    for (const auto& child : node.children) {
-        CollectGradients(child, gradients);
-    }
 }
 
-void CollectPatterns(const XmlNode& node, PatternMap& patterns) {
-    if (Lower(node.name) == "pattern") {
+void CollectPatterns(const std::vector<const XmlNode*>& pattern_nodes, PatternMap& patterns) {
+    for (const auto* pattern_node : pattern_nodes) {
+        const XmlNode& node = *pattern_node;
         PatternDefinition pattern;
         pattern.node = &node;
 
-        if (const auto id_it = node.attributes.find("id"); id_it != node.attributes.end()) {
+        if (const auto id_it = node.attributes.find(AttrId::kId); id_it != node.attributes.end()) {
             pattern.id = Trim(id_it->second);
         }
 
-        if (const auto units_it = node.attributes.find("patternUnits"); units_it != node.attributes.end()) {
+        if (const auto units_it = node.attributes.find(AttrId::kPatternUnits); units_it != node.attributes.end()) {
             pattern.pattern_units_user_space = Lower(Trim(units_it->second)) == "userspaceonuse";
         }
-        if (const auto content_units_it = node.attributes.find("patternContentUnits"); content_units_it != node.attributes.end()) {
+        if (const auto content_units_it = node.attributes.find(AttrId::kPatternContentUnits); content_units_it != node.attributes.end()) {
             pattern.content_units_user_space = Lower(Trim(content_units_it->second)) == "userspaceonuse";
         }
-        if (const auto transform_it = node.attributes.find("patternTransform"); transform_it != node.attributes.end()) {
-            pattern.transform = ParseTransformList(transform_it->second);
+        if (const AffineMatrix* transform = node.attributes.GetTransform(AttrId::kPatternTransform)) {
+            pattern.transform = ToCGAffineTransform(*transform);
         }
 
-        if (const auto x_it = node.attributes.find("x"); x_it != node.attributes.end()) {
-            pattern.x = ParseCoordinate(x_it->second, 0.0);
-        }
-        if (const auto y_it = node.attributes.find("y"); y_it != node.attributes.end()) {
-            pattern.y = ParseCoordinate(y_it->second, 0.0);
-        }
-        if (const auto width_it = node.attributes.find("width"); width_it != node.attributes.end()) {
-            pattern.width = ParseCoordinate(width_it->second, 0.0);
-        }
-        if (const auto height_it = node.attributes.find("height"); height_it != node.attributes.end()) {
-            pattern.height = ParseCoordinate(height_it->second, 0.0);
-        }
+        pattern.x = ParseNumberAttr(node.attributes, AttrId::kX, pattern.x);
+        pattern.y = ParseNumberAttr(node.attributes, AttrId::kY, pattern.y);
+        pattern.width = ParseNumberAttr(node.attributes, AttrId::kWidth, pattern.width);
+        pattern.height = ParseNumberAttr(node.attributes, AttrId::kHeight, pattern.height);
 
         if (!pattern.id.empty()) {
             patterns[pattern.id] = pattern;
         }
     }
+}
+
+void ApplyColor(CGContextRef context, const Color& color, float opacity, bool stroke) {
+    if (!color.is_valid || color.is_none) {
+        return;
+    }
+    const CGFloat alpha = std::clamp(color.a * opacity, 0.0f, 1.0f);
+    if (stroke) {
+        CGContextSetRGBStrokeColor(context, color.r, color.g, color.b, alpha);
+    } else {
+        CGContextSetRGBFillColor(context, color.r, color.g, color.b, alpha);
+    }
+}
+
+CGLineJoin LineJoinFromStyle(const std::string& join_style) {
+    const auto lower = Lower(join_style);
+    if (lower == "round") {
+        return kCGLineJoinRound;
+    }
+    if (lower == "bevel") {
+        return kCGLineJoinBevel;
+    }
+    return kCGLineJoinMiter;
+}
+
+CGLineCap LineCapFromStyle(const std::string& cap_style) {
+    const auto lower = Lower(cap_style);
+    if (lower == "round") {
+        return kCGLineCapRound;
+    }
+    if (lower == "square") {
+        return kCGLineCapSquare;
+    }
+    return kCGLineCapButt;
+}
+
+void PaintNode(const XmlNode& node,
+               const StyleResolver& style_resolver,
+               const GeometryEngine& geometry_engine,
+               const ResolvedStyle* parent_style,
+               CGContextRef context,
+               const GradientMap& gradients,
+               const PatternMap& patterns,
+               const NodeIdMap& id_map,
+               const ColorProfileMap& color_profiles,
+               std::set<std::string>& active_use_ids,
+               std::set<std::string>& active_pattern_ids,
+               const RenderOptions& options,
+               RenderError& error,
+               bool apply_filters = true,
+               bool suppress_current_opacity = false);
+
+std::string LocalName(const std::string& name);
+
+PixelBuffer AcquireBuffer(PixelBuffer*, size_t count, bool zeroed) {
+    if (g_paint.surface_pool != nullptr) {
+        return g_paint.surface_pool->Acquire(count, zeroed);
+    }
+    PixelBuffer buffer;
+    if (zeroed) {
+        buffer.assign(count, 0);
+    } else {
+        buffer.resize(count);
+    }
+    return buffer;
+}
+
+ChannelBuffer AcquireBuffer(ChannelBuffer*, size_t count, bool zeroed) {
+    if (g_paint.surface_pool != nullptr) {
+        return g_paint.surface_pool->AcquireChannels(count, zeroed);
+    }
+    ChannelBuffer buffer;
+    if (zeroed) {
+        buffer.assign(count, 0);
+    } else {
+        buffer.resize(count);
+    }
+    return buffer;
+}
+
+template <typename Buffer>
+void RecycleBuffer(Buffer&& buffer) {
+    if (g_paint.surface_pool != nullptr) {
+        g_paint.surface_pool->Recycle(std::move(buffer));
+    }
+}
+
+// Inclusive pixel rectangle; max < min means empty.
+struct PixelBounds {
+    size_t min_x = 0;
+    size_t min_y = 0;
+    size_t max_x = 0;
+    size_t max_y = 0;
+};
+
+PixelBounds EmptyBounds() {
+    return PixelBounds{1, 1, 0, 0};
+}
+
+bool IsEmptyBounds(const PixelBounds& bounds) {
+    return bounds.max_x < bounds.min_x || bounds.max_y < bounds.min_y;
+}
+
+PixelBounds SurfaceArea(size_t width, size_t height) {
+    if (width == 0 || height == 0) {
+        return EmptyBounds();
+    }
+    return PixelBounds{0, 0, width - 1, height - 1};
+}
+
+PixelBounds UnionBounds(const PixelBounds& a, const PixelBounds& b) {
+    if (IsEmptyBounds(a)) {
+        return b;
+    }
+    if (IsEmptyBounds(b)) {
+        return a;
+    }
+    return PixelBounds{
+        std::min(a.min_x, b.min_x),
+        std::min(a.min_y, b.min_y),
+        std::max(a.max_x, b.max_x),
+        std::max(a.max_y, b.max_y)
+    };
+}
+
+PixelBounds IntersectBounds(const PixelBounds& a, const PixelBounds& b) {
+    if (IsEmptyBounds(a) || IsEmptyBounds(b)) {
+        return EmptyBounds();
+    }
+    const PixelBounds bounds{
+        std::max(a.min_x, b.min_x),
+        std::max(a.min_y, b.min_y),
+        std::min(a.max_x, b.max_x),
+        std::min(a.max_y, b.max_y)
+    };
+    return IsEmptyBounds(bounds) ? EmptyBounds() : bounds;
+}
+
+// Grows |bounds| by |dx| columns and |dy| rows on each side, staying inside a
+// |width| x |height| surface.
+PixelBounds InflateBounds(const PixelBounds& bounds, size_t dx, size_t dy, size_t width, size_t height) {
+    if (IsEmptyBounds(bounds)) {
+        return bounds;
+    }
+    return IntersectBounds(
+        PixelBounds{
+            bounds.min_x > dx ? bounds.min_x - dx : 0,
+            bounds.min_y > dy ? bounds.min_y - dy : 0,
+            bounds.max_x + dx,
+            bounds.max_y + dy
+        },
+        SurfaceArea(width, height));
+}
+
+// |bounds| moved by (dx, dy), cut to a |width| x |height| surface.
+PixelBounds OffsetBounds(const PixelBounds& bounds, long long dx, long long dy, size_t width, size_t height) {
+    if (IsEmptyBounds(bounds) || width == 0 || height == 0) {
+        return EmptyBounds();
+    }
+    const long long min_x = std::max<long long>(static_cast<long long>(bounds.min_x) + dx, 0);
+    const long long min_y = std::max<long long>(static_cast<long long>(bounds.min_y) + dy, 0);
+    const long long max_x = std::min<long long>(static_cast<long long>(bounds.max_x) + dx, static_cast<long long>(width) - 1);
+    const long long max_y = std::min<long long>(static_cast<long long>(bounds.max_y) + dy, static_cast<long long>(height) - 1);
+    if (max_x < min_x || max_y < min_y) {
+        return EmptyBounds();
+    }
+    return PixelBounds{
+        static_cast<size_t>(min_x),
+        static_cast<size_t>(min_y),
+        static_cast<size_t>(max_x),
+        static_cast<size_t>(max_y)
+    };
+}
 
-    for (const auto& child : node.children) {
-        CollectPatterns(child, patterns);
+// Premultiplied RGBA whose channels come from, and go back to, the active
+// SurfacePool. Move-only so a filter chain never copies a whole canvas by
+// accident; Clone() says so when a copy is really wanted.
+template <typename Buffer>
+struct PooledSurface {
+    size_t width = 0;
+    size_t height = 0;
+    // 4 for RGBA; 1 for an alpha-only surface, whose color is implicitly black.
+    size_t channels = 4;
+    Buffer rgba;
+    // Every pixel outside this rectangle is transparent black. Whoever writes
+    // the pixels keeps it up to date, so filter kernels can skip the empty
+    // margins and a chain can tell an empty result without scanning it.
+    PixelBounds content = EmptyBounds();
+
+    PooledSurface() = default;
+    // Only pass zeroed = false when every pixel is about to be written.
+    PooledSurface(size_t surface_width, size_t surface_height, bool zeroed, size_t channel_count = 4)
+        : width(surface_width),
+          height(surface_height),
+          channels(channel_count),
+          rgba(AcquireBuffer(static_cast<Buffer*>(nullptr), surface_width * surface_height * channel_count, zeroed)),
+          content(zeroed ? EmptyBounds() : SurfaceArea(surface_width, surface_height)) {}
+    PooledSurface(PooledSurface&& other) noexcept
+        : width(std::exchange(other.width, 0)),
+          height(std::exchange(other.height, 0)),
+          channels(other.channels),
+          rgba(std::move(other.rgba)),
+          content(std::exchange(other.content, EmptyBounds())) {}
+    PooledSurface& operator=(PooledSurface&& other) noexcept {
+        if (this != &other) {
+            RecycleBuffer(std::move(rgba));
+            width = std::exchange(other.width, 0);
+            height = std::exchange(other.height, 0);
+            channels = other.channels;
+            rgba = std::move(other.rgba);
+            content = std::exchange(other.content, EmptyBounds());
+        }
+        return *this;
+    }
+    PooledSurface(const PooledSurface&) = delete;
+    PooledSurface& operator=(const PooledSurface&) = delete;
+    ~PooledSurface() { RecycleBuffer(std::move(rgba)); }
+
+    PooledSurface Clone() const {
+        PooledSurface copy(width, height, false, channels);
+        std::copy(rgba.begin(), rgba.begin() + std::min(copy.rgba.size(), rgba.size()), copy.rgba.begin());
+        copy.content = content;
+        return copy;
     }
+};
+
+// 8-bit sRGB, for everything Core Graphics draws into or reads from.
+using PixelSurface = PooledSurface<PixelBuffer>;
+// Filter intermediates: 16 bits per channel in the chain's working color
+// space (linearRGB unless color-interpolation-filters says sRGB), so a long
+// chain neither re-linearizes nor re-quantizes to 8 bits at every step.
+using FilterSurface = PooledSurface<ChannelBuffer>;
+constexpr double kChannelMax = 65535.0;
+
+// A |width| x |height| surface that is transparent outside |region|; the
+// caller writes every pixel inside it. Skips zeroing when |region| is
+// everything.
+template <typename Surface>
+Surface MakeRegionSurface(size_t width, size_t height, const PixelBounds& region, size_t channels = 4) {
+    const PixelBounds area = SurfaceArea(width, height);
+    const PixelBounds clipped = IntersectBounds(region, area);
+    const bool covers_all = !IsEmptyBounds(clipped) && clipped.min_x == 0 && clipped.min_y == 0 &&
+        clipped.max_x == area.max_x && clipped.max_y == area.max_y;
+    Surface surface(width, height, !covers_all, channels);
+    surface.content = clipped;
+    return surface;
 }
 
-void ApplyColor(CGContextRef context, const Color& color, float opacity, bool stroke) {
-    if (!color.is_valid || color.is_none) {
+// Calls |visit|(x, y, base) for every pixel of |region| of a surface |width|
+// pixels wide, where |base| indexes the pixel's first channel.
+template <typename Visit>
+void ForEachPixel(const PixelBounds& region, size_t width, Visit&& visit) {
+    if (IsEmptyBounds(region)) {
         return;
     }
-    const CGFloat alpha = std::clamp(color.a * opacity, 0.0f, 1.0f);
-    if (stroke) {
-        CGContextSetRGBStrokeColor(context, color.r, color.g, color.b, alpha);
-    } else {
-        CGContextSetRGBFillColor(context, color.r, color.g, color.b, alpha);
+    for (size_t y = region.min_y; y <= region.max_y; ++y) {
+        for (size_t x = region.min_x; x <= region.max_x; ++x) {
+            visit(x, y, ((y * width) + x) * 4);
+        }
     }
 }
 
-CGLineJoin LineJoinFromStyle(const std::string& join_style) {
-    const auto lower = Lower(join_style);
-    if (lower == "round") {
-        return kCGLineJoinRound;
+// The smallest rectangle holding every non-transparent pixel, or empty. Only
+// looks inside |surface.content|, and from each edge only as far as the first
+// covered pixel, so a mostly filled surface costs little more than its margins.
+template <typename Surface>
+PixelBounds FindContentBounds(const Surface& surface) {
+    const PixelBounds area = IntersectBounds(surface.content, SurfaceArea(surface.width, surface.height));
+    if (IsEmptyBounds(area)) {
+        return EmptyBounds();
     }
-    if (lower == "bevel") {
-        return kCGLineJoinBevel;
-    }
-    return kCGLineJoinMiter;
-}
+    const auto covered = [&](size_t x, size_t y) {
+        return surface.rgba[((y * surface.width) + x + 1) * surface.channels - 1] != 0;
+    };
+    const auto row_empty = [&](size_t y) {
+        for (size_t x = area.min_x; x <= area.max_x; ++x) {
+            if (covered(x, y)) {
+                return false;
+            }
+        }
+        return true;
+    };
 
-CGLineCap LineCapFromStyle(const std::string& cap_style) {
-    const auto lower = Lower(cap_style);
-    if (lower == "round") {
-        return kCGLineCapRound;
+    size_t min_y = area.min_y;
+    while (min_y <= area.max_y && row_empty(min_y)) {
+        ++min_y;
     }
-    if (lower == "square") {
-        return kCGLineCapSquare;
+    if (min_y > area.max_y) {
+        return EmptyBounds();
+    }
+    size_t max_y = area.max_y;
+    while (max_y > min_y && row_empty(max_y)) {
+        --max_y;
     }
-    return kCGLineCapButt;
-}
-
-void PaintNode(const XmlNode& node,
-               const StyleResolver& style_resolver,
-               const GeometryEngine& geometry_engine,
-               const ResolvedStyle* parent_style,
-               CGContextRef context,
-               const GradientMap& gradients,
-               const PatternMap& patterns,
-               const NodeIdMap& id_map,
-               const ColorProfileMap& color_profiles,
-               std::set<std::string>& active_use_ids,
-               std::set<std::string>& active_pattern_ids,
-               const RenderOptions& options,
-               RenderError& error,
-               bool apply_filters = true,
-               bool suppress_current_opacity = false);
-
-std::string LocalName(const std::string& name);
 
-struct PixelSurface {
-    size_t width = 0;
-    size_t height = 0;
-    std::vector<uint8_t> rgba;
-};
+    size_t min_x = area.max_x;
+    size_t max_x = area.min_x;
+    for (size_t y = min_y; y <= max_y; ++y) {
+        for (size_t x = area.min_x; x < min_x; ++x) {
+            if (covered(x, y)) {
+                min_x = x;
+                break;
+            }
+        }
+        for (size_t x = area.max_x; x > max_x; --x) {
+            if (covered(x, y)) {
+                max_x = x;
+                break;
+            }
+        }
+    }
+    return PixelBounds{min_x, min_y, max_x, max_y};
+}
 
-struct PixelBounds {
-    size_t min_x = 0;
-    size_t min_y = 0;
-    size_t max_x = 0;
-    size_t max_y = 0;
-};
+// Like FindContentBounds, but the whole surface when nothing is covered.
+template <typename Surface>
+PixelBounds ComputeNonTransparentBounds(const Surface& surface) {
+    const PixelBounds bounds = FindContentBounds(surface);
+    if (!IsEmptyBounds(bounds)) {
+        return bounds;
+    }
+    return PixelBounds{
+        0,
+        0,
+        surface.width > 0 ? surface.width - 1 : 0,
+        surface.height > 0 ? surface.height - 1 : 0
+    };
+}
 
 std::optional<std::string> ResolveFilterID(const XmlNode& node,
-                                           const std::map<std::string, std::string>& inline_style,
-                                           const std::map<std::string, std::string>* matched_css_properties) {
-    const auto filter_value = ReadAttrOrStyle(node, inline_style, matched_css_properties, "filter");
+                                           const PropertyMap& inline_style,
+                                           const PropertyMap* matched_css_properties) {
+    const auto filter_value = ReadAttrOrStyle(node, inline_style, matched_css_properties, AttrId::kFilter);
     if (!filter_value.has_value()) {
         return std::nullopt;
     }
@@ -2355,9 +1314,9 @@ std::optional<std::string> ResolveFilterID(const XmlNode& node,
 }
 
 std::optional<std::string> ResolveClipPathID(const XmlNode& node,
-                                              const std::map<std::string, std::string>& inline_style,
-                                              const std::map<std::string, std::string>* matched_css_properties) {
-    const auto clip_path_value = ReadAttrOrStyle(node, inline_style, matched_css_properties, "clip-path");
+                                              const PropertyMap& inline_style,
+                                              const PropertyMap* matched_css_properties) {
+    const auto clip_path_value = ReadAttrOrStyle(node, inline_style, matched_css_properties, AttrId::kClipPath);
     if (!clip_path_value.has_value()) {
         return std::nullopt;
     }
@@ -2365,9 +1324,9 @@ std::optional<std::string> ResolveClipPathID(const XmlNode& node,
 }
 
 std::optional<std::string> ResolveMaskID(const XmlNode& node,
-                                          const std::map<std::string, std::string>& inline_style,
-                                          const std::map<std::string, std::string>* matched_css_properties) {
-    const auto mask_value = ReadAttrOrStyle(node, inline_style, matched_css_properties, "mask");
+                                          const PropertyMap& inline_style,
+                                          const PropertyMap* matched_css_properties) {
+    const auto mask_value = ReadAttrOrStyle(node, inline_style, matched_css_properties, AttrId::kMask);
     if (!mask_value.has_value()) {
         return std::nullopt;
     }
@@ -2386,20 +1345,22 @@ std::optional<PixelSurface> RenderNodeToSurface(const XmlNode& node,
                                                 RenderError& error) {
     const size_t width = static_cast<size_t>(std::max(1.0, std::ceil(std::max(geometry_engine.viewport_width(), 1.0))));
     const size_t height = static_cast<size_t>(std::max(1.0, std::ceil(std::max(geometry_engine.viewport_height(), 1.0))));
-    const size_t bytes_per_row = width * 4;
+    // The node is drawn straight into the surface's pooled pixels.
+    PixelSurface surface(width, height, true);
 
     CGColorSpaceRef color_space = CGColorSpaceCreateDeviceRGB();
-    CGContextRef bitmap = CGBitmapContextCreate(nullptr,
+    CGContextRef bitmap = CGBitmapContextCreate(surface.rgba.data(),
                                                 width,
                                                 height,
                                                 8,
-                                                bytes_per_row,
+                                                width * 4,
                                                 color_space,
                                                 static_cast<CGBitmapInfo>(kCGImageAlphaPremultipliedLast));
     CGColorSpaceRelease(color_space);
     if (bitmap == nullptr) {
         return std::nullopt;
     }
+    ProfileOffscreenPixels(width, height);
 
     CGContextTranslateCTM(bitmap, 0.0, static_cast<CGFloat>(height));
     CGContextScaleCTM(bitmap, 1.0, -1.0);
@@ -2423,99 +1384,223 @@ std::optional<PixelSurface> RenderNodeToSurface(const XmlNode& node,
               false,
               true);
 
+    CGContextRelease(bitmap);
     if (local_error.code != RenderErrorCode::kNone) {
-        CGContextRelease(bitmap);
         error = local_error;
         return std::nullopt;
     }
+    // Core Graphics does not say which pixels it touched, so the drawing is
+    // scanned once here; filters carry these bounds forward from then on.
+    surface.content = SurfaceArea(width, height);
+    surface.content = FindContentBounds(surface);
+    return surface;
+}
 
-    const auto* source_data = static_cast<const uint8_t*>(CGBitmapContextGetData(bitmap));
-    const size_t source_stride = CGBitmapContextGetBytesPerRow(bitmap);
-    if (source_data == nullptr || source_stride == 0) {
-        CGContextRelease(bitmap);
-        return std::nullopt;
+double SRGBToLinear(double value) {
+    value = std::clamp(value, 0.0, 1.0);
+    if (value <= 0.04045) {
+        return value / 12.92;
     }
+    return std::pow((value + 0.055) / 1.055, 2.4);
+}
 
-    PixelSurface surface;
-    surface.width = width;
-    surface.height = height;
-    surface.rgba.resize(bytes_per_row * height, 0);
-    for (size_t row = 0; row < height; ++row) {
-        std::memcpy(surface.rgba.data() + row * bytes_per_row,
-                    source_data + row * source_stride,
-                    bytes_per_row);
+double LinearToSRGB(double value) {
+    value = std::clamp(value, 0.0, 1.0);
+    if (value <= 0.0031308) {
+        return value * 12.92;
     }
-    CGContextRelease(bitmap);
-    return surface;
+    return (1.055 * std::pow(value, 1.0 / 2.4)) - 0.055;
 }
 
-PixelBounds ComputeNonTransparentBounds(const PixelSurface& surface) {
-    PixelBounds bounds{
-        surface.width,
-        surface.height,
-        0,
-        0
-    };
-    bool found = false;
+// Straight 8-bit sRGB to 16-bit linear.
+const std::array<uint16_t, 256>& SRGBToLinearTable() {
+    static const auto table = [] {
+        std::array<uint16_t, 256> values{};
+        for (size_t i = 0; i < values.size(); ++i) {
+            values[i] = static_cast<uint16_t>(std::lround(SRGBToLinear(static_cast<double>(i) / 255.0) * kChannelMax));
+        }
+        return values;
+    }();
+    return table;
+}
 
-    for (size_t y = 0; y < surface.height; ++y) {
-        for (size_t x = 0; x < surface.width; ++x) {
-            const size_t base = ((y * surface.width) + x) * 4;
-            if (surface.rgba[base + 3] == 0) {
-                continue;
-            }
-            if (!found) {
-                bounds.min_x = x;
-                bounds.max_x = x;
-                bounds.min_y = y;
-                bounds.max_y = y;
-                found = true;
-                continue;
+// Straight 16-bit linear, indexed by its top 12 bits, to 8-bit sRGB.
+const std::array<uint8_t, 4096>& LinearToSRGBTable() {
+    static const auto table = [] {
+        std::array<uint8_t, 4096> values{};
+        for (size_t i = 0; i < values.size(); ++i) {
+            const double linear = (static_cast<double>(i) + 0.5) / static_cast<double>(values.size());
+            values[i] = static_cast<uint8_t>(std::lround(LinearToSRGB(linear) * 255.0));
+        }
+        return values;
+    }();
+    return table;
+}
+
+// Brings drawn pixels into a filter chain's working format. The only place
+// a chain pays for linearizing.
+FilterSurface ToFilterSurface(const PixelSurface& source, bool linear) {
+    FilterSurface output = MakeRegionSurface<FilterSurface>(source.width, source.height, source.content);
+    const PixelBounds& region = output.content;
+    const auto& to_linear = SRGBToLinearTable();
+    for (size_t y = region.min_y; !IsEmptyBounds(region) && y <= region.max_y; ++y) {
+        for (size_t x = region.min_x; x <= region.max_x; ++x) {
+            const size_t base = ((y * source.width) + x) * 4;
+            const uint32_t alpha = source.rgba[base + 3];
+            output.rgba[base + 3] = static_cast<uint16_t>(alpha * 257u);
+            for (size_t channel = 0; channel < 3; ++channel) {
+                const uint32_t premul = std::min<uint32_t>(source.rgba[base + channel], alpha);
+                uint32_t value = premul * 257u;
+                if (linear && alpha == 255u) {
+                    value = to_linear[premul];
+                } else if (linear && alpha != 0u) {
+                    const uint32_t straight = (premul * 255u + alpha / 2u) / alpha;
+                    value = (to_linear[straight] * alpha + 127u) / 255u;
+                }
+                output.rgba[base + channel] = static_cast<uint16_t>(value);
             }
-            bounds.min_x = std::min(bounds.min_x, x);
-            bounds.max_x = std::max(bounds.max_x, x);
-            bounds.min_y = std::min(bounds.min_y, y);
-            bounds.max_y = std::max(bounds.max_y, y);
         }
     }
+    return output;
+}
 
-    if (!found) {
-        bounds.min_x = 0;
-        bounds.min_y = 0;
-        bounds.max_x = surface.width > 0 ? surface.width - 1 : 0;
-        bounds.max_y = surface.height > 0 ? surface.height - 1 : 0;
+// Takes a chain's result back to 8-bit premultiplied sRGB for drawing.
+PixelSurface FromFilterSurface(const FilterSurface& source, bool linear) {
+    PixelSurface output = MakeRegionSurface<PixelSurface>(source.width, source.height, source.content);
+    const PixelBounds& region = output.content;
+    const auto& to_srgb = LinearToSRGBTable();
+    for (size_t y = region.min_y; !IsEmptyBounds(region) && y <= region.max_y; ++y) {
+        for (size_t x = region.min_x; x <= region.max_x; ++x) {
+            const size_t base = ((y * source.width) + x) * 4;
+            const uint32_t alpha16 = source.rgba[base + 3];
+            const uint32_t alpha = (alpha16 + 128u) / 257u;
+            output.rgba[base + 3] = static_cast<uint8_t>(alpha);
+            for (size_t channel = 0; channel < 3; ++channel) {
+                const uint32_t premul16 = std::min<uint32_t>(source.rgba[base + channel], alpha16);
+                uint32_t value = 0;
+                if (alpha16 != 0u && !linear) {
+                    value = std::min(alpha, (premul16 + 128u) / 257u);
+                } else if (alpha16 != 0u) {
+                    const uint64_t straight = (static_cast<uint64_t>(premul16) * 65535u + alpha16 / 2u) / alpha16;
+                    value = (static_cast<uint32_t>(to_srgb[straight >> 4]) * alpha + 127u) / 255u;
+                }
+                output.rgba[base + channel] = static_cast<uint8_t>(value);
+            }
+        }
     }
+    return output;
+}
 
-    return bounds;
+// An sRGB color component (flood-color, lighting-color) in a working space.
+double ToWorkingSpace(double srgb, bool linear) {
+    return linear ? SRGBToLinear(srgb) : std::clamp(srgb, 0.0, 1.0);
 }
 
-PixelSurface MakeFloodSurface(size_t width, size_t height, const XmlNode& primitive, const PixelBounds& bounds) {
-    PixelSurface surface;
-    surface.width = width;
-    surface.height = height;
-    surface.rgba.resize(width * height * 4, 0);
-    if (width == 0 || height == 0) {
-        return surface;
+// color-interpolation-filters on |node|, else |inherited|; true for linearRGB.
+bool ResolveLinearFilterSpace(const XmlNode& node, bool inherited) {
+    const auto style_it = node.attributes.find(AttrId::kStyle);
+    const auto inline_style = style_it != node.attributes.end()
+        ? ParseInlineStyle(style_it->second)
+        : PropertyMap{};
+    const auto value = ReadAttrOrStyle(node, inline_style, nullptr, AttrId::kColorInterpolationFilters);
+    if (!value.has_value()) {
+        return inherited;
+    }
+    const std::string space = Lower(Trim(*value));
+    if (space == "srgb") {
+        return false;
+    }
+    if (space == "linearrgb" || space == "auto") {
+        return true;
     }
+    return inherited;
+}
 
-    const auto style_it = primitive.attributes.find("style");
-    const auto inline_style = style_it != primitive.attributes.end()
-        ? ParseInlineStyle(style_it->second)
-        : std::map<std::string, std::string>{};
+struct RGBAColor {
+    double r = 0.0;
+    double g = 0.0;
+    double b = 0.0;
+    double a = 0.0;
+};
 
-    const auto flood_color_text = ReadAttrOrStyle(primitive, inline_style, nullptr, "flood-color").value_or("black");
-    const auto flood_opacity_text = ReadAttrOrStyle(primitive, inline_style, nullptr, "flood-opacity").value_or("1");
-    auto flood_color = StyleResolver::ParseColor(flood_color_text);
-    if (!flood_color.is_valid || flood_color.is_none) {
-        flood_color = StyleResolver::ParseColor("black");
+// Unpremultiplied, in the surface's working space.
+RGBAColor ReadPixelStraight(const FilterSurface& surface, size_t base) {
+    RGBAColor color;
+    color.a = static_cast<double>(surface.rgba[base + 3]) / kChannelMax;
+    if (color.a <= 0.0) {
+        return color;
+    }
+    const double scale = 1.0 / static_cast<double>(surface.rgba[base + 3]);
+    color.r = std::min(1.0, static_cast<double>(surface.rgba[base + 0]) * scale);
+    color.g = std::min(1.0, static_cast<double>(surface.rgba[base + 1]) * scale);
+    color.b = std::min(1.0, static_cast<double>(surface.rgba[base + 2]) * scale);
+    return color;
+}
+
+void WritePixelFromStraight(FilterSurface& surface, size_t base, const RGBAColor& color) {
+    const double scale = std::clamp(color.a, 0.0, 1.0) * kChannelMax;
+    surface.rgba[base + 0] = static_cast<uint16_t>(std::lround(std::clamp(color.r, 0.0, 1.0) * scale));
+    surface.rgba[base + 1] = static_cast<uint16_t>(std::lround(std::clamp(color.g, 0.0, 1.0) * scale));
+    surface.rgba[base + 2] = static_cast<uint16_t>(std::lround(std::clamp(color.b, 0.0, 1.0) * scale));
+    surface.rgba[base + 3] = static_cast<uint16_t>(std::lround(scale));
+}
+
+// SourceAlpha: just the alpha channel, a quarter of the pixels to carry.
+FilterSurface ExtractAlpha(const FilterSurface& source) {
+    FilterSurface alpha = MakeRegionSurface<FilterSurface>(source.width, source.height, source.content, 1);
+    ForEachPixel(alpha.content, alpha.width, [&](size_t, size_t, size_t base) {
+        alpha.rgba[base / 4] = source.rgba[base + 3];
+    });
+    return alpha;
+}
+
+// An alpha-only surface as black RGBA, for kernels that read color.
+FilterSurface ExpandAlpha(const FilterSurface& alpha) {
+    FilterSurface output = MakeRegionSurface<FilterSurface>(alpha.width, alpha.height, alpha.content);
+    ForEachPixel(output.content, output.width, [&](size_t, size_t, size_t base) {
+        output.rgba[base + 0] = 0;
+        output.rgba[base + 1] = 0;
+        output.rgba[base + 2] = 0;
+        output.rgba[base + 3] = alpha.rgba[base / 4];
+    });
+    return output;
+}
+
+// For a primitive whose color-interpolation-filters differs from the
+// result it reads.
+FilterSurface ConvertWorkingSpace(FilterSurface surface, bool to_linear) {
+    const auto convert = [to_linear](double value) {
+        return to_linear ? SRGBToLinear(value) : LinearToSRGB(value);
+    };
+    ForEachPixel(surface.content, surface.width, [&](size_t, size_t, size_t base) {
+        auto color = ReadPixelStraight(surface, base);
+        color.r = convert(color.r);
+        color.g = convert(color.g);
+        color.b = convert(color.b);
+        WritePixelFromStraight(surface, base, color);
+    });
+    return surface;
+}
+
+// |color| at |alpha| over |bounds|, transparent elsewhere.
+FilterSurface MakeSolidSurface(size_t width,
+                               size_t height,
+                               const Color& color,
+                               double alpha,
+                               const PixelBounds& bounds,
+                               bool linear) {
+    FilterSurface surface(width, height, true);
+    if (width == 0 || height == 0) {
+        return surface;
     }
 
-    const double opacity = std::clamp(ParseDouble(flood_opacity_text, 1.0), 0.0, 1.0);
-    const double alpha = std::clamp(static_cast<double>(flood_color.a) * opacity, 0.0, 1.0);
-    const uint8_t a = static_cast<uint8_t>(std::lround(alpha * 255.0));
-    const uint8_t r = static_cast<uint8_t>(std::lround(std::clamp(static_cast<double>(flood_color.r) * alpha, 0.0, 1.0) * 255.0));
-    const uint8_t g = static_cast<uint8_t>(std::lround(std::clamp(static_cast<double>(flood_color.g) * alpha, 0.0, 1.0) * 255.0));
-    const uint8_t b = static_cast<uint8_t>(std::lround(std::clamp(static_cast<double>(flood_color.b) * alpha, 0.0, 1.0) * 255.0));
+    const auto premultiply = [&](double component) {
+        return static_cast<uint16_t>(std::lround(ToWorkingSpace(component, linear) * alpha * kChannelMax));
+    };
+    const uint16_t a = static_cast<uint16_t>(std::lround(alpha * kChannelMax));
+    const uint16_t r = premultiply(color.r);
+    const uint16_t g = premultiply(color.g);
+    const uint16_t b = premultiply(color.b);
 
     const size_t max_x = std::min(bounds.max_x, width > 0 ? width - 1 : 0);
     const size_t max_y = std::min(bounds.max_y, height > 0 ? height - 1 : 0);
@@ -2531,9 +1616,44 @@ PixelSurface MakeFloodSurface(size_t width, size_t height, const XmlNode& primit
             surface.rgba[base + 3] = a;
         }
     }
+    surface.content = a != 0 ? PixelBounds{min_x, min_y, max_x, max_y} : EmptyBounds();
     return surface;
 }
 
+FilterSurface MakeFloodSurface(size_t width, size_t height, const XmlNode& primitive, const PixelBounds& bounds, bool linear) {
+    const auto style_it = primitive.attributes.find(AttrId::kStyle);
+    const auto inline_style = style_it != primitive.attributes.end()
+        ? ParseInlineStyle(style_it->second)
+        : PropertyMap{};
+
+    const auto flood_color_text = ReadAttrOrStyle(primitive, inline_style, nullptr, AttrId::kFloodColor).value_or("black");
+    const auto flood_opacity_text = ReadAttrOrStyle(primitive, inline_style, nullptr, AttrId::kFloodOpacity).value_or("1");
+    auto flood_color = ThemedColor(StyleResolver::ParseColor(flood_color_text));
+    if (!flood_color.is_valid || flood_color.is_none) {
+        flood_color = StyleResolver::ParseColor("black");
+    }
+
+    const double opacity = std::clamp(ParseDouble(flood_opacity_text, 1.0), 0.0, 1.0);
+    const double alpha = std::clamp(static_cast<double>(flood_color.a) * opacity, 0.0, 1.0);
+    return MakeSolidSurface(width, height, flood_color, alpha, bounds, linear);
+}
+
+// FillPaint or StrokePaint: the element's paint over the filter region. Only
+// solid colors are supported; a paint server or none gives transparent black.
+FilterSurface MakePaintSurface(size_t width,
+                               size_t height,
+                               const Color& paint,
+                               const std::string& paint_value,
+                               double opacity,
+                               const PixelBounds& filter_region,
+                               bool linear) {
+    if (!paint.is_valid || paint.is_none || ExtractPaintURLId(paint_value).has_value()) {
+        return FilterSurface(width, height, true);
+    }
+    const double alpha = std::clamp(static_cast<double>(paint.a) * opacity, 0.0, 1.0);
+    return MakeSolidSurface(width, height, paint, alpha, filter_region, linear);
+}
+
 double BlendChannel(double cb, double cs, const std::string& mode) {
     if (mode == "multiply") {
         return cb * cs;
@@ -2550,76 +1670,29 @@ double BlendChannel(double cb, double cs, const std::string& mode) {
     return cs;
 }
 
-double SRGBToLinear(double value) {
-    value = std::clamp(value, 0.0, 1.0);
-    if (value <= 0.04045) {
-        return value / 12.92;
-    }
-    return std::pow((value + 0.055) / 1.055, 2.4);
-}
-
-double LinearToSRGB(double value) {
-    value = std::clamp(value, 0.0, 1.0);
-    if (value <= 0.0031308) {
-        return value * 12.92;
-    }
-    return (1.055 * std::pow(value, 1.0 / 2.4)) - 0.055;
-}
-
-PixelSurface BlendSurfaces(const PixelSurface& in_surface, const PixelSurface& in2_surface, const std::string& mode) {
-    PixelSurface out;
-    out.width = in_surface.width;
-    out.height = in_surface.height;
-    out.rgba.resize(out.width * out.height * 4, 0);
+FilterSurface BlendSurfaces(const FilterSurface& in_surface, const FilterSurface& in2_surface, const std::string& mode) {
+    // Two transparent pixels blend to a transparent one.
+    FilterSurface out = MakeRegionSurface<FilterSurface>(in_surface.width,
+                                                         in_surface.height,
+                                                         UnionBounds(in_surface.content, in2_surface.content));
 
-    for (size_t i = 0; i < out.width * out.height; ++i) {
-        const size_t base = i * 4;
-        const double s_a = static_cast<double>(in_surface.rgba[base + 3]) / 255.0;
-        const double b_a = static_cast<double>(in2_surface.rgba[base + 3]) / 255.0;
+    ForEachPixel(out.content, out.width, [&](size_t, size_t, size_t base) {
+        const auto source = ReadPixelStraight(in_surface, base);
+        const auto backdrop = ReadPixelStraight(in2_surface, base);
+        const double s_a = source.a;
+        const double b_a = backdrop.a;
 
-        const auto to_straight = [](uint8_t premul, double alpha) -> double {
-            if (alpha <= 0.0) {
-                return 0.0;
-            }
-            return std::clamp((static_cast<double>(premul) / 255.0) / alpha, 0.0, 1.0);
+        const auto blend = [&](double cs, double cb) {
+            return std::clamp(s_a * (1.0 - b_a) * cs +
+                              b_a * (1.0 - s_a) * cb +
+                              s_a * b_a * BlendChannel(cb, cs, mode), 0.0, 1.0);
         };
-
-        const double s_r = SRGBToLinear(to_straight(in_surface.rgba[base + 0], s_a));
-        const double s_g = SRGBToLinear(to_straight(in_surface.rgba[base + 1], s_a));
-        const double s_b = SRGBToLinear(to_straight(in_surface.rgba[base + 2], s_a));
-        const double b_r = SRGBToLinear(to_straight(in2_surface.rgba[base + 0], b_a));
-        const double b_g = SRGBToLinear(to_straight(in2_surface.rgba[base + 1], b_a));
-        const double b_b = SRGBToLinear(to_straight(in2_surface.rgba[base + 2], b_a));
-
         const double out_a = std::clamp(s_a + b_a - (s_a * b_a), 0.0, 1.0);
-        const double out_r_premul_linear = std::clamp(s_a * (1.0 - b_a) * s_r +
-                                                      b_a * (1.0 - s_a) * b_r +
-                                                      s_a * b_a * BlendChannel(b_r, s_r, mode), 0.0, 1.0);
-        const double out_g_premul_linear = std::clamp(s_a * (1.0 - b_a) * s_g +
-                                                      b_a * (1.0 - s_a) * b_g +
-                                                      s_a * b_a * BlendChannel(b_g, s_g, mode), 0.0, 1.0);
-        const double out_b_premul_linear = std::clamp(s_a * (1.0 - b_a) * s_b +
-                                                      b_a * (1.0 - s_a) * b_b +
-                                                      s_a * b_a * BlendChannel(b_b, s_b, mode), 0.0, 1.0);
-
-        auto linear_premul_to_srgb_premul = [out_a](double premul_linear) -> double {
-            if (out_a <= 0.0) {
-                return 0.0;
-            }
-            const double straight_linear = std::clamp(premul_linear / out_a, 0.0, 1.0);
-            const double straight_srgb = LinearToSRGB(straight_linear);
-            return std::clamp(straight_srgb * out_a, 0.0, 1.0);
-        };
-
-        const double out_r_premul = linear_premul_to_srgb_premul(out_r_premul_linear);
-        const double out_g_premul = linear_premul_to_srgb_premul(out_g_premul_linear);
-        const double out_b_premul = linear_premul_to_srgb_premul(out_b_premul_linear);
-
-        out.rgba[base + 0] = static_cast<uint8_t>(std::lround(out_r_premul * 255.0));
-        out.rgba[base + 1] = static_cast<uint8_t>(std::lround(out_g_premul * 255.0));
-        out.rgba[base + 2] = static_cast<uint8_t>(std::lround(out_b_premul * 255.0));
-        out.rgba[base + 3] = static_cast<uint8_t>(std::lround(out_a * 255.0));
-    }
+        out.rgba[base + 0] = static_cast<uint16_t>(std::lround(std::min(blend(source.r, backdrop.r), out_a) * kChannelMax));
+        out.rgba[base + 1] = static_cast<uint16_t>(std::lround(std::min(blend(source.g, backdrop.g), out_a) * kChannelMax));
+        out.rgba[base + 2] = static_cast<uint16_t>(std::lround(std::min(blend(source.b, backdrop.b), out_a) * kChannelMax));
+        out.rgba[base + 3] = static_cast<uint16_t>(std::lround(out_a * kChannelMax));
+    });
 
     return out;
 }
@@ -2648,46 +1721,6 @@ std::vector<double> ParseNumberList(const std::string& text) {
     return values;
 }
 
-struct RGBAColor {
-    double r = 0.0;
-    double g = 0.0;
-    double b = 0.0;
-    double a = 0.0;
-};
-
-RGBAColor ReadPixelStraightLinear(const PixelSurface& surface, size_t base) {
-    const double alpha = static_cast<double>(surface.rgba[base + 3]) / 255.0;
-    auto to_straight = [alpha](uint8_t premul) -> double {
-        if (alpha <= 0.0) {
-            return 0.0;
-        }
-        return std::clamp((static_cast<double>(premul) / 255.0) / alpha, 0.0, 1.0);
-    };
-
-    RGBAColor color;
-    color.a = alpha;
-    color.r = SRGBToLinear(to_straight(surface.rgba[base + 0]));
-    color.g = SRGBToLinear(to_straight(surface.rgba[base + 1]));
-    color.b = SRGBToLinear(to_straight(surface.rgba[base + 2]));
-    return color;
-}
-
-void WritePixelFromStraightLinear(PixelSurface& surface, size_t base, const RGBAColor& color) {
-    const double alpha = std::clamp(color.a, 0.0, 1.0);
-    const double r = std::clamp(color.r, 0.0, 1.0);
-    const double g = std::clamp(color.g, 0.0, 1.0);
-    const double b = std::clamp(color.b, 0.0, 1.0);
-
-    const double r_srgb = LinearToSRGB(r);
-    const double g_srgb = LinearToSRGB(g);
-    const double b_srgb = LinearToSRGB(b);
-
-    surface.rgba[base + 0] = static_cast<uint8_t>(std::lround(std::clamp(r_srgb * alpha, 0.0, 1.0) * 255.0));
-    surface.rgba[base + 1] = static_cast<uint8_t>(std::lround(std::clamp(g_srgb * alpha, 0.0, 1.0) * 255.0));
-    surface.rgba[base + 2] = static_cast<uint8_t>(std::lround(std::clamp(b_srgb * alpha, 0.0, 1.0) * 255.0));
-    surface.rgba[base + 3] = static_cast<uint8_t>(std::lround(alpha * 255.0));
-}
-
 std::array<double, 20> IdentityColorMatrix() {
     return {
         1.0, 0.0, 0.0, 0.0, 0.0,
@@ -2729,8 +1762,8 @@ std::array<double, 20> MatrixForLuminanceToAlpha() {
 }
 
 std::array<double, 20> ResolveColorMatrix(const XmlNode& primitive) {
-    const std::string matrix_type = Lower(Trim(primitive.attributes.count("type") ? primitive.attributes.at("type") : "matrix"));
-    const auto values = ParseNumberList(primitive.attributes.count("values") ? primitive.attributes.at("values") : "");
+    const std::string matrix_type = Lower(Trim(primitive.attributes.count(AttrId::kType) ? primitive.attributes.at(AttrId::kType) : "matrix"));
+    const auto values = ParseNumberList(primitive.attributes.count(AttrId::kValues) ? primitive.attributes.at(AttrId::kValues) : "");
 
     if (matrix_type == "saturate") {
         return MatrixForSaturate(values.empty() ? 1.0 : values[0]);
@@ -2751,13 +1784,17 @@ std::array<double, 20> ResolveColorMatrix(const XmlNode& primitive) {
     return matrix;
 }
 
-PixelSurface ApplyColorMatrix(const PixelSurface& input, const XmlNode& primitive) {
-    PixelSurface output = input;
+// Each pixel depends only on itself, so the input is rewritten in place.
+FilterSurface ApplyColorMatrix(FilterSurface output, const XmlNode& primitive) {
     const auto matrix = ResolveColorMatrix(primitive);
+    // Transparent black maps to the offset column; only a positive alpha
+    // offset makes the empty margins visible.
+    if (matrix[19] > 0.0) {
+        output.content = SurfaceArea(output.width, output.height);
+    }
 
-    for (size_t i = 0; i < input.width * input.height; ++i) {
-        const size_t base = i * 4;
-        const auto src = ReadPixelStraightLinear(input, base);
+    ForEachPixel(output.content, output.width, [&](size_t, size_t, size_t base) {
+        const auto src = ReadPixelStraight(output, base);
         RGBAColor dst;
 
         dst.r = matrix[0] * src.r + matrix[1] * src.g + matrix[2] * src.b + matrix[3] * src.a + matrix[4];
@@ -2765,37 +1802,43 @@ PixelSurface ApplyColorMatrix(const PixelSurface& input, const XmlNode& primitiv
         dst.b = matrix[10] * src.r + matrix[11] * src.g + matrix[12] * src.b + matrix[13] * src.a + matrix[14];
         dst.a = matrix[15] * src.r + matrix[16] * src.g + matrix[17] * src.b + matrix[18] * src.a + matrix[19];
 
-        WritePixelFromStraightLinear(output, base, dst);
-    }
+        WritePixelFromStraight(output, base, dst);
+    });
 
     return output;
 }
 
-PixelSurface CompositeSurfaces(const PixelSurface& in_surface,
-                              const PixelSurface& in2_surface,
-                              const std::string& op,
-                              double k1 = 0.0,
-                              double k2 = 0.0,
-                              double k3 = 0.0,
-                              double k4 = 0.0) {
-    PixelSurface out;
-    out.width = in_surface.width;
-    out.height = in_surface.height;
-    out.rgba.resize(out.width * out.height * 4, 0);
-
+FilterSurface CompositeSurfaces(const FilterSurface& in_surface,
+                               const FilterSurface& in2_surface,
+                               const std::string& op,
+                               double k1 = 0.0,
+                               double k2 = 0.0,
+                               double k3 = 0.0,
+                               double k4 = 0.0) {
     const std::string op_lower = Lower(op);
-    const auto sample_premul = [](const PixelSurface& surface, size_t base, size_t channel) -> double {
+    // Where the operator's result is necessarily transparent; arithmetic
+    // keeps uncovered pixels transparent too.
+    PixelBounds region = UnionBounds(in_surface.content, in2_surface.content);
+    if (op_lower == "in") {
+        region = IntersectBounds(in_surface.content, in2_surface.content);
+    } else if (op_lower == "out") {
+        region = in_surface.content;
+    } else if (op_lower == "atop") {
+        region = in2_surface.content;
+    }
+    FilterSurface out = MakeRegionSurface<FilterSurface>(in_surface.width, in_surface.height, region);
+
+    const auto sample_premul = [](const FilterSurface& surface, size_t base, size_t channel) -> double {
         if (base + channel >= surface.rgba.size()) {
             return 0.0;
         }
-        return static_cast<double>(surface.rgba[base + channel]) / 255.0;
+        return static_cast<double>(surface.rgba[base + channel]) / kChannelMax;
     };
-    const auto sample_alpha = [&](const PixelSurface& surface, size_t base) -> double {
+    const auto sample_alpha = [&](const FilterSurface& surface, size_t base) -> double {
         return sample_premul(surface, base, 3);
     };
 
-    for (size_t i = 0; i < out.width * out.height; ++i) {
-        const size_t base = i * 4;
+    ForEachPixel(out.content, out.width, [&](size_t, size_t, size_t base) {
         const double in_r = sample_premul(in_surface, base, 0);
         const double in_g = sample_premul(in_surface, base, 1);
         const double in_b = sample_premul(in_surface, base, 2);
@@ -2807,15 +1850,15 @@ PixelSurface CompositeSurfaces(const PixelSurface& in_surface,
         const double a_in2 = sample_alpha(in2_surface, base);
 
         auto write_premul = [&](double r, double g, double b, double a) {
-            out.rgba[base + 0] = static_cast<uint8_t>(std::lround(std::clamp(r, 0.0, 1.0) * 255.0));
-            out.rgba[base + 1] = static_cast<uint8_t>(std::lround(std::clamp(g, 0.0, 1.0) * 255.0));
-            out.rgba[base + 2] = static_cast<uint8_t>(std::lround(std::clamp(b, 0.0, 1.0) * 255.0));
-            out.rgba[base + 3] = static_cast<uint8_t>(std::lround(std::clamp(a, 0.0, 1.0) * 255.0));
+            out.rgba[base + 0] = static_cast<uint16_t>(std::lround(std::clamp(r, 0.0, 1.0) * kChannelMax));
+            out.rgba[base + 1] = static_cast<uint16_t>(std::lround(std::clamp(g, 0.0, 1.0) * kChannelMax));
+            out.rgba[base + 2] = static_cast<uint16_t>(std::lround(std::clamp(b, 0.0, 1.0) * kChannelMax));
+            out.rgba[base + 3] = static_cast<uint16_t>(std::lround(std::clamp(a, 0.0, 1.0) * kChannelMax));
         };
 
         if (op_lower == "in") {
             write_premul(in_r * a_in2, in_g * a_in2, in_b * a_in2, a_in * a_in2);
-            continue;
+            return;
         }
 
         if (op_lower == "out") {
@@ -2823,7 +1866,7 @@ PixelSurface CompositeSurfaces(const PixelSurface& in_surface,
                          in_g * (1.0 - a_in2),
                          in_b * (1.0 - a_in2),
                          a_in * (1.0 - a_in2));
-            continue;
+            return;
         }
 
         if (op_lower == "atop") {
@@ -2831,7 +1874,7 @@ PixelSurface CompositeSurfaces(const PixelSurface& in_surface,
                          in_g * a_in2 + in2_g * (1.0 - a_in),
                          in_b * a_in2 + in2_b * (1.0 - a_in),
                          a_in2);
-            continue;
+            return;
         }
 
         if (op_lower == "xor") {
@@ -2839,7 +1882,7 @@ PixelSurface CompositeSurfaces(const PixelSurface& in_surface,
                          in_g * (1.0 - a_in2) + in2_g * (1.0 - a_in),
                          in_b * (1.0 - a_in2) + in2_b * (1.0 - a_in),
                          a_in * (1.0 - a_in2) + a_in2 * (1.0 - a_in));
-            continue;
+            return;
         }
 
         if (op_lower == "arithmetic") {
@@ -2852,7 +1895,7 @@ PixelSurface CompositeSurfaces(const PixelSurface& in_surface,
             const bool has_coverage = (a_in > 0.0) || (a_in2 > 0.0);
             if (!has_coverage) {
                 write_premul(0.0, 0.0, 0.0, 0.0);
-                continue;
+                return;
             }
 
             const double out_alpha = arithmetic(a_in, a_in2);
@@ -2860,7 +1903,7 @@ PixelSurface CompositeSurfaces(const PixelSurface& in_surface,
             const double out_g = std::min(arithmetic(in_g, in2_g), out_alpha);
             const double out_b = std::min(arithmetic(in_b, in2_b), out_alpha);
             write_premul(out_r, out_g, out_b, out_alpha);
-            continue;
+            return;
         }
 
         // "over" default behavior for unhandled operators.
@@ -2868,7 +1911,7 @@ PixelSurface CompositeSurfaces(const PixelSurface& in_surface,
                      in_g + in2_g * (1.0 - a_in),
                      in_b + in2_b * (1.0 - a_in),
                      a_in + a_in2 * (1.0 - a_in));
-    }
+    });
 
     return out;
 }
@@ -2876,25 +1919,19 @@ PixelSurface CompositeSurfaces(const PixelSurface& in_surface,
 CGImageRef CreateImageFromSurface(const PixelSurface& surface);
 
 PixelSurface MakeTransparentSurface(size_t width, size_t height) {
-    PixelSurface output;
-    output.width = width;
-    output.height = height;
-    output.rgba.resize(width * height * 4, 0);
-    return output;
-}
-
-bool IsEmptyBounds(const PixelBounds& bounds) {
-    return bounds.max_x < bounds.min_x || bounds.max_y < bounds.min_y;
+    return PixelSurface(width, height, true);
 }
 
-PixelBounds FullSurfaceBounds(const PixelSurface& surface) {
+template <typename Surface>
+PixelBounds FullSurfaceBounds(const Surface& surface) {
     if (surface.width == 0 || surface.height == 0) {
         return PixelBounds{0, 0, 0, 0};
     }
     return PixelBounds{0, 0, surface.width - 1, surface.height - 1};
 }
 
-PixelBounds ResolveUsableBounds(const PixelSurface& surface, const PixelBounds& candidate) {
+template <typename Surface>
+PixelBounds ResolveUsableBounds(const Surface& surface, const PixelBounds& candidate) {
     if (!IsEmptyBounds(candidate)) {
         return candidate;
     }
@@ -2908,7 +1945,7 @@ PixelSurface CropSurface(const PixelSurface& surface, const PixelBounds& bounds)
 
     const size_t crop_width = bounds.max_x - bounds.min_x + 1;
     const size_t crop_height = bounds.max_y - bounds.min_y + 1;
-    PixelSurface cropped = MakeTransparentSurface(crop_width, crop_height);
+    PixelSurface cropped(crop_width, crop_height, false);
     for (size_t row = 0; row < crop_height; ++row) {
         const size_t source_row = bounds.min_y + row;
         const size_t source_offset = ((source_row * surface.width) + bounds.min_x) * 4;
@@ -3030,6 +2067,18 @@ void DrawCGImageToSurface(PixelSurface& surface, CGImageRef image, double x, dou
                        image);
     CGContextRestoreGState(bitmap);
     CGContextRelease(bitmap);
+
+    const double right = std::ceil(x + width);
+    const double bottom = std::ceil(y + height);
+    if (right > 0.0 && bottom > 0.0 && x < static_cast<double>(surface.width) && y < static_cast<double>(surface.height)) {
+        const PixelBounds drawn{
+            static_cast<size_t>(std::max(0.0, std::floor(x))),
+            static_cast<size_t>(std::max(0.0, std::floor(y))),
+            static_cast<size_t>(std::min(right, static_cast<double>(surface.width))) - 1,
+            static_cast<size_t>(std::min(bottom, static_cast<double>(surface.height))) - 1
+        };
+        surface.content = UnionBounds(surface.content, drawn);
+    }
 }
 
 PixelSurface RenderImageFilterPrimitive(const XmlNode& primitive,
@@ -3049,13 +2098,13 @@ PixelSurface RenderImageFilterPrimitive(const XmlNode& primitive,
     }
 
     if (!href->empty() && href->front() == '#') {
-        const std::string id = href->substr(1);
+        const std::string id(href->substr(1));
         const auto it = id_map.find(id);
         if (it == id_map.end() || it->second == nullptr) {
             return output;
         }
 
-        const PixelBounds source_bounds = ResolveUsableBounds(source_surface, ComputeNonTransparentBounds(source_surface));
+        const PixelBounds source_bounds = ResolveUsableBounds(source_surface, source_surface.content);
         const double source_width = static_cast<double>(source_bounds.max_x - source_bounds.min_x + 1);
         const double source_height = static_cast<double>(source_bounds.max_y - source_bounds.min_y + 1);
         const auto intrinsic_size = ResolveIntrinsicNodeViewport(*it->second,
@@ -3089,18 +2138,18 @@ PixelSurface RenderImageFilterPrimitive(const XmlNode& primitive,
         const double default_y = static_cast<double>(source_bounds.min_y);
         const double default_width = static_cast<double>(source_bounds.max_x - source_bounds.min_x + 1);
         const double default_height = static_cast<double>(source_bounds.max_y - source_bounds.min_y + 1);
-        const double x = ParseSVGLengthAttr(primitive.attributes, "x", default_x, SvgLengthAxis::kX, viewport_width, viewport_height);
-        const double y = ParseSVGLengthAttr(primitive.attributes, "y", default_y, SvgLengthAxis::kY, viewport_width, viewport_height);
+        const double x = ParseSVGLengthAttr(primitive.attributes, AttrId::kX, default_x, LengthAxis::kX, viewport_width, viewport_height);
+        const double y = ParseSVGLengthAttr(primitive.attributes, AttrId::kY, default_y, LengthAxis::kY, viewport_width, viewport_height);
         const double width = ParseSVGLengthAttr(primitive.attributes,
-                                                "width",
+                                                AttrId::kWidth,
                                                 default_width,
-                                                SvgLengthAxis::kX,
+                                                LengthAxis::kX,
                                                 viewport_width,
                                                 viewport_height);
         const double height = ParseSVGLengthAttr(primitive.attributes,
-                                                 "height",
+                                                 AttrId::kHeight,
                                                  default_height,
-                                                 SvgLengthAxis::kY,
+                                                 LengthAxis::kY,
                                                  viewport_width,
                                                  viewport_height);
         DrawCGImageToSurface(output, image, x, y, width, height);
@@ -3108,26 +2157,38 @@ PixelSurface RenderImageFilterPrimitive(const XmlNode& primitive,
         return output;
     }
 
-    CGImageRef image = LoadImageFromHref(*href);
-    if (image == nullptr) {
+    // The header gives the default width and height; an image that misses
+    // the surface is never decoded.
+    size_t source_width = 0;
+    size_t source_height = 0;
+    if (!ImageDimensionsFromHref(*href, source_width, source_height)) {
         return output;
     }
     const double viewport_width = static_cast<double>(std::max<size_t>(1, source_surface.width));
     const double viewport_height = static_cast<double>(std::max<size_t>(1, source_surface.height));
-    const double x = ParseSVGLengthAttr(primitive.attributes, "x", 0.0, SvgLengthAxis::kX, viewport_width, viewport_height);
-    const double y = ParseSVGLengthAttr(primitive.attributes, "y", 0.0, SvgLengthAxis::kY, viewport_width, viewport_height);
+    const double x = ParseSVGLengthAttr(primitive.attributes, AttrId::kX, 0.0, LengthAxis::kX, viewport_width, viewport_height);
+    const double y = ParseSVGLengthAttr(primitive.attributes, AttrId::kY, 0.0, LengthAxis::kY, viewport_width, viewport_height);
     const double width = ParseSVGLengthAttr(primitive.attributes,
-                                            "width",
-                                            static_cast<double>(CGImageGetWidth(image)),
-                                            SvgLengthAxis::kX,
+                                            AttrId::kWidth,
+                                            static_cast<double>(source_width),
+                                            LengthAxis::kX,
                                             viewport_width,
                                             viewport_height);
     const double height = ParseSVGLengthAttr(primitive.attributes,
-                                             "height",
-                                             static_cast<double>(CGImageGetHeight(image)),
-                                             SvgLengthAxis::kY,
+                                             AttrId::kHeight,
+                                             static_cast<double>(source_height),
+                                             LengthAxis::kY,
                                              viewport_width,
                                              viewport_height);
+    if (!(width > 0.0 && height > 0.0) || x >= static_cast<double>(output.width) ||
+        y >= static_cast<double>(output.height) || x + width <= 0.0 || y + height <= 0.0) {
+        return output;
+    }
+    // Filter surfaces are already in device pixels.
+    CGImageRef image = LoadImageFromHref(*href, DevicePixelSize(width, height, CGAffineTransformIdentity));
+    if (image == nullptr) {
+        return output;
+    }
     DrawCGImageToSurface(output, image, x, y, width, height);
     CGImageRelease(image);
     return output;
@@ -3145,33 +2206,29 @@ size_t ResolveChannelSelector(const std::string& selector) {
         return 2;
     }
     return 3;
-}
-
-PixelSurface ApplyOffsetFilter(const PixelSurface& input, double dx, double dy) {
-    PixelSurface output = MakeTransparentSurface(input.width, input.height);
-    if (input.width == 0 || input.height == 0) {
-        return output;
-    }
-
-    const int offset_x = static_cast<int>(std::lround(dx));
-    const int offset_y = static_cast<int>(std::lround(dy));
-    const int width = static_cast<int>(input.width);
-    const int height = static_cast<int>(input.height);
-
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            const int src_x = x - offset_x;
-            const int src_y = y - offset_y;
-            if (src_x < 0 || src_y < 0 || src_x >= width || src_y >= height) {
-                continue;
-            }
-            const size_t src_base = (static_cast<size_t>(src_y) * input.width + static_cast<size_t>(src_x)) * 4;
-            const size_t dst_base = (static_cast<size_t>(y) * output.width + static_cast<size_t>(x)) * 4;
-            output.rgba[dst_base + 0] = input.rgba[src_base + 0];
-            output.rgba[dst_base + 1] = input.rgba[src_base + 1];
-            output.rgba[dst_base + 2] = input.rgba[src_base + 2];
-            output.rgba[dst_base + 3] = input.rgba[src_base + 3];
-        }
+}
+
+FilterSurface ApplyOffsetFilter(const FilterSurface& input, double dx, double dy) {
+    const long offset_x = std::lround(dx);
+    const long offset_y = std::lround(dy);
+    // Whole pixels only, so the content moves as it is and each of its rows
+    // that stays on the surface is one copy.
+    FilterSurface output = MakeRegionSurface<FilterSurface>(
+        input.width,
+        input.height,
+        OffsetBounds(input.content, offset_x, offset_y, input.width, input.height),
+        input.channels);
+    const PixelBounds& region = output.content;
+    if (IsEmptyBounds(region)) {
+        return output;
+    }
+    const size_t row_channels = (region.max_x - region.min_x + 1) * input.channels;
+    const size_t src_min_x = static_cast<size_t>(static_cast<long>(region.min_x) - offset_x);
+    for (size_t y = region.min_y; y <= region.max_y; ++y) {
+        const size_t src_y = static_cast<size_t>(static_cast<long>(y) - offset_y);
+        const size_t src_base = (src_y * input.width + src_min_x) * input.channels;
+        const size_t dst_base = (y * output.width + region.min_x) * input.channels;
+        std::copy_n(input.rgba.data() + src_base, row_channels, output.rgba.data() + dst_base);
     }
     return output;
 }
@@ -3198,18 +2255,31 @@ std::vector<double> BuildGaussianKernel(double std_deviation) {
     return kernel;
 }
 
-PixelSurface Convolve1D(const PixelSurface& input, const std::vector<double>& kernel, bool horizontal) {
+// Blurs RGBA and alpha-only surfaces alike.
+FilterSurface Convolve1D(const FilterSurface& input, const std::vector<double>& kernel, bool horizontal) {
     if (input.width == 0 || input.height == 0 || kernel.empty()) {
-        return input;
+        return input.Clone();
     }
 
-    PixelSurface output = MakeTransparentSurface(input.width, input.height);
     const int radius = static_cast<int>(kernel.size() / 2);
     const int width = static_cast<int>(input.width);
     const int height = static_cast<int>(input.height);
-
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
+    // The kernel spreads the content by its radius along one axis; past that
+    // every sample is transparent.
+    FilterSurface output = MakeRegionSurface<FilterSurface>(
+        input.width,
+        input.height,
+        InflateBounds(input.content,
+                      horizontal ? static_cast<size_t>(radius) : 0,
+                      horizontal ? 0 : static_cast<size_t>(radius),
+                      input.width,
+                      input.height),
+        input.channels);
+    const PixelBounds& region = output.content;
+    const size_t channels = input.channels;
+
+    for (int y = static_cast<int>(region.min_y); !IsEmptyBounds(region) && y <= static_cast<int>(region.max_y); ++y) {
+        for (int x = static_cast<int>(region.min_x); x <= static_cast<int>(region.max_x); ++x) {
             double accum[4] = {0.0, 0.0, 0.0, 0.0};
             double weight_sum = 0.0;
             for (int k = -radius; k <= radius; ++k) {
@@ -3219,38 +2289,37 @@ PixelSurface Convolve1D(const PixelSurface& input, const std::vector<double>& ke
                     continue;
                 }
                 const double weight = kernel[static_cast<size_t>(k + radius)];
-                const size_t sample_base = (static_cast<size_t>(sample_y) * input.width + static_cast<size_t>(sample_x)) * 4;
-                for (size_t channel = 0; channel < 4; ++channel) {
-                    accum[channel] += (static_cast<double>(input.rgba[sample_base + channel]) / 255.0) * weight;
+                const size_t sample_base = (static_cast<size_t>(sample_y) * input.width + static_cast<size_t>(sample_x)) * channels;
+                for (size_t channel = 0; channel < channels; ++channel) {
+                    accum[channel] += (static_cast<double>(input.rgba[sample_base + channel]) / kChannelMax) * weight;
                 }
                 weight_sum += weight;
             }
 
             if (weight_sum > 0.0) {
-                for (double& channel_value : accum) {
-                    channel_value /= weight_sum;
+                for (size_t channel = 0; channel < channels; ++channel) {
+                    accum[channel] /= weight_sum;
                 }
             }
 
-            const size_t out_base = (static_cast<size_t>(y) * output.width + static_cast<size_t>(x)) * 4;
-            for (size_t channel = 0; channel < 4; ++channel) {
-                output.rgba[out_base + channel] = static_cast<uint8_t>(std::lround(std::clamp(accum[channel], 0.0, 1.0) * 255.0));
+            const size_t out_base = (static_cast<size_t>(y) * output.width + static_cast<size_t>(x)) * channels;
+            for (size_t channel = 0; channel < channels; ++channel) {
+                output.rgba[out_base + channel] = static_cast<uint16_t>(std::lround(std::clamp(accum[channel], 0.0, 1.0) * kChannelMax));
             }
         }
     }
     return output;
 }
 
-PixelSurface ApplyGaussianBlurFilter(const PixelSurface& input, double std_x, double std_y) {
+FilterSurface ApplyGaussianBlurFilter(const FilterSurface& input, double std_x, double std_y) {
     if (std_x <= 0.0 && std_y <= 0.0) {
-        return input;
+        return input.Clone();
     }
-
-    PixelSurface horizontal = input;
-    if (std_x > 0.0) {
-        horizontal = Convolve1D(input, BuildGaussianKernel(std_x), true);
+    if (std_x <= 0.0) {
+        return Convolve1D(input, BuildGaussianKernel(std_y), false);
     }
 
+    FilterSurface horizontal = Convolve1D(input, BuildGaussianKernel(std_x), true);
     if (std_y > 0.0) {
         return Convolve1D(horizontal, BuildGaussianKernel(std_y), false);
     }
@@ -3277,22 +2346,22 @@ struct ChannelTransferFunction {
 
 ChannelTransferFunction ParseTransferFunction(const XmlNode& node) {
     ChannelTransferFunction fn;
-    const std::string type = Lower(Trim(node.attributes.count("type") ? node.attributes.at("type") : "identity"));
+    const std::string type = Lower(Trim(node.attributes.count(AttrId::kType) ? node.attributes.at(AttrId::kType) : "identity"));
     if (type == "table") {
         fn.type = ChannelTransferFunction::Type::kTable;
-        fn.table_values = ParseNumberList(node.attributes.count("tableValues") ? node.attributes.at("tableValues") : "");
+        fn.table_values = ParseNumberList(node.attributes.count(AttrId::kTableValues) ? node.attributes.at(AttrId::kTableValues) : "");
     } else if (type == "discrete") {
         fn.type = ChannelTransferFunction::Type::kDiscrete;
-        fn.table_values = ParseNumberList(node.attributes.count("tableValues") ? node.attributes.at("tableValues") : "");
+        fn.table_values = ParseNumberList(node.attributes.count(AttrId::kTableValues) ? node.attributes.at(AttrId::kTableValues) : "");
     } else if (type == "linear") {
         fn.type = ChannelTransferFunction::Type::kLinear;
-        fn.slope = ParseDouble(node.attributes.count("slope") ? node.attributes.at("slope") : "", 1.0);
-        fn.intercept = ParseDouble(node.attributes.count("intercept") ? node.attributes.at("intercept") : "", 0.0);
+        fn.slope = ParseNumberAttr(node.attributes, AttrId::kSlope, 1.0);
+        fn.intercept = ParseNumberAttr(node.attributes, AttrId::kIntercept, 0.0);
     } else if (type == "gamma") {
         fn.type = ChannelTransferFunction::Type::kGamma;
-        fn.amplitude = ParseDouble(node.attributes.count("amplitude") ? node.attributes.at("amplitude") : "", 1.0);
-        fn.exponent = ParseDouble(node.attributes.count("exponent") ? node.attributes.at("exponent") : "", 1.0);
-        fn.offset = ParseDouble(node.attributes.count("offset") ? node.attributes.at("offset") : "", 0.0);
+        fn.amplitude = ParseNumberAttr(node.attributes, AttrId::kAmplitude, 1.0);
+        fn.exponent = ParseNumberAttr(node.attributes, AttrId::kExponent, 1.0);
+        fn.offset = ParseNumberAttr(node.attributes, AttrId::kOffset, 0.0);
     }
     return fn;
 }
@@ -3338,7 +2407,8 @@ double EvaluateTransferFunction(const ChannelTransferFunction& fn, double value)
     return x;
 }
 
-PixelSurface ApplyComponentTransferFilter(const PixelSurface& input, const XmlNode& primitive) {
+// Like the color matrix, rewrites the input in place.
+FilterSurface ApplyComponentTransferFilter(FilterSurface output, const XmlNode& primitive) {
     ChannelTransferFunction fn_r;
     ChannelTransferFunction fn_g;
     ChannelTransferFunction fn_b;
@@ -3357,17 +2427,20 @@ PixelSurface ApplyComponentTransferFilter(const PixelSurface& input, const XmlNo
         }
     }
 
-    PixelSurface output = input;
-    for (size_t i = 0; i < input.width * input.height; ++i) {
-        const size_t base = i * 4;
-        const auto src = ReadPixelStraightLinear(input, base);
+    // Transparent pixels stay transparent unless the alpha function lifts 0.
+    if (EvaluateTransferFunction(fn_a, 0.0) > 0.0) {
+        output.content = SurfaceArea(output.width, output.height);
+    }
+
+    ForEachPixel(output.content, output.width, [&](size_t, size_t, size_t base) {
+        const auto src = ReadPixelStraight(output, base);
         RGBAColor dst;
         dst.r = EvaluateTransferFunction(fn_r, src.r);
         dst.g = EvaluateTransferFunction(fn_g, src.g);
         dst.b = EvaluateTransferFunction(fn_b, src.b);
         dst.a = EvaluateTransferFunction(fn_a, src.a);
-        WritePixelFromStraightLinear(output, base, dst);
-    }
+        WritePixelFromStraight(output, base, dst);
+    });
     return output;
 }
 
@@ -3382,7 +2455,7 @@ int PositiveModulo(int value, int mod) {
     return result;
 }
 
-RGBAColor SampleLinearRGBA(const PixelSurface& surface, int x, int y, const std::string& edge_mode) {
+RGBAColor SampleStraight(const FilterSurface& surface, int x, int y, const std::string& edge_mode) {
     const int width = static_cast<int>(surface.width);
     const int height = static_cast<int>(surface.height);
     if (width <= 0 || height <= 0) {
@@ -3404,16 +2477,16 @@ RGBAColor SampleLinearRGBA(const PixelSurface& surface, int x, int y, const std:
     }
 
     const size_t base = (static_cast<size_t>(sy) * surface.width + static_cast<size_t>(sx)) * 4;
-    return ReadPixelStraightLinear(surface, base);
+    return ReadPixelStraight(surface, base);
 }
 
-PixelSurface ApplyConvolveMatrixFilter(const PixelSurface& input, const XmlNode& primitive) {
-    const auto order_values = ParseNumberList(primitive.attributes.count("order") ? primitive.attributes.at("order") : "");
+FilterSurface ApplyConvolveMatrixFilter(const FilterSurface& input, const XmlNode& primitive) {
+    const auto order_values = ParseNumberList(primitive.attributes.count(AttrId::kOrder) ? primitive.attributes.at(AttrId::kOrder) : "");
     const int order_x = std::max(1, static_cast<int>(std::lround(order_values.empty() ? 3.0 : order_values[0])));
     const int order_y = std::max(1, static_cast<int>(std::lround(order_values.size() > 1 ? order_values[1] : static_cast<double>(order_x))));
     const int kernel_size = order_x * order_y;
 
-    std::vector<double> kernel = ParseNumberList(primitive.attributes.count("kernelMatrix") ? primitive.attributes.at("kernelMatrix") : "");
+    std::vector<double> kernel = ParseNumberList(primitive.attributes.count(AttrId::kKernelMatrix) ? primitive.attributes.at(AttrId::kKernelMatrix) : "");
     if (static_cast<int>(kernel.size()) < kernel_size) {
         kernel.assign(static_cast<size_t>(kernel_size), 0.0);
         const int center = (order_y / 2) * order_x + (order_x / 2);
@@ -3425,30 +2498,39 @@ PixelSurface ApplyConvolveMatrixFilter(const PixelSurface& input, const XmlNode&
     }
 
     const double kernel_sum = std::accumulate(kernel.begin(), kernel.end(), 0.0);
-    const double divisor = ParseDouble(primitive.attributes.count("divisor") ? primitive.attributes.at("divisor") : "",
-                                       std::abs(kernel_sum) > 1e-9 ? kernel_sum : 1.0);
+    const double divisor = ParseNumberAttr(primitive.attributes, AttrId::kDivisor, std::abs(kernel_sum) > 1e-9 ? kernel_sum : 1.0);
     const double safe_divisor = std::abs(divisor) > 1e-9 ? divisor : 1.0;
-    const double bias = ParseDouble(primitive.attributes.count("bias") ? primitive.attributes.at("bias") : "", 0.0);
-    const int target_x = static_cast<int>(std::lround(ParseDouble(primitive.attributes.count("targetX") ? primitive.attributes.at("targetX") : "",
-                                                                   static_cast<double>(order_x / 2))));
-    const int target_y = static_cast<int>(std::lround(ParseDouble(primitive.attributes.count("targetY") ? primitive.attributes.at("targetY") : "",
-                                                                   static_cast<double>(order_y / 2))));
-    const bool preserve_alpha = Lower(Trim(primitive.attributes.count("preserveAlpha") ? primitive.attributes.at("preserveAlpha") : "false")) == "true";
-    const std::string edge_mode = primitive.attributes.count("edgeMode") ? primitive.attributes.at("edgeMode") : "duplicate";
-
-    PixelSurface output = input;
-    const int width = static_cast<int>(input.width);
-    const int height = static_cast<int>(input.height);
-
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
+    const double bias = ParseNumberAttr(primitive.attributes, AttrId::kBias, 0.0);
+    const int target_x = static_cast<int>(std::lround(ParseNumberAttr(primitive.attributes, AttrId::kTargetX, static_cast<double>(order_x / 2))));
+    const int target_y = static_cast<int>(std::lround(ParseNumberAttr(primitive.attributes, AttrId::kTargetY, static_cast<double>(order_y / 2))));
+    const bool preserve_alpha = Lower(Trim(primitive.attributes.count(AttrId::kPreserveAlpha) ? primitive.attributes.at(AttrId::kPreserveAlpha) : "false")) == "true";
+    const std::string edge_mode = primitive.attributes.count(AttrId::kEdgeMode) ? primitive.attributes.at(AttrId::kEdgeMode) : "duplicate";
+
+    // Away from the content every sample is transparent, so the result is too
+    // unless wrapping pulls content in from the far edge or the bias lifts
+    // alpha.
+    const bool fills_surface = Lower(edge_mode) == "wrap" || (!preserve_alpha && bias > 0.0);
+    FilterSurface output = MakeRegionSurface<FilterSurface>(
+        input.width,
+        input.height,
+        fills_surface
+            ? SurfaceArea(input.width, input.height)
+            : InflateBounds(input.content,
+                            static_cast<size_t>(order_x),
+                            static_cast<size_t>(order_y),
+                            input.width,
+                            input.height));
+    const PixelBounds& region = output.content;
+
+    for (int y = static_cast<int>(region.min_y); !IsEmptyBounds(region) && y <= static_cast<int>(region.max_y); ++y) {
+        for (int x = static_cast<int>(region.min_x); x <= static_cast<int>(region.max_x); ++x) {
             RGBAColor accum;
             for (int ky = 0; ky < order_y; ++ky) {
                 for (int kx = 0; kx < order_x; ++kx) {
                     const int sample_x = x + (kx - target_x);
                     const int sample_y = y + (ky - target_y);
                     const double weight = kernel[static_cast<size_t>(ky * order_x + kx)];
-                    const auto sample = SampleLinearRGBA(input, sample_x, sample_y, edge_mode);
+                    const auto sample = SampleStraight(input, sample_x, sample_y, edge_mode);
                     accum.r += sample.r * weight;
                     accum.g += sample.g * weight;
                     accum.b += sample.b * weight;
@@ -3461,32 +2543,43 @@ PixelSurface ApplyConvolveMatrixFilter(const PixelSurface& input, const XmlNode&
             dst.g = (accum.g / safe_divisor) + bias;
             dst.b = (accum.b / safe_divisor) + bias;
             dst.a = preserve_alpha
-                ? ReadPixelStraightLinear(input, (static_cast<size_t>(y) * input.width + static_cast<size_t>(x)) * 4).a
+                ? ReadPixelStraight(input, (static_cast<size_t>(y) * input.width + static_cast<size_t>(x)) * 4).a
                 : ((accum.a / safe_divisor) + bias);
 
             const size_t base = (static_cast<size_t>(y) * output.width + static_cast<size_t>(x)) * 4;
-            WritePixelFromStraightLinear(output, base, dst);
+            WritePixelFromStraight(output, base, dst);
         }
     }
     return output;
 }
 
-PixelSurface ApplyMorphologyFilter(const PixelSurface& input, const XmlNode& primitive) {
-    const auto radius_values = ParseNumberList(primitive.attributes.count("radius") ? primitive.attributes.at("radius") : "");
+FilterSurface ApplyMorphologyFilter(const FilterSurface& input, const XmlNode& primitive) {
+    const auto radius_values = ParseNumberList(primitive.attributes.count(AttrId::kRadius) ? primitive.attributes.at(AttrId::kRadius) : "");
     const int radius_x = std::max(0, static_cast<int>(std::lround(radius_values.empty() ? 0.0 : radius_values[0])));
     const int radius_y = std::max(0, static_cast<int>(std::lround(radius_values.size() > 1 ? radius_values[1] : static_cast<double>(radius_x))));
     if (radius_x == 0 && radius_y == 0) {
-        return input;
-    }
-
-    const bool dilate = Lower(Trim(primitive.attributes.count("operator") ? primitive.attributes.at("operator") : "erode")) == "dilate";
-    PixelSurface output = input;
+        return input.Clone();
+    }
+
+    const bool dilate = Lower(Trim(primitive.attributes.count(AttrId::kOperator) ? primitive.attributes.at(AttrId::kOperator) : "erode")) == "dilate";
+    // Erosion never grows the content; dilation grows it by the radius.
+    FilterSurface output = MakeRegionSurface<FilterSurface>(
+        input.width,
+        input.height,
+        dilate ? InflateBounds(input.content,
+                               static_cast<size_t>(radius_x),
+                               static_cast<size_t>(radius_y),
+                               input.width,
+                               input.height)
+               : input.content);
+    const PixelBounds& region = output.content;
     const int width = static_cast<int>(input.width);
     const int height = static_cast<int>(input.height);
+    const int start = dilate ? 0 : 65535;
 
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            int extrema[4] = {dilate ? 0 : 255, dilate ? 0 : 255, dilate ? 0 : 255, dilate ? 0 : 255};
+    for (int y = static_cast<int>(region.min_y); !IsEmptyBounds(region) && y <= static_cast<int>(region.max_y); ++y) {
+        for (int x = static_cast<int>(region.min_x); x <= static_cast<int>(region.max_x); ++x) {
+            int extrema[4] = {start, start, start, start};
             for (int dy = -radius_y; dy <= radius_y; ++dy) {
                 for (int dx = -radius_x; dx <= radius_x; ++dx) {
                     const int sx = std::clamp(x + dx, 0, width - 1);
@@ -3501,16 +2594,16 @@ PixelSurface ApplyMorphologyFilter(const PixelSurface& input, const XmlNode& pri
 
             const size_t out_base = (static_cast<size_t>(y) * output.width + static_cast<size_t>(x)) * 4;
             for (size_t channel = 0; channel < 4; ++channel) {
-                output.rgba[out_base + channel] = static_cast<uint8_t>(std::clamp(extrema[channel], 0, 255));
+                output.rgba[out_base + channel] = static_cast<uint16_t>(std::clamp(extrema[channel], 0, 65535));
             }
         }
     }
     return output;
 }
 
-PixelSurface ApplyTileFilter(const PixelSurface& input, const XmlNode& primitive) {
-    PixelSurface output = MakeTransparentSurface(input.width, input.height);
-    if (input.width == 0 || input.height == 0) {
+FilterSurface ApplyTileFilter(const FilterSurface& input, const XmlNode& primitive) {
+    FilterSurface output(input.width, input.height, true);
+    if (input.width == 0 || input.height == 0 || IsEmptyBounds(input.content)) {
         return output;
     }
 
@@ -3523,10 +2616,10 @@ PixelSurface ApplyTileFilter(const PixelSurface& input, const XmlNode& primitive
 
     const double viewport_width = static_cast<double>(std::max<size_t>(1, input.width));
     const double viewport_height = static_cast<double>(std::max<size_t>(1, input.height));
-    const double region_x = ParseSVGLengthAttr(primitive.attributes, "x", 0.0, SvgLengthAxis::kX, viewport_width, viewport_height);
-    const double region_y = ParseSVGLengthAttr(primitive.attributes, "y", 0.0, SvgLengthAxis::kY, viewport_width, viewport_height);
-    const double region_w = ParseSVGLengthAttr(primitive.attributes, "width", viewport_width, SvgLengthAxis::kX, viewport_width, viewport_height);
-    const double region_h = ParseSVGLengthAttr(primitive.attributes, "height", viewport_height, SvgLengthAxis::kY, viewport_width, viewport_height);
+    const double region_x = ParseSVGLengthAttr(primitive.attributes, AttrId::kX, 0.0, LengthAxis::kX, viewport_width, viewport_height);
+    const double region_y = ParseSVGLengthAttr(primitive.attributes, AttrId::kY, 0.0, LengthAxis::kY, viewport_width, viewport_height);
+    const double region_w = ParseSVGLengthAttr(primitive.attributes, AttrId::kWidth, viewport_width, LengthAxis::kX, viewport_width, viewport_height);
+    const double region_h = ParseSVGLengthAttr(primitive.attributes, AttrId::kHeight, viewport_height, LengthAxis::kY, viewport_width, viewport_height);
 
     const int start_x = std::max(0, static_cast<int>(std::floor(region_x)));
     const int start_y = std::max(0, static_cast<int>(std::floor(region_y)));
@@ -3547,6 +2640,14 @@ PixelSurface ApplyTileFilter(const PixelSurface& input, const XmlNode& primitive
             output.rgba[dst_base + 3] = input.rgba[src_base + 3];
         }
     }
+    if (start_x < end_x && start_y < end_y) {
+        output.content = PixelBounds{
+            static_cast<size_t>(start_x),
+            static_cast<size_t>(start_y),
+            static_cast<size_t>(end_x - 1),
+            static_cast<size_t>(end_y - 1)
+        };
+    }
     return output;
 }
 
@@ -3609,13 +2710,14 @@ double FractalNoise(double x, double y, int seed, int octaves, bool turbulence)
     return std::clamp(value, 0.0, 1.0);
 }
 
-PixelSurface ApplyTurbulenceFilter(const PixelSurface& source_surface, const XmlNode& primitive) {
-    PixelSurface output = MakeTransparentSurface(source_surface.width, source_surface.height);
+// The noise is generated directly in the chain's working space.
+FilterSurface ApplyTurbulenceFilter(const PixelSurface& source_surface, const XmlNode& primitive) {
+    FilterSurface output(source_surface.width, source_surface.height, true);
     if (source_surface.width == 0 || source_surface.height == 0) {
         return output;
     }
 
-    const auto base_values = ParseNumberList(primitive.attributes.count("baseFrequency") ? primitive.attributes.at("baseFrequency") : "");
+    const auto base_values = ParseNumberList(primitive.attributes.count(AttrId::kBaseFrequency) ? primitive.attributes.at(AttrId::kBaseFrequency) : "");
     double fx = base_values.empty() ? 0.0 : base_values[0];
     double fy = base_values.size() > 1 ? base_values[1] : fx;
     fx = std::max(fx, 0.0);
@@ -3630,9 +2732,9 @@ PixelSurface ApplyTurbulenceFilter(const PixelSurface& source_surface, const Xml
         fy = fx;
     }
 
-    const int octaves = std::clamp(static_cast<int>(std::lround(ParseDouble(primitive.attributes.count("numOctaves") ? primitive.attributes.at("numOctaves") : "", 1.0))), 1, 8);
-    const int seed = static_cast<int>(std::lround(ParseDouble(primitive.attributes.count("seed") ? primitive.attributes.at("seed") : "", 0.0)));
-    const bool turbulence = Lower(Trim(primitive.attributes.count("type") ? primitive.attributes.at("type") : "turbulence")) != "fractalnoise";
+    const int octaves = std::clamp(static_cast<int>(std::lround(ParseNumberAttr(primitive.attributes, AttrId::kNumOctaves, 1.0))), 1, 8);
+    const int seed = static_cast<int>(std::lround(ParseNumberAttr(primitive.attributes, AttrId::kSeed, 0.0)));
+    const bool turbulence = Lower(Trim(primitive.attributes.count(AttrId::kType) ? primitive.attributes.at(AttrId::kType) : "turbulence")) != "fractalnoise";
 
     for (size_t y = 0; y < output.height; ++y) {
         for (size_t x = 0; x < output.width; ++x) {
@@ -3642,41 +2744,45 @@ PixelSurface ApplyTurbulenceFilter(const PixelSurface& source_surface, const Xml
             const double g = FractalNoise(nx, ny, seed + 37, octaves, turbulence);
             const double b = FractalNoise(nx, ny, seed + 73, octaves, turbulence);
             const size_t base = (y * output.width + x) * 4;
-            output.rgba[base + 0] = static_cast<uint8_t>(std::lround(r * 255.0));
-            output.rgba[base + 1] = static_cast<uint8_t>(std::lround(g * 255.0));
-            output.rgba[base + 2] = static_cast<uint8_t>(std::lround(b * 255.0));
-            output.rgba[base + 3] = 255;
+            output.rgba[base + 0] = static_cast<uint16_t>(std::lround(r * kChannelMax));
+            output.rgba[base + 1] = static_cast<uint16_t>(std::lround(g * kChannelMax));
+            output.rgba[base + 2] = static_cast<uint16_t>(std::lround(b * kChannelMax));
+            output.rgba[base + 3] = 65535;
         }
     }
+    output.content = SurfaceArea(output.width, output.height);
     return output;
 }
 
-RGBAColor SampleNearestLinear(const PixelSurface& surface, double x, double y) {
+RGBAColor SampleNearest(const FilterSurface& surface, double x, double y) {
     const int sx = static_cast<int>(std::lround(x));
     const int sy = static_cast<int>(std::lround(y));
     if (sx < 0 || sy < 0 || sx >= static_cast<int>(surface.width) || sy >= static_cast<int>(surface.height)) {
         return {};
     }
     const size_t base = (static_cast<size_t>(sy) * surface.width + static_cast<size_t>(sx)) * 4;
-    return ReadPixelStraightLinear(surface, base);
+    return ReadPixelStraight(surface, base);
 }
 
-PixelSurface ApplyDisplacementMapFilter(const PixelSurface& input, const PixelSurface& map_surface, const XmlNode& primitive) {
-    PixelSurface output = MakeTransparentSurface(input.width, input.height);
-    const double scale = ParseDouble(primitive.attributes.count("scale") ? primitive.attributes.at("scale") : "", 0.0);
-    const size_t channel_x = ResolveChannelSelector(primitive.attributes.count("xChannelSelector") ? primitive.attributes.at("xChannelSelector") : "A");
-    const size_t channel_y = ResolveChannelSelector(primitive.attributes.count("yChannelSelector") ? primitive.attributes.at("yChannelSelector") : "A");
+FilterSurface ApplyDisplacementMapFilter(const FilterSurface& input, const FilterSurface& map_surface, const XmlNode& primitive) {
+    if (IsEmptyBounds(input.content)) {
+        return FilterSurface(input.width, input.height, true);
+    }
+    FilterSurface output(input.width, input.height, false);
+    const double scale = ParseNumberAttr(primitive.attributes, AttrId::kScale, 0.0);
+    const size_t channel_x = ResolveChannelSelector(primitive.attributes.count(AttrId::kXChannelSelector) ? primitive.attributes.at(AttrId::kXChannelSelector) : "A");
+    const size_t channel_y = ResolveChannelSelector(primitive.attributes.count(AttrId::kYChannelSelector) ? primitive.attributes.at(AttrId::kYChannelSelector) : "A");
 
     for (size_t y = 0; y < output.height; ++y) {
         for (size_t x = 0; x < output.width; ++x) {
             const size_t map_base = (y * map_surface.width + x) * 4;
-            const auto map_color = ReadPixelStraightLinear(map_surface, map_base);
+            const auto map_color = ReadPixelStraight(map_surface, map_base);
             const double channel_values[4] = {map_color.r, map_color.g, map_color.b, map_color.a};
             const double dx = scale * (channel_values[channel_x] - 0.5);
             const double dy = scale * (channel_values[channel_y] - 0.5);
-            const auto sample = SampleNearestLinear(input, static_cast<double>(x) + dx, static_cast<double>(y) + dy);
+            const auto sample = SampleNearest(input, static_cast<double>(x) + dx, static_cast<double>(y) + dy);
             const size_t out_base = (y * output.width + x) * 4;
-            WritePixelFromStraightLinear(output, out_base, sample);
+            WritePixelFromStraight(output, out_base, sample);
         }
     }
     return output;
@@ -3709,8 +2815,8 @@ LightSource ParseLightSource(const XmlNode& primitive) {
     for (const auto& child : primitive.children) {
         const std::string light_name = LocalName(child.name);
         if (light_name == "fedistantlight") {
-            const double azimuth = ParseDouble(child.attributes.count("azimuth") ? child.attributes.at("azimuth") : "", 0.0) * M_PI / 180.0;
-            const double elevation = ParseDouble(child.attributes.count("elevation") ? child.attributes.at("elevation") : "", 0.0) * M_PI / 180.0;
+            const double azimuth = ParseNumberAttr(child.attributes, AttrId::kAzimuth, 0.0) * M_PI / 180.0;
+            const double elevation = ParseNumberAttr(child.attributes, AttrId::kElevation, 0.0) * M_PI / 180.0;
             LightSource source;
             source.type = LightSourceType::kDistant;
             source.direction = Normalize3(std::cos(elevation) * std::cos(azimuth),
@@ -3722,58 +2828,61 @@ LightSource ParseLightSource(const XmlNode& primitive) {
             LightSource source;
             source.type = LightSourceType::kPoint;
             source.position = {
-                ParseDouble(child.attributes.count("x") ? child.attributes.at("x") : "", 0.0),
-                ParseDouble(child.attributes.count("y") ? child.attributes.at("y") : "", 0.0),
-                ParseDouble(child.attributes.count("z") ? child.attributes.at("z") : "", 0.0),
+                ParseNumberAttr(child.attributes, AttrId::kX, 0.0),
+                ParseNumberAttr(child.attributes, AttrId::kY, 0.0),
+                ParseNumberAttr(child.attributes, AttrId::kZ, 0.0),
             };
             return source;
         }
         if (light_name == "fespotlight") {
             LightSource source;
             source.type = LightSourceType::kSpot;
-            const double light_x = ParseDouble(child.attributes.count("x") ? child.attributes.at("x") : "", 0.0);
-            const double light_y = ParseDouble(child.attributes.count("y") ? child.attributes.at("y") : "", 0.0);
-            const double light_z = ParseDouble(child.attributes.count("z") ? child.attributes.at("z") : "", 0.0);
+            const double light_x = ParseNumberAttr(child.attributes, AttrId::kX, 0.0);
+            const double light_y = ParseNumberAttr(child.attributes, AttrId::kY, 0.0);
+            const double light_z = ParseNumberAttr(child.attributes, AttrId::kZ, 0.0);
             source.position = {light_x, light_y, light_z};
             source.points_at = {
-                ParseDouble(child.attributes.count("pointsAtX") ? child.attributes.at("pointsAtX") : "", light_x),
-                ParseDouble(child.attributes.count("pointsAtY") ? child.attributes.at("pointsAtY") : "", light_y),
-                ParseDouble(child.attributes.count("pointsAtZ") ? child.attributes.at("pointsAtZ") : "", 0.0),
+                ParseNumberAttr(child.attributes, AttrId::kPointsAtX, light_x),
+                ParseNumberAttr(child.attributes, AttrId::kPointsAtY, light_y),
+                ParseNumberAttr(child.attributes, AttrId::kPointsAtZ, 0.0),
             };
-            source.spot_exponent = std::max(0.0, ParseDouble(child.attributes.count("specularExponent") ? child.attributes.at("specularExponent") : "", 1.0));
-            source.limiting_cone_angle = ParseDouble(child.attributes.count("limitingConeAngle") ? child.attributes.at("limitingConeAngle") : "", -1.0);
+            source.spot_exponent = std::max(0.0, ParseNumberAttr(child.attributes, AttrId::kSpecularExponent, 1.0));
+            source.limiting_cone_angle = ParseNumberAttr(child.attributes, AttrId::kLimitingConeAngle, -1.0);
             return source;
         }
     }
     return {};
 }
 
-PixelSurface ApplyLightingFilter(const PixelSurface& input, const XmlNode& primitive, bool specular) {
-    PixelSurface output = MakeTransparentSurface(input.width, input.height);
+FilterSurface ApplyLightingFilter(const FilterSurface& input, const XmlNode& primitive, bool specular, bool linear) {
+    FilterSurface output(input.width, input.height, false);
     if (input.width == 0 || input.height == 0) {
         return output;
     }
 
     const LightSource light_source = ParseLightSource(primitive);
-    const double surface_scale = ParseDouble(primitive.attributes.count("surfaceScale") ? primitive.attributes.at("surfaceScale") : "", 1.0);
-    const double diffuse_constant = ParseDouble(primitive.attributes.count("diffuseConstant") ? primitive.attributes.at("diffuseConstant") : "", 1.0);
-    const double specular_constant = ParseDouble(primitive.attributes.count("specularConstant") ? primitive.attributes.at("specularConstant") : "", 1.0);
-    const double specular_exponent = std::clamp(ParseDouble(primitive.attributes.count("specularExponent") ? primitive.attributes.at("specularExponent") : "", 1.0), 1.0, 128.0);
+    const double surface_scale = ParseNumberAttr(primitive.attributes, AttrId::kSurfaceScale, 1.0);
+    const double diffuse_constant = ParseNumberAttr(primitive.attributes, AttrId::kDiffuseConstant, 1.0);
+    const double specular_constant = ParseNumberAttr(primitive.attributes, AttrId::kSpecularConstant, 1.0);
+    const double specular_exponent = std::clamp(ParseNumberAttr(primitive.attributes, AttrId::kSpecularExponent, 1.0), 1.0, 128.0);
 
-    const auto style_it = primitive.attributes.find("style");
+    const auto style_it = primitive.attributes.find(AttrId::kStyle);
     const auto inline_style = style_it != primitive.attributes.end()
         ? ParseInlineStyle(style_it->second)
-        : std::map<std::string, std::string>{};
-    Color light_color = StyleResolver::ParseColor(ReadAttrOrStyle(primitive, inline_style, nullptr, "lighting-color").value_or("white"));
+        : PropertyMap{};
+    Color light_color = ThemedColor(StyleResolver::ParseColor(ReadAttrOrStyle(primitive, inline_style, nullptr, AttrId::kLightingColor).value_or("white")));
     if (!light_color.is_valid || light_color.is_none) {
         light_color = StyleResolver::ParseColor("white");
     }
+    const double light_r = ToWorkingSpace(light_color.r, linear);
+    const double light_g = ToWorkingSpace(light_color.g, linear);
+    const double light_b = ToWorkingSpace(light_color.b, linear);
 
     const auto alpha_at = [&](int x, int y) -> double {
         x = std::clamp(x, 0, static_cast<int>(input.width) - 1);
         y = std::clamp(y, 0, static_cast<int>(input.height) - 1);
         const size_t base = (static_cast<size_t>(y) * input.width + static_cast<size_t>(x)) * 4;
-        return (static_cast<double>(input.rgba[base + 3]) / 255.0) * surface_scale;
+        return (static_cast<double>(input.rgba[base + 3]) / kChannelMax) * surface_scale;
     };
 
     for (int y = 0; y < static_cast<int>(output.height); ++y) {
@@ -3832,10 +2941,10 @@ PixelSurface ApplyLightingFilter(const PixelSurface& input, const XmlNode& primi
             intensity = std::clamp(intensity, 0.0, 1.0);
 
             const size_t base = (static_cast<size_t>(y) * output.width + static_cast<size_t>(x)) * 4;
-            output.rgba[base + 0] = static_cast<uint8_t>(std::lround(std::clamp(light_color.r * intensity, 0.0, 1.0) * 255.0));
-            output.rgba[base + 1] = static_cast<uint8_t>(std::lround(std::clamp(light_color.g * intensity, 0.0, 1.0) * 255.0));
-            output.rgba[base + 2] = static_cast<uint8_t>(std::lround(std::clamp(light_color.b * intensity, 0.0, 1.0) * 255.0));
-            output.rgba[base + 3] = 255;
+            output.rgba[base + 0] = static_cast<uint16_t>(std::lround(std::clamp(light_r * intensity, 0.0, 1.0) * kChannelMax));
+            output.rgba[base + 1] = static_cast<uint16_t>(std::lround(std::clamp(light_g * intensity, 0.0, 1.0) * kChannelMax));
+            output.rgba[base + 2] = static_cast<uint16_t>(std::lround(std::clamp(light_b * intensity, 0.0, 1.0) * kChannelMax));
+            output.rgba[base + 3] = 65535;
         }
     }
     return output;
@@ -3849,8 +2958,8 @@ PixelBounds ComputeFilterRegionBounds(const XmlNode& filter_node,
         return full_bounds;
     }
 
-    const std::string units = Lower(Trim(filter_node.attributes.count("filterUnits")
-                                             ? filter_node.attributes.at("filterUnits")
+    const std::string units = Lower(Trim(filter_node.attributes.count(AttrId::kFilterUnits)
+                                             ? filter_node.attributes.at(AttrId::kFilterUnits)
                                              : "objectBoundingBox"));
 
     double x = 0.0;
@@ -3862,31 +2971,31 @@ PixelBounds ComputeFilterRegionBounds(const XmlNode& filter_node,
         const double viewport_width = std::max(geometry_engine.viewport_width(), 1.0);
         const double viewport_height = std::max(geometry_engine.viewport_height(), 1.0);
         x = ParseSVGLengthAttr(filter_node.attributes,
-                               "x",
+                               AttrId::kX,
                                -0.1 * viewport_width,
-                               SvgLengthAxis::kX,
+                               LengthAxis::kX,
                                viewport_width,
                                viewport_height);
         y = ParseSVGLengthAttr(filter_node.attributes,
-                               "y",
+                               AttrId::kY,
                                -0.1 * viewport_height,
-                               SvgLengthAxis::kY,
+                               LengthAxis::kY,
                                viewport_width,
                                viewport_height);
         width = ParseSVGLengthAttr(filter_node.attributes,
-                                   "width",
+                                   AttrId::kWidth,
                                    1.2 * viewport_width,
-                                   SvgLengthAxis::kX,
+                                   LengthAxis::kX,
                                    viewport_width,
                                    viewport_height);
         height = ParseSVGLengthAttr(filter_node.attributes,
-                                    "height",
+                                    AttrId::kHeight,
                                     1.2 * viewport_height,
-                                    SvgLengthAxis::kY,
+                                    LengthAxis::kY,
                                     viewport_width,
                                     viewport_height);
     } else {
-        const PixelBounds source_bounds = ResolveUsableBounds(source_surface, ComputeNonTransparentBounds(source_surface));
+        const PixelBounds source_bounds = ResolveUsableBounds(source_surface, source_surface.content);
         const double bbox_x = static_cast<double>(source_bounds.min_x);
         const double bbox_y = static_cast<double>(source_bounds.min_y);
         const double bbox_width = static_cast<double>(source_bounds.max_x - source_bounds.min_x + 1);
@@ -3895,23 +3004,10 @@ PixelBounds ComputeFilterRegionBounds(const XmlNode& filter_node,
             return full_bounds;
         }
 
-        const auto x_it = filter_node.attributes.find("x");
-        const auto y_it = filter_node.attributes.find("y");
-        const auto width_it = filter_node.attributes.find("width");
-        const auto height_it = filter_node.attributes.find("height");
-
-        const double x_rel = x_it != filter_node.attributes.end()
-            ? ParseObjectBoundingBoxLength(x_it->second, -0.1)
-            : -0.1;
-        const double y_rel = y_it != filter_node.attributes.end()
-            ? ParseObjectBoundingBoxLength(y_it->second, -0.1)
-            : -0.1;
-        const double width_rel = width_it != filter_node.attributes.end()
-            ? ParseObjectBoundingBoxLength(width_it->second, 1.2)
-            : 1.2;
-        const double height_rel = height_it != filter_node.attributes.end()
-            ? ParseObjectBoundingBoxLength(height_it->second, 1.2)
-            : 1.2;
+        const double x_rel = ParseNumberAttr(filter_node.attributes, AttrId::kX, -0.1);
+        const double y_rel = ParseNumberAttr(filter_node.attributes, AttrId::kY, -0.1);
+        const double width_rel = ParseNumberAttr(filter_node.attributes, AttrId::kWidth, 1.2);
+        const double height_rel = ParseNumberAttr(filter_node.attributes, AttrId::kHeight, 1.2);
 
         x = bbox_x + (x_rel * bbox_width);
         y = bbox_y + (y_rel * bbox_height);
@@ -3940,32 +3036,28 @@ PixelBounds ComputeFilterRegionBounds(const XmlNode& filter_node,
     };
 }
 
-PixelSurface ClipSurfaceToBounds(const PixelSurface& input, const PixelBounds& bounds) {
-    if (input.width == 0 || input.height == 0) {
-        return input;
-    }
-    if (IsEmptyBounds(bounds)) {
-        return MakeTransparentSurface(input.width, input.height);
-    }
-
-    PixelSurface output = input;
-    for (size_t y = 0; y < output.height; ++y) {
-        for (size_t x = 0; x < output.width; ++x) {
-            if (x >= bounds.min_x && x <= bounds.max_x && y >= bounds.min_y && y <= bounds.max_y) {
-                continue;
-            }
-            const size_t base = (y * output.width + x) * 4;
-            output.rgba[base + 0] = 0;
-            output.rgba[base + 1] = 0;
-            output.rgba[base + 2] = 0;
-            output.rgba[base + 3] = 0;
+// Clears everything outside |bounds| in place. Only the content can hold
+// anything to clear.
+PixelSurface ClipSurfaceToBounds(PixelSurface output, const PixelBounds& bounds) {
+    const PixelBounds content = IntersectBounds(output.content, SurfaceArea(output.width, output.height));
+    const PixelBounds kept = IntersectBounds(content, bounds);
+    for (size_t y = content.min_y; !IsEmptyBounds(content) && y <= content.max_y; ++y) {
+        uint8_t* row = output.rgba.data() + y * output.width * 4;
+        if (IsEmptyBounds(kept) || y < kept.min_y || y > kept.max_y) {
+            std::memset(row + content.min_x * 4, 0, (content.max_x - content.min_x + 1) * 4);
+            continue;
         }
+        std::memset(row + content.min_x * 4, 0, (kept.min_x - content.min_x) * 4);
+        std::memset(row + (kept.max_x + 1) * 4, 0, (content.max_x - kept.max_x) * 4);
     }
+    output.content = kept;
     return output;
 }
 
 std::optional<PixelSurface> ExecuteBasicFilterPrimitives(const XmlNode& filter_node,
                                                          const PixelSurface& source_surface,
+                                                         const ResolvedStyle& node_style,
+                                                         const PixelBounds& filter_region,
                                                          const StyleResolver& style_resolver,
                                                          const GeometryEngine& geometry_engine,
                                                          const GradientMap& gradients,
@@ -3978,131 +3070,206 @@ std::optional<PixelSurface> ExecuteBasicFilterPrimitives(const XmlNode& filter_n
         return MakeTransparentSurface(source_surface.width, source_surface.height);
     }
 
-    std::map<std::string, PixelSurface> surfaces;
-    surfaces["SourceGraphic"] = source_surface;
-    PixelSurface source_alpha = source_surface;
-    for (size_t i = 0; i < source_alpha.width * source_alpha.height; ++i) {
-        const size_t base = i * 4;
-        const uint8_t alpha = source_alpha.rgba[base + 3];
-        source_alpha.rgba[base + 0] = 0;
-        source_alpha.rgba[base + 1] = 0;
-        source_alpha.rgba[base + 2] = 0;
-        source_alpha.rgba[base + 3] = alpha;
-    }
-    surfaces["SourceAlpha"] = std::move(source_alpha);
+    // Every result stays in the 16-bit working format; the source is
+    // converted into it once here and the final result out of it once below.
+    struct FilterResult {
+        FilterSurface surface;
+        bool linear = true;
+    };
+    const bool chain_linear = ResolveLinearFilterSpace(filter_node, true);
+    const FilterResult source_graphic{ToFilterSurface(source_surface, chain_linear), chain_linear};
+    ProfileOffscreenPixels(source_surface.width, source_surface.height);
+    std::map<std::string, FilterResult> surfaces;
+    // The other standard inputs, each built the first time a primitive
+    // names it.
+    std::map<std::string, FilterResult> standard_inputs;
     std::string last_key = "SourceGraphic";
+    bool last_result_unnamed = false;
     size_t unnamed_index = 0;
-    const PixelBounds filter_bounds = ComputeNonTransparentBounds(source_surface);
-
-    const auto resolve_input = [&](const std::string& key) -> const PixelSurface* {
+    // The source's drawn bounds were found when it was rendered.
+    const PixelBounds filter_bounds = ResolveUsableBounds(source_surface, source_surface.content);
+    // The working space of the primitive being run.
+    bool linear = chain_linear;
+    // Inputs converted for a primitive whose color-interpolation-filters
+    // differs from theirs; a deque keeps them in place while it reads them.
+    std::deque<FilterSurface> converted_inputs;
+
+    const auto standard_input = [&](const std::string& key) -> const FilterResult* {
+        const auto it = standard_inputs.find(key);
+        if (it != standard_inputs.end()) {
+            return &it->second;
+        }
+        const size_t width = source_surface.width;
+        const size_t height = source_surface.height;
+        FilterSurface surface;
+        if (key == "SourceAlpha") {
+            surface = ExtractAlpha(source_graphic.surface);
+        } else if (key == "BackgroundImage" || key == "BackgroundAlpha") {
+            // As in Chromium, there is no accumulated background to read.
+            surface = FilterSurface(width, height, true, 1);
+        } else if (key == "FillPaint") {
+            surface = MakePaintSurface(width, height, node_style.fill, node_style.fill_paint,
+                                       node_style.fill_opacity, filter_region, chain_linear);
+        } else if (key == "StrokePaint") {
+            surface = MakePaintSurface(width, height, node_style.stroke, node_style.stroke_paint,
+                                       node_style.stroke_opacity, filter_region, chain_linear);
+        } else {
+            return nullptr;
+        }
+        ProfileOffscreenPixels(width, height);
+        return &standard_inputs.emplace(key, FilterResult{std::move(surface), chain_linear}).first->second;
+    };
+    const auto find_result = [&](const std::string& key) -> const FilterResult* {
         const auto it = surfaces.find(key);
         if (it != surfaces.end()) {
             return &it->second;
         }
-        const auto last_it = surfaces.find(last_key);
-        return last_it != surfaces.end() ? &last_it->second : nullptr;
+        return key == "SourceGraphic" ? &source_graphic : standard_input(key);
+    };
+    // Blur and offset read alpha-only surfaces as they are; every other
+    // kernel gets them expanded to RGBA. Alpha needs no color conversion.
+    const auto resolve_input = [&](const std::string& key, bool alpha_only_ok = false) -> const FilterSurface* {
+        const auto* result = find_result(key);
+        if (result == nullptr) {
+            result = find_result(last_key);
+        }
+        if (result == nullptr) {
+            return nullptr;
+        }
+        if (result->surface.channels == 1) {
+            if (alpha_only_ok) {
+                return &result->surface;
+            }
+            converted_inputs.push_back(ExpandAlpha(result->surface));
+            return &converted_inputs.back();
+        }
+        if (result->linear == linear) {
+            return &result->surface;
+        }
+        converted_inputs.push_back(ConvertWorkingSpace(result->surface.Clone(), linear));
+        return &converted_inputs.back();
+    };
+    // An unnamed result is only ever read by the primitive right after it,
+    // which may then take its pixels and work in place instead of copying.
+    const auto take_input = [&](const std::string& key) -> std::optional<FilterSurface> {
+        const std::string& resolved_key = find_result(key) != nullptr ? key : last_key;
+        std::optional<FilterSurface> taken;
+        bool taken_linear = linear;
+        const auto it = surfaces.find(resolved_key);
+        if (last_result_unnamed && resolved_key == last_key && it != surfaces.end()) {
+            taken = std::move(it->second.surface);
+            taken_linear = it->second.linear;
+            surfaces.erase(it);
+        } else if (const auto* result = find_result(resolved_key)) {
+            taken = result->surface.Clone();
+            taken_linear = result->linear;
+        } else {
+            return std::nullopt;
+        }
+        if (taken->channels == 1) {
+            taken = ExpandAlpha(*taken);
+        } else if (taken_linear != linear) {
+            taken = ConvertWorkingSpace(std::move(*taken), linear);
+        }
+        return taken;
     };
 
     for (const auto& primitive : filter_node.children) {
         const auto primitive_name = LocalName(primitive.name);
-        PixelSurface output;
+        linear = ResolveLinearFilterSpace(primitive, chain_linear);
+        converted_inputs.clear();
+        FilterSurface output;
 
         if (primitive_name == "feflood") {
-            output = MakeFloodSurface(source_surface.width, source_surface.height, primitive, filter_bounds);
+            output = MakeFloodSurface(source_surface.width, source_surface.height, primitive, filter_bounds, linear);
         } else if (primitive_name == "fegaussianblur") {
-            const auto stddev_values = ParseNumberList(primitive.attributes.count("stdDeviation") ? primitive.attributes.at("stdDeviation") : "");
+            const auto stddev_values = ParseNumberList(primitive.attributes.count(AttrId::kStdDeviation) ? primitive.attributes.at(AttrId::kStdDeviation) : "");
             const double std_x = stddev_values.empty() ? 0.0 : std::max(0.0, stddev_values[0]);
             const double std_y = stddev_values.size() > 1 ? std::max(0.0, stddev_values[1]) : std_x;
-            const std::string in_key = Trim(primitive.attributes.count("in") ? primitive.attributes.at("in") : last_key);
-            const auto* in_surface = resolve_input(in_key.empty() ? last_key : in_key);
+            const std::string in_key = Trim(primitive.attributes.count(AttrId::kIn) ? primitive.attributes.at(AttrId::kIn) : last_key);
+            const auto* in_surface = resolve_input(in_key.empty() ? last_key : in_key, true);
             if (in_surface == nullptr) {
                 return std::nullopt;
             }
             output = ApplyGaussianBlurFilter(*in_surface, std_x, std_y);
         } else if (primitive_name == "feoffset") {
-            const std::string in_key = Trim(primitive.attributes.count("in") ? primitive.attributes.at("in") : last_key);
-            const auto* in_surface = resolve_input(in_key.empty() ? last_key : in_key);
+            const std::string in_key = Trim(primitive.attributes.count(AttrId::kIn) ? primitive.attributes.at(AttrId::kIn) : last_key);
+            const auto* in_surface = resolve_input(in_key.empty() ? last_key : in_key, true);
             if (in_surface == nullptr) {
                 return std::nullopt;
             }
             const double viewport_width = static_cast<double>(std::max<size_t>(1, in_surface->width));
             const double viewport_height = static_cast<double>(std::max<size_t>(1, in_surface->height));
-            const double dx = ParseSVGLengthAttr(primitive.attributes, "dx", 0.0, SvgLengthAxis::kX, viewport_width, viewport_height);
-            const double dy = ParseSVGLengthAttr(primitive.attributes, "dy", 0.0, SvgLengthAxis::kY, viewport_width, viewport_height);
+            const double dx = ParseSVGLengthAttr(primitive.attributes, AttrId::kDx, 0.0, LengthAxis::kX, viewport_width, viewport_height);
+            const double dy = ParseSVGLengthAttr(primitive.attributes, AttrId::kDy, 0.0, LengthAxis::kY, viewport_width, viewport_height);
             output = ApplyOffsetFilter(*in_surface, dx, dy);
         } else if (primitive_name == "feimage") {
-            output = RenderImageFilterPrimitive(primitive,
-                                                source_surface,
-                                                style_resolver,
-                                                geometry_engine,
-                                                gradients,
-                                                patterns,
-                                                id_map,
-                                                color_profiles,
-                                                options,
-                                                error);
+            output = ToFilterSurface(RenderImageFilterPrimitive(primitive,
+                                                                source_surface,
+                                                                style_resolver,
+                                                                geometry_engine,
+                                                                gradients,
+                                                                patterns,
+                                                                id_map,
+                                                                color_profiles,
+                                                                options,
+                                                                error),
+                                     linear);
         } else if (primitive_name == "fecolormatrix") {
-            const std::string in_key = Trim(primitive.attributes.count("in") ? primitive.attributes.at("in") : last_key);
-            const auto* in_surface = resolve_input(in_key.empty() ? last_key : in_key);
-            if (in_surface == nullptr) {
+            const std::string in_key = Trim(primitive.attributes.count(AttrId::kIn) ? primitive.attributes.at(AttrId::kIn) : last_key);
+            auto in_surface = take_input(in_key.empty() ? last_key : in_key);
+            if (!in_surface.has_value()) {
                 return std::nullopt;
             }
-            output = ApplyColorMatrix(*in_surface, primitive);
+            output = ApplyColorMatrix(std::move(*in_surface), primitive);
         } else if (primitive_name == "fecomponenttransfer") {
-            const std::string in_key = Trim(primitive.attributes.count("in") ? primitive.attributes.at("in") : last_key);
-            const auto* in_surface = resolve_input(in_key.empty() ? last_key : in_key);
-            if (in_surface == nullptr) {
+            const std::string in_key = Trim(primitive.attributes.count(AttrId::kIn) ? primitive.attributes.at(AttrId::kIn) : last_key);
+            auto in_surface = take_input(in_key.empty() ? last_key : in_key);
+            if (!in_surface.has_value()) {
                 return std::nullopt;
             }
-            output = ApplyComponentTransferFilter(*in_surface, primitive);
+            output = ApplyComponentTransferFilter(std::move(*in_surface), primitive);
         } else if (primitive_name == "feconvolvematrix") {
-            const std::string in_key = Trim(primitive.attributes.count("in") ? primitive.attributes.at("in") : last_key);
+            const std::string in_key = Trim(primitive.attributes.count(AttrId::kIn) ? primitive.attributes.at(AttrId::kIn) : last_key);
             const auto* in_surface = resolve_input(in_key.empty() ? last_key : in_key);
             if (in_surface == nullptr) {
                 return std::nullopt;
             }
             output = ApplyConvolveMatrixFilter(*in_surface, primitive);
         } else if (primitive_name == "fecomposite") {
-            const std::string in_key = Trim(primitive.attributes.count("in") ? primitive.attributes.at("in") : last_key);
-            const std::string in2_key = Trim(primitive.attributes.count("in2") ? primitive.attributes.at("in2") : "SourceGraphic");
+            const std::string in_key = Trim(primitive.attributes.count(AttrId::kIn) ? primitive.attributes.at(AttrId::kIn) : last_key);
+            const std::string in2_key = Trim(primitive.attributes.count(AttrId::kIn2) ? primitive.attributes.at(AttrId::kIn2) : "SourceGraphic");
             const auto* in_surface = resolve_input(in_key.empty() ? last_key : in_key);
             const auto* in2_surface = resolve_input(in2_key.empty() ? "SourceGraphic" : in2_key);
             if (in_surface == nullptr || in2_surface == nullptr) {
                 return std::nullopt;
             }
-            const std::string op = Lower(Trim(primitive.attributes.count("operator") ? primitive.attributes.at("operator") : "over"));
-            const auto parse_attr = [&](const char* key, double fallback) -> double {
-                const auto it = primitive.attributes.find(key);
-                if (it == primitive.attributes.end()) {
-                    return fallback;
-                }
-                return ParseDouble(it->second, fallback);
-            };
+            const std::string op = Lower(Trim(primitive.attributes.count(AttrId::kOperator) ? primitive.attributes.at(AttrId::kOperator) : "over"));
             output = CompositeSurfaces(*in_surface,
                                        *in2_surface,
                                        op,
-                                       parse_attr("k1", 0.0),
-                                       parse_attr("k2", 0.0),
-                                       parse_attr("k3", 0.0),
-                                       parse_attr("k4", 0.0));
+                                       ParseNumberAttr(primitive.attributes, AttrId::kK1, 0.0),
+                                       ParseNumberAttr(primitive.attributes, AttrId::kK2, 0.0),
+                                       ParseNumberAttr(primitive.attributes, AttrId::kK3, 0.0),
+                                       ParseNumberAttr(primitive.attributes, AttrId::kK4, 0.0));
         } else if (primitive_name == "feblend") {
-            const std::string in_key = Trim(primitive.attributes.count("in") ? primitive.attributes.at("in") : last_key);
-            const std::string in2_key = Trim(primitive.attributes.count("in2") ? primitive.attributes.at("in2") : "SourceGraphic");
+            const std::string in_key = Trim(primitive.attributes.count(AttrId::kIn) ? primitive.attributes.at(AttrId::kIn) : last_key);
+            const std::string in2_key = Trim(primitive.attributes.count(AttrId::kIn2) ? primitive.attributes.at(AttrId::kIn2) : "SourceGraphic");
             const auto* in_surface = resolve_input(in_key.empty() ? last_key : in_key);
             const auto* in2_surface = resolve_input(in2_key.empty() ? "SourceGraphic" : in2_key);
             if (in_surface == nullptr || in2_surface == nullptr) {
                 return std::nullopt;
             }
 
-            const std::string mode = Lower(Trim(primitive.attributes.count("mode") ? primitive.attributes.at("mode") : "normal"));
+            const std::string mode = Lower(Trim(primitive.attributes.count(AttrId::kMode) ? primitive.attributes.at(AttrId::kMode) : "normal"));
             output = BlendSurfaces(*in_surface, *in2_surface, mode);
         } else if (primitive_name == "femerge") {
-            output = MakeTransparentSurface(source_surface.width, source_surface.height);
+            output = FilterSurface(source_surface.width, source_surface.height, true);
             for (const auto& child : primitive.children) {
                 if (LocalName(child.name) != "femergenode") {
                     continue;
                 }
-                const std::string in_key = Trim(child.attributes.count("in") ? child.attributes.at("in") : last_key);
+                const std::string in_key = Trim(child.attributes.count(AttrId::kIn) ? child.attributes.at(AttrId::kIn) : last_key);
                 const auto* merge_surface = resolve_input(in_key.empty() ? last_key : in_key);
                 if (merge_surface == nullptr) {
                     continue;
@@ -4110,15 +3277,15 @@ std::optional<PixelSurface> ExecuteBasicFilterPrimitives(const XmlNode& filter_n
                 output = CompositeSurfaces(*merge_surface, output, "over");
             }
         } else if (primitive_name == "femorphology") {
-            const std::string in_key = Trim(primitive.attributes.count("in") ? primitive.attributes.at("in") : last_key);
+            const std::string in_key = Trim(primitive.attributes.count(AttrId::kIn) ? primitive.attributes.at(AttrId::kIn) : last_key);
             const auto* in_surface = resolve_input(in_key.empty() ? last_key : in_key);
             if (in_surface == nullptr) {
                 return std::nullopt;
             }
             output = ApplyMorphologyFilter(*in_surface, primitive);
         } else if (primitive_name == "fedisplacementmap") {
-            const std::string in_key = Trim(primitive.attributes.count("in") ? primitive.attributes.at("in") : last_key);
-            const std::string in2_key = Trim(primitive.attributes.count("in2") ? primitive.attributes.at("in2") : "SourceGraphic");
+            const std::string in_key = Trim(primitive.attributes.count(AttrId::kIn) ? primitive.attributes.at(AttrId::kIn) : last_key);
+            const std::string in2_key = Trim(primitive.attributes.count(AttrId::kIn2) ? primitive.attributes.at(AttrId::kIn2) : "SourceGraphic");
             const auto* in_surface = resolve_input(in_key.empty() ? last_key : in_key);
             const auto* in2_surface = resolve_input(in2_key.empty() ? "SourceGraphic" : in2_key);
             if (in_surface == nullptr || in2_surface == nullptr) {
@@ -4126,7 +3293,7 @@ std::optional<PixelSurface> ExecuteBasicFilterPrimitives(const XmlNode& filter_n
             }
             output = ApplyDisplacementMapFilter(*in_surface, *in2_surface, primitive);
         } else if (primitive_name == "fetile") {
-            const std::string in_key = Trim(primitive.attributes.count("in") ? primitive.attributes.at("in") : last_key);
+            const std::string in_key = Trim(primitive.attributes.count(AttrId::kIn) ? primitive.attributes.at(AttrId::kIn) : last_key);
             const auto* in_surface = resolve_input(in_key.empty() ? last_key : in_key);
             if (in_surface == nullptr) {
                 return std::nullopt;
@@ -4135,42 +3302,50 @@ std::optional<PixelSurface> ExecuteBasicFilterPrimitives(const XmlNode& filter_n
         } else if (primitive_name == "feturbulence") {
             output = ApplyTurbulenceFilter(source_surface, primitive);
         } else if (primitive_name == "fediffuselighting") {
-            const std::string in_key = Trim(primitive.attributes.count("in") ? primitive.attributes.at("in") : "SourceAlpha");
+            const std::string in_key = Trim(primitive.attributes.count(AttrId::kIn) ? primitive.attributes.at(AttrId::kIn) : "SourceAlpha");
             const auto* in_surface = resolve_input(in_key.empty() ? "SourceAlpha" : in_key);
             if (in_surface == nullptr) {
                 return std::nullopt;
             }
-            output = ApplyLightingFilter(*in_surface, primitive, false);
+            output = ApplyLightingFilter(*in_surface, primitive, false, linear);
         } else if (primitive_name == "fespecularlighting") {
-            const std::string in_key = Trim(primitive.attributes.count("in") ? primitive.attributes.at("in") : "SourceAlpha");
+            const std::string in_key = Trim(primitive.attributes.count(AttrId::kIn) ? primitive.attributes.at(AttrId::kIn) : "SourceAlpha");
             const auto* in_surface = resolve_input(in_key.empty() ? "SourceAlpha" : in_key);
             if (in_surface == nullptr) {
                 return std::nullopt;
             }
-            output = ApplyLightingFilter(*in_surface, primitive, true);
+            output = ApplyLightingFilter(*in_surface, primitive, true, linear);
         } else {
             // Keep rendering moving for still-unsupported primitives.
-            const auto* fallback = resolve_input(last_key);
-            output = fallback != nullptr ? *fallback : source_surface;
+            auto fallback = take_input(last_key);
+            if (!fallback.has_value()) {
+                return std::nullopt;
+            }
+            output = std::move(*fallback);
         }
 
-        auto result_it = primitive.attributes.find("result");
+        auto result_it = primitive.attributes.find(AttrId::kResult);
         std::string result_key;
         if (result_it != primitive.attributes.end()) {
             result_key = Trim(result_it->second);
         }
+        last_result_unnamed = result_key.empty();
         if (result_key.empty()) {
             result_key = "__result_" + std::to_string(++unnamed_index);
         }
-        surfaces[result_key] = std::move(output);
+        ProfileOffscreenPixels(output.width, output.height);
+        surfaces[result_key] = FilterResult{std::move(output), linear};
         last_key = result_key;
     }
 
-    const auto out_it = surfaces.find(last_key);
-    if (out_it == surfaces.end()) {
+    const auto* out = find_result(last_key);
+    if (out == nullptr) {
         return std::nullopt;
     }
-    return out_it->second;
+    if (out->surface.channels == 1) {
+        return FromFilterSurface(ExpandAlpha(out->surface), out->linear);
+    }
+    return FromFilterSurface(out->surface, out->linear);
 }
 
 CGImageRef CreateImageFromSurface(const PixelSurface& surface) {
@@ -4207,7 +3382,7 @@ bool ApplyClipPath(CGContextRef context,
     }
 
     // Check clipPathUnits attribute (default is userSpaceOnUse)
-    const auto units_it = clip_path_node->attributes.find("clipPathUnits");
+    const auto units_it = clip_path_node->attributes.find(AttrId::kClipPathUnits);
     const bool object_bounding_box = (units_it != clip_path_node->attributes.end() &&
                                       Lower(Trim(units_it->second)) == "objectboundingbox");
 
@@ -4310,99 +3485,54 @@ bool ApplyClipPath(CGContextRef context,
         // Handle text specially - convert glyphs to paths
         bool path_added = false;
         if (scaled_geometry.type == ShapeType::kText) {
-            // Extract font attributes
-            const auto font_family_it = child.attributes.find("font-family");
-            const auto font_size_it = child.attributes.find("font-size");
-
-            const std::string font_family = font_family_it != child.attributes.end()
-                ? font_family_it->second
-                : "Helvetica";
-            const double font_size = font_size_it != child.attributes.end()
-                ? std::strtod(font_size_it->second.c_str(), nullptr)
-                : 12.0;
-
-            // Create CTFont
-            CFStringRef family_cf = CFStringCreateWithCString(kCFAllocatorDefault,
-                                                             font_family.c_str(),
-                                                             kCFStringEncodingUTF8);
-            if (family_cf != nullptr) {
-                CTFontRef font = CTFontCreateWithName(family_cf, font_size, nullptr);
-                CFRelease(family_cf);
-
-                if (font != nullptr && !scaled_geometry.text.empty()) {
-                    // Create attributed string
-                    CFStringRef text_cf = CFStringCreateWithCString(kCFAllocatorDefault,
-                                                                   scaled_geometry.text.c_str(),
-                                                                   kCFStringEncodingUTF8);
-                    if (text_cf != nullptr) {
-                        CFStringRef keys[] = {kCTFontAttributeName};
-                        CFTypeRef values[] = {font};
-                        CFDictionaryRef attrs = CFDictionaryCreate(kCFAllocatorDefault,
-                                                                  (const void**)&keys,
-                                                                  (const void**)&values,
-                                                                  1,
-                                                                  &kCFTypeDictionaryKeyCallBacks,
-                                                                  &kCFTypeDictionaryValueCallBacks);
-
-                        CFAttributedStringRef attr_string = CFAttributedStringCreate(kCFAllocatorDefault,
-                                                                                     text_cf,
-                                                                                     attrs);
-                        CFRelease(attrs);
-                        CFRelease(text_cf);
-
-                        if (attr_string != nullptr) {
-                            // Create line
-                            CTLineRef line = CTLineCreateWithAttributedString(attr_string);
-                            CFRelease(attr_string);
-
-                            if (line != nullptr) {
-                                // Save context state and position text
-                                CGContextSaveGState(context);
-                                CGContextTranslateCTM(context,
-                                                     scaled_geometry.x,
-                                                     scaled_geometry.y);
-                                // Flip Y axis for text (SVG coords vs CoreText coords)
-                                CGContextScaleCTM(context, 1.0, -1.0);
-
-                                // Get glyph runs
-                                CFArrayRef runs = CTLineGetGlyphRuns(line);
-                                CFIndex run_count = CFArrayGetCount(runs);
-
-                                for (CFIndex i = 0; i < run_count; i++) {
-                                    CTRunRef run = (CTRunRef)CFArrayGetValueAtIndex(runs, i);
-                                    CFIndex glyph_count = CTRunGetGlyphCount(run);
-
-                                    // Get glyphs and positions
-                                    std::vector<CGGlyph> glyphs(glyph_count);
-                                    std::vector<CGPoint> positions(glyph_count);
-                                    CTRunGetGlyphs(run, CFRangeMake(0, glyph_count), glyphs.data());
-                                    CTRunGetPositions(run, CFRangeMake(0, glyph_count), positions.data());
-
-                                    // Convert each glyph to path
-                                    for (CFIndex j = 0; j < glyph_count; j++) {
-                                        CGPathRef glyph_path = CTFontCreatePathForGlyph(font,
-                                                                                       glyphs[j],
-                                                                                       nullptr);
-                                        if (glyph_path != nullptr) {
-                                            CGContextSaveGState(context);
-                                            CGContextTranslateCTM(context,
-                                                                positions[j].x,
-                                                                positions[j].y);
-                                            CGContextAddPath(context, glyph_path);
-                                            CGContextRestoreGState(context);
-                                            CGPathRelease(glyph_path);
-                                            path_added = true;
-                                        }
-                                    }
-                                }
-
-                                CGContextRestoreGState(context);
-                                CFRelease(line);
-                            }
+            TextShapeKey key;
+            const std::string* font_family = child.attributes.Get(AttrId::kFontFamily);
+            key.font_family = font_family != nullptr ? *font_family : "Helvetica";
+            const std::string* font_size = child.attributes.Get(AttrId::kFontSize);
+            const double size = font_size != nullptr ? std::strtod(font_size->c_str(), nullptr) : 12.0;
+            key.font_size = static_cast<float>(size > 0.0 ? size : 12.0);
+
+            const auto layout = (g_paint.text_layouts != nullptr && !scaled_geometry.text.empty())
+                ? g_paint.text_layouts->Get(scaled_geometry.text, key)
+                : nullptr;
+            if (layout != nullptr && layout->line() != nullptr) {
+                CGContextSaveGState(context);
+                CGContextTranslateCTM(context,
+                                     scaled_geometry.x,
+                                     scaled_geometry.y);
+                // Flip Y axis for text (SVG coords vs CoreText coords)
+                CGContextScaleCTM(context, 1.0, -1.0);
+
+                CFArrayRef runs = CTLineGetGlyphRuns(layout->line());
+                CFIndex run_count = CFArrayGetCount(runs);
+                for (CFIndex i = 0; i < run_count; i++) {
+                    CTRunRef run = (CTRunRef)CFArrayGetValueAtIndex(runs, i);
+                    CFIndex glyph_count = CTRunGetGlyphCount(run);
+
+                    std::vector<CGGlyph> glyphs(glyph_count);
+                    std::vector<CGPoint> positions(glyph_count);
+                    CTRunGetGlyphs(run, CFRangeMake(0, glyph_count), glyphs.data());
+                    CTRunGetPositions(run, CFRangeMake(0, glyph_count), positions.data());
+
+                    // Convert each glyph to path
+                    for (CFIndex j = 0; j < glyph_count; j++) {
+                        CGPathRef glyph_path = CTFontCreatePathForGlyph(layout->font(),
+                                                                       glyphs[j],
+                                                                       nullptr);
+                        if (glyph_path != nullptr) {
+                            CGContextSaveGState(context);
+                            CGContextTranslateCTM(context,
+                                                positions[j].x,
+                                                positions[j].y);
+                            CGContextAddPath(context, glyph_path);
+                            CGContextRestoreGState(context);
+                            CGPathRelease(glyph_path);
+                            path_added = true;
                         }
                     }
-                    CFRelease(font);
                 }
+
+                CGContextRestoreGState(context);
             }
         } else {
             // Regular shapes - use AddGeometryPath
@@ -4416,7 +3546,7 @@ bool ApplyClipPath(CGContextRef context,
         has_path = true;
 
         // Track clip-rule for this shape
-        const auto child_clip_rule_it = child.attributes.find("clip-rule");
+        const auto child_clip_rule_it = child.attributes.find(AttrId::kClipRule);
         const std::string this_clip_rule = child_clip_rule_it != child.attributes.end()
             ? Lower(Trim(child_clip_rule_it->second))
             : "nonzero";
@@ -4460,12 +3590,12 @@ bool ApplyMask(CGContextRef context,
     }
 
     // Check maskUnits attribute (default is objectBoundingBox for masks, unlike clipPath)
-    const auto units_it = mask_node->attributes.find("maskUnits");
+    const auto units_it = mask_node->attributes.find(AttrId::kMaskUnits);
     const bool object_bounding_box = (units_it == mask_node->attributes.end() ||
                                       Lower(Trim(units_it->second)) == "objectboundingbox");
 
     // Check maskContentUnits attribute (default is userSpaceOnUse)
-    const auto content_units_it = mask_node->attributes.find("maskContentUnits");
+    const auto content_units_it = mask_node->attributes.find(AttrId::kMaskContentUnits);
     const bool content_object_bounding_box = (content_units_it != mask_node->attributes.end() &&
                                               Lower(Trim(content_units_it->second)) == "objectboundingbox");
 
@@ -4508,10 +3638,10 @@ bool ApplyMask(CGContextRef context,
     CGRect mask_region;
     if (object_bounding_box) {
         // Parse mask region attributes or use defaults
-        const auto x_it = mask_node->attributes.find("x");
-        const auto y_it = mask_node->attributes.find("y");
-        const auto width_it = mask_node->attributes.find("width");
-        const auto height_it = mask_node->attributes.find("height");
+        const auto x_it = mask_node->attributes.find(AttrId::kX);
+        const auto y_it = mask_node->attributes.find(AttrId::kY);
+        const auto width_it = mask_node->attributes.find(AttrId::kWidth);
+        const auto height_it = mask_node->attributes.find(AttrId::kHeight);
 
         const double x_frac = x_it != mask_node->attributes.end() ? std::stod(x_it->second) : -0.1;
         const double y_frac = y_it != mask_node->attributes.end() ? std::stod(y_it->second) : -0.1;
@@ -4526,10 +3656,10 @@ bool ApplyMask(CGContextRef context,
         );
     } else {
         // userSpaceOnUse - mask region in absolute coordinates
-        const auto x_it = mask_node->attributes.find("x");
-        const auto y_it = mask_node->attributes.find("y");
-        const auto width_it = mask_node->attributes.find("width");
-        const auto height_it = mask_node->attributes.find("height");
+        const auto x_it = mask_node->attributes.find(AttrId::kX);
+        const auto y_it = mask_node->attributes.find(AttrId::kY);
+        const auto width_it = mask_node->attributes.find(AttrId::kWidth);
+        const auto height_it = mask_node->attributes.find(AttrId::kHeight);
 
         const double x_val = x_it != mask_node->attributes.end() ? std::stod(x_it->second) :
                             bbox.origin.x - 0.1 * bbox.size.width;
@@ -4547,10 +3677,11 @@ bool ApplyMask(CGContextRef context,
     const size_t width = static_cast<size_t>(std::max(1.0, std::ceil(mask_region.size.width)));
     const size_t height = static_cast<size_t>(std::max(1.0, std::ceil(mask_region.size.height)));
     const size_t bytes_per_row = width * 4;
+    PixelSurface mask_surface(width, height, true);
 
     CGColorSpaceRef color_space = CGColorSpaceCreateDeviceRGB();
     CGContextRef mask_bitmap = CGBitmapContextCreate(
-        nullptr,
+        mask_surface.rgba.data(),
         width,
         height,
         8,
@@ -4563,6 +3694,7 @@ bool ApplyMask(CGContextRef context,
     if (mask_bitmap == nullptr) {
         return false;
     }
+    ProfileOffscreenPixels(width, height);
 
     // Set up coordinate system for mask rendering
     CGContextTranslateCTM(mask_bitmap, 0.0, static_cast<CGFloat>(height));
@@ -4600,18 +3732,16 @@ bool ApplyMask(CGContextRef context,
                  false); // suppress_current_opacity
     }
 
-    // Extract pixel data from mask bitmap
-    unsigned char* mask_data = static_cast<unsigned char*>(CGBitmapContextGetData(mask_bitmap));
-    if (mask_data == nullptr) {
-        CGContextRelease(mask_bitmap);
-        return false;
-    }
+    CGContextRelease(mask_bitmap);
 
     // Convert RGBA mask to grayscale alpha mask based on luminance
     // SVG masks use luminance: L = 0.299*R + 0.587*G + 0.114*B
     // White (255,255,255) = fully visible, Black (0,0,0) = fully transparent
+    // Pixel i is written to byte i, which its own and earlier pixels have
+    // already been read from, so the gray mask reuses the RGBA buffer.
     const size_t pixel_count = width * height;
-    std::vector<unsigned char> alpha_data(pixel_count);
+    unsigned char* mask_data = mask_surface.rgba.data();
+    unsigned char* alpha_data = mask_surface.rgba.data();
 
     for (size_t i = 0; i < pixel_count; i++) {
         const size_t offset = i * 4;
@@ -4628,12 +3758,10 @@ bool ApplyMask(CGContextRef context,
         alpha_data[i] = static_cast<unsigned char>(combined_alpha * 255.0);
     }
 
-    CGContextRelease(mask_bitmap);
-
     // Create grayscale image from alpha data
     CGColorSpaceRef gray_space = CGColorSpaceCreateDeviceGray();
     CGContextRef alpha_context = CGBitmapContextCreate(
-        alpha_data.data(),
+        alpha_data,
         width,
         height,
         8,
@@ -4646,6 +3774,7 @@ bool ApplyMask(CGContextRef context,
     if (alpha_context == nullptr) {
         return false;
     }
+    ProfileOffscreenPixels(width, height);
 
     CGImageRef mask_image = CGBitmapContextCreateImage(alpha_context);
     CGContextRelease(alpha_context);
@@ -4662,8 +3791,8 @@ bool ApplyMask(CGContextRef context,
 }
 
 bool PaintNodeWithFilter(const XmlNode& node,
-                         const std::map<std::string, std::string>& inline_style,
-                         const std::map<std::string, std::string>& matched_css_properties,
+                         const PropertyMap& inline_style,
+                         const PropertyMap& matched_css_properties,
                          const ResolvedStyle& node_style,
                          const StyleResolver& style_resolver,
                          const GeometryEngine& geometry_engine,
@@ -4701,8 +3830,16 @@ bool PaintNodeWithFilter(const XmlNode& node,
         return false;
     }
 
-    const auto filtered_surface = ExecuteBasicFilterPrimitives(*filter_it->second,
+    const ScopedPaintCost filter_cost(PaintCostKind::kFilter);
+    // Nothing the chain produces could survive an empty filter region.
+    const PixelBounds filter_region = ComputeFilterRegionBounds(*filter_it->second, *source_surface, geometry_engine);
+    if (IsEmptyBounds(filter_region)) {
+        return true;
+    }
+    auto filtered_surface = ExecuteBasicFilterPrimitives(*filter_it->second,
                                                                *source_surface,
+                                                               node_style,
+                                                               filter_region,
                                                                style_resolver,
                                                                geometry_engine,
                                                                gradients,
@@ -4715,8 +3852,10 @@ bool PaintNodeWithFilter(const XmlNode& node,
         return false;
     }
 
-    const PixelBounds filter_region = ComputeFilterRegionBounds(*filter_it->second, *source_surface, geometry_engine);
-    const PixelSurface clipped_surface = ClipSurfaceToBounds(*filtered_surface, filter_region);
+    const PixelSurface clipped_surface = ClipSurfaceToBounds(std::move(*filtered_surface), filter_region);
+    if (IsEmptyBounds(clipped_surface.content)) {
+        return true;
+    }
     CGImageRef filtered_image = CreateImageFromSurface(clipped_surface);
     if (filtered_image == nullptr) {
         return false;
@@ -4888,18 +4027,20 @@ bool PaintPatternFill(CGContextRef context,
     const size_t tile_px_w = static_cast<size_t>(std::max(1.0, std::ceil(tile_w)));
     const size_t tile_px_h = static_cast<size_t>(std::max(1.0, std::ceil(tile_h)));
 
+    PixelSurface tile_surface(tile_px_w, tile_px_h, true);
     CGColorSpaceRef tile_cs = CGColorSpaceCreateDeviceRGB();
-    CGContextRef tile_context = CGBitmapContextCreate(nullptr,
+    CGContextRef tile_context = CGBitmapContextCreate(tile_surface.rgba.data(),
                                                       tile_px_w,
                                                       tile_px_h,
                                                       8,
-                                                      0,
+                                                      tile_px_w * 4,
                                                       tile_cs,
                                                       static_cast<CGBitmapInfo>(kCGImageAlphaPremultipliedLast));
     CGColorSpaceRelease(tile_cs);
     if (tile_context == nullptr) {
         return false;
     }
+    ProfileOffscreenPixels(tile_px_w, tile_px_h);
 
     // Mirror the renderer's Y-down coordinate convention in tile space.
     CGContextTranslateCTM(tile_context, 0.0, static_cast<CGFloat>(tile_px_h));
@@ -5000,16 +4141,6 @@ bool PaintPatternFill(CGContextRef context,
     return true;
 }
 
-void CollectNodesByID(const XmlNode& node, NodeIdMap& id_map) {
-    const auto id_it = node.attributes.find("id");
-    if (id_it != node.attributes.end() && !id_it->second.empty()) {
-        id_map.emplace(id_it->second, &node);
-    }
-    for (const auto& child : node.children) {
-        CollectNodesByID(child, id_map);
-    }
-}
-
 bool AddGeometryPath(CGContextRef context, const ShapeGeometry& geometry) {
     switch (geometry.type) {
         case ShapeType::kRect: {
@@ -5085,70 +4216,6 @@ bool AddGeometryPath(CGContextRef context, const ShapeGeometry& geometry) {
     }
 }
 
-std::string ResolveGenericFontFamily(const std::string& family) {
-    const std::string normalized = Lower(Trim(family));
-    if (normalized == "sans-serif") {
-        return "Helvetica";
-    }
-    if (normalized == "serif") {
-        return "Times New Roman";
-    }
-    if (normalized == "monospace") {
-        return "Courier";
-    }
-    return Trim(family);
-}
-
-static std::string SystemFallbackFamily() {
-    return "Helvetica";
-}
-
-std::vector<std::string> ResolveTextFontFamilies(const std::string& font_family) {
-    std::vector<std::string> families;
-    std::stringstream stream(font_family);
-    std::string candidate;
-    while (std::getline(stream, candidate, ',')) {
-        candidate = Trim(candidate);
-        if (candidate.size() >= 2 &&
-            ((candidate.front() == '"' && candidate.back() == '"') ||
-             (candidate.front() == '\'' && candidate.back() == '\''))) {
-            candidate = Trim(candidate.substr(1, candidate.size() - 2));
-        }
-        candidate = ResolveGenericFontFamily(candidate);
-        if (!candidate.empty()) {
-            families.push_back(candidate);
-        }
-    }
-    if (families.empty()) {
-        families.push_back(SystemFallbackFamily());
-    }
-    return families;
-}
-
-bool FontFamilyExists(const std::string& family_name) {
-    static const std::set<std::string> available_families = []() {
-        std::set<std::string> names;
-        CFArrayRef families = CTFontManagerCopyAvailableFontFamilyNames();
-        if (families != nullptr) {
-            const CFIndex count = CFArrayGetCount(families);
-            for (CFIndex i = 0; i < count; ++i) {
-                const auto* item = static_cast<CFStringRef>(CFArrayGetValueAtIndex(families, i));
-                if (item == nullptr) {
-                    continue;
-                }
-                char buffer[256];
-                if (CFStringGetCString(item, buffer, sizeof(buffer), kCFStringEncodingUTF8)) {
-                    names.insert(Lower(Trim(buffer)));
-                }
-            }
-            CFRelease(families);
-        }
-        return names;
-    }();
-
-    return available_families.find(Lower(Trim(family_name))) != available_families.end();
-}
-
 struct TextRun {
     std::string text;
     double x = 0.0;
@@ -5160,194 +4227,6 @@ struct TextRun {
     ResolvedStyle style;
 };
 
-struct PathSegment {
-    CGPoint start = CGPointZero;
-    CGPoint end = CGPointZero;
-    double length = 0.0;
-};
-
-struct FlattenPathContext {
-    std::vector<PathSegment> segments;
-    CGPoint current = CGPointZero;
-    CGPoint subpath_start = CGPointZero;
-    bool has_current = false;
-};
-
-CGPoint EvaluateQuadraticBezier(CGPoint p0, CGPoint p1, CGPoint p2, double t) {
-    const double one_minus_t = 1.0 - t;
-    const double x = (one_minus_t * one_minus_t * p0.x) +
-        (2.0 * one_minus_t * t * p1.x) +
-        (t * t * p2.x);
-    const double y = (one_minus_t * one_minus_t * p0.y) +
-        (2.0 * one_minus_t * t * p1.y) +
-        (t * t * p2.y);
-    return CGPointMake(static_cast<CGFloat>(x), static_cast<CGFloat>(y));
-}
-
-CGPoint EvaluateCubicBezier(CGPoint p0, CGPoint p1, CGPoint p2, CGPoint p3, double t) {
-    const double one_minus_t = 1.0 - t;
-    const double x = (one_minus_t * one_minus_t * one_minus_t * p0.x) +
-        (3.0 * one_minus_t * one_minus_t * t * p1.x) +
-        (3.0 * one_minus_t * t * t * p2.x) +
-        (t * t * t * p3.x);
-    const double y = (one_minus_t * one_minus_t * one_minus_t * p0.y) +
-        (3.0 * one_minus_t * one_minus_t * t * p1.y) +
-        (3.0 * one_minus_t * t * t * p2.y) +
-        (t * t * t * p3.y);
-    return CGPointMake(static_cast<CGFloat>(x), static_cast<CGFloat>(y));
-}
-
-void AppendPathSegment(FlattenPathContext* context, CGPoint start, CGPoint end) {
-    if (context == nullptr) {
-        return;
-    }
-    const double dx = static_cast<double>(end.x - start.x);
-    const double dy = static_cast<double>(end.y - start.y);
-    const double length = std::sqrt((dx * dx) + (dy * dy));
-    if (length <= 1e-9) {
-        return;
-    }
-    PathSegment segment;
-    segment.start = start;
-    segment.end = end;
-    segment.length = length;
-    context->segments.push_back(segment);
-}
-
-void FlattenPathCallback(void* info, const CGPathElement* element) {
-    auto* context = static_cast<FlattenPathContext*>(info);
-    if (context == nullptr || element == nullptr) {
-        return;
-    }
-
-    switch (element->type) {
-        case kCGPathElementMoveToPoint:
-            context->current = element->points[0];
-            context->subpath_start = context->current;
-            context->has_current = true;
-            break;
-        case kCGPathElementAddLineToPoint:
-            if (!context->has_current) {
-                break;
-            }
-            AppendPathSegment(context, context->current, element->points[0]);
-            context->current = element->points[0];
-            break;
-        case kCGPathElementAddQuadCurveToPoint:
-            if (!context->has_current) {
-                break;
-            }
-            {
-                CGPoint last = context->current;
-                constexpr int kSteps = 24;
-                for (int step = 1; step <= kSteps; ++step) {
-                    const double t = static_cast<double>(step) / static_cast<double>(kSteps);
-                    const CGPoint point = EvaluateQuadraticBezier(context->current,
-                                                                  element->points[0],
-                                                                  element->points[1],
-                                                                  t);
-                    AppendPathSegment(context, last, point);
-                    last = point;
-                }
-                context->current = element->points[1];
-            }
-            break;
-        case kCGPathElementAddCurveToPoint:
-            if (!context->has_current) {
-                break;
-            }
-            {
-                CGPoint last = context->current;
-                constexpr int kSteps = 32;
-                for (int step = 1; step <= kSteps; ++step) {
-                    const double t = static_cast<double>(step) / static_cast<double>(kSteps);
-                    const CGPoint point = EvaluateCubicBezier(context->current,
-                                                              element->points[0],
-                                                              element->points[1],
-                                                              element->points[2],
-                                                              t);
-                    AppendPathSegment(context, last, point);
-                    last = point;
-                }
-                context->current = element->points[2];
-            }
-            break;
-        case kCGPathElementCloseSubpath:
-            if (!context->has_current) {
-                break;
-            }
-            AppendPathSegment(context, context->current, context->subpath_start);
-            context->current = context->subpath_start;
-            break;
-    }
-}
-
-std::vector<PathSegment> FlattenPathSegments(CGPathRef path) {
-    if (path == nullptr) {
-        return {};
-    }
-    FlattenPathContext context;
-    CGPathApply(path, &context, FlattenPathCallback);
-    return context.segments;
-}
-
-double PathLength(const std::vector<PathSegment>& segments) {
-    double length = 0.0;
-    for (const auto& segment : segments) {
-        length += segment.length;
-    }
-    return length;
-}
-
-bool PointAndTangentAtDistance(const std::vector<PathSegment>& segments,
-                               double distance,
-                               CGPoint& point,
-                               CGPoint& tangent) {
-    if (segments.empty()) {
-        return false;
-    }
-
-    const double total_length = PathLength(segments);
-    if (!(total_length > 0.0)) {
-        return false;
-    }
-
-    const double target = std::clamp(distance, 0.0, total_length);
-    double traversed = 0.0;
-    for (const auto& segment : segments) {
-        if (!(segment.length > 0.0)) {
-            continue;
-        }
-        if (target <= traversed + segment.length) {
-            const double t = (target - traversed) / segment.length;
-            const double px = static_cast<double>(segment.start.x) +
-                (static_cast<double>(segment.end.x - segment.start.x) * t);
-            const double py = static_cast<double>(segment.start.y) +
-                (static_cast<double>(segment.end.y - segment.start.y) * t);
-            point = CGPointMake(static_cast<CGFloat>(px), static_cast<CGFloat>(py));
-
-            const double dx = static_cast<double>(segment.end.x - segment.start.x);
-            const double dy = static_cast<double>(segment.end.y - segment.start.y);
-            const double inv_length = 1.0 / segment.length;
-            tangent = CGPointMake(static_cast<CGFloat>(dx * inv_length), static_cast<CGFloat>(dy * inv_length));
-            return true;
-        }
-        traversed += segment.length;
-    }
-
-    const auto& tail = segments.back();
-    point = tail.end;
-    const double dx = static_cast<double>(tail.end.x - tail.start.x);
-    const double dy = static_cast<double>(tail.end.y - tail.start.y);
-    const double length = std::sqrt((dx * dx) + (dy * dy));
-    if (!(length > 1e-9)) {
-        tangent = CGPointMake(1.0, 0.0);
-        return true;
-    }
-    tangent = CGPointMake(static_cast<CGFloat>(dx / length), static_cast<CGFloat>(dy / length));
-    return true;
-}
-
 std::vector<std::string> SplitUTF8Codepoints(const std::string& text) {
     std::vector<std::string> codepoints;
     size_t index = 0;
@@ -5373,94 +4252,45 @@ std::vector<std::string> SplitUTF8Codepoints(const std::string& text) {
     return codepoints;
 }
 
-CGPathRef CopyPathForTextPathNode(const XmlNode& text_path_node,
-                                  const GeometryEngine& geometry_engine,
-                                  const NodeIdMap& id_map) {
+const XmlNode* FindTextPathTarget(const XmlNode& text_path_node, const NodeIdMap& id_map) {
     const auto href = ExtractHrefValue(text_path_node);
     if (!href.has_value() || href->empty() || href->front() != '#') {
         return nullptr;
     }
-    const auto target_it = id_map.find(href->substr(1));
-    if (target_it == id_map.end() || target_it->second == nullptr) {
-        return nullptr;
-    }
-
-    const auto geometry = geometry_engine.Build(*target_it->second);
-    if (!geometry.has_value()) {
-        return nullptr;
-    }
-    CGColorSpaceRef color_space = CGColorSpaceCreateDeviceRGB();
-    CGContextRef temp_context = CGBitmapContextCreate(nullptr,
-                                                      1,
-                                                      1,
-                                                      8,
-                                                      0,
-                                                      color_space,
-                                                      static_cast<CGBitmapInfo>(kCGImageAlphaPremultipliedLast));
-    CGColorSpaceRelease(color_space);
-    if (temp_context == nullptr) {
+    const auto target_it = id_map.find(std::string(href->substr(1)));
+    if (target_it == id_map.end()) {
         return nullptr;
     }
-
-    CGContextBeginPath(temp_context);
-    if (!AddGeometryPath(temp_context, *geometry)) {
-        CGContextRelease(temp_context);
-        return nullptr;
-    }
-    CGPathRef path = CGContextCopyPath(temp_context);
-    CGContextRelease(temp_context);
-    return path;
+    return target_it->second;
 }
 
 double ParseTextPathStartOffset(const XmlNode& text_path_node,
                                 double path_length,
                                 const GeometryEngine& geometry_engine) {
-    const auto start_offset_it = text_path_node.attributes.find("startOffset");
-    if (start_offset_it == text_path_node.attributes.end()) {
-        return 0.0;
-    }
-
-    const std::string raw = Trim(start_offset_it->second);
-    if (raw.empty()) {
+    const SvgLength* start_offset = text_path_node.attributes.GetLength(AttrId::kStartOffset);
+    if (start_offset == nullptr) {
         return 0.0;
     }
-    if (!raw.empty() && raw.back() == '%') {
-        return ParseDouble(raw, 0.0) * 0.01 * path_length;
+    if (start_offset->unit == LengthUnit::kPercent) {
+        return start_offset->value * 0.01 * path_length;
     }
-
-    return ParseSVGLength(raw,
-                          0.0,
-                          SvgLengthAxis::kX,
-                          std::max(geometry_engine.viewport_width(), 1.0),
-                          std::max(geometry_engine.viewport_height(), 1.0));
-}
-
-std::string FirstLengthComponent(const std::string& raw) {
-    std::string normalized = raw;
-    std::replace(normalized.begin(), normalized.end(), ',', ' ');
-    std::stringstream stream(normalized);
-    std::string token;
-    stream >> token;
-    return token;
+    return start_offset->ToPixels(LengthAxis::kX,
+                                  std::max(geometry_engine.viewport_width(), 1.0),
+                                  std::max(geometry_engine.viewport_height(), 1.0));
 }
 
+// Only the first entry of an x/y/dx/dy list is honoured.
 double ParseTextLengthAttr(const XmlNode& node,
-                           const char* key,
+                           AttrId key,
                            double fallback,
-                           SvgLengthAxis axis,
+                           LengthAxis axis,
                            const GeometryEngine& geometry_engine) {
-    const auto it = node.attributes.find(key);
-    if (it == node.attributes.end()) {
-        return fallback;
-    }
-    const double viewport_width = std::max(geometry_engine.viewport_width(), 1.0);
-    const double viewport_height = std::max(geometry_engine.viewport_height(), 1.0);
-    const std::string token = FirstLengthComponent(it->second);
-    return ParseSVGLength(token.empty() ? it->second : token,
-                          fallback,
-                          axis,
-                          viewport_width,
-                          viewport_height);
+    return ParseSVGLengthAttr(node.attributes,
+                              key,
+                              fallback,
+                              axis,
+                              std::max(geometry_engine.viewport_width(), 1.0),
+                              std::max(geometry_engine.viewport_height(), 1.0));
 }
 
 std::string ResolveTextReference(const XmlNode& tref_node, const NodeIdMap& id_map) {
@@ -5468,7 +4298,7 @@ std::string ResolveTextReference(const XmlNode& tref_node, const NodeIdMap& id_m
     if (!href.has_value() || href->empty() || href->front() != '#') {
         return {};
     }
-    const auto target_it = id_map.find(href->substr(1));
+    const auto target_it = id_map.find(std::string(href->substr(1)));
     if (target_it == id_map.end() || target_it->second == nullptr) {
         return {};
     }
@@ -5501,16 +4331,16 @@ void CollectTextRuns(const XmlNode& node,
         run.style = child_style;
         run.text = (local_name == "tref") ? ResolveTextReference(child, id_map) : child.text;
 
-        if (child.attributes.find("x") != child.attributes.end()) {
+        if (child.attributes.find(AttrId::kX) != child.attributes.end()) {
             run.has_x = true;
-            run.x = ParseTextLengthAttr(child, "x", 0.0, SvgLengthAxis::kX, geometry_engine);
+            run.x = ParseTextLengthAttr(child, AttrId::kX, 0.0, LengthAxis::kX, geometry_engine);
         }
-        if (child.attributes.find("y") != child.attributes.end()) {
+        if (child.attributes.find(AttrId::kY) != child.attributes.end()) {
             run.has_y = true;
-            run.y = ParseTextLengthAttr(child, "y", 0.0, SvgLengthAxis::kY, geometry_engine);
+            run.y = ParseTextLengthAttr(child, AttrId::kY, 0.0, LengthAxis::kY, geometry_engine);
         }
-        run.dx = ParseTextLengthAttr(child, "dx", 0.0, SvgLengthAxis::kX, geometry_engine);
-        run.dy = ParseTextLengthAttr(child, "dy", 0.0, SvgLengthAxis::kY, geometry_engine);
+        run.dx = ParseTextLengthAttr(child, AttrId::kDx, 0.0, LengthAxis::kX, geometry_engine);
+        run.dy = ParseTextLengthAttr(child, AttrId::kDy, 0.0, LengthAxis::kY, geometry_engine);
 
         if (!run.text.empty()) {
             runs.push_back(std::move(run));
@@ -5526,191 +4356,21 @@ void CollectTextRuns(const XmlNode& node,
     }
 }
 
-static bool FontFamilyExistsFast(const std::string& family_name) {
-    return FontFamilyExists(family_name);
-}
-
-static bool IsGenericFamily(const std::string& v) {
-    const std::string s = Lower(Trim(v));
-    return s == "serif" ||
-           s == "sans-serif" ||
-           s == "monospace" ||
-           s == "cursive" ||
-           s == "fantasy" ||
-           s == "system-ui" ||
-           s == "ui-serif" ||
-           s == "ui-sans-serif" ||
-           s == "ui-monospace" ||
-           s == "ui-rounded" ||
-           s == "emoji" ||
-           s == "math" ||
-           s == "fangsong";
-}
-static std::string MapGenericToAppleFamily(const std::string& generic) {
-    const std::string g = Lower(Trim(generic));
-    if (g == "sans-serif" || g == "ui-sans-serif" || g == "system-ui") return "Helvetica";
-    if (g == "serif" || g == "ui-serif") return "Times New Roman";
-    if (g == "monospace" || g == "ui-monospace") return "Courier";
-    if (g == "ui-rounded") return "Helvetica";
-    if (g == "cursive") return "Snell Roundhand";
-    if (g == "fantasy") return "Papyrus";
-    if (g == "emoji") return "Apple Color Emoji";
-    return "";
-}
-
-std::string ResolveCssFontFamily(const std::string& font_family_css) {
-    const auto candidates = ResolveTextFontFamilies(font_family_css);
-
-    for (const auto& raw : candidates) {
-        const std::string name = Trim(raw);
-        if (name.empty()) continue;
-
-        if (IsGenericFamily(name)) {
-            const std::string mapped = MapGenericToAppleFamily(name);
-            if (!mapped.empty() && FontFamilyExistsFast(mapped)) {
-                return mapped;
-            }
-            continue;
-        }
-
-        if (FontFamilyExistsFast(name)) {
-            return name;
-        }
-    }
-
-    const std::string fallback = SystemFallbackFamily();
-    if (!fallback.empty() && FontFamilyExistsFast(fallback)) {
-        return fallback;
-    }
-
-    return !candidates.empty() ? candidates.front() : SystemFallbackFamily();
-}
-
-CTFontRef CreateTextFontForStyle(const ResolvedStyle& style) {
-    const std::string resolved_family = ResolveCssFontFamily(style.font_family);
-    const CGFloat font_size = style.font_size > 0.0f ? style.font_size : 16.0f;
-
-    CFStringRef family_name = CFStringCreateWithCString(kCFAllocatorDefault,
-                                                         resolved_family.c_str(),
-                                                         kCFStringEncodingUTF8);
-    CTFontRef font = nullptr;
-
-    const void* keys[] = {kCTFontFamilyNameAttribute};
-    const void* values[] = {family_name};
-    CFDictionaryRef descriptor_attrs = CFDictionaryCreate(kCFAllocatorDefault,
-                                                          keys,
-                                                          values,
-                                                          1,
-                                                          &kCFTypeDictionaryKeyCallBacks,
-                                                          &kCFTypeDictionaryValueCallBacks);
-    if (descriptor_attrs != nullptr) {
-        CTFontDescriptorRef descriptor = CTFontDescriptorCreateWithAttributes(descriptor_attrs);
-        if (descriptor != nullptr) {
-            font = CTFontCreateWithFontDescriptor(descriptor, font_size, nullptr);
-            CFRelease(descriptor);
-        }
-        CFRelease(descriptor_attrs);
-    }
-
-    if (font == nullptr) {
-        font = CTFontCreateWithName(family_name, font_size, nullptr);
-    }
-
-    CTFontSymbolicTraits desired_traits = 0;
-    if (style.font_weight >= 600) {
-        desired_traits |= kCTFontBoldTrait;
-    }
-    if (style.font_style == "italic" || style.font_style == "oblique") {
-        desired_traits |= kCTFontItalicTrait;
-    }
-    if (desired_traits != 0) {
-        if (CTFontRef trait_font = CTFontCreateCopyWithSymbolicTraits(font,
-                                                                       font_size,
-                                                                       nullptr,
-                                                                       desired_traits,
-                                                                       kCTFontBoldTrait | kCTFontItalicTrait)) {
-            CFRelease(font);
-            font = trait_font;
-        }
+std::shared_ptr<const TextLayout> LayoutTextRun(const TextRun& run) {
+    if (run.text.empty() || g_paint.text_layouts == nullptr) {
+        return nullptr;
     }
-
-    CFRelease(family_name);
-    return font;
-}
-
-double CountSpaces(const std::string& text) {
-    return static_cast<double>(std::count(text.begin(), text.end(), ' '));
+    return g_paint.text_layouts->Get(run.text, run.style);
 }
 
 double MeasureTextRunWidth(const TextRun& run) {
-    if (run.text.empty()) {
-        return 0.0;
-    }
-
-    CTFontRef font = CreateTextFontForStyle(run.style);
-    if (font == nullptr) {
-        return 0.0;
-    }
-
-    CFStringRef text = CFStringCreateWithCString(kCFAllocatorDefault, run.text.c_str(), kCFStringEncodingUTF8);
-    if (text == nullptr) {
-        CFRelease(font);
-        return 0.0;
-    }
-
-    CGFloat fill_components[] = {0.0, 0.0, 0.0, 1.0};
-    CGColorSpaceRef cs = CGColorSpaceCreateDeviceRGB();
-    CGColorRef color = CGColorCreate(cs, fill_components);
-    CFNumberRef kern = nullptr;
-    const CGFloat kern_value = run.style.letter_spacing;
-    if (std::abs(kern_value) > 0.0001) {
-        kern = CFNumberCreate(kCFAllocatorDefault, kCFNumberCGFloatType, &kern_value);
-    }
-
-    std::array<CFTypeRef, 3> keys = {kCTFontAttributeName, kCTForegroundColorAttributeName, kCTKernAttributeName};
-    std::array<CFTypeRef, 3> values = {font, color, kern};
-    CFIndex count = kern != nullptr ? 3 : 2;
-    CFDictionaryRef attrs = CFDictionaryCreate(kCFAllocatorDefault,
-                                               reinterpret_cast<const void**>(keys.data()),
-                                               reinterpret_cast<const void**>(values.data()),
-                                               count,
-                                               &kCFTypeDictionaryKeyCallBacks,
-                                               &kCFTypeDictionaryValueCallBacks);
-
-    CFAttributedStringRef attr_string = CFAttributedStringCreate(kCFAllocatorDefault, text, attrs);
-    CTLineRef line = CTLineCreateWithAttributedString(attr_string);
-    double width = CTLineGetTypographicBounds(line, nullptr, nullptr, nullptr);
-    if (!std::isfinite(width)) {
-        width = 0.0;
-    }
-    width += run.style.word_spacing * CountSpaces(run.text);
-
-    CFRelease(line);
-    CFRelease(attr_string);
-    CFRelease(attrs);
-    if (kern != nullptr) {
-        CFRelease(kern);
-    }
-    CGColorRelease(color);
-    CGColorSpaceRelease(cs);
-    CFRelease(text);
-    CFRelease(font);
-    return width;
+    const auto layout = LayoutTextRun(run);
+    return layout != nullptr ? layout->width() : 0.0;
 }
 
 double DrawTextRun(CGContextRef context, const TextRun& run, double x, double y) {
-    if (run.text.empty()) {
-        return 0.0;
-    }
-
-    CTFontRef font = CreateTextFontForStyle(run.style);
-    if (font == nullptr) {
-        return 0.0;
-    }
-
-    CFStringRef text = CFStringCreateWithCString(kCFAllocatorDefault, run.text.c_str(), kCFStringEncodingUTF8);
-    if (text == nullptr) {
-        CFRelease(font);
+    const auto layout = LayoutTextRun(run);
+    if (layout == nullptr || layout->line() == nullptr) {
         return 0.0;
     }
 
@@ -5728,34 +4388,11 @@ double DrawTextRun(CGContextRef context, const TextRun& run, double x, double y)
     const CGFloat components[] = {fill_r, fill_g, fill_b, fill_a};
     CGColorSpaceRef cs = CGColorSpaceCreateDeviceRGB();
     CGColorRef color = CGColorCreate(cs, components);
-
-    CFNumberRef kern = nullptr;
-    const CGFloat kern_value = run.style.letter_spacing;
-    if (std::abs(kern_value) > 0.0001) {
-        kern = CFNumberCreate(kCFAllocatorDefault, kCFNumberCGFloatType, &kern_value);
-    }
-
-    std::array<CFTypeRef, 3> keys = {kCTFontAttributeName, kCTForegroundColorAttributeName, kCTKernAttributeName};
-    std::array<CFTypeRef, 3> values = {font, color, kern};
-    CFIndex count = kern != nullptr ? 3 : 2;
-    CFDictionaryRef attrs = CFDictionaryCreate(kCFAllocatorDefault,
-                                               reinterpret_cast<const void**>(keys.data()),
-                                               reinterpret_cast<const void**>(values.data()),
-                                               count,
-                                               &kCFTypeDictionaryKeyCallBacks,
-                                               &kCFTypeDictionaryValueCallBacks);
-
-    CFAttributedStringRef attr_string = CFAttributedStringCreate(kCFAllocatorDefault, text, attrs);
-    CTLineRef line = CTLineCreateWithAttributedString(attr_string);
-    CGFloat ascent = 0.0;
-    CGFloat descent = 0.0;
-    double line_width = CTLineGetTypographicBounds(line, &ascent, &descent, nullptr);
-    if (!std::isfinite(line_width)) {
-        line_width = 0.0;
-    }
-    line_width += run.style.word_spacing * CountSpaces(run.text);
+    const double line_width = layout->width();
 
     CGContextSaveGState(context);
+    const bool drawn_from_atlas = g_paint.glyph_atlas != nullptr &&
+        g_paint.glyph_atlas->DrawLine(context, *layout, x, y, color);
     // CoreText glyphs are defined in a Y-up text space. Since the renderer
     // flips the global CTM to SVG's Y-down coordinates, unflip locally for
     // text so glyphs are not mirrored/inverted.
@@ -5763,22 +4400,26 @@ double DrawTextRun(CGContextRef context, const TextRun& run, double x, double y)
     CGContextScaleCTM(context, 1.0, -1.0);
     CGContextSetTextMatrix(context, CGAffineTransformIdentity);
     CGContextSetTextPosition(context, 0.0, 0.0);
-    CTLineDraw(line, context);
+    // The shared line takes its color from the context.
+    CGContextSetFillColorWithColor(context, color);
+    if (!drawn_from_atlas) {
+        CTLineDraw(layout->line(), context);
+    }
 
     const std::string text_decoration = Lower(Trim(run.style.text_decoration));
     if (text_decoration != "none") {
         CGContextSetStrokeColorWithColor(context, color);
-        const CGFloat underline_thickness = std::max(CTFontGetUnderlineThickness(font), 1.0);
+        const CGFloat underline_thickness = std::max(CTFontGetUnderlineThickness(layout->font()), 1.0);
         CGContextSetLineWidth(context, underline_thickness);
 
         if (text_decoration.find("underline") != std::string::npos) {
-            const CGFloat underline_y = CTFontGetUnderlinePosition(font);
+            const CGFloat underline_y = CTFontGetUnderlinePosition(layout->font());
             CGContextMoveToPoint(context, 0.0, underline_y);
             CGContextAddLineToPoint(context, static_cast<CGFloat>(line_width), underline_y);
             CGContextStrokePath(context);
         }
         if (text_decoration.find("line-through") != std::string::npos) {
-            const CGFloat strike_y = ascent * 0.35f;
+            const CGFloat strike_y = static_cast<CGFloat>(layout->ascent()) * 0.35f;
             CGContextMoveToPoint(context, 0.0, strike_y);
             CGContextAddLineToPoint(context, static_cast<CGFloat>(line_width), strike_y);
             CGContextStrokePath(context);
@@ -5786,16 +4427,8 @@ double DrawTextRun(CGContextRef context, const TextRun& run, double x, double y)
     }
     CGContextRestoreGState(context);
 
-    CFRelease(line);
-    CFRelease(attr_string);
-    CFRelease(attrs);
-    if (kern != nullptr) {
-        CFRelease(kern);
-    }
     CGColorRelease(color);
     CGColorSpaceRelease(cs);
-    CFRelease(text);
-    CFRelease(font);
     return line_width;
 }
 
@@ -5817,13 +4450,22 @@ void DrawTextAlongPath(CGContextRef context,
         return;
     }
 
-    CGPathRef path = CopyPathForTextPathNode(*text_path_node, geometry_engine, id_map);
-    if (path == nullptr) {
+    const XmlNode* target = FindTextPathTarget(*text_path_node, id_map);
+    if (target == nullptr) {
         return;
     }
-    const auto segments = FlattenPathSegments(path);
-    CGPathRelease(path);
-    const double total_length = PathLength(segments);
+    // Flatten finely enough for the current device scale; glyph placement
+    // then binary-searches the cached arc-length table.
+    const CGAffineTransform ctm = CGContextGetCTM(context);
+    const double device_scale = std::sqrt(std::fabs(static_cast<double>(ctm.a * ctm.d - ctm.b * ctm.c)));
+    const double tolerance = FlatteningTolerance(device_scale);
+    std::optional<FlattenedPathCache> local_cache;
+    FlattenedPathCache* cache = g_paint.path_cache;
+    if (cache == nullptr) {
+        cache = &local_cache.emplace();
+    }
+    const FlattenedPath& flattened = *cache->Get(*target, geometry_engine, tolerance);
+    const double total_length = flattened.length();
     if (!(total_length > 0.0)) {
         return;
     }
@@ -5863,16 +4505,16 @@ void DrawTextAlongPath(CGContextRef context,
                 continue;
             }
 
-            CGPoint point = CGPointZero;
-            CGPoint tangent = CGPointMake(1.0, 0.0);
-            if (PointAndTangentAtDistance(segments, pen + advance * 0.5, point, tangent)) {
-                const double angle = std::atan2(static_cast<double>(tangent.y), static_cast<double>(tangent.x));
-                const double normal_x = -static_cast<double>(tangent.y);
-                const double normal_y = static_cast<double>(tangent.x);
+            Point point;
+            Point tangent{1.0, 0.0};
+            if (flattened.PointAndTangentAt(pen + advance * 0.5, point, tangent)) {
+                const double angle = std::atan2(tangent.y, tangent.x);
+                const double normal_x = -tangent.y;
+                const double normal_y = tangent.x;
                 CGContextSaveGState(context);
                 CGContextTranslateCTM(context,
-                                      static_cast<CGFloat>(static_cast<double>(point.x) + normal_x * baseline_shift),
-                                      static_cast<CGFloat>(static_cast<double>(point.y) + normal_y * baseline_shift));
+                                      static_cast<CGFloat>(point.x + normal_x * baseline_shift),
+                                      static_cast<CGFloat>(point.y + normal_y * baseline_shift));
                 CGContextRotateCTM(context, static_cast<CGFloat>(angle));
                 DrawTextRun(context, glyph_run, -advance * 0.5, 0.0);
                 CGContextRestoreGState(context);
@@ -6021,7 +4663,7 @@ bool MaybeRenderNamespaceBusinessPieChart(const XmlNode& node,
                                           const ResolvedStyle& style,
                                           CGContextRef context,
                                           const NodeIdMap& id_map) {
-    const auto id_it = node.attributes.find("id");
+    const auto id_it = node.attributes.find(AttrId::kId);
     if (id_it == node.attributes.end() || Trim(id_it->second) != "PieParent") {
         return false;
     }
@@ -6130,19 +4772,20 @@ void PaintNode(const XmlNode& node,
                RenderError& error,
                bool apply_filters,
                bool suppress_current_opacity) {
+    const ScopedNodeProfile node_profile(node);
     const auto matched_css_properties = ResolveMatchedCssProperties(node);
     auto style = style_resolver.Resolve(node, parent_style, options, &matched_css_properties);
     if (suppress_current_opacity) {
         style.opacity = 1.0f;
     }
-    const auto style_it = node.attributes.find("style");
-    const auto inline_style = style_it != node.attributes.end() ? ParseInlineStyle(style_it->second) : std::map<std::string, std::string>{};
+    const auto style_it = node.attributes.find(AttrId::kStyle);
+    const auto inline_style = style_it != node.attributes.end() ? ParseInlineStyle(style_it->second) : PropertyMap{};
 
-    if (const auto display = ReadAttrOrStyle(node, inline_style, &matched_css_properties, "display");
+    if (const auto display = ReadAttrOrStyle(node, inline_style, &matched_css_properties, AttrId::kDisplay);
         display.has_value() && Lower(Trim(*display)) == "none") {
         return;
     }
-    if (const auto visibility = ReadAttrOrStyle(node, inline_style, &matched_css_properties, "visibility"); visibility.has_value()) {
+    if (const auto visibility = ReadAttrOrStyle(node, inline_style, &matched_css_properties, AttrId::kVisibility); visibility.has_value()) {
         const auto visibility_value = Lower(Trim(*visibility));
         if (visibility_value == "hidden" || visibility_value == "collapse") {
             return;
@@ -6150,9 +4793,8 @@ void PaintNode(const XmlNode& node,
     }
 
     CGContextSaveGState(context);
-    const auto transform_it = node.attributes.find("transform");
-    if (transform_it != node.attributes.end()) {
-        CGContextConcatCTM(context, ParseTransformList(transform_it->second));
+    if (const AffineMatrix* transform = node.attributes.GetTransform(AttrId::kTransform)) {
+        CGContextConcatCTM(context, ToCGAffineTransform(*transform));
     }
 
     if (node.name == "defs") {
@@ -6200,6 +4842,7 @@ void PaintNode(const XmlNode& node,
         if (clip_it != id_map.end() && clip_it->second != nullptr) {
             const std::string clip_name = Lower(LocalName(clip_it->second->name));
             if (clip_name == "clippath") {
+                const ScopedPaintCost clip_cost(PaintCostKind::kClip);
                 ApplyClipPath(context, clip_it->second, node, geometry_engine);
             }
         }
@@ -6212,6 +4855,7 @@ void PaintNode(const XmlNode& node,
         if (mask_it != id_map.end() && mask_it->second != nullptr) {
             const std::string mask_name = Lower(LocalName(mask_it->second->name));
             if (mask_name == "mask") {
+                const ScopedPaintCost mask_cost(PaintCostKind::kMask);
                 ApplyMask(context, mask_it->second, node, style_resolver, geometry_engine,
                          gradients, patterns, id_map, color_profiles, options, error);
             }
@@ -6226,15 +4870,15 @@ void PaintNode(const XmlNode& node,
                 const double viewport_width = geometry_engine.viewport_width();
                 const double viewport_height = geometry_engine.viewport_height();
                 const double x = ParseSVGLengthAttr(node.attributes,
-                                                    "x",
+                                                    AttrId::kX,
                                                     0.0,
-                                                    SvgLengthAxis::kX,
+                                                    LengthAxis::kX,
                                                     viewport_width,
                                                     viewport_height);
                 const double y = ParseSVGLengthAttr(node.attributes,
-                                                    "y",
+                                                    AttrId::kY,
                                                     0.0,
-                                                    SvgLengthAxis::kY,
+                                                    LengthAxis::kY,
                                                     viewport_width,
                                                     viewport_height);
 
@@ -6266,29 +4910,29 @@ void PaintNode(const XmlNode& node,
             const double parent_viewport_height = geometry_engine.viewport_height();
 
             const double viewport_x = ParseSVGLengthAttr(node.attributes,
-                                                         "x",
+                                                         AttrId::kX,
                                                          0.0,
-                                                         SvgLengthAxis::kX,
+                                                         LengthAxis::kX,
                                                          parent_viewport_width,
                                                          parent_viewport_height);
             const double viewport_y = ParseSVGLengthAttr(node.attributes,
-                                                         "y",
+                                                         AttrId::kY,
                                                          0.0,
-                                                         SvgLengthAxis::kY,
+                                                         LengthAxis::kY,
                                                          parent_viewport_width,
                                                          parent_viewport_height);
             const double viewport_width_default = parent_viewport_width > 0.0 ? parent_viewport_width : 100.0;
             const double viewport_height_default = parent_viewport_height > 0.0 ? parent_viewport_height : 100.0;
             const double viewport_width = ParseSVGLengthAttr(node.attributes,
-                                                             "width",
+                                                             AttrId::kWidth,
                                                              viewport_width_default,
-                                                             SvgLengthAxis::kX,
+                                                             LengthAxis::kX,
                                                              parent_viewport_width,
                                                              parent_viewport_height);
             const double viewport_height = ParseSVGLengthAttr(node.attributes,
-                                                              "height",
+                                                              AttrId::kHeight,
                                                               viewport_height_default,
-                                                              SvgLengthAxis::kY,
+                                                              LengthAxis::kY,
                                                               parent_viewport_width,
                                                               parent_viewport_height);
 
@@ -6308,29 +4952,11 @@ void PaintNode(const XmlNode& node,
 
             double child_viewport_width = viewport_width;
             double child_viewport_height = viewport_height;
-            if (const auto view_box_it = node.attributes.find("viewBox"); view_box_it != node.attributes.end()) {
-                double view_box_x = 0.0;
-                double view_box_y = 0.0;
-                double view_box_width = 0.0;
-                double view_box_height = 0.0;
-                if (ParseViewBoxValue(view_box_it->second,
-                                      view_box_x,
-                                      view_box_y,
-                                      view_box_width,
-                                      view_box_height)) {
-                    const auto preserve_it = node.attributes.find("preserveAspectRatio");
-                    const std::string preserve_value = preserve_it != node.attributes.end() ? preserve_it->second : "";
-                    CGContextConcatCTM(context,
-                                       ComputeViewBoxTransform(viewport_width,
-                                                               viewport_height,
-                                                               view_box_x,
-                                                               view_box_y,
-                                                               view_box_width,
-                                                               view_box_height,
-                                                               preserve_value));
-                    child_viewport_width = view_box_width;
-                    child_viewport_height = view_box_height;
-                }
+            if (const ViewBox* view_box = node.attributes.GetViewBox(AttrId::kViewBox); view_box != nullptr && view_box->IsValid()) {
+                CGContextConcatCTM(context,
+                                   ComputeViewBoxTransform(viewport_width, viewport_height, *view_box, PreserveAspectRatioOf(node)));
+                child_viewport_width = view_box->width;
+                child_viewport_height = view_box->height;
             }
 
             const GeometryEngine child_geometry_engine(child_viewport_width, child_viewport_height);
@@ -6468,13 +5094,50 @@ void PaintNode(const XmlNode& node,
                      options);
             break;
         case ShapeType::kImage: {
-            if (geometry->width > 0.0 && geometry->height > 0.0 && !geometry->href.empty()) {
-                CGImageRef image = LoadImageFromHref(geometry->href);
+            const CGRect rect = CGRectMake(static_cast<CGFloat>(geometry->x),
+                                           static_cast<CGFloat>(geometry->y),
+                                           static_cast<CGFloat>(geometry->width),
+                                           static_cast<CGFloat>(geometry->height));
+            size_t source_width = 0;
+            size_t source_height = 0;
+            // The image never draws outside its viewport, so one that misses
+            // the clip is skipped before its source is opened or decoded.
+            if (geometry->width > 0.0 && geometry->height > 0.0 && !geometry->href.empty() &&
+                CGRectIntersectsRect(CGContextGetClipBoundingBox(context), rect) &&
+                ImageDimensionsFromHref(geometry->href, source_width, source_height)) {
+                CGRect draw_rect = rect;
+                bool clip_to_viewport = false;
+                const PreserveAspectRatio preserve = PreserveAspectRatioOf(node);
+                // Layout uses the encoded size so it does not depend on the
+                // resolution the image is decoded at.
+                const double image_width = static_cast<double>(source_width);
+                const double image_height = static_cast<double>(source_height);
+                if (!preserve.none) {
+                    const double scale_x = static_cast<double>(rect.size.width) / image_width;
+                    const double scale_y = static_cast<double>(rect.size.height) / image_height;
+                    const double uniform_scale = preserve.slice
+                        ? std::max(scale_x, scale_y)
+                        : std::min(scale_x, scale_y);
+                    const double draw_width = image_width * uniform_scale;
+                    const double draw_height = image_height * uniform_scale;
+                    const double offset_x = (static_cast<double>(rect.size.width) - draw_width) * preserve.align_x;
+                    const double offset_y = (static_cast<double>(rect.size.height) - draw_height) * preserve.align_y;
+                    draw_rect = CGRectMake(rect.origin.x + static_cast<CGFloat>(offset_x),
+                                           rect.origin.y + static_cast<CGFloat>(offset_y),
+                                           static_cast<CGFloat>(draw_width),
+                                           static_cast<CGFloat>(draw_height));
+                    clip_to_viewport = preserve.slice;
+                }
+
+                const size_t device_size = DevicePixelSize(static_cast<double>(draw_rect.size.width),
+                                                           static_cast<double>(draw_rect.size.height),
+                                                           CGContextGetCTM(context));
+                CGImageRef image = LoadImageFromHref(geometry->href, device_size);
                 if (image != nullptr) {
                     CGImageRef image_to_draw = image;
                     CGImageRef transformed = nullptr;
 
-                    if (const auto color_profile_value = ReadAttrOrStyle(node, inline_style, &matched_css_properties, "color-profile");
+                    if (const auto color_profile_value = ReadAttrOrStyle(node, inline_style, &matched_css_properties, AttrId::kColorProfile);
                         color_profile_value.has_value()) {
                         if (const auto profile_ref = ExtractColorProfileReference(*color_profile_value); profile_ref.has_value()) {
                             auto profile_it = color_profiles.find(*profile_ref);
@@ -6494,34 +5157,6 @@ void PaintNode(const XmlNode& node,
                         }
                     }
 
-                    const CGRect rect = CGRectMake(static_cast<CGFloat>(geometry->x),
-                                                   static_cast<CGFloat>(geometry->y),
-                                                   static_cast<CGFloat>(geometry->width),
-                                                   static_cast<CGFloat>(geometry->height));
-                    CGRect draw_rect = rect;
-                    bool clip_to_viewport = false;
-                    const auto preserve_it = node.attributes.find("preserveAspectRatio");
-                    const PreserveAspectRatioSpec preserve = ParsePreserveAspectRatioSpec(
-                        preserve_it != node.attributes.end() ? preserve_it->second : "");
-                    const double image_width = static_cast<double>(CGImageGetWidth(image_to_draw));
-                    const double image_height = static_cast<double>(CGImageGetHeight(image_to_draw));
-                    if (!preserve.none && image_width > 0.0 && image_height > 0.0) {
-                        const double scale_x = static_cast<double>(rect.size.width) / image_width;
-                        const double scale_y = static_cast<double>(rect.size.height) / image_height;
-                        const double uniform_scale = preserve.slice
-                            ? std::max(scale_x, scale_y)
-                            : std::min(scale_x, scale_y);
-                        const double draw_width = image_width * uniform_scale;
-                        const double draw_height = image_height * uniform_scale;
-                        const double offset_x = (static_cast<double>(rect.size.width) - draw_width) * preserve.align_x;
-                        const double offset_y = (static_cast<double>(rect.size.height) - draw_height) * preserve.align_y;
-                        draw_rect = CGRectMake(rect.origin.x + static_cast<CGFloat>(offset_x),
-                                               rect.origin.y + static_cast<CGFloat>(offset_y),
-                                               static_cast<CGFloat>(draw_width),
-                                               static_cast<CGFloat>(draw_height));
-                        clip_to_viewport = preserve.slice;
-                    }
-
                     CGContextSaveGState(context);
                     CGContextSetAlpha(context, std::clamp(style.opacity, 0.0f, 1.0f));
                     if (clip_to_viewport) {
@@ -6574,6 +5209,7 @@ void PaintNode(const XmlNode& node,
                                                     gradients,
                                                     static_cast<double>(style.opacity * style.fill_opacity));
             if (!gradient_fill_drawn) {
+                ScopedPaintCost pattern_cost(PaintCostKind::kPattern);
                 pattern_fill_drawn = PaintPatternFill(context,
                                                       path,
                                                       style,
@@ -6588,6 +5224,9 @@ void PaintNode(const XmlNode& node,
                                                       options,
                                                       error,
                                                       static_cast<double>(style.opacity * style.fill_opacity));
+                if (!pattern_fill_drawn) {
+                    pattern_cost.Cancel();
+                }
             }
             if (error.code != RenderErrorCode::kNone) {
                 if (path != nullptr) {
@@ -6645,11 +5284,18 @@ void PaintNode(const XmlNode& node,
 } // namespace
 
 bool PaintEngine::Paint(const SvgDocument& document,
+                        const DocumentIndex& index,
                         const LayoutResult& layout,
                         const RenderOptions& options,
                         const CompatFlags&,
                         RasterSurface& surface,
-                        RenderError& error) const {
+                        RenderError& error,
+                        PaintProfile* profile,
+                        TextLayoutCache* text_layouts,
+                        GlyphAtlas* glyph_atlas,
+                        ImageDecodeCache* images,
+                        const FetchedResources* fetched,
+                        RenderScratch* scratch) const {
     const auto context = surface.context();
     if (context == nullptr) {
         error.code = RenderErrorCode::kRenderFailed;
@@ -6660,37 +5306,51 @@ bool PaintEngine::Paint(const SvgDocument& document,
     const StyleResolver style_resolver;
     const GeometryEngine geometry_engine(layout.view_box_width, layout.view_box_height);
 
+    const PaintContext previous_paint = g_paint;
+    g_paint.theme = options.theme.get();
     GradientMap gradients;
-    CollectGradients(document.root, gradients);
+    CollectGradients(index.gradient_nodes, gradients);
     PatternMap patterns;
-    CollectPatterns(document.root, patterns);
-    NodeIdMap id_map;
-    CollectNodesByID(document.root, id_map);
+    CollectPatterns(index.pattern_nodes, patterns);
+    const NodeIdMap& id_map = index.nodes_by_id;
     ColorProfileMap color_profiles;
-    CollectColorProfiles(document.root, color_profiles);
-    const CssStylesheet stylesheet = BuildCssStylesheet(document.root);
-    const CssStylesheet* previous_stylesheet = g_active_stylesheet;
-    g_active_stylesheet = &stylesheet;
+    CollectColorProfiles(index.color_profile_nodes, color_profiles);
+    const CssCascade cascade = BuildCssCascade(index, options);
+    // Selector matching is skipped entirely when no rule can ever match.
+    g_paint.cascade = cascade.sheets.empty() ? nullptr : &cascade;
     std::set<std::string> active_use_ids;
     std::set<std::string> active_pattern_ids;
+    std::optional<FlattenedPathCache> local_path_cache;
+    if (scratch != nullptr) {
+        scratch->path_cache.Clear();
+        g_paint.path_cache = &scratch->path_cache;
+    } else {
+        g_paint.path_cache = &local_path_cache.emplace();
+    }
+    std::optional<TextLayoutCache> local_text_layouts;
+    g_paint.text_layouts = text_layouts != nullptr ? text_layouts : &local_text_layouts.emplace();
+    g_paint.glyph_atlas = glyph_atlas;
+    std::optional<ImageDecodeCache> local_images;
+    g_paint.images = images != nullptr ? images : &local_images.emplace();
+    g_paint.fetched = fetched;
+    std::optional<SurfacePool> local_surface_pool;
+    g_paint.surface_pool = scratch != nullptr ? &scratch->surfaces : &local_surface_pool.emplace();
+
+    std::optional<PaintProfileRecorder> recorder;
+    const auto paint_start = ProfileClock::now();
+    g_paint.profiler = nullptr;
+    if (profile != nullptr) {
+        *profile = {};
+        recorder.emplace(*profile);
+        g_paint.profiler = &*recorder;
+    }
 
     CGContextSaveGState(context);
     // SVG uses a top-left origin with positive Y downward.
     CGContextTranslateCTM(context, 0.0, static_cast<CGFloat>(layout.height));
     CGContextScaleCTM(context, 1.0, -1.0);
 
-    if (layout.view_box_width > 0.0 && layout.view_box_height > 0.0) {
-        const auto preserve_it = document.root.attributes.find("preserveAspectRatio");
-        const std::string preserve_value = preserve_it != document.root.attributes.end() ? preserve_it->second : "";
-        const CGAffineTransform viewbox_transform = ComputeViewBoxTransform(static_cast<double>(layout.width),
-                                                                            static_cast<double>(layout.height),
-                                                                            layout.view_box_x,
-                                                                            layout.view_box_y,
-                                                                            layout.view_box_width,
-                                                                            layout.view_box_height,
-                                                                            preserve_value);
-        CGContextConcatCTM(context, viewbox_transform);
-    }
+    CGContextConcatCTM(context, ToCGAffineTransform(NodeTransformCache::RootMatrix(document.root, layout)));
 
     PaintNode(document.root,
               style_resolver,
@@ -6706,7 +5366,11 @@ bool PaintEngine::Paint(const SvgDocument& document,
               options,
               error);
     CGContextRestoreGState(context);
-    g_active_stylesheet = previous_stylesheet;
+    g_paint = previous_paint;
+    if (recorder.has_value()) {
+        recorder->Finish(document.root);
+        profile->paint_ms = ElapsedMilliseconds(paint_start);
+    }
     return error.code == RenderErrorCode::kNone;
 }
 
@@ -0,0 +1,119 @@
+#include "YepSVGCore/PaintProfile.hpp"
+
+#include <cmath>
+#include <cstdio>
+
+namespace csvg {
+namespace {
+
+void AppendJsonString(std::string& out, const std::string& value) {
+    out.push_back('"');
+    for (const char c : value) {
+        switch (c) {
+            case '"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\r':
+                out += "\\r";
+                break;
+            case '\t':
+                out += "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned int>(static_cast<unsigned char>(c)));
+                    out += escaped;
+                } else {
+                    out.push_back(c);
+                }
+                break;
+        }
+    }
+    out.push_back('"');
+}
+
+void AppendJsonNumber(std::string& out, double value) {
+    if (!std::isfinite(value)) {
+        value = 0.0;
+    }
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.3f", value);
+    out += buffer;
+}
+
+void AppendJsonField(std::string& out, const char* key, double value) {
+    out.push_back('"');
+    out += key;
+    out += "\":";
+    AppendJsonNumber(out, value);
+}
+
+void AppendJsonField(std::string& out, const char* key, uint64_t value) {
+    out.push_back('"');
+    out += key;
+    out += "\":";
+    out += std::to_string(value);
+}
+
+void AppendJsonField(std::string& out, const char* key, const std::string& value) {
+    out.push_back('"');
+    out += key;
+    out += "\":";
+    AppendJsonString(out, value);
+}
+
+} // namespace
+
+std::string SerializePaintProfileJson(const PaintProfile& profile) {
+    std::string out;
+    out.reserve(128 + profile.entries.size() * 256);
+    out.push_back('{');
+    AppendJsonField(out, "paint_ms", profile.paint_ms);
+    out.push_back(',');
+    AppendJsonField(out, "offscreen_pixels", profile.offscreen_pixels);
+    out.push_back(',');
+    AppendJsonField(out, "decoded_image_pixels", profile.decoded_image_pixels);
+    out += ",\"elements\":[";
+    for (size_t i = 0; i < profile.entries.size(); ++i) {
+        const auto& entry = profile.entries[i];
+        if (i > 0) {
+            out.push_back(',');
+        }
+        out.push_back('{');
+        AppendJsonField(out, "id", entry.id);
+        out.push_back(',');
+        AppendJsonField(out, "path", entry.path);
+        out.push_back(',');
+        AppendJsonField(out, "tag", entry.tag);
+        out.push_back(',');
+        AppendJsonField(out, "paint_count", static_cast<uint64_t>(entry.paint_count));
+        out.push_back(',');
+        AppendJsonField(out, "inclusive_ms", entry.inclusive_ms);
+        out.push_back(',');
+        AppendJsonField(out, "exclusive_ms", entry.exclusive_ms);
+        out.push_back(',');
+        AppendJsonField(out, "offscreen_pixels", entry.offscreen_pixels);
+        out.push_back(',');
+        AppendJsonField(out, "decoded_image_pixels", entry.decoded_image_pixels);
+        out.push_back(',');
+        AppendJsonField(out, "filter_ms", entry.filter_ms);
+        out.push_back(',');
+        AppendJsonField(out, "mask_ms", entry.mask_ms);
+        out.push_back(',');
+        AppendJsonField(out, "clip_ms", entry.clip_ms);
+        out.push_back(',');
+        AppendJsonField(out, "pattern_ms", entry.pattern_ms);
+        out.push_back('}');
+    }
+    out += "]}";
+    return out;
+}
+
+} // namespace csvg
@@ -0,0 +1,473 @@
+#include "YepSVGCore/PathData.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+
+#include "YepSVGCore/Types.hpp"
+
+namespace csvg {
+namespace {
+
+bool IsNumberStart(char c) {
+    return std::isdigit(static_cast<unsigned char>(c)) || c == '-' || c == '+' || c == '.';
+}
+
+void SkipPathDelimiters(const std::string& text, size_t& index) {
+    while (index < text.size()) {
+        const char c = text[index];
+        if (std::isspace(static_cast<unsigned char>(c)) || c == ',') {
+            ++index;
+            continue;
+        }
+        break;
+    }
+}
+
+bool ParsePathNumber(const std::string& text, size_t& index, double& out) {
+    SkipPathDelimiters(text, index);
+    if (index >= text.size()) {
+        return false;
+    }
+
+    const char* start = text.c_str() + index;
+    char* end_ptr = nullptr;
+    out = std::strtod(start, &end_ptr);
+    if (end_ptr == start || !std::isfinite(out)) {
+        return false;
+    }
+    index = static_cast<size_t>(end_ptr - text.c_str());
+    return true;
+}
+
+bool HasMorePathNumbers(const std::string& text, size_t index) {
+    SkipPathDelimiters(text, index);
+    if (index >= text.size()) {
+        return false;
+    }
+    return IsNumberStart(text[index]);
+}
+
+constexpr double kArcEpsilon = 1e-9;
+
+bool NearlyEqual(double a, double b) {
+    return std::fabs(a - b) <= kArcEpsilon;
+}
+
+double SignedVectorAngle(double ux, double uy, double vx, double vy) {
+    return std::atan2((ux * vy) - (uy * vx), (ux * vx) + (uy * vy));
+}
+
+Point MapUnitArcPoint(double ux,
+                     double uy,
+                     double cx,
+                     double cy,
+                     double rx,
+                     double ry,
+                     double cos_phi,
+                     double sin_phi) {
+    const double x = cx + (rx * ux * cos_phi) - (ry * uy * sin_phi);
+    const double y = cy + (rx * ux * sin_phi) + (ry * uy * cos_phi);
+    return Point{x, y};
+}
+
+void AddArcAsBezier(PathDataSink& sink,
+                    double x1,
+                    double y1,
+                    double rx,
+                    double ry,
+                    double x_axis_rotation_degrees,
+                    bool large_arc_flag,
+                    bool sweep_flag,
+                    double x2,
+                    double y2) {
+    if (NearlyEqual(x1, x2) && NearlyEqual(y1, y2)) {
+        return;
+    }
+
+    rx = std::fabs(rx);
+    ry = std::fabs(ry);
+    if (rx < kArcEpsilon || ry < kArcEpsilon) {
+        sink.LineTo(x2, y2);
+        return;
+    }
+
+    const double phi = x_axis_rotation_degrees * M_PI / 180.0;
+    const double cos_phi = std::cos(phi);
+    const double sin_phi = std::sin(phi);
+
+    const double dx2 = (x1 - x2) / 2.0;
+    const double dy2 = (y1 - y2) / 2.0;
+    const double x1p = (cos_phi * dx2) + (sin_phi * dy2);
+    const double y1p = (-sin_phi * dx2) + (cos_phi * dy2);
+
+    const double x1p2 = x1p * x1p;
+    const double y1p2 = y1p * y1p;
+
+    double rx2 = rx * rx;
+    double ry2 = ry * ry;
+    const double lambda = (x1p2 / rx2) + (y1p2 / ry2);
+    if (lambda > 1.0) {
+        const double scale = std::sqrt(lambda);
+        rx *= scale;
+        ry *= scale;
+        rx2 = rx * rx;
+        ry2 = ry * ry;
+    }
+
+    const double numerator = (rx2 * ry2) - (rx2 * y1p2) - (ry2 * x1p2);
+    const double denominator = (rx2 * y1p2) + (ry2 * x1p2);
+    if (std::fabs(denominator) < kArcEpsilon) {
+        sink.LineTo(x2, y2);
+        return;
+    }
+
+    double center_scale = std::sqrt(std::max(0.0, numerator / denominator));
+    if (large_arc_flag == sweep_flag) {
+        center_scale = -center_scale;
+    }
+
+    const double cxp = center_scale * ((rx * y1p) / ry);
+    const double cyp = center_scale * (-(ry * x1p) / rx);
+
+    const double cx = (cos_phi * cxp) - (sin_phi * cyp) + ((x1 + x2) / 2.0);
+    const double cy = (sin_phi * cxp) + (cos_phi * cyp) + ((y1 + y2) / 2.0);
+
+    const double ux = (x1p - cxp) / rx;
+    const double uy = (y1p - cyp) / ry;
+    const double vx = (-x1p - cxp) / rx;
+    const double vy = (-y1p - cyp) / ry;
+
+    double start_angle = std::atan2(uy, ux);
+    double delta_angle = SignedVectorAngle(ux, uy, vx, vy);
+    if (!sweep_flag && delta_angle > 0.0) {
+        delta_angle -= 2.0 * M_PI;
+    } else if (sweep_flag && delta_angle < 0.0) {
+        delta_angle += 2.0 * M_PI;
+    }
+
+    const int segment_count = std::max(1, static_cast<int>(std::ceil(std::fabs(delta_angle) / (M_PI / 2.0))));
+    const double segment_angle = delta_angle / static_cast<double>(segment_count);
+
+    for (int i = 0; i < segment_count; ++i) {
+        const double theta1 = start_angle + (segment_angle * static_cast<double>(i));
+        const double theta2 = theta1 + segment_angle;
+        const double alpha = (4.0 / 3.0) * std::tan((theta2 - theta1) / 4.0);
+
+        const double cos_theta1 = std::cos(theta1);
+        const double sin_theta1 = std::sin(theta1);
+        const double cos_theta2 = std::cos(theta2);
+        const double sin_theta2 = std::sin(theta2);
+
+        const double cp1x_u = cos_theta1 - (alpha * sin_theta1);
+        const double cp1y_u = sin_theta1 + (alpha * cos_theta1);
+        const double cp2x_u = cos_theta2 + (alpha * sin_theta2);
+        const double cp2y_u = sin_theta2 - (alpha * cos_theta2);
+
+        const Point cp1 = MapUnitArcPoint(cp1x_u, cp1y_u, cx, cy, rx, ry, cos_phi, sin_phi);
+        const Point cp2 = MapUnitArcPoint(cp2x_u, cp2y_u, cx, cy, rx, ry, cos_phi, sin_phi);
+        const Point end = MapUnitArcPoint(cos_theta2, sin_theta2, cx, cy, rx, ry, cos_phi, sin_phi);
+
+        sink.CubicTo(cp1.x, cp1.y, cp2.x, cp2.y, end.x, end.y);
+    }
+}
+
+} // namespace
+
+bool PathDataParser::Parse(const std::string& path_data, PathDataSink& sink) const {
+    size_t index = 0;
+    char command = '\0';
+
+    double current_x = 0.0;
+    double current_y = 0.0;
+    double start_x = 0.0;
+    double start_y = 0.0;
+
+    double last_cubic_ctrl_x = 0.0;
+    double last_cubic_ctrl_y = 0.0;
+    double last_quad_ctrl_x = 0.0;
+    double last_quad_ctrl_y = 0.0;
+    bool has_last_cubic = false;
+    bool has_last_quad = false;
+
+    size_t previous_start = std::string::npos;
+    while (index < path_data.size()) {
+        SkipPathDelimiters(path_data, index);
+        if (index >= path_data.size()) {
+            break;
+        }
+        // A stray token after an implicit command (e.g. "L.") consumes nothing;
+        // stop instead of spinning on it forever.
+        if (index == previous_start) {
+            break;
+        }
+        previous_start = index;
+
+        const char token = path_data[index];
+        if (std::isalpha(static_cast<unsigned char>(token))) {
+            command = token;
+            ++index;
+        } else if (command == '\0') {
+            ++index;
+            continue;
+        }
+
+        const bool relative = std::islower(static_cast<unsigned char>(command));
+        const char upper = static_cast<char>(std::toupper(static_cast<unsigned char>(command)));
+
+        if (upper == 'M') {
+            double x = 0.0;
+            double y = 0.0;
+            if (!ParsePathNumber(path_data, index, x) || !ParsePathNumber(path_data, index, y)) {
+                break;
+            }
+            if (relative) {
+                x += current_x;
+                y += current_y;
+            }
+            sink.MoveTo(x, y);
+            current_x = x;
+            current_y = y;
+            start_x = x;
+            start_y = y;
+
+            while (HasMorePathNumbers(path_data, index)) {
+                if (!ParsePathNumber(path_data, index, x) || !ParsePathNumber(path_data, index, y)) {
+                    break;
+                }
+                if (relative) {
+                    x += current_x;
+                    y += current_y;
+                }
+                sink.LineTo(x, y);
+                current_x = x;
+                current_y = y;
+            }
+            has_last_cubic = false;
+            has_last_quad = false;
+            continue;
+        }
+
+        if (upper == 'L') {
+            double x = 0.0;
+            double y = 0.0;
+            while (ParsePathNumber(path_data, index, x) && ParsePathNumber(path_data, index, y)) {
+                if (relative) {
+                    x += current_x;
+                    y += current_y;
+                }
+                sink.LineTo(x, y);
+                current_x = x;
+                current_y = y;
+            }
+            has_last_cubic = false;
+            has_last_quad = false;
+            continue;
+        }
+
+        if (upper == 'H') {
+            double x = 0.0;
+            while (ParsePathNumber(path_data, index, x)) {
+                if (relative) {
+                    x += current_x;
+                }
+                sink.LineTo(x, current_y);
+                current_x = x;
+            }
+            has_last_cubic = false;
+            has_last_quad = false;
+            continue;
+        }
+
+        if (upper == 'V') {
+            double y = 0.0;
+            while (ParsePathNumber(path_data, index, y)) {
+                if (relative) {
+                    y += current_y;
+                }
+                sink.LineTo(current_x, y);
+                current_y = y;
+            }
+            has_last_cubic = false;
+            has_last_quad = false;
+            continue;
+        }
+
+        if (upper == 'C') {
+            double x1 = 0.0;
+            double y1 = 0.0;
+            double x2 = 0.0;
+            double y2 = 0.0;
+            double x = 0.0;
+            double y = 0.0;
+            while (ParsePathNumber(path_data, index, x1) &&
+                   ParsePathNumber(path_data, index, y1) &&
+                   ParsePathNumber(path_data, index, x2) &&
+                   ParsePathNumber(path_data, index, y2) &&
+                   ParsePathNumber(path_data, index, x) &&
+                   ParsePathNumber(path_data, index, y)) {
+                if (relative) {
+                    x1 += current_x;
+                    y1 += current_y;
+                    x2 += current_x;
+                    y2 += current_y;
+                    x += current_x;
+                    y += current_y;
+                }
+                sink.CubicTo(x1, y1, x2, y2, x, y);
+                current_x = x;
+                current_y = y;
+                last_cubic_ctrl_x = x2;
+                last_cubic_ctrl_y = y2;
+                has_last_cubic = true;
+                has_last_quad = false;
+            }
+            continue;
+        }
+
+        if (upper == 'S') {
+            double x2 = 0.0;
+            double y2 = 0.0;
+            double x = 0.0;
+            double y = 0.0;
+            while (ParsePathNumber(path_data, index, x2) &&
+                   ParsePathNumber(path_data, index, y2) &&
+                   ParsePathNumber(path_data, index, x) &&
+                   ParsePathNumber(path_data, index, y)) {
+                double x1 = current_x;
+                double y1 = current_y;
+                if (has_last_cubic) {
+                    x1 = 2.0 * current_x - last_cubic_ctrl_x;
+                    y1 = 2.0 * current_y - last_cubic_ctrl_y;
+                }
+
+                if (relative) {
+                    x2 += current_x;
+                    y2 += current_y;
+                    x += current_x;
+                    y += current_y;
+                }
+
+                sink.CubicTo(x1, y1, x2, y2, x, y);
+
+                current_x = x;
+                current_y = y;
+                last_cubic_ctrl_x = x2;
+                last_cubic_ctrl_y = y2;
+                has_last_cubic = true;
+                has_last_quad = false;
+            }
+            continue;
+        }
+
+        if (upper == 'Q') {
+            double x1 = 0.0;
+            double y1 = 0.0;
+            double x = 0.0;
+            double y = 0.0;
+            while (ParsePathNumber(path_data, index, x1) &&
+                   ParsePathNumber(path_data, index, y1) &&
+                   ParsePathNumber(path_data, index, x) &&
+                   ParsePathNumber(path_data, index, y)) {
+                if (relative) {
+                    x1 += current_x;
+                    y1 += current_y;
+                    x += current_x;
+                    y += current_y;
+                }
+
+                sink.QuadTo(x1, y1, x, y);
+
+                current_x = x;
+                current_y = y;
+                last_quad_ctrl_x = x1;
+                last_quad_ctrl_y = y1;
+                has_last_quad = true;
+                has_last_cubic = false;
+            }
+            continue;
+        }
+
+        if (upper == 'T') {
+            double x = 0.0;
+            double y = 0.0;
+            while (ParsePathNumber(path_data, index, x) && ParsePathNumber(path_data, index, y)) {
+                double x1 = current_x;
+                double y1 = current_y;
+                if (has_last_quad) {
+                    x1 = 2.0 * current_x - last_quad_ctrl_x;
+                    y1 = 2.0 * current_y - last_quad_ctrl_y;
+                }
+
+                if (relative) {
+                    x += current_x;
+                    y += current_y;
+                }
+
+                sink.QuadTo(x1, y1, x, y);
+
+                current_x = x;
+                current_y = y;
+                last_quad_ctrl_x = x1;
+                last_quad_ctrl_y = y1;
+                has_last_quad = true;
+                has_last_cubic = false;
+            }
+            continue;
+        }
+
+        if (upper == 'A') {
+            double rx = 0.0;
+            double ry = 0.0;
+            double angle = 0.0;
+            double large_arc = 0.0;
+            double sweep = 0.0;
+            double x = 0.0;
+            double y = 0.0;
+            while (ParsePathNumber(path_data, index, rx) &&
+                   ParsePathNumber(path_data, index, ry) &&
+                   ParsePathNumber(path_data, index, angle) &&
+                   ParsePathNumber(path_data, index, large_arc) &&
+                   ParsePathNumber(path_data, index, sweep) &&
+                   ParsePathNumber(path_data, index, x) &&
+                   ParsePathNumber(path_data, index, y)) {
+                if (relative) {
+                    x += current_x;
+                    y += current_y;
+                }
+
+                AddArcAsBezier(sink,
+                               current_x,
+                               current_y,
+                               rx,
+                               ry,
+                               angle,
+                               std::fabs(large_arc) > 0.0,
+                               std::fabs(sweep) > 0.0,
+                               x,
+                               y);
+                current_x = x;
+                current_y = y;
+            }
+            has_last_cubic = false;
+            has_last_quad = false;
+            continue;
+        }
+
+        if (upper == 'Z') {
+            sink.ClosePath();
+            current_x = start_x;
+            current_y = start_y;
+            has_last_cubic = false;
+            has_last_quad = false;
+            continue;
+        }
+
+        ++index;
+    }
+
+    return true;
+}
+
+} // namespace csvg
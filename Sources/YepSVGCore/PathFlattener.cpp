@@ -0,0 +1,252 @@
+#include "YepSVGCore/PathFlattener.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace csvg {
+namespace {
+
+constexpr double kDeviceTolerance = 0.25;
+constexpr double kMinTolerance = 1e-6;
+constexpr int kMaxSteps = 1024;
+// Control point distance for a quarter ellipse drawn as one cubic.
+constexpr double kCircleKappa = 0.5522847498307936;
+
+double Distance(double dx, double dy) {
+    return std::sqrt((dx * dx) + (dy * dy));
+}
+
+// A uniform step h = 1/n keeps the chord error under |second_derivative| * h^2 / 8.
+int StepCount(double max_second_derivative, double tolerance) {
+    const double steps = std::ceil(std::sqrt(max_second_derivative / (8.0 * tolerance)));
+    if (!std::isfinite(steps) || steps < 1.0) {
+        return 1;
+    }
+    return static_cast<int>(std::min(steps, static_cast<double>(kMaxSteps)));
+}
+
+void EmitEllipse(double cx, double cy, double rx, double ry, PathDataSink& sink) {
+    const double kx = rx * kCircleKappa;
+    const double ky = ry * kCircleKappa;
+    sink.MoveTo(cx + rx, cy);
+    sink.CubicTo(cx + rx, cy + ky, cx + kx, cy + ry, cx, cy + ry);
+    sink.CubicTo(cx - kx, cy + ry, cx - rx, cy + ky, cx - rx, cy);
+    sink.CubicTo(cx - rx, cy - ky, cx - kx, cy - ry, cx, cy - ry);
+    sink.CubicTo(cx + kx, cy - ry, cx + rx, cy - ky, cx + rx, cy);
+    sink.ClosePath();
+}
+
+void EmitRect(const ShapeGeometry& geometry, PathDataSink& sink) {
+    const double x = geometry.x;
+    const double y = geometry.y;
+    const double w = geometry.width;
+    const double h = geometry.height;
+    // Painting rounds with max(rx, ry) on both axes; match it.
+    const double radius = std::min({std::max(geometry.rx, geometry.ry), w * 0.5, h * 0.5});
+    if (!(radius > 0.0)) {
+        sink.MoveTo(x, y);
+        sink.LineTo(x + w, y);
+        sink.LineTo(x + w, y + h);
+        sink.LineTo(x, y + h);
+        sink.ClosePath();
+        return;
+    }
+
+    const double k = radius * (1.0 - kCircleKappa);
+    sink.MoveTo(x + radius, y);
+    sink.LineTo(x + w - radius, y);
+    sink.CubicTo(x + w - k, y, x + w, y + k, x + w, y + radius);
+    sink.LineTo(x + w, y + h - radius);
+    sink.CubicTo(x + w, y + h - k, x + w - k, y + h, x + w - radius, y + h);
+    sink.LineTo(x + radius, y + h);
+    sink.CubicTo(x + k, y + h, x, y + h - k, x, y + h - radius);
+    sink.LineTo(x, y + radius);
+    sink.CubicTo(x, y + k, x + k, y, x + radius, y);
+    sink.ClosePath();
+}
+
+} // namespace
+
+double FlatteningTolerance(double device_scale) {
+    if (!(device_scale > 0.0) || !std::isfinite(device_scale)) {
+        return kDeviceTolerance;
+    }
+    return std::max(kDeviceTolerance / device_scale, kMinTolerance);
+}
+
+bool FlattenedPath::PointAndTangentAt(double distance, Point& point, Point& tangent) const {
+    if (segments_.empty() || !(length_ > 0.0)) {
+        return false;
+    }
+
+    const double target = std::clamp(distance, 0.0, length_);
+    // First segment whose end reaches |target|.
+    auto it = std::lower_bound(segments_.begin(),
+                               segments_.end(),
+                               target,
+                               [](const Segment& segment, double value) {
+                                   return segment.offset + segment.length < value;
+                               });
+    if (it == segments_.end()) {
+        it = std::prev(segments_.end());
+    }
+
+    const Segment& segment = *it;
+    const double dx = segment.end.x - segment.start.x;
+    const double dy = segment.end.y - segment.start.y;
+    const double t = std::clamp((target - segment.offset) / segment.length, 0.0, 1.0);
+    point = Point{segment.start.x + dx * t, segment.start.y + dy * t};
+    tangent = Point{dx / segment.length, dy / segment.length};
+    return true;
+}
+
+PathFlattener::PathFlattener(double tolerance) {
+    path_.tolerance_ = std::max(tolerance, kMinTolerance);
+}
+
+void PathFlattener::MoveTo(double x, double y) {
+    current_ = Point{x, y};
+    subpath_start_ = current_;
+    has_current_ = true;
+    subpath_open_ = false;
+}
+
+void PathFlattener::LineTo(double x, double y) {
+    if (!has_current_) {
+        return;
+    }
+    Append(Point{x, y});
+}
+
+void PathFlattener::QuadTo(double x1, double y1, double x, double y) {
+    if (!has_current_) {
+        return;
+    }
+    const Point p0 = current_;
+    const double second_derivative = 2.0 * Distance(p0.x - 2.0 * x1 + x, p0.y - 2.0 * y1 + y);
+    const int steps = StepCount(second_derivative, path_.tolerance_);
+    for (int step = 1; step < steps; ++step) {
+        const double t = static_cast<double>(step) / static_cast<double>(steps);
+        const double mt = 1.0 - t;
+        Append(Point{(mt * mt * p0.x) + (2.0 * mt * t * x1) + (t * t * x),
+                     (mt * mt * p0.y) + (2.0 * mt * t * y1) + (t * t * y)});
+    }
+    Append(Point{x, y});
+}
+
+void PathFlattener::CubicTo(double x1, double y1, double x2, double y2, double x, double y) {
+    if (!has_current_) {
+        return;
+    }
+    const Point p0 = current_;
+    const double second_derivative = 6.0 * std::max(Distance(p0.x - 2.0 * x1 + x2, p0.y - 2.0 * y1 + y2),
+                                                    Distance(x1 - 2.0 * x2 + x, y1 - 2.0 * y2 + y));
+    const int steps = StepCount(second_derivative, path_.tolerance_);
+    for (int step = 1; step < steps; ++step) {
+        const double t = static_cast<double>(step) / static_cast<double>(steps);
+        const double mt = 1.0 - t;
+        const double a = mt * mt * mt;
+        const double b = 3.0 * mt * mt * t;
+        const double c = 3.0 * mt * t * t;
+        const double d = t * t * t;
+        Append(Point{(a * p0.x) + (b * x1) + (c * x2) + (d * x),
+                     (a * p0.y) + (b * y1) + (c * y2) + (d * y)});
+    }
+    Append(Point{x, y});
+}
+
+void PathFlattener::ClosePath() {
+    if (!has_current_) {
+        return;
+    }
+    Append(subpath_start_);
+    if (subpath_open_) {
+        path_.subpaths_.back().closed = true;
+        subpath_open_ = false;
+    }
+}
+
+FlattenedPath PathFlattener::Finish() {
+    FlattenedPath result = std::move(path_);
+    path_ = FlattenedPath{};
+    path_.tolerance_ = result.tolerance_;
+    has_current_ = false;
+    subpath_open_ = false;
+    return result;
+}
+
+void PathFlattener::Append(Point end) {
+    const Point start = current_;
+    current_ = end;
+    const double length = Distance(end.x - start.x, end.y - start.y);
+    if (!(length > 1e-9) || !std::isfinite(length)) {
+        return;
+    }
+    if (!subpath_open_) {
+        path_.subpaths_.push_back(FlattenedPath::Subpath{path_.segments_.size(), path_.segments_.size(), false});
+        subpath_open_ = true;
+    }
+    path_.segments_.push_back(FlattenedPath::Segment{start, end, path_.length_, length});
+    path_.subpaths_.back().end = path_.segments_.size();
+    path_.length_ += length;
+}
+
+bool EmitShapeOutline(const ShapeGeometry& geometry, PathDataSink& sink) {
+    switch (geometry.type) {
+        case ShapeType::kRect:
+            EmitRect(geometry, sink);
+            return true;
+        case ShapeType::kCircle:
+            EmitEllipse(geometry.x, geometry.y, geometry.rx, geometry.rx, sink);
+            return true;
+        case ShapeType::kEllipse:
+            EmitEllipse(geometry.x, geometry.y, geometry.rx, geometry.ry, sink);
+            return true;
+        case ShapeType::kLine:
+            if (geometry.points.size() >= 2) {
+                sink.MoveTo(geometry.points[0].x, geometry.points[0].y);
+                sink.LineTo(geometry.points[1].x, geometry.points[1].y);
+            }
+            return true;
+        case ShapeType::kPolygon:
+        case ShapeType::kPolyline:
+            if (!geometry.points.empty()) {
+                sink.MoveTo(geometry.points[0].x, geometry.points[0].y);
+                for (size_t i = 1; i < geometry.points.size(); ++i) {
+                    sink.LineTo(geometry.points[i].x, geometry.points[i].y);
+                }
+                if (geometry.type == ShapeType::kPolygon) {
+                    sink.ClosePath();
+                }
+            }
+            return true;
+        case ShapeType::kPath:
+            (void)PathDataParser().Parse(geometry.path_data, sink);
+            return true;
+        case ShapeType::kText:
+        case ShapeType::kImage:
+        case ShapeType::kUnknown:
+            return false;
+    }
+    return false;
+}
+
+const FlattenedPath* FlattenedPathCache::Get(const XmlNode& node,
+                                             const GeometryEngine& geometry_engine,
+                                             double tolerance) {
+    const auto it = paths_.find(&node);
+    if (it != paths_.end() && it->second.tolerance() <= tolerance) {
+        return &it->second;
+    }
+
+    PathFlattener flattener(tolerance);
+    const auto geometry = geometry_engine.Build(node);
+    if (geometry.has_value()) {
+        (void)EmitShapeOutline(*geometry, flattener);
+    }
+    FlattenedPath& entry = paths_[&node];
+    entry = flattener.Finish();
+    return &entry;
+}
+
+} // namespace csvg
@@ -4,17 +4,40 @@
 
 namespace csvg {
 
-RasterSurface::RasterSurface(int32_t width, int32_t height, const Color& background)
-    : width_(width), height_(height), bytes_(static_cast<size_t>(width) * static_cast<size_t>(height) * 4u, 0), context_(nullptr) {
-    CGColorSpaceRef color_space = CGColorSpaceCreateDeviceRGB();
-    context_ = CGBitmapContextCreate(bytes_.data(),
-                                     static_cast<size_t>(width),
-                                     static_cast<size_t>(height),
-                                     8,
-                                     static_cast<size_t>(width) * 4,
-                                     color_space,
-                                     kCGImageAlphaPremultipliedLast | kCGBitmapByteOrderDefault);
-    CGColorSpaceRelease(color_space);
+RasterSurface::RasterSurface(int32_t width, int32_t height, const Color& background) {
+    Reset(width, height, background);
+}
+
+RasterSurface::~RasterSurface() {
+    Release();
+}
+
+void RasterSurface::Reset(int32_t width, int32_t height, const Color& background) {
+    const bool fills_opaque = background.is_valid && !background.is_none && background.a >= 1.0f;
+    if (context_ != nullptr && width == width_ && height == height_) {
+        // An opaque background overwrites every pixel anyway.
+        if (!fills_opaque) {
+            std::memset(bytes_.data(), 0, bytes_.size());
+        }
+    } else {
+        if (context_ != nullptr) {
+            CGContextRelease(context_);
+            context_ = nullptr;
+        }
+        width_ = width;
+        height_ = height;
+        bytes_.assign(static_cast<size_t>(width) * static_cast<size_t>(height) * 4u, 0);
+
+        CGColorSpaceRef color_space = CGColorSpaceCreateDeviceRGB();
+        context_ = CGBitmapContextCreate(bytes_.data(),
+                                         static_cast<size_t>(width),
+                                         static_cast<size_t>(height),
+                                         8,
+                                         static_cast<size_t>(width) * 4,
+                                         color_space,
+                                         kCGImageAlphaPremultipliedLast | kCGBitmapByteOrderDefault);
+        CGColorSpaceRelease(color_space);
+    }
 
     if (context_ != nullptr && background.is_valid && !background.is_none) {
         CGContextSetRGBFillColor(context_, background.r, background.g, background.b, background.a);
@@ -22,10 +45,14 @@ RasterSurface::RasterSurface(int32_t width, int32_t height, const Color& backgro
     }
 }
 
-RasterSurface::~RasterSurface() {
+void RasterSurface::Release() {
     if (context_ != nullptr) {
         CGContextRelease(context_);
+        context_ = nullptr;
     }
+    width_ = 0;
+    height_ = 0;
+    std::vector<uint8_t>().swap(bytes_);
 }
 
 CGContextRef RasterSurface::context() const {
@@ -41,7 +68,7 @@ bool RasterSurface::Extract(ImageBuffer& out, RenderError& error) const {
 
     out.width = width_;
     out.height = height_;
-    out.rgba = bytes_;
+    out.rgba.assign(bytes_.begin(), bytes_.end());
     return true;
 }
 
@@ -0,0 +1,415 @@
+#include "YepSVGCore/RenderCache.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+namespace csvg {
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr uint64_t kC1 = 0x87c37b91114253d5ull;
+constexpr uint64_t kC2 = 0x4cf5ad432745937full;
+
+constexpr char kMagic[8] = {'Y', 'S', 'V', 'G', 'P', 'I', 'X', '1'};
+constexpr uint32_t kEncodingRawRgba = 0;
+constexpr const char* kExtension = ".rgba";
+constexpr const char* kTempPrefix = ".tmp-";
+// Temporary files this old belong to writers that died mid-store.
+constexpr auto kStaleTempAge = std::chrono::hours(1);
+
+// Files are never modified after the rename that publishes them, so a
+// mapping stays valid even if another process evicts or replaces the file.
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t encoding;
+    int32_t width;
+    int32_t height;
+    uint64_t key_high;
+    uint64_t key_low;
+    uint64_t rgba_size;
+};
+static_assert(sizeof(FileHeader) == 48, "render cache header layout changed");
+
+uint64_t Rotl(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+uint64_t FinalMix(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdull;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ull;
+    value ^= value >> 33;
+    return value;
+}
+
+uint64_t LoadLittleEndian(const uint8_t* bytes, size_t count) {
+    uint64_t value = 0;
+    for (size_t i = count; i > 0; --i) {
+        value = (value << 8) | bytes[i - 1];
+    }
+    return value;
+}
+
+std::optional<RenderCacheKey> ParseHexKey(std::string_view text) {
+    if (text.size() != 32) {
+        return std::nullopt;
+    }
+    RenderCacheKey key;
+    for (size_t i = 0; i < text.size(); ++i) {
+        const char c = text[i];
+        uint64_t digit = 0;
+        if (c >= '0' && c <= '9') {
+            digit = static_cast<uint64_t>(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            digit = static_cast<uint64_t>(c - 'a' + 10);
+        } else {
+            return std::nullopt;
+        }
+        uint64_t& half = i < 16 ? key.high : key.low;
+        half = (half << 4) | digit;
+    }
+    return key;
+}
+
+bool HeaderMatches(const FileHeader& header, const RenderCacheKey& key, uint64_t file_size) {
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kRenderOutputVersion ||
+        header.encoding != kEncodingRawRgba || header.key_high != key.high || header.key_low != key.low) {
+        return false;
+    }
+    if (header.width <= 0 || header.height <= 0) {
+        return false;
+    }
+    const uint64_t expected = static_cast<uint64_t>(header.width) * static_cast<uint64_t>(header.height) * 4u;
+    return header.rgba_size == expected && file_size == sizeof(FileHeader) + expected;
+}
+
+} // namespace
+
+std::string RenderCacheKey::Hex() const {
+    static constexpr char kDigits[] = "0123456789abcdef";
+    std::string out(32, '0');
+    for (int i = 0; i < 16; ++i) {
+        out[static_cast<size_t>(15 - i)] = kDigits[(high >> (i * 4)) & 0xF];
+        out[static_cast<size_t>(31 - i)] = kDigits[(low >> (i * 4)) & 0xF];
+    }
+    return out;
+}
+
+void RenderFingerprint::Mix(const uint8_t* block) {
+    uint64_t k1 = LoadLittleEndian(block, 8);
+    uint64_t k2 = LoadLittleEndian(block + 8, 8);
+
+    k1 *= kC1;
+    k1 = Rotl(k1, 31);
+    k1 *= kC2;
+    h1_ ^= k1;
+    h1_ = Rotl(h1_, 27);
+    h1_ += h2_;
+    h1_ = h1_ * 5 + 0x52dce729;
+
+    k2 *= kC2;
+    k2 = Rotl(k2, 33);
+    k2 *= kC1;
+    h2_ ^= k2;
+    h2_ = Rotl(h2_, 31);
+    h2_ += h1_;
+    h2_ = h2_ * 5 + 0x38495ab5;
+}
+
+void RenderFingerprint::Add(const void* data, size_t size) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    total_size_ += size;
+    if (pending_size_ > 0) {
+        const size_t take = std::min(size, sizeof(pending_) - pending_size_);
+        std::memcpy(pending_ + pending_size_, bytes, take);
+        pending_size_ += take;
+        bytes += take;
+        size -= take;
+        if (pending_size_ < sizeof(pending_)) {
+            return;
+        }
+        Mix(pending_);
+        pending_size_ = 0;
+    }
+    for (; size >= sizeof(pending_); bytes += sizeof(pending_), size -= sizeof(pending_)) {
+        Mix(bytes);
+    }
+    if (size > 0) {
+        std::memcpy(pending_, bytes, size);
+        pending_size_ = size;
+    }
+}
+
+void RenderFingerprint::AddString(std::string_view text) {
+    AddValue(static_cast<uint64_t>(text.size()));
+    Add(text.data(), text.size());
+}
+
+RenderCacheKey RenderFingerprint::Finish() const {
+    uint64_t h1 = h1_;
+    uint64_t h2 = h2_;
+    if (pending_size_ > 0) {
+        uint64_t k1 = LoadLittleEndian(pending_, std::min<size_t>(pending_size_, 8));
+        uint64_t k2 = pending_size_ > 8 ? LoadLittleEndian(pending_ + 8, pending_size_ - 8) : 0;
+        k2 *= kC2;
+        k2 = Rotl(k2, 33);
+        k2 *= kC1;
+        h2 ^= k2;
+        k1 *= kC1;
+        k1 = Rotl(k1, 31);
+        k1 *= kC2;
+        h1 ^= k1;
+    }
+
+    h1 ^= total_size_;
+    h2 ^= total_size_;
+    h1 += h2;
+    h2 += h1;
+    h1 = FinalMix(h1);
+    h2 = FinalMix(h2);
+    h1 += h2;
+    h2 += h1;
+    return RenderCacheKey{h1, h2};
+}
+
+RenderCache::Hit::Hit(void* mapping,
+                      size_t mapping_size,
+                      int32_t width,
+                      int32_t height,
+                      const uint8_t* rgba,
+                      size_t rgba_size)
+    : mapping_(mapping),
+      mapping_size_(mapping_size),
+      width_(width),
+      height_(height),
+      rgba_(rgba),
+      rgba_size_(rgba_size) {}
+
+RenderCache::Hit::~Hit() {
+    if (mapping_ != nullptr) {
+        munmap(mapping_, mapping_size_);
+    }
+}
+
+RenderCache::Hit::Hit(Hit&& other) noexcept
+    : mapping_(std::exchange(other.mapping_, nullptr)),
+      mapping_size_(std::exchange(other.mapping_size_, 0)),
+      width_(other.width_),
+      height_(other.height_),
+      rgba_(std::exchange(other.rgba_, nullptr)),
+      rgba_size_(std::exchange(other.rgba_size_, 0)) {}
+
+RenderCache::RenderCache(std::string directory, uint64_t max_bytes)
+    : directory_(std::move(directory)), max_bytes_(max_bytes) {}
+
+std::shared_ptr<RenderCache> RenderCache::Open(const std::string& directory, uint64_t max_bytes, RenderError& error) {
+    std::error_code ec;
+    if (directory.empty()) {
+        error.code = RenderErrorCode::kRenderFailed;
+        error.message = "Render cache directory is empty";
+        return nullptr;
+    }
+    fs::create_directories(directory, ec);
+    if (ec || !fs::is_directory(directory, ec)) {
+        error.code = RenderErrorCode::kRenderFailed;
+        error.message = "Render cache directory unusable: " + directory + (ec ? ": " + ec.message() : "");
+        return nullptr;
+    }
+
+    std::shared_ptr<RenderCache> cache(new RenderCache(directory, max_bytes));
+    cache->Scan();
+    return cache;
+}
+
+void RenderCache::Scan() {
+    std::error_code ec;
+    const auto now = fs::file_time_type::clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (fs::directory_iterator it(directory_, ec), end; !ec && it != end; it.increment(ec)) {
+        std::error_code entry_ec;
+        if (!it->is_regular_file(entry_ec)) {
+            continue;
+        }
+        const fs::path& path = it->path();
+        const std::string name = path.filename().string();
+        const auto modified = it->last_write_time(entry_ec);
+        if (entry_ec) {
+            continue;
+        }
+        if (name.rfind(kTempPrefix, 0) == 0) {
+            if (now - modified > kStaleTempAge) {
+                fs::remove(path, entry_ec);
+            }
+            continue;
+        }
+        if (path.extension() != kExtension) {
+            continue;
+        }
+        const auto key = ParseHexKey(path.stem().string());
+        const uint64_t size = it->file_size(entry_ec);
+        if (!key.has_value() || entry_ec) {
+            continue;
+        }
+        Entry& entry = entries_[*key];
+        entry.size = size;
+        entry.last_use = modified.time_since_epoch().count();
+        total_bytes_ += size;
+    }
+    EvictLocked();
+}
+
+std::string RenderCache::PathFor(const RenderCacheKey& key) const {
+    return (fs::path(directory_) / (key.Hex() + kExtension)).string();
+}
+
+std::optional<RenderCache::Hit> RenderCache::Lookup(const RenderCacheKey& key) {
+    const std::string path = PathFor(key);
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Evicted by another process sharing the directory.
+        if (const auto it = entries_.find(key); it != entries_.end()) {
+            total_bytes_ -= std::min(total_bytes_, it->second.size);
+            entries_.erase(it);
+        }
+        return std::nullopt;
+    }
+
+    struct stat info {};
+    void* mapping = MAP_FAILED;
+    uint64_t file_size = 0;
+    if (fstat(fd, &info) == 0 && info.st_size >= static_cast<off_t>(sizeof(FileHeader))) {
+        file_size = static_cast<uint64_t>(info.st_size);
+        mapping = mmap(nullptr, static_cast<size_t>(file_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+
+    FileHeader header{};
+    if (mapping != MAP_FAILED) {
+        std::memcpy(&header, mapping, sizeof(header));
+    }
+    if (mapping == MAP_FAILED || !HeaderMatches(header, key, file_size)) {
+        if (mapping != MAP_FAILED) {
+            munmap(mapping, static_cast<size_t>(file_size));
+        }
+        std::error_code ec;
+        fs::remove(path, ec);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (const auto it = entries_.find(key); it != entries_.end()) {
+            total_bytes_ -= std::min(total_bytes_, it->second.size);
+            entries_.erase(it);
+        }
+        return std::nullopt;
+    }
+
+    // Refreshing the mtime carries recency over to the next process.
+    std::error_code ec;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Touch(key, file_size);
+    }
+    return std::optional<Hit>(std::in_place,
+                              mapping,
+                              static_cast<size_t>(file_size),
+                              header.width,
+                              header.height,
+                              static_cast<const uint8_t*>(mapping) + sizeof(FileHeader),
+                              static_cast<size_t>(header.rgba_size));
+}
+
+void RenderCache::Store(const RenderCacheKey& key, const ImageBuffer& image) {
+    if (image.width <= 0 || image.height <= 0 ||
+        image.rgba.size() != static_cast<size_t>(image.width) * static_cast<size_t>(image.height) * 4u) {
+        return;
+    }
+    const uint64_t file_size = sizeof(FileHeader) + image.rgba.size();
+    if (file_size > max_bytes_) {
+        return;
+    }
+
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kRenderOutputVersion;
+    header.encoding = kEncodingRawRgba;
+    header.width = image.width;
+    header.height = image.height;
+    header.key_high = key.high;
+    header.key_low = key.low;
+    header.rgba_size = image.rgba.size();
+
+    uint64_t serial = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        serial = ++temp_counter_;
+    }
+    const fs::path temp = fs::path(directory_) /
+                          (kTempPrefix + std::to_string(getpid()) + "-" + std::to_string(serial));
+    std::error_code ec;
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(image.rgba.data()), static_cast<std::streamsize>(image.rgba.size()));
+        out.close();
+        if (!out) {
+            fs::remove(temp, ec);
+            return;
+        }
+    }
+    fs::rename(temp, PathFor(key), ec);
+    if (ec) {
+        fs::remove(temp, ec);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Touch(key, file_size);
+    EvictLocked();
+}
+
+void RenderCache::Touch(const RenderCacheKey& key, uint64_t size) {
+    Entry& entry = entries_[key];
+    total_bytes_ -= std::min(total_bytes_, entry.size);
+    entry.size = size;
+    entry.last_use = fs::file_time_type::clock::now().time_since_epoch().count();
+    total_bytes_ += size;
+}
+
+void RenderCache::EvictLocked() {
+    if (total_bytes_ <= max_bytes_) {
+        return;
+    }
+    // Evict down to 7/8 of the budget so the sort runs rarely.
+    const uint64_t target = max_bytes_ - max_bytes_ / 8;
+    std::vector<std::pair<int64_t, RenderCacheKey>> by_age;
+    by_age.reserve(entries_.size());
+    for (const auto& [key, entry] : entries_) {
+        by_age.emplace_back(entry.last_use, key);
+    }
+    std::sort(by_age.begin(), by_age.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (const auto& [last_use, key] : by_age) {
+        if (total_bytes_ <= target) {
+            break;
+        }
+        std::error_code ec;
+        fs::remove(PathFor(key), ec);
+        const auto it = entries_.find(key);
+        total_bytes_ -= std::min(total_bytes_, it->second.size);
+        entries_.erase(it);
+    }
+}
+
+} // namespace csvg
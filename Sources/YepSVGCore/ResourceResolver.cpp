@@ -1,47 +1,134 @@
 #include "YepSVGCore/ResourceResolver.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+
 namespace csvg {
 namespace {
 
-void CollectURLsRecursive(const XmlNode& node, std::vector<std::string>& urls) {
-    const auto href_it = node.attributes.find("href");
-    if (href_it != node.attributes.end()) {
-        urls.push_back(href_it->second);
-    }
-    const auto xlink_it = node.attributes.find("xlink:href");
-    if (xlink_it != node.attributes.end()) {
-        urls.push_back(xlink_it->second);
-    }
+// Host loaders are usually network-bound; more threads than this mostly
+// queue inside the host's own connection pool.
+constexpr size_t kMaxConcurrentFetches = 8;
 
-    for (const auto& child : node.children) {
-        CollectURLsRecursive(child, urls);
+std::string_view TrimView(std::string_view value) {
+    const auto begin = value.find_first_not_of(" \t\r\n");
+    if (begin == std::string_view::npos) {
+        return {};
     }
+    const auto end = value.find_last_not_of(" \t\r\n");
+    return value.substr(begin, end - begin + 1);
 }
 
-bool IsRemoteURL(const std::string& value) {
-    return value.rfind("http://", 0) == 0 || value.rfind("https://", 0) == 0;
+bool IsRemoteURL(std::string_view value) {
+    return value.substr(0, 7) == "http://" || value.substr(0, 8) == "https://";
 }
 
+struct FetchResult {
+    bool ok = false;
+    std::vector<uint8_t> data;
+    std::string error;
+};
+
 } // namespace
 
-std::vector<std::string> ResourceResolver::CollectExternalURLs(const XmlNode& node) const {
-    std::vector<std::string> urls;
-    CollectURLsRecursive(node, urls);
-    return urls;
+bool ResourceResolver::ValidatePolicy(const std::vector<ExternalReference>& references,
+                                      const RenderOptions& options,
+                                      bool has_loader,
+                                      RenderError& error) const {
+    if (options.enable_external_resources && has_loader) {
+        return true;
+    }
+
+    for (const auto& reference : references) {
+        if (IsRemoteURL(reference.url)) {
+            error.code = RenderErrorCode::kExternalResourceBlocked;
+            error.message = "External resource blocked: " + std::string(reference.url);
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<ResourceRequest> ResourceResolver::CollectRemoteRequests(const std::vector<ExternalReference>& references) const {
+    std::vector<ResourceRequest> requests;
+    std::unordered_map<std::string_view, size_t> request_by_url;
+    for (const auto& reference : references) {
+        const std::string_view url = TrimView(reference.url);
+        if (!IsRemoteURL(url)) {
+            continue;
+        }
+        const auto [it, inserted] = request_by_url.emplace(url, requests.size());
+        if (inserted) {
+            requests.push_back(ResourceRequest{std::string(url), reference.purpose});
+        } else if (reference.purpose == ResourcePurpose::kImage) {
+            // One fetch serves every reference; images need it decoded.
+            requests[it->second].purpose = ResourcePurpose::kImage;
+        }
+    }
+    return requests;
 }
 
-bool ResourceResolver::ValidatePolicy(const std::vector<std::string>& urls, const RenderOptions& options, RenderError& error) const {
-    if (options.enable_external_resources) {
+bool ResourceResolver::Fetch(const std::vector<ResourceRequest>& requests,
+                             const ResourceLoader& loader,
+                             FetchedResources& out_resources,
+                             RenderError& error) const {
+    if (requests.empty()) {
         return true;
     }
+    if (!loader) {
+        error.code = RenderErrorCode::kExternalResourceBlocked;
+        error.message = "External resource blocked: " + requests.front().url;
+        return false;
+    }
 
-    for (const auto& url : urls) {
-        if (IsRemoteURL(url)) {
-            error.code = RenderErrorCode::kExternalResourceBlocked;
-            error.message = "External resource blocked: " + url;
+    std::vector<FetchResult> results(requests.size());
+    std::atomic<size_t> next{0};
+    const auto work = [&]() {
+        for (size_t i = next.fetch_add(1); i < requests.size(); i = next.fetch_add(1)) {
+            FetchResult& result = results[i];
+            try {
+                result.ok = loader(requests[i], result.data, result.error);
+            } catch (...) {
+                result.ok = false;
+                result.error = "Loader threw an exception";
+            }
+        }
+    };
+
+    // The calling thread takes a share of the requests too, and all of
+    // them that no helper thread could be started for.
+    const size_t thread_count = std::min(requests.size(), kMaxConcurrentFetches);
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count - 1);
+    for (size_t i = 1; i < thread_count; ++i) {
+        try {
+            threads.emplace_back(work);
+        } catch (const std::system_error&) {
+            break;
+        }
+    }
+    work();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (size_t i = 0; i < requests.size(); ++i) {
+        if (!results[i].ok) {
+            error.code = RenderErrorCode::kExternalResourceFailed;
+            error.message = "External resource failed: " + requests[i].url +
+                (results[i].error.empty() ? std::string() : ": " + results[i].error);
             return false;
         }
     }
+    for (size_t i = 0; i < requests.size(); ++i) {
+        out_resources[requests[i].url] = FetchedResource{
+            requests[i].purpose,
+            std::make_shared<const std::vector<uint8_t>>(std::move(results[i].data)),
+        };
+    }
     return true;
 }
 
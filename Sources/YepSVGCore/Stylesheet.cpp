@@ -0,0 +1,112 @@
+#include "YepSVGCore/Stylesheet.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+namespace csvg {
+namespace {
+
+std::string Lower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
+
+std::string CssLocalName(const std::string& name) {
+    const auto separator = name.rfind(':');
+    if (separator == std::string::npos) {
+        return Lower(name);
+    }
+    return Lower(name.substr(separator + 1));
+}
+
+void AppendBucket(const std::unordered_map<std::string, std::vector<CssSelectorRef>>& buckets,
+                  const std::string& key,
+                  std::vector<CssSelectorRef>& out) {
+    const auto it = buckets.find(key);
+    if (it != buckets.end()) {
+        out.insert(out.end(), it->second.begin(), it->second.end());
+    }
+}
+
+} // namespace
+
+std::shared_ptr<const Stylesheet> Stylesheet::Compile(const std::string& css_text, StylesheetOrigin origin) {
+    return Compile(std::vector<std::string>{css_text}, origin);
+}
+
+std::shared_ptr<const Stylesheet> Stylesheet::Compile(const std::vector<std::string>& css_blocks, StylesheetOrigin origin) {
+    std::shared_ptr<Stylesheet> stylesheet(new Stylesheet(origin));
+    const CssParser parser;
+    size_t source_order = 0;
+    for (const auto& block : css_blocks) {
+        parser.ParseRules(block, source_order, stylesheet->rules_);
+    }
+    stylesheet->BuildSelectorIndex();
+    return stylesheet;
+}
+
+void Stylesheet::BuildSelectorIndex() {
+    for (size_t rule_index = 0; rule_index < rules_.size(); ++rule_index) {
+        const auto& selectors = rules_[rule_index].selectors;
+        for (size_t selector_index = 0; selector_index < selectors.size(); ++selector_index) {
+            const auto& selector = selectors[selector_index];
+            if (selector.steps.empty()) {
+                continue;
+            }
+            const CssSelectorRef ref{static_cast<uint32_t>(rule_index), static_cast<uint32_t>(selector_index)};
+            // steps[0] is the subject; bucket by its most selective part.
+            const auto& subject = selector.steps.front().simple;
+            if (subject.id.has_value()) {
+                by_id_[*subject.id].push_back(ref);
+            } else if (!subject.classes.empty()) {
+                by_class_[subject.classes.front()].push_back(ref);
+            } else if (subject.tag != "*") {
+                by_tag_[subject.tag].push_back(ref);
+            } else {
+                universal_.push_back(ref);
+            }
+        }
+    }
+}
+
+void Stylesheet::CollectCandidates(const XmlNode& node, std::vector<CssSelectorRef>& out) const {
+    const size_t first = out.size();
+    out.insert(out.end(), universal_.begin(), universal_.end());
+    if (!by_tag_.empty()) {
+        AppendBucket(by_tag_, CssLocalName(node.name), out);
+    }
+    if (!by_id_.empty()) {
+        if (const auto id_it = node.attributes.find(AttrId::kId); id_it != node.attributes.end()) {
+            AppendBucket(by_id_, id_it->second, out);
+        }
+    }
+    if (!by_class_.empty()) {
+        if (const auto class_it = node.attributes.find(AttrId::kClass); class_it != node.attributes.end()) {
+            const std::string& value = class_it->second;
+            size_t i = 0;
+            while (i < value.size()) {
+                while (i < value.size() && std::isspace(static_cast<unsigned char>(value[i]))) {
+                    ++i;
+                }
+                const size_t start = i;
+                while (i < value.size() && !std::isspace(static_cast<unsigned char>(value[i]))) {
+                    ++i;
+                }
+                if (i > start) {
+                    AppendBucket(by_class_, value.substr(start, i - start), out);
+                }
+            }
+        }
+    }
+
+    const auto by_position = [](const CssSelectorRef& lhs, const CssSelectorRef& rhs) {
+        return lhs.rule_index != rhs.rule_index ? lhs.rule_index < rhs.rule_index : lhs.selector_index < rhs.selector_index;
+    };
+    const auto same_position = [](const CssSelectorRef& lhs, const CssSelectorRef& rhs) {
+        return lhs.rule_index == rhs.rule_index && lhs.selector_index == rhs.selector_index;
+    };
+    std::sort(out.begin() + static_cast<std::ptrdiff_t>(first), out.end(), by_position);
+    out.erase(std::unique(out.begin() + static_cast<std::ptrdiff_t>(first), out.end(), same_position), out.end());
+}
+
+} // namespace csvg
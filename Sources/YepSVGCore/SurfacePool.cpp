@@ -0,0 +1,91 @@
+#include "YepSVGCore/SurfacePool.hpp"
+
+#include <algorithm>
+
+namespace csvg {
+namespace {
+
+size_t SizeClass(size_t count) {
+    size_t size_class = 0;
+    while (count > 1) {
+        count >>= 1;
+        ++size_class;
+    }
+    return size_class;
+}
+
+} // namespace
+
+SurfacePool::SurfacePool(size_t max_retained_bytes) : max_retained_bytes_(max_retained_bytes) {}
+
+template <typename Buffer>
+Buffer SurfacePool::Take(Buckets<Buffer>& buckets, size_t count, bool zeroed) {
+    Buffer buffer;
+    // Buffers in the request's own class may be too small; every buffer one
+    // class up is large enough. Looking no further bounds the waste.
+    const size_t first_class = SizeClass(count);
+    const size_t last_class = std::min(first_class + 2, buckets.size());
+    for (size_t size_class = first_class; size_class < last_class && buffer.capacity() == 0; ++size_class) {
+        auto& bucket = buckets[size_class];
+        for (size_t i = bucket.size(); i-- > 0;) {
+            if (bucket[i].capacity() < count) {
+                continue;
+            }
+            buffer = std::move(bucket[i]);
+            if (i + 1 != bucket.size()) {
+                bucket[i] = std::move(bucket.back());
+            }
+            bucket.pop_back();
+            retained_bytes_ -= buffer.capacity() * sizeof(typename Buffer::value_type);
+            break;
+        }
+    }
+
+    if (zeroed) {
+        buffer.assign(count, 0);
+    } else {
+        buffer.clear();
+        buffer.resize(count);
+    }
+    return buffer;
+}
+
+template <typename Buffer>
+void SurfacePool::Keep(Buckets<Buffer>& buckets, Buffer&& buffer) {
+    const size_t capacity = buffer.capacity();
+    const size_t bytes = capacity * sizeof(typename Buffer::value_type);
+    if (capacity == 0 || retained_bytes_ + bytes > max_retained_bytes_) {
+        Buffer().swap(buffer);
+        return;
+    }
+    const size_t size_class = SizeClass(capacity);
+    if (buckets.size() <= size_class) {
+        buckets.resize(size_class + 1);
+    }
+    retained_bytes_ += bytes;
+    buckets[size_class].push_back(std::move(buffer));
+}
+
+PixelBuffer SurfacePool::Acquire(size_t bytes, bool zeroed) {
+    return Take(pixel_buckets_, bytes, zeroed);
+}
+
+ChannelBuffer SurfacePool::AcquireChannels(size_t count, bool zeroed) {
+    return Take(channel_buckets_, count, zeroed);
+}
+
+void SurfacePool::Recycle(PixelBuffer&& buffer) {
+    Keep(pixel_buckets_, std::move(buffer));
+}
+
+void SurfacePool::Recycle(ChannelBuffer&& buffer) {
+    Keep(channel_buckets_, std::move(buffer));
+}
+
+void SurfacePool::Clear() {
+    pixel_buckets_.clear();
+    channel_buckets_.clear();
+    retained_bytes_ = 0;
+}
+
+} // namespace csvg
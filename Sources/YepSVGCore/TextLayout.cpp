@@ -0,0 +1,241 @@
+#include "YepSVGCore/TextLayout.hpp"
+
+#include "YepSVGCore/FontFamilies.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <set>
+#include <vector>
+
+namespace csvg {
+namespace {
+
+// Bounds memory for renderers that see unbounded distinct strings; the
+// whole table is dropped and rebuilt from the labels still in use.
+constexpr size_t kMaxLayouts = 4096;
+constexpr size_t kMaxFonts = 256;
+
+std::string Trim(const std::string& value) {
+    const auto begin = value.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    const auto end = value.find_last_not_of(" \t\r\n");
+    return value.substr(begin, end - begin + 1);
+}
+
+std::string Lower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
+
+bool FontFamilyExists(const std::string& family_name) {
+    static const std::set<std::string> available_families = []() {
+        std::set<std::string> names;
+        CFArrayRef families = CTFontManagerCopyAvailableFontFamilyNames();
+        if (families != nullptr) {
+            const CFIndex count = CFArrayGetCount(families);
+            for (CFIndex i = 0; i < count; ++i) {
+                const auto* item = static_cast<CFStringRef>(CFArrayGetValueAtIndex(families, i));
+                if (item == nullptr) {
+                    continue;
+                }
+                char buffer[256];
+                if (CFStringGetCString(item, buffer, sizeof(buffer), kCFStringEncodingUTF8)) {
+                    names.insert(Lower(Trim(buffer)));
+                }
+            }
+            CFRelease(families);
+        }
+        return names;
+    }();
+
+    return available_families.find(Lower(Trim(family_name))) != available_families.end();
+}
+
+CTFontRef CreateFont(const TextShapeKey& key) {
+    const std::string resolved_family = ResolveCssFontFamily(key.font_family, FontFamilyExists);
+    const CGFloat font_size = key.font_size;
+
+    CFStringRef family_name = CFStringCreateWithCString(kCFAllocatorDefault,
+                                                         resolved_family.c_str(),
+                                                         kCFStringEncodingUTF8);
+    CTFontRef font = nullptr;
+
+    const void* keys[] = {kCTFontFamilyNameAttribute};
+    const void* values[] = {family_name};
+    CFDictionaryRef descriptor_attrs = CFDictionaryCreate(kCFAllocatorDefault,
+                                                          keys,
+                                                          values,
+                                                          1,
+                                                          &kCFTypeDictionaryKeyCallBacks,
+                                                          &kCFTypeDictionaryValueCallBacks);
+    if (descriptor_attrs != nullptr) {
+        CTFontDescriptorRef descriptor = CTFontDescriptorCreateWithAttributes(descriptor_attrs);
+        if (descriptor != nullptr) {
+            font = CTFontCreateWithFontDescriptor(descriptor, font_size, nullptr);
+            CFRelease(descriptor);
+        }
+        CFRelease(descriptor_attrs);
+    }
+
+    if (font == nullptr) {
+        font = CTFontCreateWithName(family_name, font_size, nullptr);
+    }
+
+    CTFontSymbolicTraits desired_traits = 0;
+    if (key.bold) {
+        desired_traits |= kCTFontBoldTrait;
+    }
+    if (key.italic) {
+        desired_traits |= kCTFontItalicTrait;
+    }
+    if (desired_traits != 0) {
+        if (CTFontRef trait_font = CTFontCreateCopyWithSymbolicTraits(font,
+                                                                       font_size,
+                                                                       nullptr,
+                                                                       desired_traits,
+                                                                       kCTFontBoldTrait | kCTFontItalicTrait)) {
+            CFRelease(font);
+            font = trait_font;
+        }
+    }
+
+    CFRelease(family_name);
+    return font;
+}
+
+double CountSpaces(const std::string& text) {
+    return static_cast<double>(std::count(text.begin(), text.end(), ' '));
+}
+
+void AppendKeyFloat(std::string& out, float value) {
+    char bytes[sizeof(float)];
+    std::memcpy(bytes, &value, sizeof(float));
+    out.append(bytes, sizeof(float));
+}
+
+std::string FontCacheKey(const TextShapeKey& key) {
+    std::string out = key.font_family;
+    out.push_back('\0');
+    AppendKeyFloat(out, key.font_size);
+    out.push_back(key.bold ? 'b' : '-');
+    out.push_back(key.italic ? 'i' : '-');
+    return out;
+}
+
+} // namespace
+
+TextShapeKey TextShapeKey::FromStyle(const ResolvedStyle& style) {
+    TextShapeKey key;
+    key.font_family = style.font_family;
+    key.font_size = style.font_size > 0.0f ? style.font_size : 16.0f;
+    key.bold = style.font_weight >= 600;
+    key.italic = style.font_style == "italic" || style.font_style == "oblique";
+    key.letter_spacing = style.letter_spacing;
+    key.word_spacing = style.word_spacing;
+    return key;
+}
+
+TextLayout::~TextLayout() {
+    if (line_ != nullptr) {
+        CFRelease(line_);
+    }
+    if (font_ != nullptr) {
+        CFRelease(font_);
+    }
+}
+
+TextLayoutCache::~TextLayoutCache() {
+    ReleaseFonts();
+}
+
+void TextLayoutCache::ReleaseFonts() {
+    for (const auto& entry : fonts_) {
+        CFRelease(entry.second);
+    }
+    fonts_.clear();
+}
+
+CTFontRef TextLayoutCache::FontFor(const TextShapeKey& key) {
+    std::string font_key = FontCacheKey(key);
+    if (const auto it = fonts_.find(font_key); it != fonts_.end()) {
+        return it->second;
+    }
+    if (fonts_.size() >= kMaxFonts) {
+        ReleaseFonts();
+    }
+    CTFontRef font = CreateFont(key);
+    if (font != nullptr) {
+        fonts_.emplace(std::move(font_key), font);
+    }
+    return font;
+}
+
+std::shared_ptr<const TextLayout> TextLayoutCache::Get(const std::string& text, const TextShapeKey& key) {
+    std::string cache_key = FontCacheKey(key);
+    AppendKeyFloat(cache_key, key.letter_spacing);
+    AppendKeyFloat(cache_key, key.word_spacing);
+    cache_key += text;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (const auto it = layouts_.find(cache_key); it != layouts_.end()) {
+        return it->second;
+    }
+
+    std::shared_ptr<TextLayout> layout(new TextLayout());
+    CTFontRef font = text.empty() ? nullptr : FontFor(key);
+    CFStringRef string = font != nullptr
+        ? CFStringCreateWithCString(kCFAllocatorDefault, text.c_str(), kCFStringEncodingUTF8)
+        : nullptr;
+    if (string != nullptr) {
+        layout->font_ = static_cast<CTFontRef>(CFRetain(font));
+
+        CFNumberRef kern = nullptr;
+        const CGFloat kern_value = key.letter_spacing;
+        if (std::abs(kern_value) > 0.0001) {
+            kern = CFNumberCreate(kCFAllocatorDefault, kCFNumberCGFloatType, &kern_value);
+        }
+        std::array<CFTypeRef, 3> keys = {kCTFontAttributeName, kCTForegroundColorFromContextAttributeName, kCTKernAttributeName};
+        std::array<CFTypeRef, 3> values = {font, kCFBooleanTrue, kern};
+        CFDictionaryRef attrs = CFDictionaryCreate(kCFAllocatorDefault,
+                                                   reinterpret_cast<const void**>(keys.data()),
+                                                   reinterpret_cast<const void**>(values.data()),
+                                                   kern != nullptr ? 3 : 2,
+                                                   &kCFTypeDictionaryKeyCallBacks,
+                                                   &kCFTypeDictionaryValueCallBacks);
+        CFAttributedStringRef attr_string = CFAttributedStringCreate(kCFAllocatorDefault, string, attrs);
+        if (attr_string != nullptr) {
+            layout->line_ = CTLineCreateWithAttributedString(attr_string);
+            CFRelease(attr_string);
+        }
+        if (layout->line_ != nullptr) {
+            CGFloat ascent = 0.0;
+            CGFloat descent = 0.0;
+            double width = CTLineGetTypographicBounds(layout->line_, &ascent, &descent, nullptr);
+            if (!std::isfinite(width)) {
+                width = 0.0;
+            }
+            layout->width_ = width + key.word_spacing * CountSpaces(text);
+            layout->ascent_ = ascent;
+            layout->descent_ = descent;
+        }
+
+        CFRelease(attrs);
+        if (kern != nullptr) {
+            CFRelease(kern);
+        }
+        CFRelease(string);
+    }
+
+    if (layouts_.size() >= kMaxLayouts) {
+        layouts_.clear();
+    }
+    layouts_.emplace(std::move(cache_key), layout);
+    return layout;
+}
+
+} // namespace csvg
@@ -0,0 +1,110 @@
+#include "YepSVGCore/Theme.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "YepSVGCore/StyleResolver.hpp"
+
+namespace csvg {
+namespace {
+
+constexpr int kMaxVariableDepth = 16;
+
+std::string Trim(const std::string& value) {
+    const auto begin = value.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    const auto end = value.find_last_not_of(" \t\r\n");
+    return value.substr(begin, end - begin + 1);
+}
+
+uint32_t ColorKey(const Color& color) {
+    const auto channel = [](float value) {
+        return static_cast<uint32_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+    };
+    return (channel(color.r) << 24) | (channel(color.g) << 16) | (channel(color.b) << 8) | channel(color.a);
+}
+
+bool IsUsableColor(const Color& color) {
+    return color.is_valid && !color.is_none;
+}
+
+// |open| indexes the '(' of a var(. Returns the index of the matching ')'.
+size_t FindClosingParen(const std::string& value, size_t open) {
+    int depth = 0;
+    for (size_t i = open; i < value.size(); ++i) {
+        if (value[i] == '(') {
+            ++depth;
+        } else if (value[i] == ')') {
+            --depth;
+            if (depth == 0) {
+                return i;
+            }
+        }
+    }
+    return std::string::npos;
+}
+
+} // namespace
+
+bool Theme::SetCurrentColor(const std::string& value) {
+    const Color parsed = StyleResolver::ParseColor(value);
+    if (!IsUsableColor(parsed)) {
+        return false;
+    }
+    current_color_ = parsed;
+    return true;
+}
+
+bool Theme::MapColor(const std::string& from, const std::string& to) {
+    const Color source = StyleResolver::ParseColor(from);
+    const Color replacement = StyleResolver::ParseColor(to);
+    if (!IsUsableColor(source) || !replacement.is_valid) {
+        return false;
+    }
+    color_map_[ColorKey(source)] = replacement;
+    return true;
+}
+
+void Theme::SetCustomProperty(const std::string& name, const std::string& value) {
+    const std::string trimmed = Trim(name);
+    custom_properties_[trimmed.rfind("--", 0) == 0 ? trimmed : "--" + trimmed] = value;
+}
+
+Color Theme::Apply(const Color& color) const {
+    if (color_map_.empty() || !IsUsableColor(color)) {
+        return color;
+    }
+    const auto it = color_map_.find(ColorKey(color));
+    return it != color_map_.end() ? it->second : color;
+}
+
+std::string Theme::SubstituteVariables(const std::string& value) const {
+    std::string current = value;
+    for (int depth = 0; depth < kMaxVariableDepth; ++depth) {
+        const size_t start = current.find("var(");
+        if (start == std::string::npos) {
+            return current;
+        }
+        const size_t open = start + 3;
+        const size_t close = FindClosingParen(current, open);
+        if (close == std::string::npos) {
+            return current;
+        }
+
+        const std::string inside = current.substr(open + 1, close - open - 1);
+        const size_t comma = inside.find(',');
+        const std::string name = Trim(inside.substr(0, comma));
+        std::string replacement;
+        if (const auto it = custom_properties_.find(name); it != custom_properties_.end()) {
+            replacement = it->second;
+        } else if (comma != std::string::npos) {
+            replacement = Trim(inside.substr(comma + 1));
+        }
+        current = current.substr(0, start) + replacement + current.substr(close + 1);
+    }
+    return current;
+}
+
+} // namespace csvg
@@ -0,0 +1,156 @@
+#include "YepSVGCore/Transform.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+namespace csvg {
+namespace {
+
+std::string Lower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
+
+} // namespace
+
+bool AffineMatrix::IsIdentity() const {
+    return a == 1.0 && b == 0.0 && c == 0.0 && d == 1.0 && e == 0.0 && f == 0.0;
+}
+
+void AffineMatrix::Map(double x, double y, double& out_x, double& out_y) const {
+    out_x = a * x + c * y + e;
+    out_y = b * x + d * y + f;
+}
+
+AffineMatrix AffineMatrix::Concat(const AffineMatrix& first, const AffineMatrix& then) {
+    AffineMatrix out;
+    out.a = first.a * then.a + first.b * then.c;
+    out.b = first.a * then.b + first.b * then.d;
+    out.c = first.c * then.a + first.d * then.c;
+    out.d = first.c * then.b + first.d * then.d;
+    out.e = first.e * then.a + first.f * then.c + then.e;
+    out.f = first.e * then.b + first.f * then.d + then.f;
+    return out;
+}
+
+AffineMatrix AffineMatrix::Translation(double tx, double ty) {
+    AffineMatrix out;
+    out.e = tx;
+    out.f = ty;
+    return out;
+}
+
+AffineMatrix AffineMatrix::Scale(double sx, double sy) {
+    AffineMatrix out;
+    out.a = sx;
+    out.d = sy;
+    return out;
+}
+
+AffineMatrix AffineMatrix::Rotation(double radians) {
+    const double cos_angle = std::cos(radians);
+    const double sin_angle = std::sin(radians);
+    AffineMatrix out;
+    out.a = cos_angle;
+    out.b = sin_angle;
+    out.c = -sin_angle;
+    out.d = cos_angle;
+    return out;
+}
+
+AffineMatrix TransformParser::Parse(const std::string& raw) const {
+    AffineMatrix transform;
+    size_t i = 0;
+
+    while (i < raw.size()) {
+        while (i < raw.size() && (std::isspace(static_cast<unsigned char>(raw[i])) || raw[i] == ',')) {
+            ++i;
+        }
+        if (i >= raw.size()) {
+            break;
+        }
+
+        const size_t name_start = i;
+        while (i < raw.size() && std::isalpha(static_cast<unsigned char>(raw[i]))) {
+            ++i;
+        }
+        if (i <= name_start) {
+            ++i;
+            continue;
+        }
+
+        const std::string name = Lower(raw.substr(name_start, i - name_start));
+        while (i < raw.size() && std::isspace(static_cast<unsigned char>(raw[i]))) {
+            ++i;
+        }
+        if (i >= raw.size() || raw[i] != '(') {
+            continue;
+        }
+        ++i;
+
+        std::vector<double> params;
+        while (i < raw.size() && raw[i] != ')') {
+            while (i < raw.size() && (std::isspace(static_cast<unsigned char>(raw[i])) || raw[i] == ',')) {
+                ++i;
+            }
+            if (i >= raw.size() || raw[i] == ')') {
+                break;
+            }
+
+            const char* start = raw.c_str() + i;
+            char* end_ptr = nullptr;
+            const double value = std::strtod(start, &end_ptr);
+            if (end_ptr == start) {
+                ++i;
+                continue;
+            }
+            params.push_back(value);
+            i = static_cast<size_t>(end_ptr - raw.c_str());
+        }
+
+        if (i < raw.size() && raw[i] == ')') {
+            ++i;
+        }
+
+        AffineMatrix current;
+        if (name == "matrix" && params.size() >= 6) {
+            current.a = params[0];
+            current.b = params[1];
+            current.c = params[2];
+            current.d = params[3];
+            current.e = params[4];
+            current.f = params[5];
+        } else if (name == "translate" && !params.empty()) {
+            const double tx = params[0];
+            const double ty = params.size() > 1 ? params[1] : 0.0;
+            current = AffineMatrix::Translation(tx, ty);
+        } else if (name == "scale" && !params.empty()) {
+            const double sx = params[0];
+            const double sy = params.size() > 1 ? params[1] : sx;
+            current = AffineMatrix::Scale(sx, sy);
+        } else if (name == "rotate" && !params.empty()) {
+            const double angle_rad = params[0] * M_PI / 180.0;
+            current = AffineMatrix::Rotation(angle_rad);
+            if (params.size() > 2) {
+                const double cx = params[1];
+                const double cy = params[2];
+                current = AffineMatrix::Concat(AffineMatrix::Translation(-cx, -cy), current);
+                current = AffineMatrix::Concat(current, AffineMatrix::Translation(cx, cy));
+            }
+        } else if (name == "skewx" && !params.empty()) {
+            current.c = std::tan(params[0] * M_PI / 180.0);
+        } else if (name == "skewy" && !params.empty()) {
+            current.b = std::tan(params[0] * M_PI / 180.0);
+        }
+
+        // SVG applies listed transforms from left-to-right.
+        transform = AffineMatrix::Concat(current, transform);
+    }
+
+    return transform;
+}
+
+} // namespace csvg
@@ -3,40 +3,31 @@
 #include <algorithm>
 #include <cctype>
 #include <cstdint>
-#include <regex>
 #include <sstream>
 #include <stack>
+#include <string_view>
 
 namespace csvg {
 namespace {
 
-std::string Trim(const std::string& value) {
+std::string_view TrimView(std::string_view value) {
     const auto begin = value.find_first_not_of(" \t\r\n");
-    if (begin == std::string::npos) {
-        return "";
+    if (begin == std::string_view::npos) {
+        return {};
     }
     const auto end = value.find_last_not_of(" \t\r\n");
     return value.substr(begin, end - begin + 1);
 }
 
-std::map<std::string, std::string> ParseAttributes(const std::string& raw) {
-    static const std::regex kAttrRegex(R"CSVG(([A-Za-z_:][-A-Za-z0-9_:.]*)\s*=\s*("([^"]*)"|'([^']*)'))CSVG");
-    std::map<std::string, std::string> out;
-    auto begin = std::sregex_iterator(raw.begin(), raw.end(), kAttrRegex);
-    auto end = std::sregex_iterator();
-    for (auto it = begin; it != end; ++it) {
-        const auto key = (*it)[1].str();
-        const auto value = (*it)[3].matched ? (*it)[3].str() : (*it)[4].str();
-        out[key] = value;
-    }
-    return out;
-}
-
 bool IsWhitespace(char c) {
     return std::isspace(static_cast<unsigned char>(c)) != 0;
 }
 
-std::string DecodeXmlEntities(const std::string& text) {
+std::string DecodeXmlEntities(std::string_view text) {
+    if (text.find('&') == std::string_view::npos) {
+        return std::string(text);
+    }
+
     std::string out;
     out.reserve(text.size());
 
@@ -47,12 +38,12 @@ std::string DecodeXmlEntities(const std::string& text) {
         }
 
         const size_t semi = text.find(';', i + 1);
-        if (semi == std::string::npos) {
+        if (semi == std::string_view::npos) {
             out.push_back(text[i]);
             continue;
         }
 
-        const std::string entity = text.substr(i + 1, semi - i - 1);
+        const std::string_view entity = text.substr(i + 1, semi - i - 1);
         auto append_code_point = [&out](uint32_t codepoint) {
             if (codepoint <= 0x7F) {
                 out.push_back(static_cast<char>(codepoint));
@@ -86,9 +77,9 @@ std::string DecodeXmlEntities(const std::string& text) {
             uint32_t codepoint = 0;
             try {
                 if (entity.size() > 2 && (entity[1] == 'x' || entity[1] == 'X')) {
-                    codepoint = static_cast<uint32_t>(std::stoul(entity.substr(2), nullptr, 16));
+                    codepoint = static_cast<uint32_t>(std::stoul(std::string(entity.substr(2)), nullptr, 16));
                 } else {
-                    codepoint = static_cast<uint32_t>(std::stoul(entity.substr(1), nullptr, 10));
+                    codepoint = static_cast<uint32_t>(std::stoul(std::string(entity.substr(1)), nullptr, 10));
                 }
             } catch (...) {
                 replaced = false;
@@ -110,6 +101,60 @@ std::string DecodeXmlEntities(const std::string& text) {
     return out;
 }
 
+bool IsAttrNameStart(char c) {
+    return std::isalpha(static_cast<unsigned char>(c)) || c == '_' || c == ':';
+}
+
+bool IsAttrNameChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == ':' || c == '-' || c == '.';
+}
+
+// Linear scan for name="value" / name='value' pairs; text that does not form
+// a pair is skipped. Values are copied once, straight from the source text.
+AttributeMap ParseAttributes(std::string_view raw) {
+    AttributeMap out;
+    bool missing_quote[2] = {false, false};
+    size_t i = 0;
+    while (i < raw.size()) {
+        if (!IsAttrNameStart(raw[i])) {
+            ++i;
+            continue;
+        }
+        const size_t name_start = i;
+        while (i < raw.size() && IsAttrNameChar(raw[i])) {
+            ++i;
+        }
+        const size_t name_end = i;
+
+        size_t cursor = name_end;
+        while (cursor < raw.size() && std::isspace(static_cast<unsigned char>(raw[cursor]))) {
+            ++cursor;
+        }
+        if (cursor >= raw.size() || raw[cursor] != '=') {
+            continue;
+        }
+        ++cursor;
+        while (cursor < raw.size() && std::isspace(static_cast<unsigned char>(raw[cursor]))) {
+            ++cursor;
+        }
+        if (cursor >= raw.size() || (raw[cursor] != '"' && raw[cursor] != '\'')) {
+            continue;
+        }
+
+        const char quote = raw[cursor];
+        bool& quote_missing = missing_quote[quote == '"' ? 0 : 1];
+        const size_t close = quote_missing ? std::string_view::npos : raw.find(quote, cursor + 1);
+        if (close == std::string_view::npos) {
+            quote_missing = true;
+            continue;
+        }
+
+        out.Set(std::string(raw.substr(name_start, name_end - name_start)), DecodeXmlEntities(raw.substr(cursor + 1, close - cursor - 1)));
+        i = close + 1;
+    }
+    return out;
+}
+
 std::map<std::string, std::string> ParseDoctypeEntities(const std::string& doctype_decl) {
     std::map<std::string, std::string> entities;
 
@@ -261,15 +306,21 @@ std::string PreprocessDoctypeAndEntities(const std::string& text) {
 std::optional<XmlNode> XmlParser::Parse(const std::string& text, RenderError& error) const {
     error = {};
 
-    if (Trim(text).empty()) {
+    if (TrimView(text).empty()) {
         error.code = RenderErrorCode::kInvalidDocument;
         error.message = "SVG input is empty";
         return std::nullopt;
     }
 
-    const std::string preprocessed = PreprocessDoctypeAndEntities(text);
+    // Tokens below are views into the source; only a DOCTYPE, whose entities
+    // are expanded up front, needs a rewritten copy.
+    std::string expanded;
+    std::string_view preprocessed = text;
+    if (text.find("<!DOCTYPE") != std::string::npos) {
+        expanded = PreprocessDoctypeAndEntities(text);
+        preprocessed = expanded;
+    }
 
-    static const std::regex kTokenRegex(R"((<[^>]+>)|([^<]+))");
     std::vector<XmlNode> node_stack;
     std::vector<size_t> child_indices;
 
@@ -277,25 +328,39 @@ std::optional<XmlNode> XmlParser::Parse(const std::string& text, RenderError& er
     root_holder.name = "__root__";
     node_stack.push_back(root_holder);
 
-    auto begin = std::sregex_iterator(preprocessed.begin(), preprocessed.end(), kTokenRegex);
-    auto end = std::sregex_iterator();
     bool in_comment_block = false;
+    bool tag_close_missing = false;
 
-    for (auto it = begin; it != end; ++it) {
-        const auto token = (*it).str();
-        if (token.empty()) {
-            continue;
+    size_t cursor = 0;
+    while (cursor < preprocessed.size()) {
+        std::string_view token;
+        if (preprocessed[cursor] == '<') {
+            const size_t close = tag_close_missing ? std::string_view::npos : preprocessed.find('>', cursor + 1);
+            if (close == std::string_view::npos) {
+                tag_close_missing = true;
+            }
+            if (close == std::string_view::npos || close == cursor + 1) {
+                ++cursor;
+                continue;
+            }
+            token = preprocessed.substr(cursor, close - cursor + 1);
+            cursor = close + 1;
+        } else {
+            const size_t next = preprocessed.find('<', cursor);
+            const size_t stop = next == std::string_view::npos ? preprocessed.size() : next;
+            token = preprocessed.substr(cursor, stop - cursor);
+            cursor = stop;
         }
 
         if (in_comment_block) {
-            if (token.find("-->") != std::string::npos) {
+            if (token.find("-->") != std::string_view::npos) {
                 in_comment_block = false;
             }
             continue;
         }
 
         if (token.rfind("<!--", 0) == 0) {
-            if (token.find("-->") == std::string::npos) {
+            if (token.find("-->") == std::string_view::npos) {
                 in_comment_block = true;
             }
             continue;
@@ -303,7 +368,7 @@ std::optional<XmlNode> XmlParser::Parse(const std::string& text, RenderError& er
 
         if (token[0] != '<') {
             if (!node_stack.empty()) {
-                if (token.find_first_not_of(" \t\r\n") == std::string::npos) {
+                if (token.find_first_not_of(" \t\r\n") == std::string_view::npos) {
                     continue;
                 }
                 node_stack.back().text += DecodeXmlEntities(token);
@@ -313,8 +378,8 @@ std::optional<XmlNode> XmlParser::Parse(const std::string& text, RenderError& er
 
         if (token.rfind("<![CDATA[", 0) == 0) {
             if (!node_stack.empty()) {
-                const std::string prefix = "<![CDATA[";
-                const std::string suffix = "]]>";
+                const std::string_view prefix = "<![CDATA[";
+                const std::string_view suffix = "]]>";
                 if (token.size() >= prefix.size() + suffix.size() &&
                     token.compare(token.size() - suffix.size(), suffix.size(), suffix) == 0) {
                     node_stack.back().text += token.substr(prefix.size(),
@@ -335,35 +400,34 @@ std::optional<XmlNode> XmlParser::Parse(const std::string& text, RenderError& er
                 return std::nullopt;
             }
 
-            std::string close_tag = token.substr(2, token.size() - 3);
-            close_tag = Trim(close_tag);
+            const std::string_view close_tag = TrimView(token.substr(2, token.size() - 3));
             if (!close_tag.empty() && node_stack.back().name != close_tag) {
                 error.code = RenderErrorCode::kInvalidDocument;
                 error.message = "Malformed SVG: closing tag mismatch";
                 return std::nullopt;
             }
 
-            XmlNode closed = node_stack.back();
+            XmlNode closed = std::move(node_stack.back());
             node_stack.pop_back();
             node_stack.back().children.push_back(std::move(closed));
             continue;
         }
 
         const bool self_closing = token.size() > 2 && token[token.size() - 2] == '/';
-        std::string inner = token.substr(1, token.size() - 2);
+        std::string_view inner = token.substr(1, token.size() - 2);
         if (self_closing && !inner.empty()) {
-            inner.pop_back();
+            inner.remove_suffix(1);
         }
-        inner = Trim(inner);
+        inner = TrimView(inner);
         if (inner.empty()) {
             continue;
         }
 
-        std::string tag_name;
-        std::string attr_blob;
+        std::string_view tag_name;
+        std::string_view attr_blob;
 
         const auto split = inner.find_first_of(" \t\r\n");
-        if (split == std::string::npos) {
+        if (split == std::string_view::npos) {
             tag_name = inner;
         } else {
             tag_name = inner.substr(0, split);
@@ -371,11 +435,8 @@ std::optional<XmlNode> XmlParser::Parse(const std::string& text, RenderError& er
         }
 
         XmlNode node;
-        node.name = tag_name;
+        node.name = std::string(tag_name);
         node.attributes = ParseAttributes(attr_blob);
-        for (auto& [key, value] : node.attributes) {
-            value = DecodeXmlEntities(value);
-        }
 
         if (self_closing) {
             node_stack.back().children.push_back(std::move(node));
@@ -385,7 +446,7 @@ std::optional<XmlNode> XmlParser::Parse(const std::string& text, RenderError& er
     }
 
     while (node_stack.size() > 1) {
-        XmlNode closed = node_stack.back();
+        XmlNode closed = std::move(node_stack.back());
         node_stack.pop_back();
         node_stack.back().children.push_back(std::move(closed));
     }
@@ -396,7 +457,7 @@ std::optional<XmlNode> XmlParser::Parse(const std::string& text, RenderError& er
         return std::nullopt;
     }
 
-    return node_stack.front().children.front();
+    return std::move(node_stack.front().children.front());
 }
 
 } // namespace csvg
@@ -0,0 +1,81 @@
+#ifndef CHROMIUM_SVG_CORE_ATTRIBUTE_VALUES_HPP
+#define CHROMIUM_SVG_CORE_ATTRIBUTE_VALUES_HPP
+
+#include "YepSVGCore/Transform.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace csvg {
+
+enum class LengthUnit : uint8_t {
+    kNone,
+    kPx,
+    kPercent,
+    kPt,
+    kPc,
+    kIn,
+    kCm,
+    kMm,
+    kQ,
+    // Unrecognised suffixes (em, ex, ...) keep the bare number.
+    kOther,
+};
+
+enum class LengthAxis : uint8_t {
+    kX,
+    kY,
+    kDiagonal,
+};
+
+// First component of a length, number or length list attribute.
+// Percentages stay unresolved until the viewport is known.
+struct SvgLength {
+    double value = 0.0;
+    LengthUnit unit = LengthUnit::kNone;
+
+    double ToPixels(LengthAxis axis, double viewport_width, double viewport_height) const;
+    // Bare number, with percentages as fractions (50% -> 0.5). Used for
+    // objectBoundingBox units and plain numeric attributes.
+    double ToNumber() const;
+};
+
+struct ViewBox {
+    double x = 0.0;
+    double y = 0.0;
+    double width = 0.0;
+    double height = 0.0;
+
+    bool IsValid() const { return width > 0.0 && height > 0.0; }
+};
+
+struct PreserveAspectRatio {
+    bool none = false;
+    bool slice = false;
+    double align_x = 0.5;
+    double align_y = 0.5;
+};
+
+using AttributeValue = std::variant<std::monostate, SvgLength, ViewBox, PreserveAspectRatio, AffineMatrix, std::vector<double>>;
+
+double PercentBasis(LengthAxis axis, double viewport_width, double viewport_height);
+
+std::optional<SvgLength> ParseSvgLength(std::string_view raw);
+// Four numbers separated by whitespace and/or commas; trailing text is ignored.
+std::optional<ViewBox> ParseViewBox(std::string_view raw);
+// Empty or unparsable input yields the default xMidYMid meet.
+PreserveAspectRatio ParsePreserveAspectRatio(std::string_view raw);
+std::vector<double> ParseNumberList(std::string_view raw);
+
+// Maps |view_box| into a viewport of the given size.
+AffineMatrix ViewBoxTransform(double viewport_width,
+                              double viewport_height,
+                              const ViewBox& view_box,
+                              const PreserveAspectRatio& preserve);
+
+} // namespace csvg
+
+#endif
@@ -0,0 +1,224 @@
+#ifndef CHROMIUM_SVG_CORE_ATTRIBUTES_HPP
+#define CHROMIUM_SVG_CORE_ATTRIBUTES_HPP
+
+#include "YepSVGCore/AttributeValues.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace csvg {
+
+// Attribute names the engine reads. Kept sorted by name (byte order):
+// LookupAttrId binary-searches this list.
+#define CSVG_ATTRIBUTE_LIST(X) \
+    X(kAmplitude, "amplitude") \
+    X(kAzimuth, "azimuth") \
+    X(kBaseFrequency, "baseFrequency") \
+    X(kBias, "bias") \
+    X(kClass, "class") \
+    X(kClipPath, "clip-path") \
+    X(kClipRule, "clip-rule") \
+    X(kClipPathUnits, "clipPathUnits") \
+    X(kColor, "color") \
+    X(kColorInterpolationFilters, "color-interpolation-filters") \
+    X(kColorProfile, "color-profile") \
+    X(kCx, "cx") \
+    X(kCy, "cy") \
+    X(kD, "d") \
+    X(kDiffuseConstant, "diffuseConstant") \
+    X(kDirection, "direction") \
+    X(kDisplay, "display") \
+    X(kDivisor, "divisor") \
+    X(kDominantBaseline, "dominant-baseline") \
+    X(kDx, "dx") \
+    X(kDy, "dy") \
+    X(kEdgeMode, "edgeMode") \
+    X(kElevation, "elevation") \
+    X(kExponent, "exponent") \
+    X(kFill, "fill") \
+    X(kFillOpacity, "fill-opacity") \
+    X(kFillRule, "fill-rule") \
+    X(kFilter, "filter") \
+    X(kFilterUnits, "filterUnits") \
+    X(kFloodColor, "flood-color") \
+    X(kFloodOpacity, "flood-opacity") \
+    X(kFont, "font") \
+    X(kFontFamily, "font-family") \
+    X(kFontSize, "font-size") \
+    X(kFontStyle, "font-style") \
+    X(kFontWeight, "font-weight") \
+    X(kFx, "fx") \
+    X(kFy, "fy") \
+    X(kGradientTransform, "gradientTransform") \
+    X(kGradientUnits, "gradientUnits") \
+    X(kHeight, "height") \
+    X(kHref, "href") \
+    X(kId, "id") \
+    X(kIn, "in") \
+    X(kIn2, "in2") \
+    X(kIntercept, "intercept") \
+    X(kK1, "k1") \
+    X(kK2, "k2") \
+    X(kK3, "k3") \
+    X(kK4, "k4") \
+    X(kKernelMatrix, "kernelMatrix") \
+    X(kKernelUnitLength, "kernelUnitLength") \
+    X(kLengthAdjust, "lengthAdjust") \
+    X(kLetterSpacing, "letter-spacing") \
+    X(kLightingColor, "lighting-color") \
+    X(kLimitingConeAngle, "limitingConeAngle") \
+    X(kLocal, "local") \
+    X(kMarkerEnd, "marker-end") \
+    X(kMarkerMid, "marker-mid") \
+    X(kMarkerStart, "marker-start") \
+    X(kMarkerHeight, "markerHeight") \
+    X(kMarkerUnits, "markerUnits") \
+    X(kMarkerWidth, "markerWidth") \
+    X(kMask, "mask") \
+    X(kMaskContentUnits, "maskContentUnits") \
+    X(kMaskUnits, "maskUnits") \
+    X(kMethod, "method") \
+    X(kMode, "mode") \
+    X(kName, "name") \
+    X(kNumOctaves, "numOctaves") \
+    X(kOffset, "offset") \
+    X(kOpacity, "opacity") \
+    X(kOperator, "operator") \
+    X(kOrder, "order") \
+    X(kOrient, "orient") \
+    X(kOverflow, "overflow") \
+    X(kPath, "path") \
+    X(kPathLength, "pathLength") \
+    X(kPatternContentUnits, "patternContentUnits") \
+    X(kPatternTransform, "patternTransform") \
+    X(kPatternUnits, "patternUnits") \
+    X(kPointerEvents, "pointer-events") \
+    X(kPoints, "points") \
+    X(kPointsAtX, "pointsAtX") \
+    X(kPointsAtY, "pointsAtY") \
+    X(kPointsAtZ, "pointsAtZ") \
+    X(kPreserveAlpha, "preserveAlpha") \
+    X(kPreserveAspectRatio, "preserveAspectRatio") \
+    X(kPrimitiveUnits, "primitiveUnits") \
+    X(kR, "r") \
+    X(kRadius, "radius") \
+    X(kRefX, "refX") \
+    X(kRefY, "refY") \
+    X(kRenderingIntent, "rendering-intent") \
+    X(kResult, "result") \
+    X(kRotate, "rotate") \
+    X(kRx, "rx") \
+    X(kRy, "ry") \
+    X(kScale, "scale") \
+    X(kSeed, "seed") \
+    X(kSlope, "slope") \
+    X(kSpacing, "spacing") \
+    X(kSpecularConstant, "specularConstant") \
+    X(kSpecularExponent, "specularExponent") \
+    X(kSpreadMethod, "spreadMethod") \
+    X(kStartOffset, "startOffset") \
+    X(kStdDeviation, "stdDeviation") \
+    X(kStitchTiles, "stitchTiles") \
+    X(kStopColor, "stop-color") \
+    X(kStopOpacity, "stop-opacity") \
+    X(kStroke, "stroke") \
+    X(kStrokeDasharray, "stroke-dasharray") \
+    X(kStrokeDashoffset, "stroke-dashoffset") \
+    X(kStrokeLinecap, "stroke-linecap") \
+    X(kStrokeLinejoin, "stroke-linejoin") \
+    X(kStrokeMiterlimit, "stroke-miterlimit") \
+    X(kStrokeOpacity, "stroke-opacity") \
+    X(kStrokeWidth, "stroke-width") \
+    X(kStyle, "style") \
+    X(kSurfaceScale, "surfaceScale") \
+    X(kTableValues, "tableValues") \
+    X(kTargetX, "targetX") \
+    X(kTargetY, "targetY") \
+    X(kTextAnchor, "text-anchor") \
+    X(kTextDecoration, "text-decoration") \
+    X(kTextLength, "textLength") \
+    X(kTransform, "transform") \
+    X(kType, "type") \
+    X(kValues, "values") \
+    X(kViewBox, "viewBox") \
+    X(kVisibility, "visibility") \
+    X(kWidth, "width") \
+    X(kWordSpacing, "word-spacing") \
+    X(kX, "x") \
+    X(kX1, "x1") \
+    X(kX2, "x2") \
+    X(kXChannelSelector, "xChannelSelector") \
+    X(kXlinkHref, "xlink:href") \
+    X(kXmlSpace, "xml:space") \
+    X(kY, "y") \
+    X(kY1, "y1") \
+    X(kY2, "y2") \
+    X(kYChannelSelector, "yChannelSelector") \
+    X(kZ, "z")
+
+enum class AttrId : uint16_t {
+    kUnknown = 0,
+#define CSVG_ATTRIBUTE_ENUM(id, name) id,
+    CSVG_ATTRIBUTE_LIST(CSVG_ATTRIBUTE_ENUM)
+#undef CSVG_ATTRIBUTE_ENUM
+    kCount,
+};
+
+AttrId LookupAttrId(std::string_view name);
+std::string_view AttrName(AttrId id);
+
+// Attributes of one element. Known names live in a small array sorted by
+// AttrId, so lookups by id are a few integer compares; names outside the list
+// follow in a side range sorted by name. Iterates as (name, value) pairs, in
+// that order rather than alphabetically.
+//
+// Geometry, viewBox, preserveAspectRatio, transform, point-list and numeric
+// filter attributes are also parsed into typed values when set, so painting
+// reads them without touching the string again.
+class AttributeMap {
+public:
+    using value_type = std::pair<std::string, std::string>;
+    using const_iterator = std::vector<value_type>::const_iterator;
+
+    const_iterator begin() const { return entries_.begin(); }
+    const_iterator end() const { return entries_.end(); }
+    size_t size() const { return entries_.size(); }
+    bool empty() const { return entries_.empty(); }
+
+    const_iterator find(AttrId id) const;
+    const_iterator find(std::string_view name) const;
+    size_t count(AttrId id) const { return find(id) != end() ? 1 : 0; }
+    size_t count(std::string_view name) const { return find(name) != end() ? 1 : 0; }
+    // Throws std::out_of_range when absent, like std::map::at.
+    const std::string& at(AttrId id) const;
+    const std::string& at(std::string_view name) const;
+
+    // Returns nullptr when absent.
+    const std::string* Get(AttrId id) const;
+
+    // Typed accessors; nullptr when absent, unparsable or not a typed attribute.
+    const SvgLength* GetLength(AttrId id) const;
+    const ViewBox* GetViewBox(AttrId id) const;
+    const PreserveAspectRatio* GetPreserveAspectRatio(AttrId id) const;
+    const AffineMatrix* GetTransform(AttrId id) const;
+    const std::vector<double>* GetNumberList(AttrId id) const;
+
+    // Inserts or replaces; a repeated name keeps the last value.
+    void Set(std::string name, std::string value);
+
+private:
+    std::vector<value_type> entries_;
+    // Parallel to entries_; kUnknown for the side range.
+    std::vector<AttrId> ids_;
+    // Parallel to the known range of entries_.
+    std::vector<AttributeValue> values_;
+    size_t known_count_ = 0;
+};
+
+} // namespace csvg
+
+#endif
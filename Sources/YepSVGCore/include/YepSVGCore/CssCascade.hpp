@@ -0,0 +1,32 @@
+#ifndef CHROMIUM_SVG_CORE_CSS_CASCADE_HPP
+#define CHROMIUM_SVG_CORE_CSS_CASCADE_HPP
+
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "YepSVGCore/DocumentIndex.hpp"
+#include "YepSVGCore/Stylesheet.hpp"
+#include "YepSVGCore/Types.hpp"
+
+namespace csvg {
+
+struct CssCascade {
+    // Cascade order: shared sheets in attach order, then the document's own.
+    std::vector<const Stylesheet*> sheets;
+    std::shared_ptr<const Stylesheet> document_sheet;
+    const std::unordered_map<const XmlNode*, const XmlNode*>* parent_by_node = nullptr;
+    const std::unordered_map<const XmlNode*, size_t>* index_in_parent = nullptr;
+};
+
+// |index| must outlive the cascade. Combinators and :first-child need the
+// index to have been built with its hierarchy; see Document::IndexFor.
+CssCascade BuildCssCascade(const DocumentIndex& index, const RenderOptions& options);
+
+// Winning declarations of every rule in |cascade| that matches |node|.
+PropertyMap ResolveMatchedCssProperties(const XmlNode& node, const CssCascade& cascade);
+
+} // namespace csvg
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef CHROMIUM_SVG_CORE_CSS_COLOR_HPP
+#define CHROMIUM_SVG_CORE_CSS_COLOR_HPP
+
+#include <optional>
+#include <string_view>
+
+#include "YepSVGCore/Types.hpp"
+
+namespace csvg {
+
+// Parses none, #rgb, #rgba, #rrggbb, #rrggbbaa, rgb()/rgba() and the CSS color
+// keywords in a single pass without allocating. Matching is case-insensitive
+// and surrounding whitespace is ignored. currentColor is left to the caller.
+// Returns a Color with is_valid == false when the value is not a color.
+Color ParseCssColor(std::string_view value);
+
+// Case-insensitive lookup in the compile-time perfect-hash keyword table.
+std::optional<Color> LookupColorKeyword(std::string_view name);
+
+} // namespace csvg
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef CHROMIUM_SVG_CORE_CSS_PARSER_HPP
+#define CHROMIUM_SVG_CORE_CSS_PARSER_HPP
+
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "YepSVGCore/Types.hpp"
+
+namespace csvg {
+
+enum class CssCombinator {
+    kNone,
+    kDescendant,
+    kChild,
+    kAdjacent,
+};
+
+enum class CssAttributeOperator {
+    kExists,
+    kEquals,
+    kIncludes,
+    kDashMatch,
+};
+
+struct CssAttributeSelector {
+    std::string name;
+    CssAttributeOperator op = CssAttributeOperator::kExists;
+    std::string value;
+};
+
+struct CssSimpleSelector {
+    std::string tag = "*";
+    std::optional<std::string> id;
+    std::vector<std::string> classes;
+    std::vector<CssAttributeSelector> attributes;
+    bool first_child = false;
+};
+
+struct CssSelectorStep {
+    CssSimpleSelector simple;
+    CssCombinator combinator_to_prev = CssCombinator::kNone;
+};
+
+struct CssSelector {
+    std::vector<CssSelectorStep> steps;
+    int specificity = 0;
+};
+
+struct CssRule {
+    std::vector<CssSelector> selectors;
+    PropertyMap declarations;
+    size_t source_order = 0;
+};
+
+class CssParser {
+public:
+    std::optional<CssSelector> ParseSelector(const std::string& selector_text) const;
+    PropertyMap ParseDeclarations(const std::string& declarations_text) const;
+
+    // Appends the rules of one stylesheet block. |source_order| keeps counting
+    // across calls so later blocks win specificity ties.
+    void ParseRules(const std::string& css_text, size_t& source_order, std::vector<CssRule>& rules) const;
+};
+
+} // namespace csvg
+
+#endif
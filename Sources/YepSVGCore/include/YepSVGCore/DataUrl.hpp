@@ -0,0 +1,21 @@
+#ifndef CHROMIUM_SVG_CORE_DATA_URL_HPP
+#define CHROMIUM_SVG_CORE_DATA_URL_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace csvg {
+
+class DataUrlDecoder {
+public:
+    // Skips ASCII whitespace and stops at the first '='; any other byte
+    // outside the base64 alphabet fails.
+    static std::optional<std::vector<uint8_t>> DecodeBase64(std::string_view input);
+    static std::optional<std::vector<uint8_t>> Decode(std::string_view href);
+};
+
+} // namespace csvg
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef CHROMIUM_SVG_CORE_DOCUMENT_HPP
+#define CHROMIUM_SVG_CORE_DOCUMENT_HPP
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "YepSVGCore/DocumentIndex.hpp"
+#include "YepSVGCore/Types.hpp"
+
+namespace csvg {
+
+// A parsed and indexed SVG that can be rendered repeatedly with different
+// options, stylesheets and themes. The index points into the DOM, so a
+// Document is neither copyable nor movable; hand it around by pointer.
+class Document {
+public:
+    // |index_hierarchy| is forwarded to DocumentIndexer::Build.
+    static std::unique_ptr<Document> Parse(const std::string& svg_text, bool index_hierarchy, RenderError& error);
+
+    Document(const Document&) = delete;
+    Document& operator=(const Document&) = delete;
+
+    const SvgDocument& svg() const { return svg_; }
+    const DocumentIndex& index() const { return index_; }
+    // The index to match |options| against. Shared stylesheets need the
+    // parent/sibling maps, which are built on first use when Parse skipped
+    // them; concurrent renders may call this.
+    const DocumentIndex& IndexFor(const RenderOptions& options) const;
+
+private:
+    Document() = default;
+
+    SvgDocument svg_;
+    mutable DocumentIndex index_;
+    bool has_hierarchy_ = false;
+    mutable std::once_flag hierarchy_once_;
+};
+
+} // namespace csvg
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef CHROMIUM_SVG_CORE_DOCUMENT_INDEX_HPP
+#define CHROMIUM_SVG_CORE_DOCUMENT_INDEX_HPP
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "YepSVGCore/Types.hpp"
+
+namespace csvg {
+
+struct DocumentFeatures {
+    // A non-empty <style> block; selector matching needs the hierarchy maps.
+    bool uses_css = false;
+};
+
+struct ExternalReference {
+    // Raw href / xlink:href value, viewing the document's attributes.
+    std::string_view url;
+    ResourcePurpose purpose = ResourcePurpose::kOther;
+};
+
+struct DocumentIndex {
+    // Every href / xlink:href in document order.
+    std::vector<ExternalReference> external_urls;
+
+    // First element wins for duplicate ids.
+    std::map<std::string, const XmlNode*> nodes_by_id;
+
+    std::vector<const XmlNode*> gradient_nodes;
+    std::vector<const XmlNode*> pattern_nodes;
+    std::vector<const XmlNode*> color_profile_nodes;
+    std::vector<const XmlNode*> filter_nodes;
+    std::vector<std::string> css_blocks;
+
+    // Only populated when the document carries <style> blocks or the indexer
+    // was asked for them.
+    std::unordered_map<const XmlNode*, const XmlNode*> parent_by_node;
+    std::unordered_map<const XmlNode*, size_t> index_in_parent;
+
+    size_t node_count = 0;
+    DocumentFeatures features;
+};
+
+class DocumentIndexer {
+public:
+    // |index_hierarchy| forces the parent/sibling maps, e.g. when shared
+    // stylesheets will be matched against a document without <style>.
+    DocumentIndex Build(const SvgDocument& document, bool index_hierarchy = false) const;
+    // Fills the parent/sibling maps of an index built without them.
+    void BuildHierarchy(const SvgDocument& document, DocumentIndex& document_index) const;
+};
+
+} // namespace csvg
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef CHROMIUM_SVG_CORE_ELEMENT_BOUNDS_HPP
+#define CHROMIUM_SVG_CORE_ELEMENT_BOUNDS_HPP
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "YepSVGCore/Document.hpp"
+#include "YepSVGCore/Types.hpp"
+
+namespace csvg {
+
+struct BoundingBox {
+    double x = 0.0;
+    double y = 0.0;
+    double width = 0.0;
+    double height = 0.0;
+};
+
+struct ElementBounds {
+    // Geometry of the element and its descendants in the element's own user
+    // space (after its transform attribute), like SVG's getBBox(). Zero for
+    // elements without geometry.
+    BoundingBox fill;
+    // |fill| grown by half the stroke width of every stroked shape. Joins,
+    // caps and markers are not included.
+    BoundingBox stroke;
+    // Device-pixel hull of the stroked geometry, before clipping.
+    BoundingBox device;
+};
+
+// Bounding boxes of every element with an id for one layout, computed from
+// the shapes' outlines and transforms without painting. Follows display,
+// nested viewports and <use> like painting does; content instanced by <use>
+// counts toward the <use>. Text has no geometry yet. Immutable once built.
+class ElementBoundsIndex {
+public:
+    static std::unique_ptr<ElementBoundsIndex> Build(const Document& document, const RenderOptions& options, RenderError& error);
+
+    // True when |options| produce the same layout and style inputs as the
+    // options this index was built with.
+    bool Matches(const RenderOptions& options) const;
+
+    // nullptr when no displayed element has |id|.
+    const ElementBounds* Find(const std::string& id) const;
+
+private:
+    class Builder;
+
+    ElementBoundsIndex() = default;
+
+    RenderOptions options_;
+    std::unordered_map<std::string, ElementBounds> bounds_;
+};
+
+} // namespace csvg
+
+#endif
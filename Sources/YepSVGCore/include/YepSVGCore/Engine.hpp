@@ -1,25 +1,59 @@
 #ifndef CHROMIUM_SVG_CORE_ENGINE_HPP
 #define CHROMIUM_SVG_CORE_ENGINE_HPP
 
+#include <memory>
 #include <optional>
 #include <string>
 
 #include "YepSVGCore/CompatFlags.hpp"
+#include "YepSVGCore/Document.hpp"
+#include "YepSVGCore/PaintProfile.hpp"
+#include "YepSVGCore/ResourceResolver.hpp"
 #include "YepSVGCore/Types.hpp"
 
 namespace csvg {
 
+class GlyphAtlas;
+class ImageDecodeCache;
+class TextLayoutCache;
+struct RenderScratch;
+
 class Engine {
 public:
     Engine();
 
+    // Fetches remote hrefs when enable_external_resources is set; without a
+    // loader they are blocked. Each render requests every remote URL its
+    // document references once, concurrently, before painting. Images the
+    // renderer already holds are not requested again.
+    void SetResourceLoader(ResourceLoader loader);
+
     bool Render(const std::string& svg_text,
                 const RenderOptions& options,
                 ImageBuffer& out_image,
-                RenderError& out_error) const;
+                RenderError& out_error,
+                PaintProfile* out_profile = nullptr) const;
+
+    // Renders a retained document; only style resolution, layout and paint
+    // run again. Shared stylesheets work whether or not the document was
+    // parsed with index_hierarchy.
+    bool Render(const Document& document,
+                const RenderOptions& options,
+                ImageBuffer& out_image,
+                RenderError& out_error,
+                PaintProfile* out_profile = nullptr) const;
 
 private:
     CompatFlags flags_;
+    ResourceLoader loader_;
+    // Shaped text reused by every render; shared by copies of the engine.
+    std::shared_ptr<TextLayoutCache> text_layouts_;
+    // Rasterized small glyphs, shared the same way.
+    std::shared_ptr<GlyphAtlas> glyph_atlas_;
+    // Raster images decoded at the sizes they were drawn.
+    std::shared_ptr<ImageDecodeCache> images_;
+    // Surface and tables reused by the next render at the same size.
+    std::shared_ptr<RenderScratch> scratch_;
 };
 
 } // namespace csvg
@@ -0,0 +1,140 @@
+#ifndef CHROMIUM_SVG_CORE_FONT_FACE_HPP
+#define CHROMIUM_SVG_CORE_FONT_FACE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "YepSVGCore/PathData.hpp"
+#include "YepSVGCore/Transform.hpp"
+#include "YepSVGCore/Types.hpp"
+
+namespace csvg {
+
+// A glyph outline in font units (y up), stored as verbs and points so it
+// can be replayed at any size without reparsing the font.
+struct GlyphOutline {
+    enum class Verb : uint8_t {
+        kMove,
+        kLine,
+        kQuad,
+        kCubic,
+        kClose,
+    };
+
+    std::vector<Verb> verbs;
+    std::vector<Point> points;
+
+    // Emits the outline with every point mapped through |matrix|.
+    void Emit(const AffineMatrix& matrix, PathDataSink& sink) const;
+};
+
+// One face of a TrueType or OpenType file. TrueType (glyf) and CFF outlines,
+// including CID-keyed CFF, are supported; CFF2 variable fonts are not. The
+// face shares ownership of the file's bytes and never writes to them.
+class FontFace {
+public:
+    // Faces in |data|: the count of a TrueType collection, 1 for a single
+    // font, 0 when the bytes are not an sfnt.
+    static uint32_t FaceCount(const std::vector<uint8_t>& data);
+
+    // Parses face |index| of |data|. Returns nullptr and fills |error| when
+    // the tables needed for layout and outlines are missing or malformed.
+    static std::shared_ptr<const FontFace> Parse(std::shared_ptr<const std::vector<uint8_t>> data,
+                                                 uint32_t index,
+                                                 RenderError& error);
+
+    // Typographic family (name ID 16), else the legacy family (name ID 1).
+    const std::string& family() const { return family_; }
+    // usWeightClass, 100-900.
+    int weight() const { return weight_; }
+    bool italic() const { return italic_; }
+    // 'post' isFixedPitch, else a monospaced PANOSE proportion.
+    bool fixed_pitch() const { return fixed_pitch_; }
+    // The OS/2 IBM family class, else the PANOSE serif style.
+    bool serif() const { return serif_; }
+
+    uint16_t units_per_em() const { return units_per_em_; }
+    int16_t ascender() const { return ascender_; }
+    int16_t descender() const { return descender_; }
+    uint16_t glyph_count() const { return glyph_count_; }
+
+    // 0 (.notdef) for codepoints the face does not map.
+    uint16_t GlyphForCodepoint(uint32_t codepoint) const;
+    // In font units.
+    uint16_t AdvanceWidth(uint16_t glyph) const;
+    // Pair adjustment from the 'kern' table, in font units.
+    int16_t Kerning(uint16_t left, uint16_t right) const;
+    // Appends the glyph's contours to |outline|; false for glyphs whose
+    // outline data is malformed. Empty glyphs such as space succeed.
+    bool BuildOutline(uint16_t glyph, GlyphOutline& outline) const;
+
+private:
+    struct Range {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+    };
+
+    // A CFF INDEX: |count| objects whose bytes follow |data|.
+    struct CffIndex {
+        uint32_t count = 0;
+        uint32_t offsets = 0;
+        uint32_t data = 0;
+        uint8_t offset_size = 0;
+    };
+
+    struct CffPrivate {
+        CffIndex subrs;
+    };
+
+    FontFace() = default;
+
+    bool ParseCff(RenderError& error);
+    bool ReadIndex(uint32_t offset, CffIndex& index, uint32_t* end) const;
+    bool IndexObject(const CffIndex& index, uint32_t item, Range& range) const;
+    bool ParsePrivate(const Range& top_or_font_dict, CffPrivate& out) const;
+    uint8_t FontDictForGlyph(uint16_t glyph) const;
+
+    bool BuildTrueTypeOutline(uint16_t glyph,
+                              const AffineMatrix& matrix,
+                              int depth,
+                              size_t& components,
+                              GlyphOutline& outline) const;
+    bool BuildCffOutline(uint16_t glyph, GlyphOutline& outline) const;
+
+    std::shared_ptr<const std::vector<uint8_t>> data_;
+    std::string family_;
+    int weight_ = 400;
+    bool italic_ = false;
+    bool fixed_pitch_ = false;
+    bool serif_ = false;
+
+    uint16_t units_per_em_ = 1000;
+    int16_t ascender_ = 0;
+    int16_t descender_ = 0;
+    uint16_t glyph_count_ = 0;
+    uint16_t metric_count_ = 0;
+    bool long_loca_ = false;
+
+    Range cmap_subtable_;
+    uint16_t cmap_format_ = 0;
+    Range hmtx_;
+    Range loca_;
+    Range glyf_;
+    Range cff_;
+
+    CffIndex char_strings_;
+    CffIndex global_subrs_;
+    std::vector<CffPrivate> privates_;
+    uint32_t fd_select_ = 0;
+    bool cid_keyed_ = false;
+
+    // (left << 16 | right) -> adjustment, sorted by key.
+    std::vector<std::pair<uint32_t, int16_t>> kerning_;
+};
+
+} // namespace csvg
+
+#endif
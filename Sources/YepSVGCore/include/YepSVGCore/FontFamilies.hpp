@@ -0,0 +1,26 @@
+#ifndef CHROMIUM_SVG_CORE_FONT_FAMILIES_HPP
+#define CHROMIUM_SVG_CORE_FONT_FAMILIES_HPP
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace csvg {
+
+// Families of a CSS font-family list in order, unquoted, with sans-serif,
+// serif and monospace replaced by their platform family. Never empty.
+std::vector<std::string> ResolveTextFontFamilies(const std::string& font_family);
+
+// The first generic family (serif, monospace, ...) in |font_family_css|,
+// lowercase; empty when the list names none.
+std::string FirstGenericFontFamily(const std::string& font_family_css);
+
+// The family text is drawn with: the first candidate of |font_family_css|
+// for which |family_exists| holds, generic families mapped to a platform
+// family, then the system fallback, else the first candidate as written.
+std::string ResolveCssFontFamily(const std::string& font_family_css,
+                                 const std::function<bool(const std::string&)>& family_exists);
+
+} // namespace csvg
+
+#endif
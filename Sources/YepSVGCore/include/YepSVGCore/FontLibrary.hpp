@@ -0,0 +1,97 @@
+#ifndef CHROMIUM_SVG_CORE_FONT_LIBRARY_HPP
+#define CHROMIUM_SVG_CORE_FONT_LIBRARY_HPP
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "YepSVGCore/FontFace.hpp"
+#include "YepSVGCore/PathData.hpp"
+#include "YepSVGCore/Types.hpp"
+
+namespace csvg {
+
+struct ShapedGlyph {
+    // Owned by the library that shaped the run.
+    const FontFace* face = nullptr;
+    uint16_t glyph = 0;
+    // Pen position along the baseline, in user units.
+    double x = 0.0;
+};
+
+struct ShapedText {
+    std::vector<ShapedGlyph> glyphs;
+    // Advance of the whole run, including kerning, letter and word spacing.
+    double width = 0.0;
+    double ascent = 0.0;
+    double descent = 0.0;
+};
+
+// Fonts loaded from files or memory, independent of the platform font
+// stack. Families resolve with the same fallback rules as CoreText text
+// (ResolveCssFontFamily). Glyph outlines are cached in font units, so one
+// entry serves every size. Safe to share between threads.
+class FontLibrary {
+public:
+    FontLibrary() = default;
+
+    FontLibrary(const FontLibrary&) = delete;
+    FontLibrary& operator=(const FontLibrary&) = delete;
+
+    // Registers every face of a TrueType/OpenType file or collection and
+    // returns how many were added; 0 with |error| set when none parse.
+    size_t AddFontData(std::vector<uint8_t> data, RenderError& error);
+    size_t AddFontFile(const std::string& path, RenderError& error);
+    // Adds .ttf, .otf, .ttc and .otc files below |path|, skipping files that
+    // fail to load. Returns the number of faces added.
+    size_t AddFontDirectory(const std::string& path);
+
+    size_t face_count() const;
+
+    // The face for a CSS font-family list, weight (100-900) and style, with
+    // the nearest weight per CSS font matching. When no registered family
+    // matches, generic families (serif, sans-serif, monospace) pick among
+    // faces of that class, then among all faces, by the same weight and
+    // style rules; nullptr only when the library is empty.
+    std::shared_ptr<const FontFace> Match(const std::string& font_family_css, int weight, bool italic) const;
+
+    // Outline of |glyph| in font units; nullptr when its data is malformed.
+    std::shared_ptr<const GlyphOutline> Outline(const FontFace& face, uint16_t glyph) const;
+
+    // Lays |text| (UTF-8) out on one line with |face|, using the other
+    // registered faces for characters |face| does not map.
+    ShapedText Shape(const std::string& text,
+                     const FontFace& face,
+                     double font_size,
+                     double letter_spacing,
+                     double word_spacing) const;
+
+    // Emits the outlines of |shaped| in user space (y down) with the
+    // baseline origin at (x, y).
+    void EmitText(const ShapedText& shaped, double font_size, double x, double y, PathDataSink& sink) const;
+
+private:
+    struct OutlineKey {
+        const FontFace* face = nullptr;
+        uint16_t glyph = 0;
+
+        bool operator==(const OutlineKey& other) const { return face == other.face && glyph == other.glyph; }
+    };
+
+    struct OutlineKeyHash {
+        size_t operator()(const OutlineKey& key) const {
+            return std::hash<const void*>()(key.face) ^ (static_cast<size_t>(key.glyph) * 0x9E3779B97F4A7C15ull);
+        }
+    };
+
+    mutable std::mutex mutex_;
+    std::vector<std::shared_ptr<const FontFace>> faces_;
+    mutable std::unordered_map<OutlineKey, std::shared_ptr<const GlyphOutline>, OutlineKeyHash> outlines_;
+};
+
+} // namespace csvg
+
+#endif
@@ -3,6 +3,7 @@
 
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "YepSVGCore/Types.hpp"
@@ -33,7 +34,8 @@ struct ShapeGeometry {
     std::vector<Point> points;
     std::string path_data;
     std::string text;
-    std::string href;
+    // Views the node's attribute; valid while the document is.
+    std::string_view href;
 };
 
 class GeometryEngine {
@@ -0,0 +1,91 @@
+#ifndef CHROMIUM_SVG_CORE_GLYPH_ATLAS_HPP
+#define CHROMIUM_SVG_CORE_GLYPH_ATLAS_HPP
+
+#include <CoreGraphics/CoreGraphics.h>
+#include <CoreText/CoreText.h>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "YepSVGCore/TextLayout.hpp"
+
+namespace csvg {
+
+// Coverage masks of small glyphs, rasterized once per (font, glyph, device
+// size, quarter-pixel offset) and composited into one mask per line, so a
+// label costs a single masked fill instead of a path fill per glyph. Meant
+// to live as long as a renderer. Safe to share between threads.
+class GlyphAtlas {
+public:
+    // Lines whose device font size exceeds this are drawn as paths.
+    static constexpr double kMaxDeviceFontSize = 32.0;
+
+    GlyphAtlas() = default;
+    ~GlyphAtlas();
+
+    GlyphAtlas(const GlyphAtlas&) = delete;
+    GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+
+    // Fills the glyphs of |layout| with |color|, baseline origin at (x, y) in
+    // the current user space (y down). Draws nothing and returns false when
+    // the line needs the path renderer: a non-bitmap context, a transform
+    // that rotates, skews, mirrors or scales unevenly, large text, or runs
+    // with their own text matrix.
+    bool DrawLine(CGContextRef context, const TextLayout& layout, double x, double y, CGColorRef color);
+
+private:
+    static constexpr int kSubpixelSteps = 4;
+    static constexpr int kPageSize = 512;
+    static constexpr size_t kMaxPages = 8;
+
+    // A mask in a page; |left| and |bottom| place it relative to the device
+    // pixel holding the pen. Empty glyphs have no pixels.
+    struct Entry {
+        uint16_t page = 0;
+        uint16_t x = 0;
+        uint16_t y = 0;
+        uint16_t width = 0;
+        uint16_t height = 0;
+        int16_t left = 0;
+        int16_t bottom = 0;
+    };
+
+    // One font at one device size.
+    struct Strike {
+        CTFontRef font = nullptr;
+        // glyph << 8 | y bucket << 4 | x bucket
+        std::unordered_map<uint32_t, Entry> entries;
+    };
+
+    // Rows are packed top to bottom into shelves.
+    struct Page {
+        std::vector<uint8_t> coverage;
+        int shelf_x = 0;
+        int shelf_y = 0;
+        int shelf_height = 0;
+    };
+
+    enum class LookupResult {
+        kFound,
+        // The glyph is too large or cannot be rasterized; draw the line as paths.
+        kIneligible,
+        // Every page is full; the atlas must be reset to make room.
+        kAtlasFull,
+    };
+
+    Strike* StrikeFor(CTFontRef font, double device_size);
+    LookupResult Lookup(Strike& strike, CGGlyph glyph, int bucket_x, int bucket_y, Entry& entry);
+    bool Allocate(int width, int height, Entry& entry);
+    void Reset();
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, Strike> strikes_;
+    std::vector<Page> pages_;
+};
+
+} // namespace csvg
+
+#endif
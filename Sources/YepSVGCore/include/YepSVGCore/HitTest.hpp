@@ -0,0 +1,119 @@
+#ifndef CHROMIUM_SVG_CORE_HIT_TEST_HPP
+#define CHROMIUM_SVG_CORE_HIT_TEST_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "YepSVGCore/Document.hpp"
+#include "YepSVGCore/Types.hpp"
+
+namespace csvg {
+
+struct HitTestQuery {
+    // Extra reach in device pixels around every shape, for touch input.
+    double tolerance = 0.0;
+    // Report every element under the point instead of only the topmost.
+    bool collect_all = false;
+};
+
+// Device-space hit geometry of a document for one layout. Shapes are
+// flattened once with their transforms, clip paths, nested viewports and
+// resolved fill/stroke, visibility and pointer-events, then bucketed into a
+// uniform grid so a query only tests the few shapes near the point. Text is
+// not hit-testable yet. Immutable once built; queries may run concurrently.
+class HitTestIndex {
+public:
+    // Lays |document| out with |options| the way Engine::Render would; device
+    // points are pixels of the rendered image.
+    static std::unique_ptr<HitTestIndex> Build(const Document& document, const RenderOptions& options, RenderError& error);
+
+    // True when |options| produce the same layout and style inputs as the
+    // options this index was built with.
+    bool Matches(const RenderOptions& options) const;
+
+    // Ids of the elements under (x, y), topmost first; at most one unless
+    // |query.collect_all|, in which case repeated ids are dropped. Elements
+    // report their own id, else their nearest ancestor's; content instanced
+    // by <use> reports the <use>. An empty string means no id on that chain.
+    std::vector<std::string> HitTest(double x, double y, const HitTestQuery& query) const;
+
+    size_t shape_count() const { return shapes_.size(); }
+
+private:
+    class Builder;
+
+    struct Box {
+        double min_x = 0.0;
+        double min_y = 0.0;
+        double max_x = 0.0;
+        double max_y = 0.0;
+    };
+
+    // Points [begin, begin + count) of one flattened subpath. Fills close it
+    // implicitly; strokes only follow the recorded points.
+    struct Contour {
+        uint32_t begin = 0;
+        uint32_t count = 0;
+    };
+
+    struct Area {
+        uint32_t contour_begin = 0;
+        uint32_t contour_count = 0;
+        bool even_odd = false;
+    };
+
+    // Union of |areas|, intersected with the parent region.
+    struct ClipRegion {
+        int32_t parent = -1;
+        uint32_t area_begin = 0;
+        uint32_t area_count = 0;
+        Box bounds;
+    };
+
+    struct Shape {
+        Box bounds;
+        Area area;
+        // Half the device stroke width; negative when the stroke is not hit.
+        double stroke_radius = -1.0;
+        bool fill = false;
+        int32_t clip = -1;
+        uint32_t id = 0;
+    };
+
+    HitTestIndex() = default;
+
+    bool AreaContains(const Area& area, double x, double y, double tolerance) const;
+    double DistanceToEdges(const Area& area, double x, double y, bool close) const;
+    bool ClipContains(int32_t clip, double x, double y) const;
+    bool ShapeContains(const Shape& shape, double x, double y, double tolerance) const;
+    void BuildGrid();
+
+    RenderOptions options_;
+    double width_ = 0.0;
+    double height_ = 0.0;
+
+    std::vector<Point> points_;
+    std::vector<Contour> contours_;
+    std::vector<Area> clip_areas_;
+    std::vector<ClipRegion> clips_;
+    // Paint order; later shapes are on top.
+    std::vector<Shape> shapes_;
+    std::vector<std::string> ids_;
+
+    uint32_t grid_columns_ = 0;
+    uint32_t grid_rows_ = 0;
+    double cell_width_ = 1.0;
+    double cell_height_ = 1.0;
+    // Shapes of cell i are cell_items_[cell_offsets_[i], cell_offsets_[i + 1]),
+    // in paint order.
+    std::vector<uint32_t> cell_offsets_;
+    std::vector<uint32_t> cell_items_;
+    // Shapes spanning too many cells to bucket; tested on every query.
+    std::vector<uint32_t> large_items_;
+};
+
+} // namespace csvg
+
+#endif
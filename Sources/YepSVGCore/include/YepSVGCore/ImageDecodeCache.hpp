@@ -0,0 +1,79 @@
+#ifndef CHROMIUM_SVG_CORE_IMAGE_DECODE_CACHE_HPP
+#define CHROMIUM_SVG_CORE_IMAGE_DECODE_CACHE_HPP
+
+#include <CoreGraphics/CoreGraphics.h>
+#include <ImageIO/ImageIO.h>
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace csvg {
+
+// Raster images referenced by <image> and feImage, decoded no larger than
+// they are drawn. The encoded source stays open so a later, larger draw can
+// decode again at its own size. Meant to live as long as a renderer. Safe to
+// share between threads.
+class ImageDecodeCache {
+public:
+    ImageDecodeCache() = default;
+    ~ImageDecodeCache();
+
+    ImageDecodeCache(const ImageDecodeCache&) = delete;
+    ImageDecodeCache& operator=(const ImageDecodeCache&) = delete;
+
+    // Pixel size of the encoded image, read from its header without
+    // decoding. False when |href| does not name a readable raster image.
+    bool Dimensions(std::string_view href, size_t& width, size_t& height);
+
+    // The image at |href| with its longer side at least |max_pixel_size|
+    // pixels, or at full resolution when |max_pixel_size| is 0 or not
+    // smaller than the source. The caller releases the result. Sizes are
+    // rounded up to a power of two so nearby sizes share one decode.
+    CGImageRef CopyImage(std::string_view href, size_t max_pixel_size);
+
+    // Serves |href| from |data|, encoded bytes the host fetched, unless a
+    // readable source for it is already cached.
+    void AddEncoded(std::string_view href, const std::vector<uint8_t>& data);
+    // Whether |href| already has a readable source; never opens one.
+    bool HasSource(std::string_view href);
+
+private:
+    struct Entry {
+        // Owns the bytes the table key views.
+        std::string href;
+        // nullptr when the href could not be opened; kept so it is not
+        // retried on every paint.
+        CGImageSourceRef source = nullptr;
+        size_t width = 0;
+        size_t height = 0;
+        CGImageRef image = nullptr;
+        // Largest decode size |image| satisfies; the source's longer side
+        // for a full decode.
+        size_t decoded_size = 0;
+    };
+
+    Entry& EntryFor(std::string_view href);
+    Entry& InsertEntry(std::string_view href, CGImageSourceRef source);
+    void Clear();
+
+    std::mutex mutex_;
+    // Keyed by views of Entry::href, so lookups with a data: URL held by the
+    // document do not copy it.
+    std::unordered_map<std::string_view, std::unique_ptr<Entry>> entries_;
+    // Approximate memory held by decoded images.
+    size_t decoded_bytes_ = 0;
+};
+
+// Opens |href| (a data: URL, file:// URL or local path) as an image source
+// without decoding it. Remote URLs are not fetched. The caller releases the
+// result.
+CGImageSourceRef CreateImageSourceForHref(std::string_view href);
+
+} // namespace csvg
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef CHROMIUM_SVG_CORE_NODE_TRANSFORMS_HPP
+#define CHROMIUM_SVG_CORE_NODE_TRANSFORMS_HPP
+
+#include <unordered_map>
+
+#include "YepSVGCore/LayoutEngine.hpp"
+#include "YepSVGCore/Transform.hpp"
+#include "YepSVGCore/Types.hpp"
+
+namespace csvg {
+
+// Composed user-space-to-device matrices for every element of a document,
+// built once for a given root matrix. Follows transform attributes and nested
+// <svg> viewports the same way painting does; <use> instances are not
+// expanded, so referenced content only has the matrix of its own position.
+class NodeTransformCache {
+public:
+    // |root_matrix| maps the outermost <svg>'s viewBox space to device pixels;
+    // |viewport_width| and |viewport_height| resolve percentages beneath it.
+    NodeTransformCache(const XmlNode& root, const AffineMatrix& root_matrix, double viewport_width, double viewport_height);
+    NodeTransformCache(const XmlNode& root, const LayoutResult& layout);
+
+    // The matrix the root is painted with for |layout|.
+    static AffineMatrix RootMatrix(const XmlNode& root, const LayoutResult& layout);
+
+    // Maps |node|'s user space (after its own transform; inside the viewport
+    // for a nested <svg>) to device pixels. nullptr for nodes that are not
+    // painted, such as the content of a zero-sized nested <svg>.
+    const AffineMatrix* UserToDevice(const XmlNode& node) const;
+    const AffineMatrix& root_matrix() const { return root_matrix_; }
+
+private:
+    void Build(const XmlNode& node, const AffineMatrix& parent, double viewport_width, double viewport_height, bool nested);
+
+    AffineMatrix root_matrix_;
+    std::unordered_map<const XmlNode*, AffineMatrix> matrices_;
+};
+
+} // namespace csvg
+
+#endif
@@ -2,22 +2,37 @@
 #define CHROMIUM_SVG_CORE_PAINT_ENGINE_HPP
 
 #include "YepSVGCore/CompatFlags.hpp"
+#include "YepSVGCore/DocumentIndex.hpp"
 #include "YepSVGCore/GeometryEngine.hpp"
 #include "YepSVGCore/LayoutEngine.hpp"
+#include "YepSVGCore/PaintProfile.hpp"
 #include "YepSVGCore/RasterBackendCG.hpp"
+#include "YepSVGCore/ResourceResolver.hpp"
 #include "YepSVGCore/StyleResolver.hpp"
 #include "YepSVGCore/Types.hpp"
 
 namespace csvg {
 
+class GlyphAtlas;
+class ImageDecodeCache;
+class TextLayoutCache;
+struct RenderScratch;
+
 class PaintEngine {
 public:
     bool Paint(const SvgDocument& document,
+               const DocumentIndex& index,
                const LayoutResult& layout,
                const RenderOptions& options,
                const CompatFlags& flags,
                RasterSurface& surface,
-               RenderError& error) const;
+               RenderError& error,
+               PaintProfile* profile = nullptr,
+               TextLayoutCache* text_layouts = nullptr,
+               GlyphAtlas* glyph_atlas = nullptr,
+               ImageDecodeCache* images = nullptr,
+               const FetchedResources* fetched = nullptr,
+               RenderScratch* scratch = nullptr) const;
 };
 
 } // namespace csvg
@@ -0,0 +1,40 @@
+#ifndef CHROMIUM_SVG_CORE_PAINT_PROFILE_HPP
+#define CHROMIUM_SVG_CORE_PAINT_PROFILE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace csvg {
+
+struct PaintProfileEntry {
+    std::string id;
+    // XPath-like position, e.g. "/svg[1]/g[2]/rect[1]".
+    std::string path;
+    std::string tag;
+    uint32_t paint_count = 0;
+
+    double inclusive_ms = 0.0;
+    double exclusive_ms = 0.0;
+    uint64_t offscreen_pixels = 0;
+    uint64_t decoded_image_pixels = 0;
+
+    double filter_ms = 0.0;
+    double mask_ms = 0.0;
+    double clip_ms = 0.0;
+    double pattern_ms = 0.0;
+};
+
+struct PaintProfile {
+    double paint_ms = 0.0;
+    uint64_t offscreen_pixels = 0;
+    uint64_t decoded_image_pixels = 0;
+    // Document order; elements that were never painted are omitted.
+    std::vector<PaintProfileEntry> entries;
+};
+
+std::string SerializePaintProfileJson(const PaintProfile& profile);
+
+} // namespace csvg
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef CHROMIUM_SVG_CORE_PATH_DATA_HPP
+#define CHROMIUM_SVG_CORE_PATH_DATA_HPP
+
+#include <string>
+
+namespace csvg {
+
+class PathDataSink {
+public:
+    virtual ~PathDataSink() = default;
+
+    virtual void MoveTo(double x, double y) = 0;
+    virtual void LineTo(double x, double y) = 0;
+    virtual void CubicTo(double x1, double y1, double x2, double y2, double x, double y) = 0;
+    virtual void QuadTo(double x1, double y1, double x, double y) = 0;
+    virtual void ClosePath() = 0;
+};
+
+class PathDataParser {
+public:
+    // Emits absolute coordinates; arcs are converted to cubic segments.
+    bool Parse(const std::string& path_data, PathDataSink& sink) const;
+};
+
+} // namespace csvg
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef CHROMIUM_SVG_CORE_PATH_FLATTENER_HPP
+#define CHROMIUM_SVG_CORE_PATH_FLATTENER_HPP
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include "YepSVGCore/GeometryEngine.hpp"
+#include "YepSVGCore/PathData.hpp"
+#include "YepSVGCore/Types.hpp"
+
+namespace csvg {
+
+// Flattening tolerance in user units that keeps the chord error under a
+// quarter of a device pixel at |device_scale| device pixels per user unit.
+double FlatteningTolerance(double device_scale);
+
+// Polyline approximation of a path with a cumulative arc-length table.
+// Zero-length segments are dropped; closed subpaths end with their closing
+// segment.
+class FlattenedPath {
+public:
+    struct Segment {
+        Point start;
+        Point end;
+        // Distance along the path at |start|.
+        double offset = 0.0;
+        double length = 0.0;
+    };
+
+    // Segments [begin, end) of one subpath. Subpaths without length are
+    // omitted; a closed subpath's last segment returns to its start.
+    struct Subpath {
+        size_t begin = 0;
+        size_t end = 0;
+        bool closed = false;
+    };
+
+    double tolerance() const { return tolerance_; }
+    double length() const { return length_; }
+    const std::vector<Segment>& segments() const { return segments_; }
+    const std::vector<Subpath>& subpaths() const { return subpaths_; }
+
+    // Point and unit tangent at |distance| along the path, clamped to the
+    // path's ends. Binary search over the arc-length table.
+    bool PointAndTangentAt(double distance, Point& point, Point& tangent) const;
+
+private:
+    friend class PathFlattener;
+
+    std::vector<Segment> segments_;
+    std::vector<Subpath> subpaths_;
+    double tolerance_ = 0.0;
+    double length_ = 0.0;
+};
+
+// Flattens curves into the fewest uniform steps whose deviation from the
+// curve stays within the tolerance.
+class PathFlattener final : public PathDataSink {
+public:
+    explicit PathFlattener(double tolerance);
+
+    void MoveTo(double x, double y) override;
+    void LineTo(double x, double y) override;
+    void CubicTo(double x1, double y1, double x2, double y2, double x, double y) override;
+    void QuadTo(double x1, double y1, double x, double y) override;
+    void ClosePath() override;
+
+    FlattenedPath Finish();
+
+private:
+    void Append(Point end);
+
+    FlattenedPath path_;
+    Point current_;
+    Point subpath_start_;
+    bool has_current_ = false;
+    bool subpath_open_ = false;
+};
+
+// Emits the outline of |geometry| the way SVG defines it for shapes: rects
+// start at the top edge, circles and ellipses at their rightmost point, both
+// proceeding clockwise. Returns false for text, images and unknown shapes.
+bool EmitShapeOutline(const ShapeGeometry& geometry, PathDataSink& sink);
+
+// Flattened outlines of elements, kept for the lifetime of the cache. A cached
+// entry is reused for any request at the same or a coarser tolerance.
+class FlattenedPathCache {
+public:
+    // Never nullptr; elements without an outline yield an empty path.
+    const FlattenedPath* Get(const XmlNode& node, const GeometryEngine& geometry_engine, double tolerance);
+    // Forgets every outline but keeps the table's buckets for the next render.
+    void Clear() { paths_.clear(); }
+
+private:
+    std::unordered_map<const XmlNode*, FlattenedPath> paths_;
+};
+
+} // namespace csvg
+
+#endif
@@ -11,20 +11,30 @@ namespace csvg {
 
 class RasterSurface {
 public:
+    RasterSurface() = default;
     RasterSurface(int32_t width, int32_t height, const Color& background);
     ~RasterSurface();
 
     RasterSurface(const RasterSurface&) = delete;
     RasterSurface& operator=(const RasterSurface&) = delete;
 
+    // Starts a new render of |width| x |height| filled with |background|.
+    // Pixels and the bitmap context are reused when the size is unchanged;
+    // otherwise the pixel buffer keeps its capacity.
+    void Reset(int32_t width, int32_t height, const Color& background);
+    // Frees the pixels and the context.
+    void Release();
+    size_t byte_capacity() const { return bytes_.capacity(); }
+
     CGContextRef context() const;
+    // Copies into |out|, reusing the capacity it already has.
     bool Extract(ImageBuffer& out, RenderError& error) const;
 
 private:
-    int32_t width_;
-    int32_t height_;
+    int32_t width_ = 0;
+    int32_t height_ = 0;
     std::vector<uint8_t> bytes_;
-    CGContextRef context_;
+    CGContextRef context_ = nullptr;
 };
 
 } // namespace csvg
@@ -0,0 +1,124 @@
+#ifndef CHROMIUM_SVG_CORE_RENDER_CACHE_HPP
+#define CHROMIUM_SVG_CORE_RENDER_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+#include "YepSVGCore/Types.hpp"
+
+namespace csvg {
+
+// Mixed into every render cache key. Bump it with any change that alters
+// rendered pixels so caches written by older builds are never served.
+constexpr uint32_t kRenderOutputVersion = 2;
+
+struct RenderCacheKey {
+    uint64_t high = 0;
+    uint64_t low = 0;
+
+    bool operator==(const RenderCacheKey& other) const { return high == other.high && low == other.low; }
+    // 32 lowercase hex digits.
+    std::string Hex() const;
+};
+
+// Streaming 128-bit hash (MurmurHash3 x64_128) of everything that decides a
+// render's pixels. Not cryptographic: a cache directory must be trusted.
+class RenderFingerprint {
+public:
+    void Add(const void* data, size_t size);
+    // Length-prefixed, so adjacent strings cannot run into each other.
+    void AddString(std::string_view text);
+    template <typename T>
+    void AddValue(T value) {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "hash fields one by one");
+        Add(&value, sizeof(value));
+    }
+
+    RenderCacheKey Finish() const;
+
+private:
+    void Mix(const uint8_t* block);
+
+    uint64_t h1_ = 0x9e3779b97f4a7c15ull;
+    uint64_t h2_ = 0xc2b2ae3d27d4eb4full;
+    uint8_t pending_[16] = {};
+    size_t pending_size_ = 0;
+    uint64_t total_size_ = 0;
+};
+
+// Rendered pixels kept as one raw file per key in a directory that may
+// outlive the process and be shared by several processes. Files are written
+// to a temporary name and renamed, so readers never see partial results;
+// the least recently used are evicted once the directory holds more than
+// |max_bytes|. Safe to share between threads.
+class RenderCache {
+public:
+    // A cached render mapped read-only; the mapping lives as long as this.
+    class Hit {
+    public:
+        Hit(void* mapping, size_t mapping_size, int32_t width, int32_t height, const uint8_t* rgba, size_t rgba_size);
+        ~Hit();
+        Hit(Hit&& other) noexcept;
+        Hit& operator=(Hit&&) = delete;
+        Hit(const Hit&) = delete;
+        Hit& operator=(const Hit&) = delete;
+
+        int32_t width() const { return width_; }
+        int32_t height() const { return height_; }
+        const uint8_t* rgba() const { return rgba_; }
+        size_t rgba_size() const { return rgba_size_; }
+
+    private:
+        void* mapping_ = nullptr;
+        size_t mapping_size_ = 0;
+        int32_t width_ = 0;
+        int32_t height_ = 0;
+        const uint8_t* rgba_ = nullptr;
+        size_t rgba_size_ = 0;
+    };
+
+    // Creates |directory| if needed and indexes the renders already in it.
+    // Returns nullptr and sets |error| when the directory is unusable.
+    static std::shared_ptr<RenderCache> Open(const std::string& directory, uint64_t max_bytes, RenderError& error);
+
+    RenderCache(const RenderCache&) = delete;
+    RenderCache& operator=(const RenderCache&) = delete;
+
+    std::optional<Hit> Lookup(const RenderCacheKey& key);
+    // Best effort: a failed write leaves the cache as it was.
+    void Store(const RenderCacheKey& key, const ImageBuffer& image);
+
+private:
+    struct Entry {
+        uint64_t size = 0;
+        // Filesystem clock ticks; file mtimes seed it on open.
+        int64_t last_use = 0;
+    };
+    struct KeyHash {
+        size_t operator()(const RenderCacheKey& key) const { return static_cast<size_t>(key.low ^ key.high); }
+    };
+
+    RenderCache(std::string directory, uint64_t max_bytes);
+    void Scan();
+    std::string PathFor(const RenderCacheKey& key) const;
+    void Touch(const RenderCacheKey& key, uint64_t size);
+    void EvictLocked();
+
+    const std::string directory_;
+    const uint64_t max_bytes_;
+    std::mutex mutex_;
+    std::unordered_map<RenderCacheKey, Entry, KeyHash> entries_;
+    uint64_t total_bytes_ = 0;
+    uint64_t temp_counter_ = 0;
+};
+
+} // namespace csvg
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef CHROMIUM_SVG_CORE_RENDER_SCRATCH_HPP
+#define CHROMIUM_SVG_CORE_RENDER_SCRATCH_HPP
+
+#include <mutex>
+
+#include "YepSVGCore/PathFlattener.hpp"
+#include "YepSVGCore/RasterBackendCG.hpp"
+#include "YepSVGCore/SurfacePool.hpp"
+
+namespace csvg {
+
+// Working memory a renderer keeps from one render to the next, so repeated
+// renders at the same size reuse their buffers instead of reallocating and
+// zeroing them. Only one render uses it at a time; Engine gives concurrent
+// renders on the same renderer a fresh one.
+struct RenderScratch {
+    std::mutex in_use;
+    RasterSurface surface;
+    FlattenedPathCache path_cache;
+    // Offscreen pixels for filters, masks and pattern tiles.
+    SurfacePool surfaces;
+};
+
+} // namespace csvg
+
+#endif
@@ -1,17 +1,58 @@
 #ifndef CHROMIUM_SVG_CORE_RESOURCE_RESOLVER_HPP
 #define CHROMIUM_SVG_CORE_RESOURCE_RESOLVER_HPP
 
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
+#include "YepSVGCore/DocumentIndex.hpp"
 #include "YepSVGCore/Types.hpp"
 
 namespace csvg {
 
+struct ResourceRequest {
+    std::string url;
+    ResourcePurpose purpose = ResourcePurpose::kOther;
+};
+
+// Fetches one remote resource for the host. May be called from several
+// threads at once. Returns false and sets |out_error| on failure.
+using ResourceLoader = std::function<bool(const ResourceRequest& request,
+                                          std::vector<uint8_t>& out_data,
+                                          std::string& out_error)>;
+
+struct FetchedResource {
+    ResourcePurpose purpose = ResourcePurpose::kOther;
+    std::shared_ptr<const std::vector<uint8_t>> bytes;
+};
+
+// Keyed by trimmed URL.
+using FetchedResources = std::unordered_map<std::string, FetchedResource>;
+
 class ResourceResolver {
 public:
-    std::vector<std::string> CollectExternalURLs(const XmlNode& node) const;
-    bool ValidatePolicy(const std::vector<std::string>& urls, const RenderOptions& options, RenderError& error) const;
+    // Remote URLs need both enable_external_resources and a loader.
+    bool ValidatePolicy(const std::vector<ExternalReference>& references,
+                        const RenderOptions& options,
+                        bool has_loader,
+                        RenderError& error) const;
+
+    // Remote URLs among |references|, trimmed and without duplicates, in
+    // document order. A URL used for several purposes keeps its first,
+    // unless any use is an image, which needs the bytes decoded.
+    std::vector<ResourceRequest> CollectRemoteRequests(const std::vector<ExternalReference>& references) const;
+
+    // Runs |loader| for every request, several at a time, and waits for all
+    // of them. Fails with kExternalResourceFailed naming the first request
+    // that failed.
+    bool Fetch(const std::vector<ResourceRequest>& requests,
+               const ResourceLoader& loader,
+               FetchedResources& out_resources,
+               RenderError& error) const;
 };
 
 } // namespace csvg
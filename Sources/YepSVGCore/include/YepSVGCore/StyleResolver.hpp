@@ -6,6 +6,7 @@
 
 #include <optional>
 #include <string>
+#include <string_view>
 
 #include "YepSVGCore/Types.hpp"
 
@@ -46,8 +47,8 @@ public:
     ResolvedStyle Resolve(const XmlNode& node,
                           const ResolvedStyle* parent,
                           const RenderOptions& options,
-                          const std::map<std::string, std::string>* matched_css_properties = nullptr) const;
-    static Color ParseColor(const std::string& value);
+                          const PropertyMap* matched_css_properties = nullptr) const;
+    static Color ParseColor(std::string_view value);
 };
 
 } // namespace csvg
@@ -0,0 +1,56 @@
+#ifndef CHROMIUM_SVG_CORE_STYLESHEET_HPP
+#define CHROMIUM_SVG_CORE_STYLESHEET_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "YepSVGCore/CssParser.hpp"
+#include "YepSVGCore/Types.hpp"
+
+namespace csvg {
+
+// User-agent declarations lose to presentation attributes; author
+// declarations beat them, as in CSS.
+enum class StylesheetOrigin {
+    kUserAgent,
+    kAuthor,
+};
+
+struct CssSelectorRef {
+    uint32_t rule_index = 0;
+    uint32_t selector_index = 0;
+};
+
+// Parsed rules plus an index of selectors keyed by their subject's id, first
+// class or tag. Immutable once compiled, so one instance can be shared by any
+// number of documents and threads.
+class Stylesheet {
+public:
+    static std::shared_ptr<const Stylesheet> Compile(const std::string& css_text, StylesheetOrigin origin);
+    static std::shared_ptr<const Stylesheet> Compile(const std::vector<std::string>& css_blocks, StylesheetOrigin origin);
+
+    StylesheetOrigin origin() const { return origin_; }
+    const std::vector<CssRule>& rules() const { return rules_; }
+    bool empty() const { return rules_.empty(); }
+
+    // Appends selectors that may match |node|, sorted by rule then selector.
+    void CollectCandidates(const XmlNode& node, std::vector<CssSelectorRef>& out) const;
+
+private:
+    explicit Stylesheet(StylesheetOrigin origin) : origin_(origin) {}
+    void BuildSelectorIndex();
+
+    StylesheetOrigin origin_;
+    std::vector<CssRule> rules_;
+    std::unordered_map<std::string, std::vector<CssSelectorRef>> by_id_;
+    std::unordered_map<std::string, std::vector<CssSelectorRef>> by_class_;
+    std::unordered_map<std::string, std::vector<CssSelectorRef>> by_tag_;
+    std::vector<CssSelectorRef> universal_;
+};
+
+} // namespace csvg
+
+#endif
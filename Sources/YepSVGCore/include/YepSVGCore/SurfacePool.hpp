@@ -0,0 +1,81 @@
+#ifndef CHROMIUM_SVG_CORE_SURFACE_POOL_HPP
+#define CHROMIUM_SVG_CORE_SURFACE_POOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace csvg {
+
+// Leaves elements uninitialized on resize() unless a value is given, so a
+// buffer every pixel of which is about to be written is not zeroed first.
+template <typename T>
+struct DefaultInitAllocator : std::allocator<T> {
+    template <typename U>
+    struct rebind {
+        using other = DefaultInitAllocator<U>;
+    };
+
+    DefaultInitAllocator() noexcept = default;
+    template <typename U>
+    DefaultInitAllocator(const DefaultInitAllocator<U>&) noexcept {}
+
+    template <typename U>
+    void construct(U* pointer) noexcept {
+        ::new (static_cast<void*>(pointer)) U;
+    }
+    template <typename U, typename... Args>
+    void construct(U* pointer, Args&&... args) {
+        ::new (static_cast<void*>(pointer)) U(std::forward<Args>(args)...);
+    }
+};
+
+// 8-bit channels, as Core Graphics draws them.
+using PixelBuffer = std::vector<uint8_t, DefaultInitAllocator<uint8_t>>;
+// 16-bit channels for filter intermediates.
+using ChannelBuffer = std::vector<uint16_t, DefaultInitAllocator<uint16_t>>;
+
+// Pixel buffers released by one offscreen pass and handed to the next,
+// bucketed by power-of-two size class. Filter chains and masks mostly ask
+// for the same canvas size over and over, so after the first few passes a
+// render allocates nothing. Not thread-safe: one render uses it at a time.
+class SurfacePool {
+public:
+    explicit SurfacePool(size_t max_retained_bytes = 64u * 1024u * 1024u);
+    SurfacePool(const SurfacePool&) = delete;
+    SurfacePool& operator=(const SurfacePool&) = delete;
+
+    // A buffer of exactly |bytes| bytes, zero-filled only when |zeroed|.
+    PixelBuffer Acquire(size_t bytes, bool zeroed);
+    // The same for |count| 16-bit channels.
+    ChannelBuffer AcquireChannels(size_t count, bool zeroed);
+    // Keeps |buffer|'s memory for a later Acquire; frees it instead when the
+    // pool already holds its limit.
+    void Recycle(PixelBuffer&& buffer);
+    void Recycle(ChannelBuffer&& buffer);
+    void Clear();
+
+    size_t retained_bytes() const { return retained_bytes_; }
+
+private:
+    // Free buffers indexed by the size class of their capacity.
+    template <typename Buffer>
+    using Buckets = std::vector<std::vector<Buffer>>;
+
+    template <typename Buffer>
+    Buffer Take(Buckets<Buffer>& buckets, size_t count, bool zeroed);
+    template <typename Buffer>
+    void Keep(Buckets<Buffer>& buckets, Buffer&& buffer);
+
+    const size_t max_retained_bytes_;
+    size_t retained_bytes_ = 0;
+    Buckets<PixelBuffer> pixel_buckets_;
+    Buckets<ChannelBuffer> channel_buckets_;
+};
+
+} // namespace csvg
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef CHROMIUM_SVG_CORE_TEXT_LAYOUT_HPP
+#define CHROMIUM_SVG_CORE_TEXT_LAYOUT_HPP
+
+#include <CoreText/CoreText.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "YepSVGCore/StyleResolver.hpp"
+
+namespace csvg {
+
+// The style inputs that change how a run of text is shaped. Paint (fill,
+// stroke, opacity) is not part of it, so one layout serves every color.
+struct TextShapeKey {
+    // CSS font-family list, resolved with the usual fallbacks.
+    std::string font_family;
+    float font_size = 16.0f;
+    bool bold = false;
+    bool italic = false;
+    float letter_spacing = 0.0f;
+    float word_spacing = 0.0f;
+
+    static TextShapeKey FromStyle(const ResolvedStyle& style);
+};
+
+// One shaped line of text. The line takes its color from the context it is
+// drawn into, so measuring, drawing and clipping share the same object.
+class TextLayout {
+public:
+    ~TextLayout();
+
+    TextLayout(const TextLayout&) = delete;
+    TextLayout& operator=(const TextLayout&) = delete;
+
+    // Advance of the whole run, including letter and word spacing.
+    double width() const { return width_; }
+    double ascent() const { return ascent_; }
+    double descent() const { return descent_; }
+    // nullptr when the text could not be shaped.
+    CTLineRef line() const { return line_; }
+    CTFontRef font() const { return font_; }
+
+private:
+    friend class TextLayoutCache;
+
+    TextLayout() = default;
+
+    CTLineRef line_ = nullptr;
+    CTFontRef font_ = nullptr;
+    double width_ = 0.0;
+    double ascent_ = 0.0;
+    double descent_ = 0.0;
+};
+
+// Shaped runs keyed by (text, TextShapeKey), plus the fonts they use. Meant
+// to live as long as a renderer so repeated labels are shaped once. Safe to
+// share between threads; layouts handed out stay valid after eviction.
+class TextLayoutCache {
+public:
+    TextLayoutCache() = default;
+    ~TextLayoutCache();
+
+    TextLayoutCache(const TextLayoutCache&) = delete;
+    TextLayoutCache& operator=(const TextLayoutCache&) = delete;
+
+    std::shared_ptr<const TextLayout> Get(const std::string& text, const TextShapeKey& key);
+    std::shared_ptr<const TextLayout> Get(const std::string& text, const ResolvedStyle& style) {
+        return Get(text, TextShapeKey::FromStyle(style));
+    }
+
+private:
+    CTFontRef FontFor(const TextShapeKey& key);
+    void ReleaseFonts();
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<const TextLayout>> layouts_;
+    std::unordered_map<std::string, CTFontRef> fonts_;
+};
+
+} // namespace csvg
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef CHROMIUM_SVG_CORE_THEME_HPP
+#define CHROMIUM_SVG_CORE_THEME_HPP
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "YepSVGCore/Types.hpp"
+
+namespace csvg {
+
+// Render-time recoloring applied during style resolution, so one parsed
+// document can be drawn under any number of themes.
+class Theme {
+public:
+    // Every currentColor (and every inherited `color`) resolves to |value|.
+    bool SetCurrentColor(const std::string& value);
+    // Colors equal to |from| after parsing ("red", "#f00", "rgb(255,0,0)")
+    // are painted as |to|. Alpha is matched too.
+    bool MapColor(const std::string& from, const std::string& to);
+    // Value used by var(--name); wins over the var() fallback.
+    void SetCustomProperty(const std::string& name, const std::string& value);
+
+    const std::optional<Color>& current_color() const { return current_color_; }
+    bool has_custom_properties() const { return !custom_properties_.empty(); }
+
+    Color Apply(const Color& color) const;
+    // Replaces var(--name[, fallback]) references. Unknown names without a
+    // fallback substitute nothing, which leaves the property invalid.
+    std::string SubstituteVariables(const std::string& value) const;
+
+private:
+    std::optional<Color> current_color_;
+    std::unordered_map<uint32_t, Color> color_map_;
+    std::map<std::string, std::string> custom_properties_;
+};
+
+} // namespace csvg
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef CHROMIUM_SVG_CORE_TRANSFORM_HPP
+#define CHROMIUM_SVG_CORE_TRANSFORM_HPP
+
+#include <string>
+
+namespace csvg {
+
+// Maps (x, y) to (a * x + c * y + e, b * x + d * y + f), as in SVG matrix().
+struct AffineMatrix {
+    double a = 1.0;
+    double b = 0.0;
+    double c = 0.0;
+    double d = 1.0;
+    double e = 0.0;
+    double f = 0.0;
+
+    bool IsIdentity() const;
+    void Map(double x, double y, double& out_x, double& out_y) const;
+
+    // Returns the matrix that applies |first| and then |then|.
+    static AffineMatrix Concat(const AffineMatrix& first, const AffineMatrix& then);
+    static AffineMatrix Translation(double tx, double ty);
+    static AffineMatrix Scale(double sx, double sy);
+    static AffineMatrix Rotation(double radians);
+};
+
+class TransformParser {
+public:
+    AffineMatrix Parse(const std::string& transform_list) const;
+};
+
+} // namespace csvg
+
+#endif
@@ -2,12 +2,23 @@
 #define CHROMIUM_SVG_CORE_TYPES_HPP
 
 #include <cstdint>
+#include <functional>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "YepSVGCore/Attributes.hpp"
+
 namespace csvg {
 
+class Stylesheet;
+class Theme;
+
+// CSS property name -> value. The comparator is transparent so lookups by
+// literal or string_view do not build a std::string key.
+using PropertyMap = std::map<std::string, std::string, std::less<>>;
+
 enum class RenderErrorCode : int32_t {
     kNone = 0,
     kInvalidDocument = 1,
@@ -17,6 +28,14 @@ enum class RenderErrorCode : int32_t {
     kRenderFailed = 5,
 };
 
+// Why an external URL is fetched; matches csvg_external_resource_purpose_t.
+enum class ResourcePurpose : int32_t {
+    kImage = 0,
+    kStylesheet = 1,
+    kFont = 2,
+    kOther = 3,
+};
+
 struct RenderError {
     RenderErrorCode code = RenderErrorCode::kNone;
     std::string message;
@@ -33,6 +52,9 @@ struct RenderOptions {
     std::string default_font_family = "Helvetica";
     float default_font_size = 16.0f;
     bool enable_external_resources = false;
+    // Precompiled sheets applied before the document's own <style> blocks.
+    std::vector<std::shared_ptr<const Stylesheet>> stylesheets;
+    std::shared_ptr<const Theme> theme;
 };
 
 struct ImageBuffer {
@@ -57,7 +79,7 @@ struct Color {
 
 struct XmlNode {
     std::string name;
-    std::map<std::string, std::string> attributes;
+    AttributeMap attributes;
     std::vector<XmlNode> children;
     std::string text;
 };
@@ -0,0 +1,376 @@
+#include "YepSVGCore/FontLibrary.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+#define EXPECT(condition)                                                          \
+    do {                                                                           \
+        if (!(condition)) {                                                        \
+            std::fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__, #condition); \
+            ++failures;                                                            \
+        }                                                                          \
+    } while (0)
+
+bool Near(double a, double b) {
+    return std::fabs(a - b) < 1e-9;
+}
+
+void PutU16(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void PutU32(std::vector<uint8_t>& out, uint32_t value) {
+    PutU16(out, value >> 16);
+    PutU16(out, value & 0xFFFF);
+}
+
+void SetU16(std::vector<uint8_t>& out, size_t offset, uint32_t value) {
+    out[offset] = static_cast<uint8_t>(value >> 8);
+    out[offset + 1] = static_cast<uint8_t>(value);
+}
+
+struct TestFace {
+    std::string family;
+    int weight = 400;
+    bool italic = false;
+    bool serif = false;
+    bool fixed_pitch = false;
+};
+
+// A TrueType font with four glyphs: .notdef, 'A' (a 100,0-500,700 square),
+// 'V' (a triangle) and space; advances 500, 600, 650 and 250 on a 1000
+// unit em, and a -80 kerning pair for "AV".
+std::vector<uint8_t> BuildFont(const TestFace& spec) {
+    struct Table {
+        const char* tag;
+        std::vector<uint8_t> data;
+    };
+    std::vector<Table> tables;
+
+    std::vector<uint8_t> glyf;
+    std::vector<uint8_t> loca;
+    const auto add_glyph = [&](const std::vector<std::pair<int, int>>& points) {
+        PutU16(loca, static_cast<uint32_t>(glyf.size() / 2));
+        if (points.empty()) {
+            return;
+        }
+        int min_x = points[0].first, max_x = min_x, min_y = points[0].second, max_y = min_y;
+        for (const auto& [x, y] : points) {
+            min_x = std::min(min_x, x);
+            max_x = std::max(max_x, x);
+            min_y = std::min(min_y, y);
+            max_y = std::max(max_y, y);
+        }
+        PutU16(glyf, 1);
+        PutU16(glyf, min_x & 0xFFFF);
+        PutU16(glyf, min_y & 0xFFFF);
+        PutU16(glyf, max_x & 0xFFFF);
+        PutU16(glyf, max_y & 0xFFFF);
+        PutU16(glyf, static_cast<uint32_t>(points.size() - 1));
+        PutU16(glyf, 0);
+        glyf.insert(glyf.end(), points.size(), 0x01);
+        int previous = 0;
+        for (const auto& point : points) {
+            PutU16(glyf, (point.first - previous) & 0xFFFF);
+            previous = point.first;
+        }
+        previous = 0;
+        for (const auto& point : points) {
+            PutU16(glyf, (point.second - previous) & 0xFFFF);
+            previous = point.second;
+        }
+        if (glyf.size() % 2 != 0) {
+            glyf.push_back(0);
+        }
+    };
+    add_glyph({});
+    add_glyph({{100, 0}, {100, 700}, {500, 700}, {500, 0}});
+    add_glyph({{0, 700}, {300, 0}, {600, 700}});
+    add_glyph({});
+    PutU16(loca, static_cast<uint32_t>(glyf.size() / 2));
+
+    std::vector<uint8_t> head(54, 0);
+    SetU16(head, 0, 1);
+    SetU16(head, 18, 1000);
+    SetU16(head, 44, (spec.weight >= 700 ? 0x1 : 0) | (spec.italic ? 0x2 : 0));
+    tables.push_back({"head", head});
+
+    std::vector<uint8_t> hhea(36, 0);
+    SetU16(hhea, 0, 1);
+    SetU16(hhea, 4, 800);
+    SetU16(hhea, 6, static_cast<uint16_t>(-200));
+    SetU16(hhea, 34, 4);
+    tables.push_back({"hhea", hhea});
+
+    std::vector<uint8_t> maxp;
+    PutU32(maxp, 0x00005000);
+    PutU16(maxp, 4);
+    tables.push_back({"maxp", maxp});
+
+    std::vector<uint8_t> hmtx;
+    for (const uint32_t advance : {500, 600, 650, 250}) {
+        PutU16(hmtx, spec.fixed_pitch ? 600 : advance);
+        PutU16(hmtx, 0);
+    }
+    tables.push_back({"hmtx", hmtx});
+
+    // Format 4 with segments for ' ', 'A', 'V' and the 0xFFFF terminator.
+    std::vector<uint8_t> cmap;
+    PutU16(cmap, 0);
+    PutU16(cmap, 1);
+    PutU16(cmap, 3);
+    PutU16(cmap, 1);
+    PutU32(cmap, 12);
+    const std::vector<uint32_t> starts = {' ', 'A', 'V', 0xFFFF};
+    const std::vector<uint32_t> glyphs = {3, 1, 2, 0};
+    const uint32_t segments = static_cast<uint32_t>(starts.size());
+    PutU16(cmap, 4);
+    PutU16(cmap, 16 + segments * 8);
+    PutU16(cmap, 0);
+    PutU16(cmap, segments * 2);
+    PutU16(cmap, 4);
+    PutU16(cmap, 1);
+    PutU16(cmap, segments * 2 - 4);
+    for (const uint32_t start : starts) {
+        PutU16(cmap, start);
+    }
+    PutU16(cmap, 0);
+    for (const uint32_t start : starts) {
+        PutU16(cmap, start);
+    }
+    for (size_t i = 0; i < segments; ++i) {
+        PutU16(cmap, i + 1 == segments ? 1 : (glyphs[i] - starts[i]) & 0xFFFF);
+    }
+    for (size_t i = 0; i < segments; ++i) {
+        PutU16(cmap, 0);
+    }
+    tables.push_back({"cmap", cmap});
+
+    std::vector<uint8_t> name;
+    PutU16(name, 0);
+    PutU16(name, 1);
+    PutU16(name, 18);
+    PutU16(name, 3);
+    PutU16(name, 1);
+    PutU16(name, 0x0409);
+    PutU16(name, 1);
+    PutU16(name, static_cast<uint32_t>(spec.family.size() * 2));
+    PutU16(name, 0);
+    for (const char c : spec.family) {
+        PutU16(name, static_cast<uint8_t>(c));
+    }
+    tables.push_back({"name", name});
+
+    std::vector<uint8_t> os2(78, 0);
+    SetU16(os2, 4, static_cast<uint32_t>(spec.weight));
+    os2[32] = 2;
+    os2[33] = spec.serif ? 2 : 11;
+    os2[35] = spec.fixed_pitch ? 9 : 3;
+    SetU16(os2, 62, spec.italic ? 0x0001 : 0x0040);
+    tables.push_back({"OS/2", os2});
+
+    std::vector<uint8_t> kern;
+    PutU16(kern, 0);
+    PutU16(kern, 1);
+    PutU16(kern, 0);
+    PutU16(kern, 20);
+    PutU16(kern, 0x0001);
+    PutU16(kern, 1);
+    PutU16(kern, 6);
+    PutU16(kern, 0);
+    PutU16(kern, 0);
+    PutU16(kern, 1);
+    PutU16(kern, 2);
+    PutU16(kern, static_cast<uint16_t>(-80));
+    tables.push_back({"kern", kern});
+
+    tables.push_back({"loca", loca});
+    tables.push_back({"glyf", glyf});
+
+    std::sort(tables.begin(), tables.end(), [](const Table& a, const Table& b) {
+        return std::string(a.tag) < std::string(b.tag);
+    });
+    std::vector<uint8_t> font;
+    PutU32(font, 0x00010000);
+    PutU16(font, static_cast<uint32_t>(tables.size()));
+    PutU16(font, 0);
+    PutU16(font, 0);
+    PutU16(font, 0);
+    uint32_t offset = static_cast<uint32_t>(12 + tables.size() * 16);
+    for (const Table& table : tables) {
+        for (int i = 0; i < 4; ++i) {
+            font.push_back(static_cast<uint8_t>(table.tag[i]));
+        }
+        PutU32(font, 0);
+        PutU32(font, offset);
+        PutU32(font, static_cast<uint32_t>(table.data.size()));
+        offset += static_cast<uint32_t>((table.data.size() + 3) & ~size_t{3});
+    }
+    for (const Table& table : tables) {
+        font.insert(font.end(), table.data.begin(), table.data.end());
+        font.resize((font.size() + 3) & ~size_t{3}, 0);
+    }
+    return font;
+}
+
+std::shared_ptr<const csvg::FontFace> ParseFace(const TestFace& spec) {
+    csvg::RenderError error;
+    auto bytes = std::make_shared<const std::vector<uint8_t>>(BuildFont(spec));
+    return csvg::FontFace::Parse(bytes, 0, error);
+}
+
+void TestFaceMetadata() {
+    const auto face = ParseFace({"Test Sans", 300, true, false, false});
+    EXPECT(face != nullptr);
+    if (face == nullptr) {
+        return;
+    }
+    EXPECT(face->family() == "Test Sans");
+    EXPECT(face->weight() == 300);
+    EXPECT(face->italic());
+    EXPECT(!face->serif());
+    EXPECT(!face->fixed_pitch());
+    EXPECT(face->units_per_em() == 1000);
+    EXPECT(face->ascender() == 800);
+    EXPECT(face->descender() == -200);
+    EXPECT(face->glyph_count() == 4);
+
+    const auto serif = ParseFace({"Test Serif", 400, false, true, false});
+    const auto mono = ParseFace({"Test Mono", 400, false, false, true});
+    EXPECT(serif != nullptr && serif->serif() && !serif->fixed_pitch());
+    EXPECT(mono != nullptr && mono->fixed_pitch());
+}
+
+void TestCmapLookup() {
+    const auto face = ParseFace({"Test Sans"});
+    EXPECT(face != nullptr);
+    if (face == nullptr) {
+        return;
+    }
+    EXPECT(face->GlyphForCodepoint('A') == 1);
+    EXPECT(face->GlyphForCodepoint('V') == 2);
+    EXPECT(face->GlyphForCodepoint(' ') == 3);
+    EXPECT(face->GlyphForCodepoint('B') == 0);
+    EXPECT(face->GlyphForCodepoint('@') == 0);
+    EXPECT(face->GlyphForCodepoint(0x1F600) == 0);
+    EXPECT(face->AdvanceWidth(1) == 600);
+    EXPECT(face->AdvanceWidth(3) == 250);
+}
+
+void TestKerning() {
+    const auto face = ParseFace({"Test Sans"});
+    EXPECT(face != nullptr);
+    if (face == nullptr) {
+        return;
+    }
+    EXPECT(face->Kerning(1, 2) == -80);
+    EXPECT(face->Kerning(2, 1) == 0);
+    EXPECT(face->Kerning(1, 1) == 0);
+
+    csvg::FontLibrary library;
+    csvg::RenderError error;
+    EXPECT(library.AddFontData(BuildFont({"Test Sans"}), error) == 1);
+    const auto shaped = library.Shape("AVA", *library.Match("Test Sans", 400, false), 10.0, 0.0, 0.0);
+    EXPECT(shaped.glyphs.size() == 3);
+    if (shaped.glyphs.size() == 3) {
+        EXPECT(Near(shaped.glyphs[1].x, 5.2));
+        EXPECT(Near(shaped.glyphs[2].x, 11.7));
+    }
+    EXPECT(Near(shaped.width, 17.7));
+}
+
+void TestOutlineBounds() {
+    const auto face = ParseFace({"Test Sans"});
+    EXPECT(face != nullptr);
+    if (face == nullptr) {
+        return;
+    }
+    csvg::GlyphOutline square;
+    EXPECT(face->BuildOutline(1, square));
+    EXPECT(!square.points.empty());
+    EXPECT(!square.verbs.empty() && square.verbs.front() == csvg::GlyphOutline::Verb::kMove);
+    EXPECT(!square.verbs.empty() && square.verbs.back() == csvg::GlyphOutline::Verb::kClose);
+    double min_x = 1e9, min_y = 1e9, max_x = -1e9, max_y = -1e9;
+    for (const csvg::Point& point : square.points) {
+        min_x = std::min(min_x, point.x);
+        min_y = std::min(min_y, point.y);
+        max_x = std::max(max_x, point.x);
+        max_y = std::max(max_y, point.y);
+    }
+    EXPECT(min_x == 100 && min_y == 0 && max_x == 500 && max_y == 700);
+
+    csvg::GlyphOutline space;
+    EXPECT(face->BuildOutline(3, space));
+    EXPECT(space.verbs.empty());
+}
+
+std::string MatchedFamily(const csvg::FontLibrary& library, const std::string& css, int weight, bool italic) {
+    const auto face = library.Match(css, weight, italic);
+    return face != nullptr ? face->family() + " " + std::to_string(face->weight()) + (face->italic() ? " italic" : "") : "";
+}
+
+void TestWeightMatching() {
+    csvg::FontLibrary library;
+    EXPECT(library.Match("sans-serif", 400, false) == nullptr);
+
+    csvg::RenderError error;
+    for (const TestFace& spec : std::vector<TestFace>{
+             {"Lato", 300},
+             {"Lato", 400},
+             {"Lato", 700},
+             {"Lato", 400, true},
+             {"Code", 400, false, false, true},
+             {"Code", 700, false, false, true},
+             {"Book", 400, false, true},
+             {"Book", 600, false, true},
+         }) {
+        EXPECT(library.AddFontData(BuildFont(spec), error) == 1);
+    }
+
+    EXPECT(MatchedFamily(library, "Lato", 400, false) == "Lato 400");
+    EXPECT(MatchedFamily(library, "'Lato', serif", 700, false) == "Lato 700");
+    EXPECT(MatchedFamily(library, "Lato", 400, true) == "Lato 400 italic");
+    EXPECT(MatchedFamily(library, "Lato", 700, true) == "Lato 400 italic");
+    // CSS Fonts 4 §5.2: 450 tries up to 500 then lighter; 600 tries heavier.
+    EXPECT(MatchedFamily(library, "Lato", 450, false) == "Lato 400");
+    EXPECT(MatchedFamily(library, "Lato", 600, false) == "Lato 700");
+    EXPECT(MatchedFamily(library, "Lato", 200, false) == "Lato 300");
+    EXPECT(MatchedFamily(library, "Missing, Code", 900, false) == "Code 700");
+
+    // No registered family matches: the generic picks the class, then weight.
+    EXPECT(MatchedFamily(library, "sans-serif", 700, false) == "Lato 700");
+    EXPECT(MatchedFamily(library, "monospace", 400, false) == "Code 400");
+    EXPECT(MatchedFamily(library, "Menlo, monospace", 800, false) == "Code 700");
+    EXPECT(MatchedFamily(library, "serif", 500, false) == "Book 400");
+    EXPECT(MatchedFamily(library, "Missing", 300, false) == "Lato 300");
+    EXPECT(MatchedFamily(library, "cursive", 600, false) == "Book 600");
+
+    csvg::FontLibrary mono_only;
+    EXPECT(mono_only.AddFontData(BuildFont({"Code", 400, false, false, true}), error) == 1);
+    EXPECT(mono_only.AddFontData(BuildFont({"Code", 700, false, false, true}), error) == 1);
+    EXPECT(MatchedFamily(mono_only, "serif", 700, false) == "Code 700");
+}
+
+} // namespace
+
+int main() {
+    TestFaceMetadata();
+    TestCmapLookup();
+    TestKerning();
+    TestOutlineBounds();
+    TestWeightMatching();
+    if (failures != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("FontLibraryTests passed\n");
+    return 0;
+}
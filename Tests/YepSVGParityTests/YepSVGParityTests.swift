@@ -4,14 +4,24 @@ import ImageIO
 @testable import YepSVG
 
 final class YepSVGParityTests: XCTestCase {
-    private let threshold: Double = 0.005
+    private let defaultThreshold: Double = 0.005
+    private let timedRenderRuns = 5
 
     func testFixtureParityAgainstChromiumGoldens() async throws {
         let root = packageRoot()
         let fixtureDir = root.appendingPathComponent("Fixtures/svg", isDirectory: true)
         let goldenDir = root.appendingPathComponent("Fixtures/golden/chromium", isDirectory: true)
         let deviationsURL = goldenDir.appendingPathComponent("known-deviations.json")
-        let deviations = try loadKnownDeviations(at: deviationsURL)
+        let manifest = try loadDeviationManifest(at: deviationsURL)
+        let threshold = manifest?.threshold ?? defaultThreshold
+        let deviations = Dictionary(uniqueKeysWithValues: (manifest?.deviations ?? []).map { ($0.id, $0) })
+        let timingsURL = goldenDir.appendingPathComponent("render-timings.json")
+        let timingBaseline = try loadTimingBaseline(at: timingsURL)
+        let maxTimeRatio = ProcessInfo.processInfo.environment["YEPSVG_PARITY_MAX_TIME_RATIO"].flatMap(Double.init)
+            ?? timingBaseline?.maxTimeRatio
+            ?? 1.5
+        let minBaselineMs = timingBaseline?.minBaselineMs ?? 2.0
+        let writingTimings = ProcessInfo.processInfo.environment["YEPSVG_PARITY_WRITE_TIMINGS"] == "1"
 
         let fixtureFiles = try FileManager.default.contentsOfDirectory(at: fixtureDir, includingPropertiesForKeys: nil)
             .filter { $0.pathExtension.lowercased() == "svg" }
@@ -24,16 +34,41 @@ final class YepSVGParityTests: XCTestCase {
         let renderer = SVGRenderer()
         var compared = 0
         var usedDeviationIDs = Set<String>()
+        var measuredTimings: [String: Double] = [:]
+        var unbaselinedFixtures: [String] = []
 
         for svgURL in fixtureFiles {
             let name = svgURL.deletingPathExtension().lastPathComponent
             let goldenURL = goldenDir.appendingPathComponent("\(name).png")
+            let hasGolden = FileManager.default.fileExists(atPath: goldenURL.path)
+            let baselineMs = timingBaseline?.timings[name]
+            // Without a golden or a baseline there is nothing to check, so skip the renders.
+            guard hasGolden || baselineMs != nil || writingTimings else {
+                continue
+            }
+
+            let image: UIImage
+            if baselineMs != nil || writingTimings {
+                let (timedImage, renderMs) = try await timedRender(renderer: renderer, svgURL: svgURL)
+                image = timedImage
+                measuredTimings[name] = renderMs
+                if let baselineMs, baselineMs >= minBaselineMs {
+                    let ratio = renderMs / baselineMs
+                    XCTAssertLessThanOrEqual(
+                        ratio,
+                        maxTimeRatio,
+                        "Render time for \(name) regressed: \(String(format: "%.2f", renderMs))ms vs baseline \(String(format: "%.2f", baselineMs))ms (max ratio \(maxTimeRatio))"
+                    )
+                }
+            } else {
+                image = try await renderer.render(svgFileURL: svgURL, options: .default)
+                unbaselinedFixtures.append(name)
+            }
 
-            guard FileManager.default.fileExists(atPath: goldenURL.path) else {
+            guard hasGolden else {
                 continue
             }
 
-            let image = try await renderer.render(svgFileURL: svgURL, options: .default)
             guard let rendered = image.cgImage else {
                 XCTFail("Missing CGImage for fixture \(name)")
                 continue
@@ -57,6 +92,16 @@ final class YepSVGParityTests: XCTestCase {
             compared += 1
         }
 
+        if !measuredTimings.isEmpty {
+            try writeTimingReport(measuredTimings, baselineURL: timingsURL, maxTimeRatio: maxTimeRatio, minBaselineMs: minBaselineMs)
+        }
+
+        // Untimed fixtures are reported rather than failed; baselines only mean
+        // something when recorded on the reference device.
+        if !unbaselinedFixtures.isEmpty {
+            print("warning: no render-time baseline for \(unbaselinedFixtures); run with YEPSVG_PARITY_WRITE_TIMINGS=1 on the reference device and check in \(timingsURL.lastPathComponent)")
+        }
+
         if compared == 0 {
             throw XCTSkip("No chromium golden PNGs found to compare")
         }
@@ -65,6 +110,43 @@ final class YepSVGParityTests: XCTestCase {
         XCTAssertTrue(staleDeviationIDs.isEmpty, "Tracked deviations are stale or unnecessary: \(staleDeviationIDs.sorted())")
     }
 
+    /// Renders once to warm caches, then reports the median of `timedRenderRuns` renders.
+    private func timedRender(renderer: SVGRenderer, svgURL: URL) async throws -> (UIImage, Double) {
+        var image = try await renderer.render(svgFileURL: svgURL, options: .default)
+        var samples: [Double] = []
+        samples.reserve(timedRenderRuns)
+        for _ in 0..<timedRenderRuns {
+            let start = DispatchTime.now().uptimeNanoseconds
+            image = try await renderer.render(svgFileURL: svgURL, options: .default)
+            let end = DispatchTime.now().uptimeNanoseconds
+            samples.append(Double(end - start) / 1_000_000.0)
+        }
+        samples.sort()
+        return (image, samples[samples.count / 2])
+    }
+
+    /// Always writes the measured timings next to the test run's temporary files. Set
+    /// `YEPSVG_PARITY_WRITE_TIMINGS=1` to overwrite the checked-in baseline instead.
+    private func writeTimingReport(_ timings: [String: Double],
+                                   baselineURL: URL,
+                                   maxTimeRatio: Double,
+                                   minBaselineMs: Double) throws {
+        let report = TimingBaseline(version: 1, maxTimeRatio: maxTimeRatio, minBaselineMs: minBaselineMs, timings: timings)
+        let encoder = JSONEncoder()
+        encoder.outputFormatting = [.prettyPrinted, .sortedKeys]
+        let data = try encoder.encode(report)
+
+        let reportURL = FileManager.default.temporaryDirectory.appendingPathComponent("yepsvg-render-timings.json")
+        try data.write(to: reportURL)
+        let attachment = XCTAttachment(contentsOfFile: reportURL)
+        attachment.lifetime = .keepAlways
+        add(attachment)
+
+        if ProcessInfo.processInfo.environment["YEPSVG_PARITY_WRITE_TIMINGS"] == "1" {
+            try data.write(to: baselineURL)
+        }
+    }
+
     private func pixelDiffRatio(lhs: CGImage, rhs: CGImage) throws -> Double {
         guard lhs.width == rhs.width, lhs.height == rhs.height else {
             throw XCTSkip("Image dimensions differ (\(lhs.width)x\(lhs.height) vs \(rhs.width)x\(rhs.height))")
@@ -124,13 +206,20 @@ final class YepSVGParityTests: XCTestCase {
             .deletingLastPathComponent()
     }
 
-    private func loadKnownDeviations(at url: URL) throws -> [String: KnownDeviation] {
+    private func loadDeviationManifest(at url: URL) throws -> DeviationManifest? {
         guard FileManager.default.fileExists(atPath: url.path) else {
-            return [:]
+            return nil
         }
         let data = try Data(contentsOf: url)
-        let manifest = try JSONDecoder().decode(DeviationManifest.self, from: data)
-        return Dictionary(uniqueKeysWithValues: manifest.deviations.map { ($0.id, $0) })
+        return try JSONDecoder().decode(DeviationManifest.self, from: data)
+    }
+
+    private func loadTimingBaseline(at url: URL) throws -> TimingBaseline? {
+        guard FileManager.default.fileExists(atPath: url.path) else {
+            return nil
+        }
+        let data = try Data(contentsOf: url)
+        return try JSONDecoder().decode(TimingBaseline.self, from: data)
     }
 }
 
@@ -145,3 +234,10 @@ private struct KnownDeviation: Decodable {
     let reason: String
     let maxDiffRatio: Double
 }
+
+private struct TimingBaseline: Codable {
+    let version: Int
+    let maxTimeRatio: Double
+    let minBaselineMs: Double
+    let timings: [String: Double]
+}
@@ -1,6 +1,7 @@
 import XCTest
 import UIKit
 import CoreGraphics
+import YepSVGCBridge
 @testable import YepSVG
 
 final class YepSVGTests: XCTestCase {
@@ -127,6 +128,40 @@ final class YepSVGTests: XCTestCase {
         XCTAssertEqual(count, 1)
     }
 
+    func testExternalResourcesAreFetchedOnceAndDrawn() async throws {
+        let format = UIGraphicsImageRendererFormat()
+        format.scale = 1
+        let png = try XCTUnwrap(UIGraphicsImageRenderer(size: CGSize(width: 4, height: 4), format: format).image { ctx in
+            UIColor.blue.setFill()
+            ctx.fill(CGRect(x: 0, y: 0, width: 4, height: 4))
+        }.pngData())
+        let loader = FixedDataLoader(data: png)
+        let renderer = SVGRenderer(loader: loader)
+        let svg = """
+        <svg width="30" height="10" xmlns="http://www.w3.org/2000/svg">
+          <image href="https://example.com/a.png" x="0" y="0" width="10" height="10"/>
+          <image href=" https://example.com/a.png " x="10" y="0" width="10" height="10"/>
+          <image href="https://example.com/b.png" x="20" y="0" width="10" height="10"/>
+        </svg>
+        """
+
+        var options = SVGRenderOptions.default
+        options.enableExternalResources = true
+        let image = try await renderer.render(svgString: svg, options: options)
+        guard let cgImage = image.cgImage else {
+            XCTFail("Missing CGImage")
+            return
+        }
+
+        let requested = await loader.requestedURLs().map(\.absoluteString).sorted()
+        XCTAssertEqual(requested, ["https://example.com/a.png", "https://example.com/b.png"])
+        for x in [5, 15, 25] {
+            let pixel = try pixelAt(cgImage: cgImage, x: x, y: 5)
+            XCTAssertGreaterThan(pixel.b, 180)
+            XCTAssertLessThan(pixel.r, 40)
+        }
+    }
+
     func testTopLeftCoordinateSystemIsPreserved() async throws {
         let renderer = SVGRenderer()
         let svg = """
@@ -1360,6 +1395,77 @@ final class YepSVGTests: XCTestCase {
         XCTAssertLessThan(right.b, 90)
     }
 
+    func testRepeatedLabelsReuseShapedTextWithTheirOwnColors() async throws {
+        let renderer = SVGRenderer()
+        func labels(_ first: String, _ second: String) -> String {
+            """
+            <svg width="120" height="50" xmlns="http://www.w3.org/2000/svg">
+              <text x="20" y="32" font-size="28" text-anchor="middle" fill="\(first)">I</text>
+              <text x="80" y="32" font-size="28" text-anchor="middle" fill="\(second)">I</text>
+            </svg>
+            """
+        }
+
+        for (first, second) in [("#ff0000", "#0000ff"), ("#0000ff", "#ff0000")] {
+            let image = try await renderer.render(svgString: labels(first, second), options: .default)
+            guard let cgImage = image.cgImage,
+                  let bounds = try opaqueBounds(cgImage: cgImage) else {
+                XCTFail("Expected visible text output")
+                return
+            }
+            XCTAssertLessThan(bounds.minX, 20)
+            XCTAssertGreaterThan(bounds.maxX, 80)
+
+            let left = try pixelAt(cgImage: cgImage, x: 20, y: 22)
+            let right = try pixelAt(cgImage: cgImage, x: 80, y: 22)
+            XCTAssertEqual(left.r > 160, first == "#ff0000")
+            XCTAssertEqual(left.b > 160, first == "#0000ff")
+            XCTAssertEqual(right.r > 160, second == "#ff0000")
+            XCTAssertEqual(right.b > 160, second == "#0000ff")
+        }
+    }
+
+    func testSmallLabelsFromGlyphAtlasMatchPathText() async throws {
+        let renderer = SVGRenderer()
+        // A tiny rotation keeps the same placement but forces path text.
+        func table(_ transform: String) -> String {
+            var labels = ""
+            for row in 0..<8 {
+                for column in 0..<4 {
+                    let x = 10.3 + Double(column) * 40.0
+                    labels += "<text x=\"\(x)\" y=\"\(14 + row * 14)\" font-size=\"11\" fill=\"#0000ff\">\(row * 4 + column)0.5</text>"
+                }
+            }
+            return """
+            <svg width="170" height="125" xmlns="http://www.w3.org/2000/svg">
+              <g transform="\(transform)">\(labels)</g>
+            </svg>
+            """
+        }
+
+        let atlasImage = try await renderer.render(svgString: table(""), options: .default)
+        let pathImage = try await renderer.render(svgString: table("rotate(0.001)"), options: .default)
+        guard let atlas = atlasImage.cgImage,
+              let path = pathImage.cgImage,
+              let atlasBounds = try opaqueBounds(cgImage: atlas),
+              let pathBounds = try opaqueBounds(cgImage: path) else {
+            XCTFail("Expected visible text output")
+            return
+        }
+        XCTAssertLessThanOrEqual(abs(atlasBounds.minX - pathBounds.minX), 1)
+        XCTAssertLessThanOrEqual(abs(atlasBounds.minY - pathBounds.minY), 1)
+        XCTAssertLessThanOrEqual(abs(atlasBounds.maxX - pathBounds.maxX), 1)
+        XCTAssertLessThanOrEqual(abs(atlasBounds.maxY - pathBounds.maxY), 1)
+
+        let isInk: ((r: UInt8, g: UInt8, b: UInt8, a: UInt8)) -> Bool = { pixel in
+            pixel.a > 120 && pixel.b > 120 && pixel.r < 80 && pixel.g < 80
+        }
+        let atlasInk = try countPixels(cgImage: atlas, x: 0, y: 0, width: atlas.width, height: atlas.height, where: isInk)
+        let pathInk = try countPixels(cgImage: path, x: 0, y: 0, width: path.width, height: path.height, where: isInk)
+        XCTAssertGreaterThan(pathInk, 400)
+        XCTAssertEqual(Double(atlasInk), Double(pathInk), accuracy: Double(pathInk) * 0.1)
+    }
+
     func testTextPath01FixtureRendersTextAlongReferencedPath() async throws {
         let root = packageRoot()
         let fixture = root.appendingPathComponent("Examples/YepSVGSampleApp/YepSVGSampleApp/Resources/W3CSuite/svggen/text-path-01-b.svg")
@@ -1716,6 +1822,634 @@ final class YepSVGTests: XCTestCase {
         XCTAssertLessThan(rightBar.a, 10)
     }
 
+    func testFullCssColorKeywordSetAndMixedCaseValuesParse() async throws {
+        let renderer = SVGRenderer()
+        let svg = """
+        <svg width="30" height="10" xmlns="http://www.w3.org/2000/svg">
+          <rect x="0" y="0" width="10" height="10" fill="RebeccaPurple"/>
+          <rect x="10" y="0" width="10" height="10" fill=" #00FF7F "/>
+          <rect x="20" y="0" width="10" height="10" fill="RGB(100%, 0%, 0%)"/>
+        </svg>
+        """
+
+        let image = try await renderer.render(svgString: svg, options: .default)
+        guard let cgImage = image.cgImage else {
+            XCTFail("Missing CGImage")
+            return
+        }
+
+        let keyword = try pixelAt(cgImage: cgImage, x: 5, y: 5)
+        XCTAssertEqual(Int(keyword.r), 0x66, accuracy: 3)
+        XCTAssertEqual(Int(keyword.g), 0x33, accuracy: 3)
+        XCTAssertEqual(Int(keyword.b), 0x99, accuracy: 3)
+        let hex = try pixelAt(cgImage: cgImage, x: 15, y: 5)
+        XCTAssertGreaterThan(hex.g, 240)
+        XCTAssertEqual(Int(hex.b), 0x7F, accuracy: 3)
+        let function = try pixelAt(cgImage: cgImage, x: 25, y: 5)
+        XCTAssertGreaterThan(function.r, 240)
+        XCTAssertLessThan(function.g, 10)
+    }
+
+    func testCommaSeparatedViewBoxScalesPercentageLengths() async throws {
+        let renderer = SVGRenderer()
+        let svg = """
+        <svg width="20" height="20" viewBox="0,0,10,10" xmlns="http://www.w3.org/2000/svg">
+          <rect x="0" y="0" width="50%" height="10" fill="#ff0000"/>
+        </svg>
+        """
+
+        let image = try await renderer.render(svgString: svg, options: .default)
+        guard let cgImage = image.cgImage else {
+            XCTFail("Missing CGImage")
+            return
+        }
+
+        XCTAssertGreaterThan(try pixelAt(cgImage: cgImage, x: 8, y: 10).r, 180)
+        XCTAssertLessThan(try pixelAt(cgImage: cgImage, x: 12, y: 10).a, 10)
+    }
+
+    func testTextPathOnCircleStartsAtRightmostPointAndRunsClockwise() async throws {
+        let renderer = SVGRenderer()
+        let svg = """
+        <svg width="100" height="100" xmlns="http://www.w3.org/2000/svg">
+          <defs><circle id="ring" cx="50" cy="50" r="30"/></defs>
+          <text font-size="14" fill="black"><textPath xlink:href="#ring" xmlns:xlink="http://www.w3.org/1999/xlink">MMM</textPath></text>
+        </svg>
+        """
+
+        let image = try await renderer.render(svgString: svg, options: .default)
+        guard let cgImage = image.cgImage else {
+            XCTFail("Missing CGImage")
+            return
+        }
+
+        XCTAssertTrue(try regionHasOpaquePixels(cgImage: cgImage, x: 50, y: 50, width: 50, height: 50))
+        XCTAssertFalse(try regionHasOpaquePixels(cgImage: cgImage, x: 0, y: 0, width: 50, height: 50))
+    }
+
+    func testDocumentHitTestHonorsTransformsClipsAndPointerEvents() throws {
+        let document = try SVGDocument(svgString: """
+        <svg width="200" height="100" viewBox="0 0 100 50" xmlns="http://www.w3.org/2000/svg">
+          <defs><clipPath id="left"><rect width="50" height="50"/></clipPath></defs>
+          <rect id="floor" width="100" height="50" fill="white"/>
+          <g id="room" transform="translate(20 10)"><circle cx="5" cy="5" r="5" fill="blue"/></g>
+          <rect id="ghost" x="20" y="10" width="10" height="10" pointer-events="none"/>
+          <rect id="outline" x="60" y="10" width="20" height="20" fill="none" stroke="black" stroke-width="4"/>
+          <rect id="clipped" x="40" y="35" width="20" height="10" clip-path="url(#left)"/>
+        </svg>
+        """)
+
+        func hit(_ x: Float, _ y: Float, all: Bool = false) -> [String] {
+            var options = csvg_hit_test_options_t()
+            csvg_hit_test_options_init_default(&options)
+            options.collect_all = all
+            var result = csvg_hit_test_result_t()
+            defer { csvg_hit_test_result_free(&result) }
+            guard csvg_document_hit_test(document.handle, x, y, &options, &result) == 1 else {
+                return []
+            }
+            if all {
+                return (0..<result.all_count).compactMap { index in result.all_ids?[index].map { String(cString: $0) } }
+            }
+            return result.id.map { [String(cString: $0)] } ?? []
+        }
+
+        XCTAssertEqual(hit(50, 30), ["room"])
+        XCTAssertEqual(hit(50, 30, all: true), ["room", "floor"])
+        XCTAssertEqual(hit(140, 40), ["floor"], "Unfilled interior falls through to the floor")
+        XCTAssertEqual(hit(122, 40), ["outline"])
+        XCTAssertEqual(hit(90, 80), ["clipped"])
+        XCTAssertEqual(hit(110, 80), ["floor"])
+        XCTAssertEqual(hit(500, 500), [])
+    }
+
+    func testDocumentHitTestAppliesRenderStylesheets() throws {
+        let document = try SVGDocument(svgString: """
+        <svg width="100" height="50" xmlns="http://www.w3.org/2000/svg">
+          <rect id="floor" width="100" height="50" fill="white"/>
+          <rect id="card" x="10" y="10" width="20" height="20"/>
+        </svg>
+        """)
+        let sheet = try SVGStylesheet(css: "#card { pointer-events: none }")
+
+        func hit(_ x: Float, _ y: Float, styled: Bool) -> String? {
+            var renderOptions = csvg_render_options_t()
+            csvg_render_options_init_default(&renderOptions)
+            let stylesheets: [OpaquePointer?] = [sheet.handle]
+            var result = csvg_hit_test_result_t()
+            defer { csvg_hit_test_result_free(&result) }
+            let status: Int32 = stylesheets.withUnsafeBufferPointer { buffer in
+                if styled {
+                    renderOptions.stylesheets = buffer.baseAddress
+                    renderOptions.stylesheet_count = buffer.count
+                }
+                return withUnsafePointer(to: &renderOptions) { renderOptionsPointer in
+                    var options = csvg_hit_test_options_t()
+                    csvg_hit_test_options_init_default(&options)
+                    options.render_options = renderOptionsPointer
+                    return csvg_document_hit_test(document.handle, x, y, &options, &result)
+                }
+            }
+            return status == 1 ? result.id.map { String(cString: $0) } : nil
+        }
+
+        XCTAssertEqual(hit(20, 20, styled: false), "card")
+        // The index built without the sheet must not answer for a styled layout.
+        XCTAssertEqual(hit(20, 20, styled: true), "floor")
+        XCTAssertEqual(hit(20, 20, styled: false), "card")
+    }
+
+    func testElementBoundsFollowTransformsStrokeAndUse() throws {
+        let document = try SVGDocument(svgString: """
+        <svg width="200" height="100" viewBox="0 0 100 50" xmlns="http://www.w3.org/2000/svg">
+          <defs><rect id="tile" width="4" height="4"/></defs>
+          <g id="room" transform="translate(20 10)">
+            <circle cx="5" cy="5" r="5"/>
+            <rect id="box" x="10" width="10" height="10" stroke="red" stroke-width="6" transform="scale(2)"/>
+          </g>
+          <use id="instance" href="#tile" x="90" y="40"/>
+          <g id="hidden" display="none"><rect width="5" height="5"/></g>
+        </svg>
+        """)
+
+        func bounds(_ id: String) -> csvg_element_bounds_t? {
+            var result = csvg_element_bounds_t()
+            return csvg_document_get_element_bounds(document.handle, id, nil, &result) ? result : nil
+        }
+        func rect(_ r: csvg_rect_t) -> CGRect {
+            CGRect(x: CGFloat(r.x), y: CGFloat(r.y), width: CGFloat(r.width), height: CGFloat(r.height))
+        }
+
+        var width: Int32 = 0
+        var height: Int32 = 0
+        XCTAssertTrue(csvg_document_get_size(document.handle, nil, &width, &height))
+        XCTAssertEqual([width, height], [200, 100])
+
+        let box = try XCTUnwrap(bounds("box"))
+        XCTAssertEqual(rect(box.fill), CGRect(x: 10, y: 0, width: 10, height: 10))
+        XCTAssertEqual(rect(box.stroke), CGRect(x: 7, y: -3, width: 16, height: 16))
+
+        let room = try XCTUnwrap(bounds("room"))
+        XCTAssertEqual(rect(room.fill), CGRect(x: 0, y: 0, width: 40, height: 20))
+        XCTAssertEqual(rect(room.device), CGRect(x: 40, y: 8, width: 92, height: 64))
+
+        let instance = try XCTUnwrap(bounds("instance"))
+        XCTAssertEqual(rect(instance.device), CGRect(x: 180, y: 80, width: 8, height: 8))
+        XCTAssertNil(bounds("hidden"))
+        XCTAssertNil(bounds("missing"))
+    }
+
+    func testElementBoundsApplyRenderStylesheets() throws {
+        let document = try SVGDocument(svgString: """
+        <svg width="40" height="40" xmlns="http://www.w3.org/2000/svg">
+          <rect id="box" x="10" y="10" width="10" height="10" stroke="black" stroke-width="2"/>
+        </svg>
+        """)
+        let sheet = try SVGStylesheet(css: "#box { stroke-width: 8 }")
+
+        func strokeBounds(styled: Bool) -> CGRect? {
+            var options = csvg_render_options_t()
+            csvg_render_options_init_default(&options)
+            let stylesheets: [OpaquePointer?] = [sheet.handle]
+            var result = csvg_element_bounds_t()
+            let found = stylesheets.withUnsafeBufferPointer { buffer in
+                if styled {
+                    options.stylesheets = buffer.baseAddress
+                    options.stylesheet_count = buffer.count
+                }
+                return csvg_document_get_element_bounds(document.handle, "box", &options, &result)
+            }
+            guard found else { return nil }
+            return CGRect(x: CGFloat(result.stroke.x), y: CGFloat(result.stroke.y),
+                          width: CGFloat(result.stroke.width), height: CGFloat(result.stroke.height))
+        }
+
+        XCTAssertEqual(strokeBounds(styled: false), CGRect(x: 9, y: 9, width: 12, height: 12))
+        XCTAssertEqual(strokeBounds(styled: true), CGRect(x: 6, y: 6, width: 18, height: 18))
+        XCTAssertEqual(strokeBounds(styled: false), CGRect(x: 9, y: 9, width: 12, height: 12))
+    }
+
+    func testRenderWithProfileReportsPerElementCosts() throws {
+        let svg = """
+        <svg width="40" height="40" xmlns="http://www.w3.org/2000/svg">
+          <defs>
+            <filter id="blur"><feGaussianBlur stdDeviation="2"/></filter>
+          </defs>
+          <g id="group">
+            <rect id="plain" x="0" y="0" width="10" height="10" fill="red"/>
+            <rect id="blurred" x="10" y="10" width="10" height="10" fill="blue" filter="url(#blur)"/>
+          </g>
+        </svg>
+        """
+
+        let elements = try renderRGBA(svg: svg, profiled: true).elements
+        let byID = Dictionary(uniqueKeysWithValues: elements.compactMap { element -> (String, [String: Any])? in
+            guard let id = element["id"] as? String, !id.isEmpty else { return nil }
+            return (id, element)
+        })
+
+        let blurred = try XCTUnwrap(byID["blurred"])
+        let plain = try XCTUnwrap(byID["plain"])
+        XCTAssertEqual(blurred["path"] as? String, "/svg[1]/g[1]/rect[2]")
+        XCTAssertGreaterThan(try XCTUnwrap(blurred["offscreen_pixels"] as? Int), 0)
+        XCTAssertEqual(plain["offscreen_pixels"] as? Int, 0)
+        XCTAssertGreaterThanOrEqual(
+            try XCTUnwrap(byID["group"]?["inclusive_ms"] as? Double),
+            try XCTUnwrap(blurred["inclusive_ms"] as? Double)
+        )
+    }
+
+    func testRepeatRendersOnOneRendererStartFromACleanSurface() throws {
+        guard let renderer = csvg_renderer_create() else {
+            XCTFail("Failed to create renderer")
+            return
+        }
+        defer { csvg_renderer_destroy(renderer) }
+
+        func render(_ svg: String) throws -> [UInt8] {
+            try renderRGBA(svg: svg, on: renderer).rgba
+        }
+
+        let full = try render("<svg width=\"4\" height=\"4\"><rect width=\"4\" height=\"4\" fill=\"red\"/></svg>")
+        XCTAssertEqual(full[3], 255)
+        // Same size, so the surface from the first render is reused.
+        let corner = try render("<svg width=\"4\" height=\"4\"><rect width=\"1\" height=\"1\" fill=\"blue\"/></svg>")
+        XCTAssertEqual(Array(corner[0..<4]), [0, 0, 255, 255])
+        XCTAssertTrue(corner[4...].allSatisfy { $0 == 0 })
+        let larger = try render("<svg width=\"8\" height=\"2\"></svg>")
+        XCTAssertEqual(larger.count, 8 * 2 * 4)
+        XCTAssertTrue(larger.allSatisfy { $0 == 0 })
+    }
+
+    func testFilterChainsOnPooledSurfacesLeaveNoStalePixels() throws {
+        guard let renderer = csvg_renderer_create() else {
+            XCTFail("Failed to create renderer")
+            return
+        }
+        defer { csvg_renderer_destroy(renderer) }
+
+        func render(offset: Int) throws -> BridgeRender {
+            let svg = """
+            <svg xmlns="http://www.w3.org/2000/svg" width="8" height="8">
+              <filter id="f" filterUnits="userSpaceOnUse" x="0" y="0" width="8" height="8">
+                <feOffset dx="\(offset)" dy="0"/>
+                <feColorMatrix values="0 0 0 0 0  0 0 0 0 0  1 0 0 0 0  0 0 0 1 0"/>
+              </filter>
+              <rect width="4" height="4" fill="red" filter="url(#f)"/>
+            </svg>
+            """
+            return try renderRGBA(svg: svg, on: renderer)
+        }
+
+        let shifted = try render(offset: 4)
+        XCTAssertEqual(shifted.pixel(5, 1), [0, 0, 255, 255])
+        XCTAssertEqual(shifted.pixel(1, 1), [0, 0, 0, 0])
+        // The second render gets the first one's buffers back from the pool.
+        XCTAssertEqual(try render(offset: 4).rgba, shifted.rgba)
+        let unshifted = try render(offset: 0)
+        XCTAssertEqual(unshifted.pixel(1, 1), [0, 0, 255, 255])
+        XCTAssertEqual(unshifted.pixel(5, 1), [0, 0, 0, 0])
+    }
+
+    func testFilterChainsWorkInTheirColorInterpolationSpace() throws {
+        let svg = """
+        <svg xmlns="http://www.w3.org/2000/svg" width="40" height="10">
+          <filter id="linear">
+            <feFlood flood-color="rgb(128,128,128)"/>
+            <feComponentTransfer><feFuncR type="linear" slope="0.5"/></feComponentTransfer>
+            <feComponentTransfer><feFuncG type="identity"/></feComponentTransfer>
+            <feComponentTransfer><feFuncB type="identity"/></feComponentTransfer>
+          </filter>
+          <filter id="srgb" color-interpolation-filters="sRGB">
+            <feFlood flood-color="rgb(128,128,128)"/>
+            <feComponentTransfer><feFuncR type="linear" slope="0.5"/></feComponentTransfer>
+          </filter>
+          <rect width="10" height="10" filter="url(#linear)"/>
+          <rect x="20" width="10" height="10" filter="url(#srgb)"/>
+        </svg>
+        """
+        let image = try renderRGBA(svg: svg)
+
+        // Halving in linear light lands well above half the sRGB value.
+        let linear = image.pixel(5, 5)
+        XCTAssertTrue((90...95).contains(linear[0]), "linearRGB red \(linear[0])")
+        // Identity steps in between convert nothing, so nothing drifts.
+        XCTAssertEqual(Array(linear[1...3]), [128, 128, 255])
+        XCTAssertEqual(image.pixel(25, 5), [64, 128, 128, 255])
+    }
+
+    func testFilterPrimitivesTrackTheBoundsTheyDrawInto() throws {
+        let svg = """
+        <svg xmlns="http://www.w3.org/2000/svg" width="40" height="10">
+          <filter id="blur" filterUnits="userSpaceOnUse" x="0" y="0" width="20" height="10">
+            <feGaussianBlur stdDeviation="1"/>
+          </filter>
+          <filter id="fill" filterUnits="userSpaceOnUse" x="20" y="0" width="20" height="10">
+            <feColorMatrix values="0 0 0 0 0  0 0 0 0 0  0 0 0 0 1  0 0 0 0 1"/>
+          </filter>
+          <rect x="2" y="3" width="4" height="4" fill="red" filter="url(#blur)"/>
+          <rect x="22" y="3" width="4" height="4" fill="red" filter="url(#fill)"/>
+        </svg>
+        """
+        let image = try renderRGBA(svg: svg)
+
+        // The blur spreads the rect by its kernel radius and no further.
+        XCTAssertGreaterThan(image.pixel(4, 5)[3], 200)
+        XCTAssertGreaterThan(image.pixel(7, 5)[3], 0)
+        XCTAssertEqual(image.pixel(12, 5), [0, 0, 0, 0])
+        // An alpha offset lights up pixels the source never touched.
+        XCTAssertEqual(image.pixel(38, 1), [0, 0, 255, 255])
+        XCTAssertEqual(image.pixel(24, 5), [0, 0, 255, 255])
+    }
+
+    func testFilterStandardInputsAreBuiltOnDemand() throws {
+        let svg = """
+        <svg xmlns="http://www.w3.org/2000/svg" width="40" height="10">
+          <filter id="shadow" filterUnits="userSpaceOnUse" x="0" y="0" width="20" height="10">
+            <feOffset in="SourceAlpha" dx="10"/>
+          </filter>
+          <filter id="paint" filterUnits="userSpaceOnUse" x="20" y="0" width="20" height="10">
+            <feMerge><feMergeNode in="FillPaint"/><feMergeNode in="BackgroundImage"/></feMerge>
+          </filter>
+          <rect x="2" y="3" width="4" height="4" fill="red" filter="url(#shadow)"/>
+          <rect x="22" y="3" width="4" height="4" fill="blue" filter="url(#paint)"/>
+        </svg>
+        """
+        let image = try renderRGBA(svg: svg)
+
+        // SourceAlpha is black wherever the source is covered.
+        XCTAssertEqual(image.pixel(13, 5), [0, 0, 0, 255])
+        XCTAssertEqual(image.pixel(4, 5), [0, 0, 0, 0])
+        // FillPaint covers the whole filter region; BackgroundImage is empty.
+        XCTAssertEqual(image.pixel(38, 1), [0, 0, 255, 255])
+    }
+
+    func testRenderCacheServesRepeatRendersFromDisk() throws {
+        let directory = FileManager.default.temporaryDirectory
+            .appendingPathComponent("yepsvg-render-cache-\(UUID().uuidString)")
+        defer { try? FileManager.default.removeItem(at: directory) }
+        let svg = "<svg width=\"8\" height=\"8\"><rect width=\"8\" height=\"8\" fill=\"red\"/></svg>"
+
+        func render(background: Float) throws -> [UInt8] {
+            // A fresh cache and renderer each time, as after a process restart.
+            guard let cache = csvg_render_cache_create(directory.path, 1 << 20),
+                  let renderer = csvg_renderer_create() else {
+                XCTFail("Failed to create renderer")
+                return []
+            }
+            defer {
+                csvg_renderer_destroy(renderer)
+                csvg_render_cache_destroy(cache)
+            }
+            csvg_renderer_set_render_cache(renderer, cache)
+            return try renderRGBA(svg: svg, on: renderer) { $0.background_alpha = background }.rgba
+        }
+        func cachedFiles() throws -> [String] {
+            try FileManager.default.contentsOfDirectory(atPath: directory.path).filter { $0.hasSuffix(".rgba") }
+        }
+
+        let first = try render(background: 0)
+        XCTAssertEqual(try cachedFiles().count, 1)
+        let second = try render(background: 0)
+        XCTAssertEqual(second, first)
+        XCTAssertEqual(try cachedFiles().count, 1)
+
+        _ = try render(background: 1)
+        XCTAssertEqual(try cachedFiles().count, 2)
+    }
+
+    func testEmbeddedImagesDecodeAtDrawnSize() throws {
+        let format = UIGraphicsImageRendererFormat()
+        format.scale = 1
+        let sourceImage = UIGraphicsImageRenderer(size: CGSize(width: 1024, height: 1024), format: format).image { ctx in
+            UIColor.red.setFill()
+            ctx.fill(CGRect(x: 0, y: 0, width: 1024, height: 512))
+            UIColor.blue.setFill()
+            ctx.fill(CGRect(x: 0, y: 512, width: 1024, height: 512))
+        }
+        let pngData = try XCTUnwrap(sourceImage.pngData())
+        let svg = """
+        <svg width="48" height="48" xmlns="http://www.w3.org/2000/svg">
+          <image id="photo" href="data:image/png;base64,\(pngData.base64EncodedString())" x="0" y="0" width="48" height="48"/>
+        </svg>
+        """
+
+        let image = try renderRGBA(svg: svg, profiled: true)
+        let photo = try XCTUnwrap(image.elements.first { $0["id"] as? String == "photo" })
+        let decoded = try XCTUnwrap(photo["decoded_image_pixels"] as? Int)
+        XCTAssertGreaterThan(decoded, 0)
+        XCTAssertLessThanOrEqual(decoded, 64 * 64)
+
+        let top = image.pixel(24, 8)
+        let bottom = image.pixel(24, 40)
+        XCTAssertGreaterThan(top[0], 180)
+        XCTAssertLessThan(top[2], 80)
+        XCTAssertGreaterThan(bottom[2], 180)
+        XCTAssertLessThan(bottom[0], 80)
+    }
+
+    func testImagesOutsideTheCanvasAreNotDecoded() throws {
+        let format = UIGraphicsImageRendererFormat()
+        format.scale = 1
+        let sourceImage = UIGraphicsImageRenderer(size: CGSize(width: 256, height: 256), format: format).image { ctx in
+            UIColor.green.setFill()
+            ctx.fill(CGRect(x: 0, y: 0, width: 256, height: 256))
+        }
+        let href = "data:image/png;base64,\(try XCTUnwrap(sourceImage.pngData()).base64EncodedString())"
+        let svg = """
+        <svg width="32" height="32" xmlns="http://www.w3.org/2000/svg">
+          <image id="visible" href="\(href)" x="0" y="0" width="32" height="32"/>
+          <image id="offscreen" href="\(href)" x="400" y="0" width="256" height="256"/>
+          <defs>
+            <clipPath id="corner"><rect x="0" y="0" width="4" height="4"/></clipPath>
+          </defs>
+          <image id="clipped" href="\(href)" x="10" y="10" width="256" height="256" clip-path="url(#corner)"/>
+        </svg>
+        """
+
+        let elements = try renderRGBA(svg: svg, profiled: true).elements
+        func decodedPixels(_ id: String) -> Int? {
+            elements.first { $0["id"] as? String == id }?["decoded_image_pixels"] as? Int
+        }
+        XCTAssertGreaterThan(try XCTUnwrap(decodedPixels("visible")), 0)
+        XCTAssertEqual(decodedPixels("offscreen") ?? 0, 0)
+        XCTAssertEqual(decodedPixels("clipped") ?? 0, 0)
+    }
+
+    func testSharedStylesheetsApplyAcrossDocumentsWithOriginPrecedence() async throws {
+        let theme = try SVGStylesheet(css: ".accent { fill: #0000ff } rect { fill: #00ff00 }")
+        let defaults = try SVGStylesheet(css: "rect { fill: #ff0000 } circle { fill: #ff0000 }", origin: .userAgent)
+        var options = SVGRenderOptions.default
+        options.stylesheets = [defaults, theme]
+
+        let renderer = SVGRenderer()
+        let first = """
+        <svg width="20" height="10" xmlns="http://www.w3.org/2000/svg">
+          <rect x="0" y="0" width="10" height="10"/>
+          <rect class="accent" x="10" y="0" width="10" height="10"/>
+        </svg>
+        """
+        let second = """
+        <svg width="20" height="10" xmlns="http://www.w3.org/2000/svg">
+          <style>.accent { fill: #ffff00 }</style>
+          <circle cx="5" cy="5" r="4" fill="#00ffff"/>
+          <rect class="accent" x="10" y="0" width="10" height="10"/>
+        </svg>
+        """
+
+        guard let firstImage = try await renderer.render(svgString: first, options: options).cgImage,
+              let secondImage = try await renderer.render(svgString: second, options: options).cgImage else {
+            XCTFail("Missing CGImage")
+            return
+        }
+
+        let plainRect = try pixelAt(cgImage: firstImage, x: 5, y: 5)
+        XCTAssertGreaterThan(plainRect.g, 180)
+        XCTAssertLessThan(plainRect.r, 40)
+        let themedRect = try pixelAt(cgImage: firstImage, x: 15, y: 5)
+        XCTAssertGreaterThan(themedRect.b, 180)
+        XCTAssertLessThan(themedRect.g, 40)
+
+        // Presentation attributes beat user-agent rules.
+        let circle = try pixelAt(cgImage: secondImage, x: 5, y: 5)
+        XCTAssertGreaterThan(circle.g, 180)
+        XCTAssertGreaterThan(circle.b, 180)
+        XCTAssertLessThan(circle.r, 40)
+        // The document's own <style> follows the shared author sheet.
+        let documentRect = try pixelAt(cgImage: secondImage, x: 15, y: 5)
+        XCTAssertGreaterThan(documentRect.r, 180)
+        XCTAssertGreaterThan(documentRect.g, 180)
+        XCTAssertLessThan(documentRect.b, 40)
+    }
+
+    func testLongLivedRendererAppliesStylesheetsPerRender() async throws {
+        let sheet = try SVGStylesheet(css: "rect { fill: #0000ff }")
+        var styled = SVGRenderOptions.default
+        styled.stylesheets = [sheet]
+        let svg = """
+        <svg width="10" height="10" xmlns="http://www.w3.org/2000/svg">
+          <rect width="10" height="10" fill="#ff0000"/>
+        </svg>
+        """
+
+        let renderer = SVGRenderer()
+        guard let first = try await renderer.render(svgString: svg, options: styled).cgImage,
+              let second = try await renderer.render(svgString: svg, options: .default).cgImage else {
+            XCTFail("Missing CGImage")
+            return
+        }
+        XCTAssertGreaterThan(try pixelAt(cgImage: first, x: 5, y: 5).b, 180)
+        // The sheet belonged to the first render only.
+        let plain = try pixelAt(cgImage: second, x: 5, y: 5)
+        XCTAssertGreaterThan(plain.r, 180)
+        XCTAssertLessThan(plain.b, 40)
+    }
+
+    func testStructuralSelectorsFromSharedSheetsMatchRetainedDocumentsWithoutStyle() async throws {
+        let document = try SVGDocument(svgString: """
+        <svg width="20" height="10" xmlns="http://www.w3.org/2000/svg">
+          <g>
+            <rect x="0" y="0" width="10" height="10" fill="#ff0000"/>
+            <rect x="10" y="0" width="10" height="10" fill="#ff0000"/>
+          </g>
+        </svg>
+        """)
+        var options = SVGRenderOptions.default
+        options.stylesheets = [try SVGStylesheet(css: "g > rect:first-child { fill: #0000ff }")]
+
+        guard let image = try await SVGRenderer().render(document: document, options: options).cgImage else {
+            XCTFail("Missing CGImage")
+            return
+        }
+        XCTAssertGreaterThan(try pixelAt(cgImage: image, x: 5, y: 5).b, 180)
+        XCTAssertGreaterThan(try pixelAt(cgImage: image, x: 15, y: 5).r, 180)
+    }
+
+    func testRetainedDocumentRendersWithThemeOverrides() async throws {
+        let document = try SVGDocument(svgString: """
+        <svg width="30" height="10" xmlns="http://www.w3.org/2000/svg">
+          <rect x="0" y="0" width="10" height="10" fill="currentColor"/>
+          <rect x="10" y="0" width="10" height="10" fill="#ff0000"/>
+          <rect x="20" y="0" width="10" height="10" style="fill: var(--brand, #000000)"/>
+        </svg>
+        """)
+        let renderer = SVGRenderer()
+
+        guard let plain = try await renderer.render(document: document, options: .default).cgImage else {
+            XCTFail("Missing CGImage")
+            return
+        }
+        XCTAssertGreaterThan(try pixelAt(cgImage: plain, x: 15, y: 5).r, 180)
+        XCTAssertLessThan(try pixelAt(cgImage: plain, x: 25, y: 5).b, 40)
+
+        var options = SVGRenderOptions.default
+        options.theme = try SVGTheme(
+            currentColor: "#00ff00",
+            colorOverrides: ["red": "#0000ff"],
+            customProperties: ["brand": "#ffff00"]
+        )
+        guard let themed = try await renderer.render(document: document, options: options).cgImage else {
+            XCTFail("Missing CGImage")
+            return
+        }
+
+        let current = try pixelAt(cgImage: themed, x: 5, y: 5)
+        XCTAssertGreaterThan(current.g, 180)
+        XCTAssertLessThan(current.r, 40)
+        let mapped = try pixelAt(cgImage: themed, x: 15, y: 5)
+        XCTAssertGreaterThan(mapped.b, 180)
+        XCTAssertLessThan(mapped.r, 40)
+        let variable = try pixelAt(cgImage: themed, x: 25, y: 5)
+        XCTAssertGreaterThan(variable.r, 180)
+        XCTAssertGreaterThan(variable.g, 180)
+        XCTAssertLessThan(variable.b, 40)
+    }
+
+    /// Renders |svg| through the C bridge on |renderer|, or on a fresh one when nil.
+    private func renderRGBA(
+        svg: String,
+        on renderer: OpaquePointer? = nil,
+        profiled: Bool = false,
+        configure: (inout csvg_render_options_t) -> Void = { _ in }
+    ) throws -> BridgeRender {
+        let owned = renderer == nil ? csvg_renderer_create() : nil
+        defer {
+            if let owned {
+                csvg_renderer_destroy(owned)
+            }
+        }
+        let target = try XCTUnwrap(renderer ?? owned, "Failed to create renderer")
+
+        var options = csvg_render_options_t()
+        csvg_render_options_init_default(&options)
+        configure(&options)
+        var result = csvg_render_result_t()
+        var profileJSON: UnsafeMutablePointer<CChar>?
+        defer {
+            csvg_render_result_free(&result)
+            csvg_free_owned_memory(profileJSON)
+        }
+        let bytes = Array(svg.utf8)
+        let status = profiled
+            ? csvg_renderer_render_with_profile(target, bytes, bytes.count, &options, &result, &profileJSON)
+            : csvg_renderer_render(target, bytes, bytes.count, &options, &result)
+        XCTAssertEqual(status, 1)
+
+        var elements: [[String: Any]] = []
+        if profiled {
+            let json = try XCTUnwrap(profileJSON, "Missing profile report")
+            let report = try XCTUnwrap(
+                JSONSerialization.jsonObject(with: Data(String(cString: json).utf8)) as? [String: Any]
+            )
+            elements = try XCTUnwrap(report["elements"] as? [[String: Any]])
+        }
+        return BridgeRender(
+            width: Int(result.width),
+            rgba: Array(UnsafeBufferPointer(start: result.rgba, count: result.rgba_size)),
+            elements: elements
+        )
+    }
+
     private func pixelAt(cgImage: CGImage, x: Int, y: Int) throws -> (r: UInt8, g: UInt8, b: UInt8, a: UInt8) {
         let width = cgImage.width
         let height = cgImage.height
@@ -1990,6 +2724,37 @@ final class YepSVGTests: XCTestCase {
     }
 }
 
+/// Pixels of a C bridge render, top row first.
+private struct BridgeRender {
+    let width: Int
+    let rgba: [UInt8]
+    /// Element entries of the paint profile; empty unless the render was profiled.
+    let elements: [[String: Any]]
+
+    func pixel(_ x: Int, _ y: Int) -> [UInt8] {
+        let base = (y * width + x) * 4
+        return Array(rgba[base..<(base + 4)])
+    }
+}
+
+actor FixedDataLoader: SVGExternalResourceLoader {
+    private let data: Data
+    private var requests: [URL] = []
+
+    init(data: Data) {
+        self.data = data
+    }
+
+    func loadResource(_ request: SVGExternalResourceRequest) async throws -> Data {
+        requests.append(request.url)
+        return data
+    }
+
+    func requestedURLs() -> [URL] {
+        requests
+    }
+}
+
 actor MockLoader: SVGExternalResourceLoader {
     private var requests: [URL] = []
 